@@ -0,0 +1,11 @@
+// epd.c itself, for its statics: one band through the byte loop without the
+// panel steps around it. make bench links this in place of epd.rel.
+#include "../src/display/epd.c"
+
+static void bench_source(void) {}
+
+void bench_epd_band(void) {
+  epd_source = bench_source;
+  epd_row = 0;
+  epd_sendBand(EPD_PLANE_BLACK);
+}
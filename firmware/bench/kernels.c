@@ -0,0 +1,251 @@
+#include "../src/cobs/cobs.h"
+#include "../src/display/bitmap.h"
+#include "../src/display/epd.h"
+#include "../src/display/text.h"
+#include "../src/hal/dma.h"
+#include "../src/hal/isr.h"
+#include "../src/hal/uart.h"
+#include "../src/mcast/gf256.h"
+#include "../src/pool/pool.h"
+#include "../src/sched/sched.h"
+#include <string.h>
+
+// Kernel benchmarks for `make bench`, run to completion by s51, the 8051
+// simulator of SDCC's ucsim, and read out by tools/bench.js.
+//
+// s51 models a plain 8051 rather than the CC2510: Timer 0 counts machine
+// cycles, and the CC2510 peripherals are just memory, so the flags the
+// drivers wait on read as done at once. The harness stands in for the DMA
+// controller. The numbers are the CPU's own work per kernel, in 8051
+// machine cycles, meant for comparing one build to the next. For cycles on
+// the tag, with its instruction timings and the waits, build with PROFILE=1
+// and run `npm run profile`.
+
+// Timer 0 of the 8051 in s51, TMOD and the count share addresses with
+// P0IFG, P1IFG and PICTL of the CC2510 which the kernels do not touch
+__sfr __at(0x89) T0MOD;
+__sfr __at(0x8A) T0LOW;
+__sfr __at(0x8C) T0HIGH;
+__sbit __at(0x8C) T0RUN; // TCON.4
+__sbit __at(0xA9) T0IE;  // IE.1
+#define T0_VECTOR 1      // ADC_VECTOR on the CC2510, unused here
+
+#define BENCH_NAME 12
+#define BENCH_FRAME 64 // bytes, about a transport frame
+
+typedef struct {
+  char name[BENCH_NAME];
+  uint32_t cycles;
+} BenchResult;
+
+typedef struct {
+  const char *name;
+  void (*setup)(void); // untimed, may be NULL
+  void (*run)(void);
+} Bench;
+
+// at BENCH_XRAM (Makefile), below the firmware's own XRAM. s51 has all 64KB.
+typedef struct {
+  uint8_t count;
+  BenchResult results[16];
+  uint8_t frame[BENCH_FRAME];
+  uint8_t band[EPD_BAND_SIZE]; // 8 rows of the panel
+  uint8_t glyph[2 * 16];       // 16x16
+  uint8_t square[32 * 4];      // 32x32
+  uint8_t turned[32 * 4];
+  uint8_t symbol[BENCH_FRAME];
+  uint8_t repair[BENCH_FRAME];
+} BenchData;
+
+static __xdata __at(BENCH_XRAM) BenchData bench;
+
+static volatile uint16_t overflows;
+static uint8_t rx_head; // RX ring slot written next, by the stand-in DMA
+
+void bench_epd_band(void); // epd_band.c
+
+INTERRUPT(bench_timer_isr, T0_VECTOR) {
+  overflows++;
+}
+
+static void count_start(void) {
+  overflows = 0;
+  T0HIGH = 0;
+  T0LOW = 0;
+  T0RUN = 1;
+}
+
+static uint32_t count_stop(void) {
+  T0RUN = 0;
+  return ((uint32_t)overflows << 16) | ((uint16_t)T0HIGH << 8) | T0LOW;
+}
+
+// what the DMA interrupt does when a channel is through. dma_isr() returns
+// with RETI, which outside an interrupt is a plain RET.
+static void dma_complete(uint8_t channel) {
+  DMAIRQ |= BV(channel);
+  dma_isr();
+}
+
+// bytes arriving on the UART, moved into the RX ring as the DMA would: the
+// byte and U1BAUD per slot, completing the channel at the end of a lap
+static void rx_feed(const uint8_t __xdata *bytes, uint16_t length) {
+  DmaDesc __xdata *desc = &DMA_DESC(DMA_CH_UART_RX);
+  uint8_t __xdata *ring = (uint8_t __xdata *)(((uint16_t)desc->dst_h << 8) | desc->dst_l);
+  uint8_t slots = desc->len_l;
+  while (length--) {
+    ring[2 * rx_head] = *bytes++;
+    ring[2 * rx_head + 1] = U1BAUD;
+    if (++rx_head == slots) {
+      rx_head = 0;
+      dma_complete(DMA_CH_UART_RX);
+    }
+  }
+}
+
+// the TX buffer handed to the DMA last, it gets sent at once
+static void tx_drain(void) {
+  uart_flush();
+  dma_complete(DMA_CH_UART_TX);
+}
+
+static void setup_cobs_send(void) {
+  tx_drain();
+}
+
+static void run_cobs_send(void) {
+  cobs_send(bench.frame, BENCH_FRAME);
+}
+
+// the frame cobs_send encoded, back in through the RX ring
+static void setup_cobs_rx(void) {
+  PoolBlock __xdata *frame;
+  while ((frame = cobs_rx_frame())) {
+    pool_free(frame);
+  }
+  tx_drain();
+  cobs_send(bench.frame, BENCH_FRAME);
+  DmaDesc __xdata *desc = &DMA_DESC(DMA_CH_UART_TX);
+  rx_feed((const uint8_t __xdata *)(((uint16_t)desc->src_h << 8) | desc->src_l),
+          ((uint16_t)(desc->len_h & 0x1F) << 8) | desc->len_l);
+  dma_complete(DMA_CH_UART_TX);
+}
+
+static void run_cobs_rx(void) {
+  cobs_rx_poll();
+}
+
+static void run_uart_send(void) {
+  for (uint8_t i = 0; i < BENCH_FRAME; i++) {
+    uart_send_byte(bench.frame[i]);
+  }
+}
+
+static void setup_uart_read(void) {
+  rx_feed(bench.frame, BENCH_FRAME);
+}
+
+static void run_uart_read(void) {
+  uint8_t data;
+  while (uart_read_byte(&data)) {
+  }
+}
+
+static void run_span(void) {
+  bitmap_span(bench.band, 3, EPD_HRES - 3, true);
+}
+
+static void run_blit(void) {
+  bitmap_blit(bench.band, EPD_ROW_BYTES, 37, bench.glyph, 2, 0, 16, EPD_BAND_ROWS, false);
+}
+
+static void run_transpose(void) {
+  bitmap_transpose8(bench.square, 4, bench.turned, 4);
+}
+
+static void run_rotate(void) {
+  bitmap_rotate(bench.square, 4, 32, 32, bench.turned, 4, BITMAP_ROTATE_90);
+}
+
+static void text_blit(void) {
+  bitmap_blit(&bench.band[text_blit_call.y * EPD_ROW_BYTES], EPD_ROW_BYTES, text_blit_call.x, text_blit_call.bits, 0, 0,
+              text_blit_call.width, text_blit_call.rows, false);
+}
+
+// the first band of a line of text, as a label renders it
+static void run_text(void) {
+  static const char __xdata line[] = "Coffee 3.49";
+  text_draw(0, 4, 0, line, sizeof(line) - 1, 0, EPD_BAND_ROWS, text_blit);
+}
+
+static void run_gf(void) {
+  gf_mul_add(bench.repair, bench.symbol, 0x53, BENCH_FRAME);
+}
+
+static void run_nothing(void) {
+}
+
+static __code const Bench benches[] = {
+    {"cobs_send", setup_cobs_send, run_cobs_send},
+    {"cobs_rx", setup_cobs_rx, run_cobs_rx},
+    {"uart_send", setup_cobs_send, run_uart_send},
+    {"uart_read", setup_uart_read, run_uart_read},
+    {"epd_band", NULL, bench_epd_band},
+    {"span", NULL, run_span},
+    {"blit", NULL, run_blit},
+    {"transpose8", NULL, run_transpose},
+    {"rotate32", NULL, run_rotate},
+    {"text_band", NULL, run_text},
+    {"gf_mul_add", NULL, run_gf},
+};
+
+static uint32_t measure(const Bench *b) {
+  if (b->setup) {
+    b->setup();
+  }
+  count_start();
+  b->run();
+  return count_stop();
+}
+
+// tools/bench.js stops the simulator here
+void bench_done(void) {
+  while (1) {
+  }
+}
+
+void main(void) {
+  dma_init();
+  uart_init();
+  sched_init();
+  pool_init();
+  cobs_rx_init();
+
+  for (uint8_t i = 0; i < BENCH_FRAME; i++) {
+    // a zero now and then, which COBS has to encode
+    bench.frame[i] = i & 0x0F ? i * 37 : 0;
+    bench.symbol[i] = i;
+    bench.repair[i] = ~i;
+  }
+  memset(bench.band, 0xFF, sizeof(bench.band));
+  for (uint8_t i = 0; i < sizeof(bench.glyph); i++) {
+    bench.glyph[i] = 0x3C ^ i;
+  }
+  for (uint8_t i = 0; i < sizeof(bench.square); i++) {
+    bench.square[i] = i * 11;
+  }
+
+  T0MOD = (T0MOD & 0xF0) | 0x01; // 16 bit timer
+  T0IE = 1;
+  HAL_ENABLE_INTERRUPTS();
+
+  static const Bench empty = {"", NULL, run_nothing};
+  uint32_t overhead = measure(&empty);
+  bench.count = 0;
+  for (uint8_t i = 0; i < sizeof(benches) / sizeof(benches[0]); i++) {
+    BenchResult __xdata *result = &bench.results[bench.count++];
+    strncpy(result->name, benches[i].name, BENCH_NAME);
+    result->cycles = measure(&benches[i]) - overhead;
+  }
+  bench_done();
+}
@@ -0,0 +1,183 @@
+#include "../src/hal/clock.h"
+#include "../src/hal/crc.h"
+#include "../src/hal/dma.h"
+#include "../src/hal/hal.h"
+#include "../src/hal/spiflash.h"
+#include "../src/ota/image.h"
+#include <string.h>
+
+// Resident bootloader at 0x0000. Installs or reverts an image staged in the
+// external flash as recorded by the application (see src/ota), then starts
+// the application at OTA_APP_START. Runs with interrupts disabled, the
+// vectors only forward to the application's table.
+
+#define FCTL_ERASE 0x01
+#define FCTL_WRITE 0x02
+#define FWT_26MHZ 0x22 // 21000 * 26MHz / 16e9
+
+#define WDT_EN BV(3)
+
+#ifdef BUILD
+#define FORWARD(vector) \
+  void forward_##vector(void) __interrupt(vector) __naked { __asm ljmp(OTA_APP_START + 3 + 8 * vector) __endasm; }
+FORWARD(0)
+FORWARD(1)
+FORWARD(2)
+FORWARD(3)
+FORWARD(4)
+FORWARD(5)
+FORWARD(6)
+FORWARD(7)
+FORWARD(8)
+FORWARD(9)
+FORWARD(10)
+FORWARD(11)
+FORWARD(12)
+FORWARD(13)
+FORWARD(14)
+FORWARD(15)
+FORWARD(16)
+FORWARD(17)
+#endif
+
+static OtaMeta __xdata meta;
+static uint8_t __xdata page[OTA_PAGE_SIZE];
+static DmaDesc __xdata flash_dma;
+
+// The flash can not be read while it is erased or written, the command is
+// issued and waited for by this routine copied to RAM.
+static __code const uint8_t flash_routine_code[] = {
+    0x43, 0xAE, 0x00, // orl FCTL, #command
+    0xE5, 0xAE,       // 1$: mov a, FCTL
+    0x20, 0xE7, 0xFB, // jb acc.7 (BUSY), 1$
+    0x22,             // ret
+};
+static uint8_t __xdata flash_routine[sizeof(flash_routine_code)];
+
+static void flash_command(uint8_t command) {
+  flash_routine[2] = command;
+  ((void (*)(void))(uint16_t)flash_routine)();
+}
+
+// erases and programs one internal page from the page buffer
+static void program_page(uint16_t address) {
+  // FADDR is a word address
+  FADDRH = address >> 9;
+  FADDRL = address >> 1;
+  flash_command(FCTL_ERASE);
+
+  DMA_SETUP_TX(flash_dma, page, DMA_XADDR_FWDATA, OTA_PAGE_SIZE, DMA_WORDSIZE_BYTE | DMA_TMODE_SINGLE | DMA_TRIG_FLASH,
+               DMA_PRI_HIGH);
+  DMA0CFGH = (uint16_t)&flash_dma >> 8;
+  DMA0CFGL = (uint16_t)&flash_dma;
+  DMA_ARM(0);
+  NOP(); // arming takes effect after 9 system clocks
+  NOP();
+  NOP();
+
+  FADDRH = address >> 9;
+  FADDRL = address >> 1;
+  flash_command(FCTL_WRITE);
+}
+
+static uint16_t internal_crc(uint16_t length) {
+  __code const uint8_t *data = (__code const uint8_t *)OTA_APP_START;
+  CRC16_INIT(0);
+  while (length--) {
+    CRC16_UPDATE(*data++);
+  }
+  return CRC16_VALUE();
+}
+
+// programs the application area from external flash, the rest stays erased
+static bool install(uint32_t source, uint16_t size, uint16_t crc) {
+  for (uint16_t offset = 0; offset < OTA_APP_SIZE; offset += OTA_PAGE_SIZE) {
+    uint16_t length = 0;
+    if (offset < size) {
+      length = size - offset < OTA_PAGE_SIZE ? size - offset : OTA_PAGE_SIZE;
+      spiflash_read(source + offset, page, length);
+    }
+    memset(page + length, 0xFF, OTA_PAGE_SIZE - length);
+    program_page(OTA_APP_START + offset);
+  }
+  return internal_crc(size) == crc;
+}
+
+static void backup(void) {
+  __code const uint8_t *data = (__code const uint8_t *)OTA_APP_START;
+  for (uint16_t offset = 0; offset < OTA_APP_SIZE; offset += SPIFLASH_PAGE_SIZE) {
+    if (!(offset & (SPIFLASH_SECTOR_SIZE - 1))) {
+      spiflash_erase_sector(OTA_BACKUP_ADDRESS + offset);
+    }
+    memcpy(page, data + offset, SPIFLASH_PAGE_SIZE);
+    spiflash_program(OTA_BACKUP_ADDRESS + offset, page, SPIFLASH_PAGE_SIZE);
+  }
+  meta.backup_size = OTA_APP_SIZE;
+  meta.backup_crc = internal_crc(OTA_APP_SIZE);
+}
+
+static void set_state(uint8_t state) {
+  meta.state = state;
+  ota_meta_write(&meta);
+}
+
+static void revert(void) {
+  set_state(OTA_REVERTING);
+  install(OTA_BACKUP_ADDRESS, meta.backup_size, meta.backup_crc);
+  meta.attempts = 0;
+  meta.flags |= OTA_FLAG_ROLLED_BACK;
+  set_state(OTA_IDLE);
+}
+
+static void update(void) {
+  switch (meta.state) {
+  case OTA_PENDING:
+    if (ota_flash_crc(OTA_STAGE_ADDRESS, meta.image_size) != meta.image_crc) {
+      set_state(OTA_IDLE);
+      return;
+    }
+    backup();
+    set_state(OTA_INSTALLING);
+    // fall through
+  case OTA_INSTALLING:
+    // also resumes an install cut short by a reset
+    if (!install(OTA_STAGE_ADDRESS, meta.image_size, meta.image_crc)) {
+      revert();
+      return;
+    }
+    meta.attempts = 0;
+    meta.flags = 0;
+    set_state(OTA_TRIAL);
+    // fall through
+  case OTA_TRIAL:
+    if (meta.attempts >= OTA_MAX_ATTEMPTS) {
+      revert();
+      return;
+    }
+    meta.attempts++;
+    ota_meta_write(&meta);
+    // a hanging image gets reset too, the application services it
+    WDCTL = WDT_EN; // 1s interval
+    return;
+
+  case OTA_REVERTING:
+    revert();
+    return;
+  }
+}
+
+void main(void) {
+  init_clock();
+  FWT = FWT_26MHZ;
+  memcpy(flash_routine, flash_routine_code, sizeof(flash_routine_code));
+
+  spiflash_init();
+  if (ota_meta_read(&meta)) {
+    update();
+  }
+  spiflash_sleep();
+
+#ifdef BUILD
+  __asm ljmp OTA_APP_START __endasm;
+#endif
+}
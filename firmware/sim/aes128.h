@@ -0,0 +1,13 @@
+#ifndef _SIM_AES128_H_
+#define _SIM_AES128_H_
+
+#include <stdint.h>
+
+// Software AES-128 encryption, the block cipher of the coprocessor model in
+// cc2510_aes.c.
+
+void aes128_set_key(const uint8_t *key);
+// in and out may be the same block
+void aes128_encrypt(const uint8_t *in, uint8_t *out);
+
+#endif
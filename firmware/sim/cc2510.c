@@ -0,0 +1,216 @@
+#include "cc2510.h"
+#include "../src/hal/hal.h"
+#include "../src/hal/isr.h"
+#include <time.h>
+
+#define CC2510_DEFINE(name) volatile uint8_t name;
+CC2510_SFRS(CC2510_DEFINE)
+CC2510_XREGS(CC2510_DEFINE)
+CC2510_BITS(CC2510_DEFINE)
+
+#define EVENT0_MASK BV(4)
+#define EVENT0_FLAG BV(0)
+
+// 26MHz / 750, see hal/time.c
+#define TICKS_PER_3MS 104
+#define NS_PER_3MS 3000000ULL
+
+#define XADDR_U0DBUF 0xDFC1
+#define XADDR_U1DBUF 0xDFF9
+#define XADDR_ENCDI 0xDFB1
+#define XADDR_ENCDO 0xDFB2
+
+typedef struct {
+  volatile uint8_t *enable;
+  uint8_t enable_mask;
+  volatile uint8_t *flag;
+  void (*isr)(void);
+} Source;
+
+// in vector order, which is the polling order within a priority level
+static const Source sources[] = {
+    {&URX1IE, 1, &URX1IF, uart_rx_isr}, // URX1_VECTOR
+    {&STIE, 1, &STIF, sleep_timer_isr}, // ST_VECTOR
+    {&DMAIE, 1, &DMAIF, dma_isr},       // DMA_VECTOR
+    {&P0IE, 1, &P0IF, port0_isr},       // P0INT_VECTOR
+    {&IEN2, BV(4), &P1IF, port1_isr},   // P1INT_VECTOR
+    {&IEN2, BV(0), &S1CON, radio_isr},  // RF_VECTOR
+};
+
+#define IDLE_MODELS 4
+
+static struct timespec origin;
+static uint64_t period_start; // sleep timer ticks at the last Event 0 match
+static bool servicing;        // an interrupt is running, no nesting
+static bool woken;            // an interrupt ran since the last idle
+static uint16_t crc;          // RNDH:RNDL
+static IdleModel idle_models[IDLE_MODELS];
+static uint8_t idle_model_count;
+
+uint64_t cc2510_now(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)(now.tv_sec - origin.tv_sec) * 1000000000ULL + now.tv_nsec - origin.tv_nsec;
+}
+
+static uint64_t ticks_now(void) {
+  return cc2510_now() * TICKS_PER_3MS / NS_PER_3MS;
+}
+
+static uint32_t event0(void) {
+  uint16_t value = ((uint16_t)WOREVT1 << 8) | WOREVT0;
+  return value ? value : 0x10000;
+}
+
+// the counter restarts on every match, whether the interrupt ran or not.
+// Returns the current tick.
+static uint64_t sleep_timer_update(void) {
+  uint64_t now = ticks_now();
+  uint64_t elapsed = now - period_start;
+  uint32_t event = event0();
+  if (elapsed >= event) {
+    period_start += elapsed - elapsed % event;
+    WORIRQ |= EVENT0_FLAG;
+    if (WORIRQ & EVENT0_MASK) {
+      STIF = 1;
+    }
+  }
+  return now;
+}
+
+// until the next Event 0 interrupt, UINT64_MAX when there is none
+static uint64_t sleep_timer_wait(void) {
+  if (!STIE || !(WORIRQ & EVENT0_MASK)) {
+    return UINT64_MAX;
+  }
+  uint64_t elapsed = ticks_now() - period_start;
+  uint32_t event = event0();
+  if (elapsed >= event) {
+    return 0;
+  }
+  return ((event - elapsed) * NS_PER_3MS + TICKS_PER_3MS - 1) / TICKS_PER_3MS;
+}
+
+uint8_t cc2510_wortime0(void) {
+  uint16_t count = sleep_timer_update() - period_start;
+  WORTIME1 = count >> 8;
+  return count;
+}
+
+void cc2510_init(void) {
+  clock_gettime(CLOCK_MONOTONIC, &origin);
+  period_start = 0;
+  // ports are inputs with pull-ups after reset
+  P0 = P1 = P2 = 0xFF;
+  P0_0 = P0_1 = P0_2 = P0_3 = P0_4 = P0_5 = P0_6 = P0_7 = 1;
+  P1_0 = P1_1 = P1_2 = P1_3 = P1_4 = P1_5 = P1_6 = P1_7 = 1;
+  P2_0 = P2_1 = P2_2 = P2_3 = P2_4 = 1;
+  // both high speed oscillators report stable at once
+  SLEEP = 0x60;
+  CLKCON = 0xC9;
+  MARCSTATE = 0x01;
+  PARTNUM = 0x81;
+  VERSION = 0x04;
+  PKTLEN = 0xFF;
+}
+
+void cc2510_interrupts(void) {
+  if (servicing) {
+    return;
+  }
+  servicing = true;
+  sleep_timer_update();
+  for (uint8_t i = 0; EA && i < sizeof(sources) / sizeof(sources[0]);) {
+    const Source *source = &sources[i];
+    if ((*source->enable & source->enable_mask) && *source->flag) {
+      source->isr();
+      woken = true;
+      i = 0; // the handler may have raised a higher one
+    } else {
+      i++;
+    }
+  }
+  servicing = false;
+}
+
+void cc2510_idle_attach(IdleModel model) {
+  if (idle_model_count < IDLE_MODELS) {
+    idle_models[idle_model_count++] = model;
+  }
+}
+
+void cc2510_idle(void) {
+  while (!woken) {
+    uint64_t wait = sleep_timer_wait();
+    uint64_t now = cc2510_now();
+    for (uint8_t i = 0; i < idle_model_count; i++) {
+      uint64_t next = idle_models[i](now);
+      wait = next < wait ? next : wait;
+    }
+    // a model may have raised an interrupt already
+    usart1_model_poll(woken ? 0 : wait);
+    cc2510_interrupts();
+  }
+  woken = false;
+}
+
+void cc2510_port1_drive(uint8_t pin, bool level) {
+  static volatile uint8_t *const pins[8] = {&P1_0, &P1_1, &P1_2, &P1_3, &P1_4, &P1_5, &P1_6, &P1_7};
+  bool was = *pins[pin];
+  *pins[pin] = level;
+  // PICTL bit 1 selects falling edges for all of port 1
+  if (was != level && level == !(PICTL & BV(1))) {
+    P1IFG |= BV(pin);
+    if (P1IEN & BV(pin)) {
+      P1IF = 1;
+    }
+    cc2510_interrupts();
+  }
+}
+
+uint8_t cc2510_xreg_read(uint16_t address) {
+  switch (address) {
+  case XADDR_U0DBUF:
+    return U0DBUF;
+  case XADDR_U0DBUF + 1:
+    return U0BAUD;
+  case XADDR_U1DBUF:
+    return U1DBUF;
+  case XADDR_U1DBUF + 1:
+    return U1BAUD;
+  case XADDR_ENCDO:
+    return aes_model_read();
+  default:
+    return 0;
+  }
+}
+
+void cc2510_xreg_write(uint16_t address, uint8_t value) {
+  switch (address) {
+  case XADDR_U0DBUF:
+    usart0_model_write(value);
+    break;
+  case XADDR_U1DBUF:
+    usart1_model_send(value);
+    break;
+  case XADDR_ENCDI:
+    aes_model_write(value);
+    break;
+  }
+}
+
+void rng_model_seed(uint8_t value) {
+  crc = (crc << 8) | value;
+}
+
+// the RNG LFSR in CRC mode: X16 + X15 + X2 + 1 (0x8005), MSB first
+void rng_model_update(uint8_t value) {
+  crc ^= (uint16_t)value << 8;
+  for (uint8_t i = 0; i < 8; i++) {
+    crc = (crc & 0x8000) ? (crc << 1) ^ 0x8005 : crc << 1;
+  }
+}
+
+uint16_t rng_model_value(void) {
+  return crc;
+}
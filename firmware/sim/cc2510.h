@@ -0,0 +1,58 @@
+#ifndef _SIM_CC2510_H_
+#define _SIM_CC2510_H_
+
+#include <cc2510fx.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Model of the CC2510 around the firmware in host builds: interrupt
+// dispatch, the sleep timer on the host clock, the DMA controller, USART1 on
+// a pty, USART0 in SPI master mode, the AES coprocessor and the port pins. The registers are in
+// cc2510fx.h next to this, the radio has its own model in cc2510_radio.h.
+//
+// The firmware runs on the calling thread. The model only gets control in
+// the driver hooks and in PCON idle, that is when the scheduler has nothing
+// left to do: that is where it waits for the host clock and the pty, so a
+// tag that sleeps costs no CPU and many can run side by side.
+
+// registers to their reset values, the sleep timer starts at 0
+void cc2510_init(void);
+
+// nanoseconds on the host clock since cc2510_init
+uint64_t cc2510_now(void);
+
+// pins driven from outside, pin 0-7. Raises the port interrupt flags on the
+// edge selected in PICTL.
+void cc2510_port1_drive(uint8_t pin, bool level);
+
+// models that keep their own time, a panel holding BUSY: they run whenever
+// the firmware idles and return the nanoseconds until they need to run
+// again, UINT64_MAX for never
+typedef uint64_t (*IdleModel)(uint64_t now);
+void cc2510_idle_attach(IdleModel model);
+
+// USART1 on the master side of a pty. The fd survives cc2510_reset.
+void usart1_model_attach(int fd);
+// paces the link at baud, 8N1, 0 for as fast as the host allows
+void usart1_model_pace(uint32_t baud);
+// bytes sent are buffered until the firmware idles or this is called
+void usart1_model_flush(void);
+// waits at most timeout_ns for the pty and delivers what arrived, as the
+// RX DMA and the URX1 interrupt would
+void usart1_model_poll(uint64_t timeout_ns);
+
+// USART0 SPI master: every byte written goes to the slave, one at a time
+typedef void (*SpiSlave)(uint8_t data);
+void usart0_model_attach(SpiSlave slave);
+
+// DMA trigger raised by a peripheral model, DMA_TRIG_* in hal/dma.h
+void dma_model_trigger(uint8_t trigger);
+// a byte written to U1DBUF, by the TX DMA
+void usart1_model_send(uint8_t data);
+// ENCDO read, by the DMA
+uint8_t aes_model_read(void);
+// XDATA register reads and writes made by the DMA controller
+uint8_t cc2510_xreg_read(uint16_t address);
+void cc2510_xreg_write(uint16_t address, uint8_t value);
+
+#endif
@@ -0,0 +1,153 @@
+#include "cc2510.h"
+#include "aes128.h"
+#include "../src/hal/dma.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The AES coprocessor. ST in ENCCS starts one command: loading the key or
+// the IV takes 16 bytes on ENCDI, an encryption takes one 128-bit block in
+// and gives one out on ENCDO, none in CBC-MAC mode. The engine asks the DMA
+// for every byte with ENC_DW and ENC_UP, RDY and ENCIF are set once the
+// command is done. The next block needs ST again.
+//
+// What the chip does on a misuse is not documented, it is likely to hang a
+// driver: the model stops the process on ST while a command runs, data with
+// none running, decryption and the feedback modes, and a block in another
+// mode than the IV was loaded with. A CBC-MAC finishes with a CBC block.
+
+#define BLOCK_SIZE 16
+
+#define ENCCS_ST BV(0)
+#define ENCCS_CMD 0x06
+#define ENCCS_RDY BV(3)
+#define ENCCS_MODE 0x70
+
+#define CMD_ENCRYPT 0x00
+#define CMD_LOAD_KEY 0x04
+#define CMD_LOAD_IV 0x06
+
+#define MODE_CBC 0x00
+#define MODE_CTR 0x30
+#define MODE_ECB 0x40
+#define MODE_CBC_MAC 0x50
+#define MODE_NONE 0xFF // no IV loaded
+
+static struct {
+  enum { IDLE, DATA_IN, DATA_OUT } state;
+  uint8_t command, mode;
+  uint8_t iv_mode;
+  uint8_t chain[BLOCK_SIZE]; // CBC value or CTR counter
+  uint8_t in[BLOCK_SIZE], out[BLOCK_SIZE];
+  uint8_t count; // bytes moved of the block
+} aes = {.iv_mode = MODE_NONE};
+
+static void fail(const char *what) {
+  fprintf(stderr, "AES coprocessor: %s\n", what);
+  abort();
+}
+
+static void done(void) {
+  aes.state = IDLE;
+  ENCCS |= ENCCS_RDY;
+  ENCIF = 1;
+}
+
+static void encrypt(void) {
+  switch (aes.mode) {
+  case MODE_ECB:
+    aes128_encrypt(aes.in, aes.out);
+    break;
+  case MODE_CTR:
+    aes128_encrypt(aes.chain, aes.out);
+    for (uint8_t i = 0; i < BLOCK_SIZE; i++) {
+      aes.out[i] ^= aes.in[i];
+    }
+    for (uint8_t i = BLOCK_SIZE; i-- && !++aes.chain[i];) {
+    }
+    break;
+  default: // CBC and CBC-MAC
+    for (uint8_t i = 0; i < BLOCK_SIZE; i++) {
+      aes.chain[i] ^= aes.in[i];
+    }
+    aes128_encrypt(aes.chain, aes.chain);
+    memcpy(aes.out, aes.chain, BLOCK_SIZE);
+  }
+}
+
+void aes_model_command(uint8_t enccs) {
+  ENCCS = (ENCCS & ENCCS_RDY) | (enccs & (ENCCS_MODE | ENCCS_CMD));
+  if (!(enccs & ENCCS_ST)) {
+    return;
+  }
+  if (aes.state != IDLE) {
+    fail("ST while a command runs");
+  }
+  aes.command = enccs & ENCCS_CMD;
+  aes.mode = enccs & ENCCS_MODE;
+  switch (aes.command) {
+  case CMD_LOAD_KEY:
+    break;
+  case CMD_LOAD_IV:
+    aes.iv_mode = aes.mode;
+    break;
+  case CMD_ENCRYPT:
+    if (aes.mode != MODE_ECB && aes.mode != MODE_CBC && aes.mode != MODE_CTR && aes.mode != MODE_CBC_MAC) {
+      fail("CFB and OFB are not modelled");
+    }
+    if (aes.mode != MODE_ECB && aes.mode != aes.iv_mode && !(aes.mode == MODE_CBC && aes.iv_mode == MODE_CBC_MAC)) {
+      fail("block in another mode than the IV was loaded with");
+    }
+    break;
+  default:
+    fail("decryption is not modelled");
+  }
+  ENCCS &= ~ENCCS_RDY;
+  aes.state = DATA_IN;
+  aes.count = 0;
+  dma_model_trigger(DMA_TRIG_ENC_DW);
+}
+
+void aes_model_write(uint8_t data) {
+  ENCDI = data;
+  if (aes.state != DATA_IN) {
+    fail("ENCDI written with no command waiting for data");
+  }
+  aes.in[aes.count++] = data;
+  if (aes.count < BLOCK_SIZE) {
+    dma_model_trigger(DMA_TRIG_ENC_DW);
+    return;
+  }
+
+  switch (aes.command) {
+  case CMD_LOAD_KEY:
+    aes128_set_key(aes.in);
+    done();
+    return;
+  case CMD_LOAD_IV:
+    memcpy(aes.chain, aes.in, BLOCK_SIZE);
+    done();
+    return;
+  }
+  encrypt();
+  if (aes.mode == MODE_CBC_MAC) {
+    done();
+    return;
+  }
+  aes.state = DATA_OUT;
+  aes.count = 0;
+  dma_model_trigger(DMA_TRIG_ENC_UP);
+}
+
+uint8_t aes_model_read(void) {
+  if (aes.state != DATA_OUT) {
+    fail("ENCDO read with no block out");
+  }
+  ENCDO = aes.out[aes.count++];
+  if (aes.count < BLOCK_SIZE) {
+    dma_model_trigger(DMA_TRIG_ENC_UP);
+  } else {
+    done();
+  }
+  return ENCDO;
+}
@@ -0,0 +1,153 @@
+#include "cc2510.h"
+#include "../src/hal/dma.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Channels 1-4 of the DMA controller. Channel 0 is moved by the radio
+// model, it only shows up in DMAARM here. Fixed lengths only, VLEN is only
+// used by the radio.
+
+#define XDATA_REGISTERS 0xDF00
+
+// A register is set up by its address, a buffer by a host pointer whose low
+// 16 bits can land anywhere, in the register range too
+#define IS_REGISTER(p, x) ((uintptr_t)(p) == (x) && (x) >= XDATA_REGISTERS)
+
+typedef struct {
+  uint8_t *src, *dst; // NULL for a register
+  uint16_t src_x, dst_x;
+  uint16_t left; // transfers
+} Channel;
+
+static Channel channels[DMA_CHANNELS];
+static uint32_t pending;  // triggers raised, by DMA_TRIG_* number
+static uint8_t requested; // DMAREQ
+static bool running;
+
+static const DmaDesc *descriptor(uint8_t ch) {
+  return ch ? &DMA_DESC(ch) : &dma_desc0;
+}
+
+static void load(uint8_t ch) {
+  const DmaDesc *desc = descriptor(ch);
+  Channel *channel = &channels[ch];
+  channel->src_x = ((uint16_t)desc->src_h << 8) | desc->src_l;
+  channel->dst_x = ((uint16_t)desc->dst_h << 8) | desc->dst_l;
+  channel->src = IS_REGISTER(desc->src, channel->src_x) ? NULL : desc->src;
+  channel->dst = IS_REGISTER(desc->dst, channel->dst_x) ? NULL : desc->dst;
+  channel->left = ((uint16_t)(desc->len_h & 0x1F) << 8) | desc->len_l;
+}
+
+// bytes to move the address by after each transfer
+static int8_t increment(uint8_t mode, uint8_t size) {
+  switch (mode) {
+  case 0:
+    return 0;
+  case 1:
+    return size;
+  case 2:
+    return 2 * size;
+  default:
+    return -size;
+  }
+}
+
+static void complete(uint8_t ch) {
+  const DmaDesc *desc = descriptor(ch);
+  DMAIRQ |= BV(ch);
+  if (desc->cfg1 & DMA_IRQMASK) {
+    DMAIF = 1;
+  }
+  if ((desc->cfg0 & 0x60) >= DMA_TMODE_REPEATED_SINGLE) {
+    load(ch);
+  } else {
+    DMAARM &= ~BV(ch);
+  }
+}
+
+static void transfer(uint8_t ch) {
+  const DmaDesc *desc = descriptor(ch);
+  Channel *channel = &channels[ch];
+  uint8_t size = desc->cfg0 & DMA_WORDSIZE_WORD ? 2 : 1;
+  int8_t src_step = increment(desc->cfg1 >> 6, size);
+  int8_t dst_step = increment((desc->cfg1 >> 4) & 3, size);
+  uint16_t count = (desc->cfg0 & 0x20) ? channel->left : 1; // block or single
+
+  while (count-- && channel->left) {
+    for (uint8_t i = 0; i < size; i++) {
+      uint8_t value = channel->src ? channel->src[i] : cc2510_xreg_read(channel->src_x + i);
+      if (channel->dst) {
+        channel->dst[i] = value;
+      } else {
+        cc2510_xreg_write(channel->dst_x + i, value);
+      }
+    }
+    if (channel->src) {
+      channel->src += src_step;
+    }
+    if (channel->dst) {
+      channel->dst += dst_step;
+    }
+    if (!--channel->left) {
+      complete(ch);
+      if (ch + 1 < DMA_CHANNELS && (DMAARM & BV(ch + 1)) && (descriptor(ch + 1)->cfg0 & 0x1F) == DMA_TRIG_PREV) {
+        transfer(ch + 1);
+      }
+    }
+  }
+}
+
+// triggers raised by the transfers themselves, a TX byte freeing the
+// USART for the next one, are handled in the same loop
+static void run(void) {
+  if (running) {
+    return;
+  }
+  running = true;
+  while (requested || pending) {
+    if (requested) {
+      uint8_t ch = __builtin_ctz(requested);
+      requested &= ~BV(ch);
+      if (DMAARM & BV(ch)) {
+        transfer(ch);
+      }
+    } else {
+      uint8_t trigger = __builtin_ctz(pending);
+      pending &= ~(1UL << trigger);
+      for (uint8_t ch = 1; ch < DMA_CHANNELS; ch++) {
+        if ((DMAARM & BV(ch)) && (descriptor(ch)->cfg0 & 0x1F) == trigger) {
+          transfer(ch);
+        }
+      }
+    }
+  }
+  running = false;
+}
+
+void dma_model_trigger(uint8_t trigger) {
+  pending |= 1UL << trigger;
+  run();
+}
+
+void dma_model_arm(uint8_t mask) {
+  for (uint8_t ch = 0; ch < DMA_CHANNELS; ch++) {
+    if (mask & BV(ch)) {
+      load(ch);
+    }
+  }
+  DMAARM |= mask;
+}
+
+void dma_model_abort(uint8_t mask) {
+  DMAARM &= ~mask;
+}
+
+void dma_model_request(uint8_t mask) {
+  requested |= mask & ~BV(DMA_CH_RADIO);
+  run();
+  cc2510_interrupts();
+}
+
+void dma_model_clear_irq(uint8_t mask) {
+  DMAIRQ &= ~mask;
+}
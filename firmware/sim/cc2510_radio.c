@@ -0,0 +1,125 @@
+#include "cc2510_radio.h"
+#include "../src/hal/dma.h"
+#include "../src/hal/isr.h"
+#include <string.h>
+
+#define MARC_IDLE 0x01
+#define MARC_RX 0x0D
+#define MARC_RX_OVERFLOW 0x11
+#define MARC_TX 0x13
+
+#define STROBE_SRX 0x02
+#define STROBE_STX 0x03
+#define STROBE_SIDLE 0x04
+
+#define IRQ_DONE 0x10
+#define IRQ_RXOVF 0x40
+
+static uint8_t *dma_buffer;
+static bool dma_armed;
+static uint8_t sent[256];
+static uint8_t sent_size;
+static uint8_t rfif; // RFIF bits are cleared by writing 0, ones written are ignored
+
+static uint16_t dma_length(void) {
+  return ((dma_desc0.len_h & 0x1F) << 8) | dma_desc0.len_l;
+}
+
+// the interrupt waits for EA like the others, the flags the firmware cleared
+// in the meantime are taken from RFIF first
+static void raise(uint8_t flags) {
+  rfif &= RFIF;
+  rfif |= flags;
+  RFIF = rfif;
+  DMAARM = (DMAARM & ~0x01) | (dma_armed ? 0x01 : 0x00);
+  if (RFIM & flags) {
+    S1CON |= 0x03;
+    cc2510_interrupts();
+  }
+  rfif &= RFIF;
+}
+
+void radio_model_dma(uint8_t *buffer) {
+  dma_buffer = buffer;
+  dma_armed = true;
+}
+
+void radio_model_strobe(uint8_t strobe) {
+  switch (strobe) {
+  case STROBE_SIDLE:
+    // the driver re-arms the DMA after every idle
+    dma_armed = false;
+    MARCSTATE = MARC_IDLE;
+    break;
+  case STROBE_SRX:
+    if (MARCSTATE != MARC_RX_OVERFLOW) {
+      MARCSTATE = MARC_RX;
+    }
+    break;
+  case STROBE_STX:
+    if (!dma_armed) {
+      break;
+    }
+    MARCSTATE = MARC_TX;
+    sent_size = dma_length();
+    memcpy(sent, dma_buffer, sent_size);
+    dma_armed = false;
+    // MCSM1 TXOFF_MODE idle
+    MARCSTATE = MARC_IDLE;
+    raise(IRQ_DONE);
+    break;
+  }
+}
+
+static bool address_match(uint8_t address) {
+  switch (PKTCTRL1 & 0x03) {
+  case 0:
+    return true;
+  case 1:
+    return address == ADDR;
+  case 2:
+    return address == ADDR || address == 0x00;
+  default:
+    return address == ADDR || address == 0x00 || address == 0xFF;
+  }
+}
+
+bool radio_model_receive(const uint8_t *packet, uint8_t rssi, bool crc_ok) {
+  uint8_t length = packet[0];
+  if (MARCSTATE != MARC_RX) {
+    return false;
+  }
+  if (!dma_armed) {
+    MARCSTATE = MARC_RX_OVERFLOW;
+    raise(IRQ_RXOVF);
+    return false;
+  }
+  if (!length || length > PKTLEN || !address_match(packet[1])) {
+    // dropped after the length and address bytes were read
+    memcpy(dma_buffer, packet, 2);
+    raise(IRQ_DONE);
+    return false;
+  }
+
+  // the length byte, the rest of the packet and the two status bytes,
+  // unless the DMA runs out of LEN first
+  uint8_t received[258];
+  uint16_t size = length + 3;
+  memcpy(received, packet, length + 1);
+  received[length + 1] = rssi;
+  received[length + 2] = (crc_ok ? 0x80 : 0x00) | 0x20;
+  if (size > dma_length()) {
+    size = dma_length();
+  }
+  memcpy(dma_buffer, received, size);
+  dma_armed = false;
+  raise(IRQ_DONE);
+  return crc_ok;
+}
+
+uint8_t radio_model_sent(uint8_t *packet) {
+  uint8_t size = sent_size;
+  memcpy(packet, sent, size);
+  sent_size = 0;
+  return size;
+}
@@ -0,0 +1,24 @@
+#ifndef _SIM_CC2510_RADIO_H_
+#define _SIM_CC2510_RADIO_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Model of the CC2510 radio registers for host builds. hal/radio.c strobes
+// through radio_model_strobe and reports the buffer behind every DMA channel 0
+// arm, the model moves packets through it as the radio and DMA would and
+// raises the RF interrupt, taken once EA allows it.
+
+void radio_model_strobe(uint8_t strobe);
+void radio_model_dma(uint8_t *buffer);
+
+// a packet on air, length | address | payload, received if the radio is in
+// RX and passes the length and address filters. False when it was dropped
+// or failed its CRC.
+bool radio_model_receive(const uint8_t *packet, uint8_t rssi, bool crc_ok);
+
+// copies out the last packet sent, returns its size with the length byte
+// or 0 when nothing was sent since the last call
+uint8_t radio_model_sent(uint8_t *packet);
+
+#endif
@@ -0,0 +1,205 @@
+#define _GNU_SOURCE
+#include "cc2510.h"
+#include "../src/hal/dma.h"
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+// USART1 in UART mode on a pty and USART0 in SPI master mode. Bytes move as
+// fast as the host allows unless usart1_model_pace() gave a baud rate. A
+// host that does not read the pty loses what does not fit, and while no host
+// has it open what is sent is lost, like on a serial line: a new session does
+// not get the frames the tag kept retransmitting to the last one.
+
+#define UCSR_RE BV(6)
+#define UCSR_RX_BYTE BV(2)
+#define SLEEP_MODE 0x03 // PM1-PM3 stop the crystal
+#define HANGUP_POLL_MS 20 // how often a closed pty is checked for a new host
+#define BITS_PER_BYTE 10  // start, 8 data, stop
+// unpaced, bytes handed to the RX DMA per poll: at once, a host write could
+// lap the RX ring before the firmware runs, no baud rate allows that
+#define RX_BURST 32
+
+static int fd = -1;
+static uint8_t tx[4096];
+static uint16_t tx_size;
+static uint8_t rx[256];
+static uint16_t rx_head, rx_size;
+// pacing: a byte's time on the wire, 0 for none. TX bytes are buffered
+// with the time their stop bit goes out and written from then on, RX bytes
+// are handed to the DMA one byte time apart.
+static uint64_t byte_ns;
+static uint64_t tx_due[sizeof(tx)];
+static uint16_t tx_sent;         // bytes of tx written to the pty already
+static uint64_t tx_free, rx_free; // cc2510_now() at which the wire is idle
+static uint64_t rx_start;         // when rx[0] started arriving
+static bool attached; // a host had the pty open at the last poll
+static SpiSlave spi_slave;
+
+void usart0_model_attach(SpiSlave slave) {
+  spi_slave = slave;
+}
+
+void usart0_model_write(uint8_t data) {
+  U0DBUF = data;
+  UTX0IF = 1;
+  if (spi_slave) {
+    spi_slave(data);
+  }
+}
+
+void usart1_model_attach(int pty) {
+  fd = pty;
+  attached = true;
+  tx_size = tx_sent = 0;
+  rx_head = rx_size = 0;
+}
+
+void usart1_model_pace(uint32_t baud) {
+  byte_ns = baud ? BITS_PER_BYTE * 1000000000ULL / baud : 0;
+}
+
+// no host has the slave end open
+static bool hung_up(void) {
+  struct pollfd pty = {fd, 0, 0};
+  return poll(&pty, 1, 0) > 0 && (pty.revents & POLLHUP);
+}
+
+// the pty keeps what the last host left unread for the next one, a serial
+// port would not
+static void drop_unread(void) {
+  int slave = open(ptsname(fd), O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if (slave >= 0) {
+    tcflush(slave, TCIFLUSH);
+    close(slave);
+  }
+}
+
+// writes the buffered bytes up to count
+static void tx_write(uint16_t count) {
+  if (count > tx_sent && !hung_up()) {
+    ssize_t written = write(fd, tx + tx_sent, count - tx_sent);
+    (void)written;
+  }
+  tx_sent = count;
+  if (tx_sent == tx_size) {
+    tx_size = tx_sent = 0;
+  }
+}
+
+void usart1_model_flush(void) {
+  tx_write(tx_size);
+}
+
+// the paced bytes whose time has come
+static void tx_release(uint64_t now) {
+  uint16_t count = tx_sent;
+  while (count < tx_size && tx_due[count] <= now) {
+    count++;
+  }
+  tx_write(count);
+}
+
+void usart1_model_send(uint8_t data) {
+  U1DBUF = data;
+  if (fd >= 0) {
+    if (tx_size == sizeof(tx)) {
+      usart1_model_flush();
+    }
+    if (byte_ns) {
+      uint64_t now = cc2510_now();
+      tx_free = (tx_free > now ? tx_free : now) + byte_ns;
+      tx_due[tx_size] = tx_free;
+    }
+    tx[tx_size++] = data;
+  }
+  // the byte leaves at once, the next one can follow
+  UTX1IF = 1;
+  dma_model_trigger(DMA_TRIG_UTX1);
+}
+
+static uint64_t rx_due(uint16_t index) {
+  return rx_start + (index + 1) * byte_ns;
+}
+
+static uint64_t earlier(uint64_t wait, uint64_t due, uint64_t now) {
+  uint64_t left = due > now ? due - now : 0;
+  return left < wait ? left : wait;
+}
+
+void usart1_model_poll(uint64_t timeout_ns) {
+  uint64_t now = cc2510_now();
+  if (!byte_ns) {
+    usart1_model_flush();
+    if (rx_head < rx_size) {
+      timeout_ns = 0;
+    }
+  } else {
+    tx_release(now);
+    if (tx_size) {
+      timeout_ns = earlier(timeout_ns, tx_due[tx_sent], now);
+    }
+    if (rx_head < rx_size) {
+      timeout_ns = earlier(timeout_ns, rx_due(rx_head), now);
+    }
+  }
+  if (rx_head < rx_size) {
+    // the next byte is still on its way
+    if (timeout_ns) {
+      struct timespec wait = {timeout_ns / 1000000000, timeout_ns % 1000000000};
+      ppoll(NULL, 0, &wait, NULL);
+    }
+  } else {
+    struct pollfd pty = {fd, POLLIN, 0};
+    struct timespec wait = {timeout_ns / 1000000000, timeout_ns % 1000000000};
+    int ready = ppoll(&pty, 1, timeout_ns == UINT64_MAX ? NULL : &wait, NULL);
+    uint64_t timeout_ms = timeout_ns / 1000000;
+    int timeout = timeout_ns == UINT64_MAX ? -1 : timeout_ms > INT_MAX ? INT_MAX : (int)timeout_ms;
+    if (ready > 0 && (pty.revents & POLLHUP)) {
+      if (attached) {
+        attached = false;
+        drop_unread();
+      }
+      // a hangup is reported at once until a host comes back, wait anyway
+      poll(NULL, 0, timeout < 0 || timeout > HANGUP_POLL_MS ? HANGUP_POLL_MS : timeout);
+    } else {
+      attached = true;
+      if (ready > 0 && (pty.revents & POLLIN)) {
+        ssize_t size = read(fd, rx, sizeof(rx));
+        rx_head = 0;
+        rx_size = size > 0 ? size : 0;
+        now = cc2510_now();
+        rx_start = rx_free > now ? rx_free : now;
+        rx_free = rx_start + rx_size * byte_ns;
+      }
+    }
+  }
+
+  if (byte_ns) {
+    now = cc2510_now();
+    tx_release(now);
+  }
+  uint8_t burst = 0;
+  while (rx_head < rx_size && (byte_ns ? rx_due(rx_head) <= now : burst++ < RX_BURST)) {
+    uint8_t data = rx[rx_head++];
+    if (SLEEP & SLEEP_MODE) {
+      // without the crystal the byte is lost, its start bit is a falling
+      // edge on P0.5 that wakes the chip
+      if (PICTL & BV(4)) {
+        P0IFG |= BV(5);
+        P0IF = 1;
+      }
+      return;
+    }
+    if (U1CSR & UCSR_RE) {
+      U1DBUF = data;
+      U1CSR |= UCSR_RX_BYTE;
+      URX1IF = 1;
+      dma_model_trigger(DMA_TRIG_URX1);
+      cc2510_interrupts();
+    }
+  }
+}
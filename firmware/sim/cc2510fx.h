@@ -0,0 +1,103 @@
+#ifndef _SIM_CC2510FX_H_
+#define _SIM_CC2510FX_H_
+
+#include <stdint.h>
+
+// Stands in for SDCC's cc2510fx.h in host builds, found first through -Isim.
+// Registers are plain variables, the firmware reads and writes them as it
+// would on the chip. Where a write has to start something (a DMA transfer,
+// a byte on the SPI bus, idle mode) the driver calls the model instead, see
+// the #ifndef BUILD branches in src/hal. Reads that have to show the current
+// state (the sleep timer count) are macros into the model. sim/cc2510.h is
+// the runner side.
+
+#define CC2510_SFRS(X)                                                                                        \
+  X(P0) X(P1) X(P2) X(SP) X(DPL0) X(DPH0) X(DPL1) X(DPH1) X(DPS) X(MPAGE) X(ENDIAN) X(PCON) X(TCON) X(S0CON) \
+  X(S1CON) X(IRCON) X(IRCON2) X(IEN0) X(IEN1) X(IEN2) X(IP0) X(IP1) X(ACC) X(B) X(PSW)                      \
+  X(P0IFG) X(P1IFG) X(P2IFG) X(PICTL) X(P1IEN) X(P0INP) X(P1INP) X(P2INP) X(P0SEL) X(P1SEL) X(P2SEL)       \
+  X(P0DIR) X(P1DIR) X(P2DIR) X(PERCFG) X(ADCCFG)                                                             \
+  X(WORIRQ) X(WORCTRL) X(WOREVT0) X(WOREVT1) X(WORTIME1) X(SLEEP) X(CLKCON) X(MEMCTR) X(WDCTL)              \
+  X(FWT) X(FADDRL) X(FADDRH) X(FCTL) X(FWDATA) X(ENCDI) X(ENCDO) X(ENCCS)                                   \
+  X(ADCCON1) X(ADCCON2) X(ADCCON3) X(ADCL) X(ADCH) X(RNDL) X(RNDH)                                          \
+  X(U0CSR) X(U0DBUF) X(U0BAUD) X(U0UCR) X(U0GCR) X(U1CSR) X(U1DBUF) X(U1BAUD) X(U1UCR) X(U1GCR)             \
+  X(T1CC0L) X(T1CC0H) X(T1CC1L) X(T1CC1H) X(T1CC2L) X(T1CC2H) X(T1CNTL) X(T1CNTH) X(T1CTL) X(T1CCTL0)       \
+  X(T1CCTL1) X(T1CCTL2) X(T2CT) X(T2PR) X(T2CTL) X(T2THD) X(T2TLD) X(T2CMP) X(T3CNT) X(T3CTL) X(T3CCTL0)    \
+  X(T3CC0) X(T3CCTL1) X(T3CC1) X(T4CNT) X(T4CTL) X(T4CCTL0) X(T4CC0) X(T4CCTL1) X(T4CC1) X(TIMIF)           \
+  X(ST0) X(ST1) X(ST2) X(DMAIRQ) X(DMA0CFGL) X(DMA0CFGH) X(DMA1CFGL) X(DMA1CFGH) X(DMAARM) X(DMAREQ)        \
+  X(RFD) X(RFST) X(RFIF) X(RFIM)
+
+// radio registers, XDATA on the chip
+#define CC2510_XREGS(X)                                                                                       \
+  X(SYNC1) X(SYNC0) X(PKTLEN) X(PKTCTRL1) X(PKTCTRL0) X(ADDR) X(CHANNR) X(FSCTRL1) X(FSCTRL0) X(FREQ2)       \
+  X(FREQ1) X(FREQ0) X(MDMCFG4) X(MDMCFG3) X(MDMCFG2) X(MDMCFG1) X(MDMCFG0) X(DEVIATN) X(MCSM2) X(MCSM1)     \
+  X(MCSM0) X(FOCCFG) X(BSCFG) X(AGCCTRL2) X(AGCCTRL1) X(AGCCTRL0) X(FREND1) X(FREND0) X(FSCAL3) X(FSCAL2)   \
+  X(FSCAL1) X(FSCAL0) X(TEST2) X(TEST1) X(TEST0) X(PA_TABLE0) X(IOCFG2) X(IOCFG1) X(IOCFG0) X(PARTNUM)      \
+  X(VERSION) X(FREQEST) X(LQI) X(RSSI) X(MARCSTATE) X(PKTSTATUS) X(VCO_VC_DAC)
+
+// bit addressable ones, separate variables from the byte registers
+#define CC2510_BITS(X)                                                                                        \
+  X(P0_0) X(P0_1) X(P0_2) X(P0_3) X(P0_4) X(P0_5) X(P0_6) X(P0_7) X(P1_0) X(P1_1) X(P1_2) X(P1_3) X(P1_4)   \
+  X(P1_5) X(P1_6) X(P1_7) X(P2_0) X(P2_1) X(P2_2) X(P2_3) X(P2_4) X(IT0) X(RFTXRXIF) X(IT1) X(URX0IF)       \
+  X(ADCIF) X(URX1IF) X(ENCIF) X(RFTXRXIE) X(ADCIE) X(URX0IE) X(URX1IE) X(ENCIE) X(STIE) X(EA) X(DMAIE)      \
+  X(T1IE) X(T2IE) X(T3IE) X(T4IE) X(P0IE) X(DMAIF) X(T1IF) X(T2IF) X(T3IF) X(T4IF) X(P0IF) X(STIF) X(P1IF)   \
+  X(UTX1IF) X(UTX0IF) X(P2IF) X(WDTIF) X(T3OVFIF) X(CY) X(AC) X(F0) X(RS1) X(RS0) X(OV) X(F1) X(P)
+
+#define CC2510_EXTERN(name) extern volatile uint8_t name;
+CC2510_SFRS(CC2510_EXTERN)
+CC2510_XREGS(CC2510_EXTERN)
+CC2510_BITS(CC2510_EXTERN)
+
+// reading WORTIME0 latches WORTIME1, as on the chip
+uint8_t cc2510_wortime0(void);
+#define WORTIME0 (cc2510_wortime0())
+
+#define RFTXRX_VECTOR 0
+#define ADC_VECTOR 1
+#define URX0_VECTOR 2
+#define URX1_VECTOR 3
+#define ENC_VECTOR 4
+#define ST_VECTOR 5
+#define P2INT_VECTOR 6
+#define UTX0_VECTOR 7
+#define DMA_VECTOR 8
+#define T1_VECTOR 9
+#define T2_VECTOR 10
+#define T3_VECTOR 11
+#define T4_VECTOR 12
+#define P0INT_VECTOR 13
+#define UTX1_VECTOR 14
+#define P1INT_VECTOR 15
+#define RF_VECTOR 16
+#define WDT_VECTOR 17
+
+#define NOP()
+
+// register side effects, called by the drivers in host builds
+
+// takes the pending interrupts that are enabled, if EA is set
+void cc2510_interrupts(void);
+// PCON idle: returns after at least one interrupt ran
+void cc2510_idle(void);
+// the watchdog runs out, the model restarts the process
+void cc2510_reset(void);
+
+// DMAARM bits set, DMAARM abort writes, DMAREQ bits set and DMAIRQ flags
+// cleared (writing 0 clears a flag on the chip, 1 leaves it)
+void dma_model_arm(uint8_t channels);
+void dma_model_abort(uint8_t channels);
+void dma_model_request(uint8_t channels);
+void dma_model_clear_irq(uint8_t channels);
+
+// U0DBUF written in SPI master mode, the byte is clocked out right away
+void usart0_model_write(uint8_t data);
+
+// ENCCS and ENCDI written by the CPU, the AES coprocessor runs the command
+void aes_model_command(uint8_t enccs);
+void aes_model_write(uint8_t data);
+
+// the random number generator as CRC16 unit, see hal/crc.h
+void rng_model_seed(uint8_t value); // RNDL
+void rng_model_update(uint8_t value); // RNDH
+uint16_t rng_model_value(void);
+
+#endif
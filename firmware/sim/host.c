@@ -0,0 +1,140 @@
+#define _GNU_SOURCE
+#include "cc2510.h"
+#include "il0373.h"
+#include "nt3h2111.h"
+#include "w25x10.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <termios.h>
+#include <unistd.h>
+
+// The firmware as a host process, see `make sim`. The serial link is a pty,
+// its path goes to stdout. A watchdog reset starts the process over, the
+// pty and the flash contents are handed down through the environment.
+//
+//   firmware.sim [--pty <link>] [--flash <file>] [--baud <rate>] [--panel <dir>]
+//                [--panel-time <scale>]
+//
+// --pty also makes a symlink to the pty, --flash keeps the SPI flash in a
+// file instead of memory. --baud paces the serial link at that rate.
+// --panel writes every refresh of the display to dir, see il0373.h,
+// --panel-time scales how long the display stays busy.
+
+// the Makefile renames main() in every file, for src/main.c
+#undef main
+
+#define ENV_PTY "CC2510_PTY_FD"
+#define ENV_FLASH "CC2510_FLASH_FD"
+
+void firmware_main(void); // src/main.c, renamed by the Makefile
+
+static char **arguments;
+static char executable[4096];
+
+static int inherited(const char *name) {
+  const char *value = getenv(name);
+  return value ? atoi(value) : -1;
+}
+
+static void fail(const char *what) {
+  perror(what);
+  exit(1);
+}
+
+static int open_pty(const char *link) {
+  int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master < 0 || grantpt(master) || unlockpt(master)) {
+    fail("pty");
+  }
+  const char *name = ptsname(master);
+  // raw mode stays with the pty after this is closed, a host need not set it
+  int slave = open(name, O_RDWR | O_NOCTTY);
+  struct termios raw;
+  if (slave < 0 || tcgetattr(slave, &raw)) {
+    fail(name);
+  }
+  cfmakeraw(&raw);
+  tcsetattr(slave, TCSANOW, &raw);
+  close(slave);
+  fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+
+  if (link) {
+    unlink(link);
+    if (symlink(name, link)) {
+      fail(link);
+    }
+  }
+  printf("%s\n", name);
+  fflush(stdout);
+  return master;
+}
+
+// the fds are not close-on-exec and main put them in the environment
+void cc2510_reset(void) {
+  usart1_model_flush();
+  execv(executable, arguments);
+  fail("reset");
+}
+
+int main(int argc, char **argv) {
+  const char *link = NULL;
+  const char *flash = NULL;
+  const char *panel = NULL;
+  double panel_time = 1.0;
+  uint32_t baud = 0;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--pty") && i + 1 < argc) {
+      link = argv[++i];
+    } else if (!strcmp(argv[i], "--flash") && i + 1 < argc) {
+      flash = argv[++i];
+    } else if (!strcmp(argv[i], "--baud") && i + 1 < argc) {
+      baud = strtoul(argv[++i], NULL, 10);
+    } else if (!strcmp(argv[i], "--panel") && i + 1 < argc) {
+      panel = argv[++i];
+    } else if (!strcmp(argv[i], "--panel-time") && i + 1 < argc) {
+      panel_time = atof(argv[++i]);
+    } else {
+      fprintf(stderr,
+              "usage: %s [--pty <link>] [--flash <file>] [--baud <rate>] [--panel <dir>] [--panel-time <scale>]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+  arguments = argv;
+  // resolved now, exec of /proc/self/exe would rename the process "exe"
+  ssize_t length = readlink("/proc/self/exe", executable, sizeof(executable) - 1);
+  if (length < 0) {
+    fail("/proc/self/exe");
+  }
+  executable[length] = 0;
+
+  int pty = inherited(ENV_PTY);
+  int storage = inherited(ENV_FLASH);
+  if (pty < 0) {
+    char value[12];
+    pty = open_pty(link);
+    snprintf(value, sizeof(value), "%d", pty);
+    setenv(ENV_PTY, value, 1);
+  }
+  if (storage < 0) {
+    char value[12];
+    storage = flash ? open(flash, O_RDWR | O_CREAT, 0644) : memfd_create("w25x10", 0);
+    if (storage < 0) {
+      fail(flash ? flash : "flash");
+    }
+    snprintf(value, sizeof(value), "%d", storage);
+    setenv(ENV_FLASH, value, 1);
+  }
+
+  cc2510_init();
+  w25x10_model_init(storage);
+  nt3h_model_init();
+  il0373_model_init(panel, panel_time);
+  usart1_model_attach(pty);
+  usart1_model_pace(baud);
+  firmware_main();
+  return 0;
+}
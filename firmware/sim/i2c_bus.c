@@ -0,0 +1,58 @@
+#include "i2c_bus.h"
+#include <stddef.h>
+
+static I2cSlave *slaves = NULL;
+static bool master_sda = true;
+static bool master_scl = true;
+
+void i2c_bus_attach(I2cSlave *slave) {
+  slave->sda = true;
+  slave->scl = true;
+  slave->next = slaves;
+  slaves = slave;
+}
+
+void i2c_bus_detach(I2cSlave *slave) {
+  for (I2cSlave **link = &slaves; *link; link = &(*link)->next) {
+    if (*link == slave) {
+      *link = slave->next;
+      return;
+    }
+  }
+}
+
+bool i2c_bus_read_sda(void) {
+  bool level = master_sda;
+  for (I2cSlave *slave = slaves; slave; slave = slave->next) {
+    level = level && slave->sda;
+  }
+  return level;
+}
+
+bool i2c_bus_read_scl(void) {
+  bool level = master_scl;
+  for (I2cSlave *slave = slaves; slave; slave = slave->next) {
+    level = level && slave->scl;
+  }
+  return level;
+}
+
+static void i2c_bus_notify(void) {
+  for (I2cSlave *slave = slaves; slave; slave = slave->next) {
+    slave->on_change(slave, i2c_bus_read_scl(), i2c_bus_read_sda());
+  }
+}
+
+void i2c_bus_sda(bool level) {
+  if (master_sda != level) {
+    master_sda = level;
+    i2c_bus_notify();
+  }
+}
+
+void i2c_bus_scl(bool level) {
+  if (master_scl != level) {
+    master_scl = level;
+    i2c_bus_notify();
+  }
+}
@@ -0,0 +1,28 @@
+#ifndef _SIM_I2C_BUS_H_
+#define _SIM_I2C_BUS_H_
+
+#include <stdbool.h>
+
+// Simulated open drain I2C bus for host builds. The firmware's bit-banged
+// master drives it through hal/i2c.c, slave models attach to it and are
+// told about every change of the lines.
+
+typedef struct I2cSlave {
+  // called after every change driven by the master, scl and sda are the
+  // resulting bus levels
+  void (*on_change)(struct I2cSlave *slave, bool scl, bool sda);
+  bool sda; // level the slave drives, true = released
+  bool scl;
+  struct I2cSlave *next;
+} I2cSlave;
+
+void i2c_bus_attach(I2cSlave *slave);
+void i2c_bus_detach(I2cSlave *slave);
+
+// master side
+void i2c_bus_sda(bool level);
+void i2c_bus_scl(bool level);
+bool i2c_bus_read_sda(void);
+bool i2c_bus_read_scl(void);
+
+#endif
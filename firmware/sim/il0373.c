@@ -0,0 +1,411 @@
+#include "il0373.h"
+#include "cc2510.h"
+#include <stdio.h>
+#include <string.h>
+
+#define CMD_PSR 0x00   // panel setting
+#define CMD_POF 0x02   // power off
+#define CMD_PON 0x04   // power on
+#define CMD_DSLP 0x07  // deep sleep, with DSLP_CHECK
+#define CMD_DTM1 0x10  // black plane
+#define CMD_DRF 0x12   // display refresh
+#define CMD_DTM2 0x13  // red plane
+#define CMD_LUTC 0x20  // VCOM LUT, then LUTWW, LUTR, LUTW, LUTB
+#define CMD_PLL 0x30   // frame rate
+#define CMD_TRES 0x61  // resolution
+#define CMD_PTL 0x90   // partial window
+#define CMD_PTIN 0x91  // partial in
+#define CMD_PTOUT 0x92 // partial out
+
+#define DSLP_CHECK 0xA5
+#define PSR_REG_EN 0x20 // LUTs from the registers, not the OTP
+#define PSR_UD 0x08     // scan up, clear flips the frame vertically
+#define PSR_SHL 0x04    // shift right, clear flips it horizontally
+#define PSR_DEFAULT 0x0F
+
+#define MAX_HRES 160
+#define MAX_VRES 296
+#define ROW_BYTES (MAX_HRES / 8)
+
+#define LUTS 5
+#define LUT_SIZE 44 // the VCOM LUT, the others are 42
+#define LUT_GROUPS 7
+#define LUT_GROUP_SIZE 6 // level select, four phase lengths in frames, repeats
+
+// estimates, the controller datasheet gives no figures for most of them
+#define RESET_BUSY_MS 2
+#define POWER_ON_MS 60
+#define POWER_OFF_MS 20
+#define OTP_REFRESH_MS 15000
+#define FRAME_HZ_DEFAULT 50
+
+#define XOSC_HZ 26000000.0
+
+// the panel pins, see display/epd.c
+#define PIN_PWR P0_0   // low powers the panel
+#define PIN_CS P0_1    // low selects
+#define PIN_DC P1_2    // low for a command
+#define PIN_RESET P2_0 // low resets
+#define BUSY_PIN 3     // P1_3, low while busy
+
+#define NS_PER_MS 1000000ULL
+
+static struct {
+  bool powered;
+  bool in_reset;
+  bool asleep;
+  uint64_t busy_until; // cc2510_now(), 0 when not busy
+
+  uint8_t command;
+  uint16_t param; // parameter bytes since the command
+  uint8_t psr;
+  uint16_t hres, vres;
+  bool tres_set;
+  uint8_t pll;
+  uint8_t ptl[7];
+  bool partial;
+  uint8_t lut[LUTS][LUT_SIZE];
+  uint8_t frame[2][MAX_VRES * ROW_BYTES]; // black, red: a set bit is white
+} chip;
+
+static struct {
+  uint32_t updates;
+  uint32_t commands;
+  uint32_t bytes;
+  uint32_t by_command[256];
+} stats;
+
+static const char *out_dir;
+static double scale = 1.0;
+
+static void reset(void) {
+  chip.asleep = false;
+  chip.command = 0;
+  chip.param = 0;
+  chip.psr = PSR_DEFAULT;
+  chip.tres_set = false;
+  chip.pll = 0;
+  chip.partial = false;
+  memset(chip.ptl, 0, sizeof(chip.ptl));
+  memset(chip.lut, 0, sizeof(chip.lut));
+  memset(chip.frame, 0xFF, sizeof(chip.frame));
+}
+
+static void busy_for(uint64_t ms) {
+  chip.busy_until = cc2510_now() + (uint64_t)(ms * NS_PER_MS * scale);
+}
+
+// the resolution set by TRES, otherwise the one the panel setting selects
+static void resolution(uint16_t *hres, uint16_t *vres) {
+  static const uint16_t sizes[4][2] = {{96, 230}, {96, 252}, {128, 296}, {160, 296}};
+  if (chip.tres_set) {
+    *hres = chip.hres > MAX_HRES ? MAX_HRES : chip.hres;
+    *vres = chip.vres > MAX_VRES ? MAX_VRES : chip.vres;
+  } else {
+    *hres = sizes[chip.psr >> 6][0];
+    *vres = sizes[chip.psr >> 6][1];
+  }
+}
+
+static uint32_t frame_hz(void) {
+  switch (chip.pll) {
+  case 0x3A:
+    return 100;
+  case 0x29:
+    return 150;
+  case 0x31:
+    return 171;
+  case 0x39:
+    return 200;
+  default:
+    return FRAME_HZ_DEFAULT; // 0x3C
+  }
+}
+
+// the VCOM LUT runs every phase of every group, repeated
+static uint32_t refresh_ms(void) {
+  if (!(chip.psr & PSR_REG_EN)) {
+    return OTP_REFRESH_MS;
+  }
+  uint32_t frames = 0;
+  for (uint8_t group = 0; group < LUT_GROUPS; group++) {
+    const uint8_t *entry = &chip.lut[0][group * LUT_GROUP_SIZE];
+    frames += (entry[1] + entry[2] + entry[3] + entry[4]) * entry[5];
+  }
+  return frames * 1000 / frame_hz();
+}
+
+// a data byte of a plane goes to the next byte of the window
+static void store(uint8_t plane, uint16_t index, uint8_t data) {
+  uint16_t hres, vres;
+  resolution(&hres, &vres);
+  uint16_t x0 = 0, x1 = hres - 1, y0 = 0, y1 = vres - 1;
+  if (chip.partial) {
+    x0 = chip.ptl[0] & 0xF8;
+    x1 = chip.ptl[1] | 0x07;
+    y0 = ((chip.ptl[2] & 1) << 8) | chip.ptl[3];
+    y1 = ((chip.ptl[4] & 1) << 8) | chip.ptl[5];
+  }
+  if (x1 < x0 || y1 < y0) {
+    return;
+  }
+  uint16_t window_bytes = (x1 - x0 + 1) / 8;
+  uint16_t y = y0 + index / window_bytes;
+  uint16_t column = x0 / 8 + index % window_bytes;
+  if (y <= y1 && y < MAX_VRES && column < ROW_BYTES) {
+    chip.frame[plane][y * ROW_BYTES + column] = data;
+  }
+}
+
+static uint32_t crc32(uint32_t crc, const uint8_t *data, size_t length) {
+  crc = ~crc;
+  while (length--) {
+    crc ^= *data++;
+    for (uint8_t i = 0; i < 8; i++) {
+      crc = crc & 1 ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+    }
+  }
+  return ~crc;
+}
+
+static void put32(uint8_t *out, uint32_t value) {
+  out[0] = value >> 24;
+  out[1] = value >> 16;
+  out[2] = value >> 8;
+  out[3] = value;
+}
+
+static void png_chunk(FILE *file, const char *type, const uint8_t *data, uint32_t length) {
+  uint8_t header[8];
+  put32(header, length);
+  memcpy(header + 4, type, 4);
+  uint32_t crc = crc32(crc32(0, header + 4, 4), data, length);
+  uint8_t trailer[4];
+  put32(trailer, crc);
+  fwrite(header, 1, 8, file);
+  fwrite(data, 1, length, file);
+  fwrite(trailer, 1, 4, file);
+}
+
+// 2 bit palette image, zlib with stored blocks: a few KB, no library needed
+static void write_png(const char *path) {
+  uint16_t hres, vres;
+  resolution(&hres, &vres);
+  uint16_t row = 1 + (hres * 2 + 7) / 8; // filter byte first
+  uint32_t size = (uint32_t)row * vres;
+  static uint8_t pixels[MAX_VRES * (1 + MAX_HRES / 4)];
+  memset(pixels, 0, size);
+  for (uint16_t y = 0; y < vres; y++) {
+    uint16_t src_y = chip.psr & PSR_UD ? y : vres - 1 - y;
+    for (uint16_t x = 0; x < hres; x++) {
+      uint16_t src_x = chip.psr & PSR_SHL ? x : hres - 1 - x;
+      uint16_t offset = src_y * ROW_BYTES + src_x / 8;
+      uint8_t bit = 0x80 >> (src_x % 8);
+      // red over black over white
+      uint8_t color = !(chip.frame[1][offset] & bit) ? 2 : !(chip.frame[0][offset] & bit) ? 1 : 0;
+      pixels[y * row + 1 + x / 4] |= color << (6 - 2 * (x % 4));
+    }
+  }
+
+  FILE *file = fopen(path, "wb");
+  if (!file) {
+    perror(path);
+    return;
+  }
+  static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+  fwrite(signature, 1, 8, file);
+
+  uint8_t ihdr[13] = {0};
+  put32(ihdr, hres);
+  put32(ihdr + 4, vres);
+  ihdr[8] = 2; // bit depth
+  ihdr[9] = 3; // palette
+  png_chunk(file, "IHDR", ihdr, sizeof(ihdr));
+  static const uint8_t palette[] = {0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00};
+  png_chunk(file, "PLTE", palette, sizeof(palette));
+
+  static uint8_t idat[2 + sizeof(pixels) + 5 * (sizeof(pixels) / 0xFFFF + 1) + 4];
+  uint32_t length = 0;
+  idat[length++] = 0x78;
+  idat[length++] = 0x01;
+  uint32_t a = 1, b = 0; // adler32
+  for (uint32_t done = 0; done < size;) {
+    uint16_t block = size - done > 0xFFFF ? 0xFFFF : size - done;
+    idat[length++] = done + block == size; // final
+    idat[length++] = block;
+    idat[length++] = block >> 8;
+    idat[length++] = ~block;
+    idat[length++] = (uint16_t)~block >> 8;
+    memcpy(idat + length, pixels + done, block);
+    for (uint16_t i = 0; i < block; i++) {
+      a = (a + pixels[done + i]) % 65521;
+      b = (b + a) % 65521;
+    }
+    length += block;
+    done += block;
+  }
+  put32(idat + length, (b << 16) | a);
+  length += 4;
+  png_chunk(file, "IDAT", idat, length);
+  png_chunk(file, "IEND", NULL, 0);
+  fclose(file);
+}
+
+static void report(uint32_t refresh) {
+  char path[4096];
+  stats.updates++;
+  if (out_dir) {
+    snprintf(path, sizeof(path), "%s/update-%u.png", out_dir, stats.updates);
+    write_png(path);
+
+    snprintf(path, sizeof(path), "%s/updates.jsonl", out_dir);
+    FILE *file = fopen(path, "a");
+    if (file) {
+      double spi_hz = (256 + U0BAUD) * (double)(1UL << (U0GCR & 0x1F)) / (1UL << 28) * XOSC_HZ;
+      fprintf(file, "{\"update\":%u,\"commands\":%u,\"bytes\":%u,\"spi_ms\":%.1f,\"refresh_ms\":%u,\"by_command\":{",
+              stats.updates, stats.commands, stats.bytes, stats.bytes * 8 * 1000.0 / spi_hz, refresh);
+      const char *separator = "";
+      for (uint16_t i = 0; i < 256; i++) {
+        if (stats.by_command[i]) {
+          fprintf(file, "%s\"0x%02X\":%u", separator, i, stats.by_command[i]);
+          separator = ",";
+        }
+      }
+      fprintf(file, "}}\n");
+      fclose(file);
+    }
+  }
+  stats.commands = 0;
+  stats.bytes = 0;
+  memset(stats.by_command, 0, sizeof(stats.by_command));
+}
+
+static void command(uint8_t cmd) {
+  chip.command = cmd;
+  chip.param = 0;
+  stats.commands++;
+  stats.by_command[cmd]++;
+  switch (cmd) {
+  case CMD_PON:
+    busy_for(POWER_ON_MS);
+    break;
+  case CMD_POF:
+    busy_for(POWER_OFF_MS);
+    break;
+  case CMD_DRF: {
+    uint32_t refresh = refresh_ms();
+    report(refresh);
+    busy_for(refresh);
+    break;
+  }
+  case CMD_PTIN:
+    chip.partial = true;
+    break;
+  case CMD_PTOUT:
+    chip.partial = false;
+    break;
+  }
+}
+
+static void parameter(uint8_t data) {
+  uint16_t i = chip.param++;
+  switch (chip.command) {
+  case CMD_PSR:
+    if (!i) {
+      chip.psr = data;
+    }
+    break;
+  case CMD_TRES:
+    if (i == 0) {
+      chip.hres = data & 0xF8;
+    } else if (i == 1) {
+      chip.vres = (data & 1) << 8;
+    } else if (i == 2) {
+      chip.vres |= data;
+      chip.tres_set = true;
+    }
+    break;
+  case CMD_PLL:
+    chip.pll = data;
+    break;
+  case CMD_PTL:
+    if (i < sizeof(chip.ptl)) {
+      chip.ptl[i] = data;
+    }
+    break;
+  case CMD_DTM1:
+  case CMD_DTM2:
+    store(chip.command == CMD_DTM2, i, data);
+    break;
+  case CMD_DSLP:
+    chip.asleep = data == DSLP_CHECK;
+    break;
+  default:
+    if (chip.command >= CMD_LUTC && chip.command < CMD_LUTC + LUTS && i < LUT_SIZE) {
+      chip.lut[chip.command - CMD_LUTC][i] = data;
+    }
+    break;
+  }
+}
+
+static void drive_busy(uint64_t now) {
+  bool busy = chip.powered && (chip.in_reset || now < chip.busy_until);
+  if (P1_3 == busy) {
+    cc2510_port1_drive(BUSY_PIN, !busy);
+  }
+}
+
+// power and reset are plain port writes, they are looked at whenever the
+// model runs
+static void sample_pins(void) {
+  bool powered = !PIN_PWR;
+  if (powered != chip.powered) {
+    chip.powered = powered;
+    chip.busy_until = 0;
+    reset();
+  }
+  bool in_reset = powered && !PIN_RESET;
+  if (in_reset != chip.in_reset) {
+    chip.in_reset = in_reset;
+    reset();
+    if (!in_reset) {
+      busy_for(RESET_BUSY_MS);
+    }
+  }
+}
+
+static void spi_byte(uint8_t data) {
+  if (PIN_CS) {
+    return;
+  }
+  sample_pins();
+  if (!chip.powered || chip.in_reset) {
+    return;
+  }
+  stats.bytes++;
+  if (chip.asleep) {
+    return; // until the next reset
+  }
+  if (!PIN_DC) {
+    command(data);
+  } else {
+    parameter(data);
+  }
+  drive_busy(cc2510_now());
+}
+
+static uint64_t idle(uint64_t now) {
+  sample_pins();
+  drive_busy(now);
+  return chip.powered && !chip.in_reset && now < chip.busy_until ? chip.busy_until - now : UINT64_MAX;
+}
+
+void il0373_model_init(const char *dir, double time_scale) {
+  out_dir = dir;
+  scale = time_scale;
+  memset(&chip, 0, sizeof(chip));
+  memset(&stats, 0, sizeof(stats));
+  reset();
+  usart0_model_attach(spi_byte);
+  cc2510_idle_attach(idle);
+}
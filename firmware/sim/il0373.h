@@ -0,0 +1,28 @@
+#ifndef _SIM_IL0373_H_
+#define _SIM_IL0373_H_
+
+#include <stdint.h>
+
+// Model of the IL0373 controller of the GDEW026Z39 panel for host builds. It
+// takes the bytes of the USART0 SPI master with CS on P0_1 and D/C on
+// P1_2, follows power on P0_0 and reset on P2_0, and holds BUSY on P1_3 low
+// for as long as the controller would be busy.
+//
+// Power on/off, booster, panel settings, resolution, VCOM and data
+// interval, PLL, the two data planes, partial window in/out and the LUT
+// registers are understood, the rest is counted and ignored. A refresh
+// takes as long as the VCOM LUT says when the panel settings select the
+// register LUTs, otherwise as long as the panel's OTP waveform, about 15s.
+//
+// Every refresh writes update-<n>.png of the frame in black, white and red
+// to the output directory and appends a line to updates.jsonl there:
+//   {"update":1,"commands":9,"bytes":11260,"spi_ms":27.7,"refresh_ms":15000,
+//    "by_command":{"0x06":1,...}}
+// bytes and commands count everything sent since the refresh before, spi_ms
+// is their time at the USART0 baud rate.
+
+// dir NULL keeps the timing only. time_scale multiplies every BUSY time,
+// below 1 to get through refreshes faster.
+void il0373_model_init(const char *dir, double time_scale);
+
+#endif
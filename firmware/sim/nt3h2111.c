@@ -0,0 +1,282 @@
+#include "nt3h2111.h"
+#include "cc2510.h"
+#include "i2c_bus.h"
+#include <string.h>
+
+#define FD_PIN 1 // P1_1
+
+#define BLOCK_SIZE 16
+#define EEPROM_BLOCKS 0x3B
+#define SRAM_BLOCK 0xF8
+#define SRAM_BLOCKS 4
+#define SESSION_BLOCK 0xFE
+
+#define REG_NC 0
+#define REG_NS 6
+#define REGISTERS 8
+
+#define NC_PTHRU_DIR 0x01 // set: RF -> I2C
+#define NC_PTHRU_ON 0x40
+#define NC_FD_ON(nc) (((nc) >> 2) & 3)
+#define NC_FD_OFF(nc) (((nc) >> 4) & 3)
+
+#define NS_RF_FIELD_PRESENT 0x01
+#define NS_SRAM_RF_READY 0x08
+#define NS_SRAM_I2C_READY 0x10
+
+enum { BUS_IDLE, BUS_RECEIVING, BUS_SENDING, BUS_IGNORING };
+
+static struct {
+  I2cSlave bus;
+  bool scl, sda; // previous bus levels
+  uint8_t state;
+  uint8_t bits;
+  uint8_t shift;
+  bool ack_clock; // 9th clock of the current byte
+
+  uint8_t rx[2 + BLOCK_SIZE];
+  uint8_t rx_count;
+
+  uint8_t pointer;      // block for reads
+  uint8_t pointer_reg;  // session register for reads
+  bool pointer_session; // reads return pointer_reg
+  uint16_t read_offset;
+
+  uint8_t eeprom[EEPROM_BLOCKS * BLOCK_SIZE];
+  uint8_t sram[SRAM_BLOCKS * BLOCK_SIZE];
+  uint8_t regs[REGISTERS];
+  bool fd_low;
+} chip;
+
+// FD is open drain, pulled up on the tag
+static void fd(bool low) {
+  if (low != chip.fd_low) {
+    chip.fd_low = low;
+    cc2510_port1_drive(FD_PIN, !low);
+  }
+}
+
+static bool pthru(uint8_t dir) {
+  uint8_t nc = chip.regs[REG_NC];
+  return (nc & NC_PTHRU_ON) && (nc & NC_PTHRU_DIR) == dir;
+}
+
+static uint8_t read_byte(void) {
+  if (chip.pointer_session) {
+    return chip.regs[chip.pointer_reg];
+  }
+  uint16_t block = chip.pointer + chip.read_offset / BLOCK_SIZE;
+  uint8_t offset = chip.read_offset % BLOCK_SIZE;
+  chip.read_offset++;
+  if (block >= SRAM_BLOCK && block < SRAM_BLOCK + SRAM_BLOCKS) {
+    uint8_t value = chip.sram[(block - SRAM_BLOCK) * BLOCK_SIZE + offset];
+    if (block == SRAM_BLOCK + SRAM_BLOCKS - 1 && offset == BLOCK_SIZE - 1 && pthru(NC_PTHRU_DIR)) {
+      // last byte of the message read, SRAM goes back to RF
+      chip.regs[REG_NS] &= ~NS_SRAM_I2C_READY;
+      if (NC_FD_OFF(chip.regs[REG_NC]) == 3) {
+        fd(false);
+      }
+    }
+    return value;
+  }
+  if (block < EEPROM_BLOCKS) {
+    return chip.eeprom[block * BLOCK_SIZE + offset];
+  }
+  return 0;
+}
+
+static void write_done(void) {
+  if (chip.rx_count < 2) {
+    return;
+  }
+  uint8_t mema = chip.rx[1];
+  uint8_t *data = chip.rx + 2;
+  uint8_t length = chip.rx_count - 2;
+
+  if (mema == SESSION_BLOCK) {
+    if (length >= 1) {
+      chip.pointer_session = true;
+      chip.pointer_reg = data[0] % REGISTERS;
+    }
+    if (length == 3 && data[0] != REG_NS) {
+      uint8_t *reg = &chip.regs[data[0] % REGISTERS];
+      *reg = (*reg & ~data[1]) | (data[2] & data[1]);
+    }
+    return;
+  }
+
+  chip.pointer = mema;
+  chip.pointer_session = false;
+  chip.read_offset = 0;
+  if (length != BLOCK_SIZE) {
+    return;
+  }
+  if (mema >= SRAM_BLOCK && mema < SRAM_BLOCK + SRAM_BLOCKS) {
+    memcpy(chip.sram + (mema - SRAM_BLOCK) * BLOCK_SIZE, data, BLOCK_SIZE);
+    if (mema == SRAM_BLOCK + SRAM_BLOCKS - 1 && pthru(0)) {
+      chip.regs[REG_NS] |= NS_SRAM_RF_READY;
+      if (NC_FD_OFF(chip.regs[REG_NC]) == 3) {
+        fd(false);
+      }
+    }
+  } else if (mema < EEPROM_BLOCKS) {
+    memcpy(chip.eeprom + mema * BLOCK_SIZE, data, BLOCK_SIZE);
+  }
+}
+
+// a complete byte arrived, returns whether to acknowledge it
+static bool byte_received(uint8_t value) {
+  if (chip.rx_count == 0) {
+    if ((value >> 1) != NT3H_MODEL_ADDRESS) {
+      return false;
+    }
+    chip.rx[chip.rx_count++] = value;
+    return true;
+  }
+  if (chip.rx_count < sizeof(chip.rx)) {
+    chip.rx[chip.rx_count++] = value;
+    return true;
+  }
+  return false;
+}
+
+static void on_change(I2cSlave *bus, bool scl, bool sda) {
+  (void)bus;
+  bool scl_rose = scl && !chip.scl;
+  bool scl_fell = !scl && chip.scl;
+
+  if (scl && chip.scl && sda != chip.sda) {
+    if (!sda) {
+      // (repeated) start
+      if (chip.state == BUS_RECEIVING) {
+        write_done();
+      }
+      chip.state = BUS_RECEIVING;
+      chip.rx_count = 0;
+    } else {
+      // stop
+      if (chip.state == BUS_RECEIVING) {
+        write_done();
+      }
+      chip.state = BUS_IDLE;
+      chip.bus.sda = true;
+    }
+    chip.bits = 0;
+    chip.ack_clock = false;
+    chip.scl = scl;
+    chip.sda = sda;
+    return;
+  }
+  chip.scl = scl;
+  chip.sda = sda;
+
+  if (chip.state == BUS_IDLE || chip.state == BUS_IGNORING) {
+    return;
+  }
+
+  if (scl_rose) {
+    if (chip.ack_clock) {
+      if (chip.state == BUS_SENDING && sda) {
+        // master NACK, done sending
+        chip.state = BUS_IGNORING;
+      }
+      return;
+    }
+    if (chip.state == BUS_RECEIVING) {
+      chip.shift = (chip.shift << 1) | sda;
+      chip.bits++;
+    }
+    return;
+  }
+
+  if (!scl_fell) {
+    return;
+  }
+
+  if (chip.ack_clock) {
+    // end of the 9th clock
+    chip.ack_clock = false;
+    chip.bus.sda = true;
+    chip.bits = 0;
+    if (chip.state == BUS_SENDING) {
+      chip.shift = read_byte();
+      chip.bus.sda = chip.shift & 0x80;
+    }
+    return;
+  }
+
+  if (chip.state == BUS_RECEIVING) {
+    if (chip.bits < 8) {
+      return;
+    }
+    bool ack = byte_received(chip.shift);
+    chip.ack_clock = true;
+    chip.bus.sda = !ack;
+    if (!ack) {
+      chip.state = BUS_IGNORING;
+      chip.bus.sda = true;
+    } else if (chip.rx_count == 1 && (chip.shift & 1)) {
+      chip.state = BUS_SENDING;
+      chip.read_offset = 0;
+    }
+    return;
+  }
+
+  // sending, next bit after the falling edge
+  chip.bits++;
+  if (chip.bits == 8) {
+    chip.bus.sda = true; // master acknowledges
+    chip.ack_clock = true;
+  } else {
+    chip.shift <<= 1;
+    chip.bus.sda = chip.shift & 0x80;
+  }
+}
+
+void nt3h_model_init(void) {
+  memset(&chip, 0, sizeof(chip));
+  chip.scl = chip.sda = true;
+  chip.bus.on_change = on_change;
+  i2c_bus_attach(&chip.bus);
+}
+
+void nt3h_rf_field(bool present) {
+  if (present) {
+    chip.regs[REG_NS] |= NS_RF_FIELD_PRESENT;
+    if (NC_FD_ON(chip.regs[REG_NC]) == 0) {
+      fd(true);
+    }
+  } else {
+    chip.regs[REG_NS] &= ~(NS_RF_FIELD_PRESENT | NS_SRAM_RF_READY | NS_SRAM_I2C_READY);
+    chip.regs[REG_NC] &= ~NC_PTHRU_ON;
+    fd(false);
+  }
+}
+
+bool nt3h_rf_write_sram(const uint8_t *data) {
+  if (!pthru(NC_PTHRU_DIR) || (chip.regs[REG_NS] & NS_SRAM_I2C_READY)) {
+    return false;
+  }
+  memcpy(chip.sram, data, sizeof(chip.sram));
+  chip.regs[REG_NS] |= NS_SRAM_I2C_READY;
+  if (NC_FD_ON(chip.regs[REG_NC]) == 3) {
+    fd(true);
+  }
+  return true;
+}
+
+bool nt3h_rf_read_sram(uint8_t *data) {
+  if (!pthru(0) || !(chip.regs[REG_NS] & NS_SRAM_RF_READY)) {
+    return false;
+  }
+  memcpy(data, chip.sram, sizeof(chip.sram));
+  chip.regs[REG_NS] &= ~NS_SRAM_RF_READY;
+  if (NC_FD_ON(chip.regs[REG_NC]) == 3) {
+    fd(true);
+  }
+  return true;
+}
+
+bool nt3h_model_fd(void) {
+  return !chip.fd_low;
+}
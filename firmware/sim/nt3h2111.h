@@ -0,0 +1,25 @@
+#ifndef _SIM_NT3H2111_H_
+#define _SIM_NT3H2111_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Behavioural model of the NT3H2111 I2C side for host builds: 1k EEPROM in
+// 16 byte blocks, the session registers and the 64 byte SRAM with
+// pass-through. The RF side (the phone) is driven through the nt3h_rf_*
+// calls.
+
+#define NT3H_MODEL_ADDRESS 0x55
+
+void nt3h_model_init(void); // attaches to the simulated I2C bus
+
+void nt3h_rf_field(bool present);
+// pass-through RF -> I2C: false while the tag did not read the last message
+bool nt3h_rf_write_sram(const uint8_t *data);
+// pass-through I2C -> RF: false while there is nothing new to read
+bool nt3h_rf_read_sram(uint8_t *data);
+
+// level of the FD pin, false = pulled low. The model drives P1_1 with it.
+bool nt3h_model_fd(void);
+
+#endif
@@ -0,0 +1,175 @@
+#include "w25x10.h"
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/random.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SIZE 0x20000UL
+#define PAGE_SIZE 256
+#define SECTOR_SIZE 4096
+#define UNIQUE_ID_SIZE 8
+
+#define CMD_WRITE_ENABLE 0x06
+#define CMD_WRITE_DISABLE 0x04
+#define CMD_READ_STATUS 0x05
+#define CMD_READ 0x03
+#define CMD_PAGE_PROGRAM 0x02
+#define CMD_SECTOR_ERASE 0x20
+#define CMD_CHIP_ERASE 0xC7
+#define CMD_POWER_DOWN 0xB9
+#define CMD_RELEASE_POWER_DOWN 0xAB
+#define CMD_READ_UNIQUE_ID 0x4B
+
+#define STATUS_WEL 0x02
+
+static struct {
+  uint8_t *memory;
+  uint8_t unique_id[UNIQUE_ID_SIZE];
+  bool selected;
+  bool clk, mosi;
+  uint8_t in, bits; // byte being shifted in
+  uint8_t out;      // byte being shifted out, MSB on MISO
+  uint8_t next;     // goes out after the current byte
+  uint8_t command;
+  uint32_t count; // bytes since CS went low
+  uint32_t address;
+  uint8_t status;
+  bool asleep;
+} chip;
+
+void w25x10_model_init(int fd) {
+  struct stat info;
+  off_t size = fstat(fd, &info) ? 0 : info.st_size;
+  if (size < (off_t)SIZE) {
+    static const uint8_t erased[SECTOR_SIZE] = {[0 ... SECTOR_SIZE - 1] = 0xFF};
+    for (; size < (off_t)SIZE; size += sizeof(erased)) {
+      pwrite(fd, erased, sizeof(erased), size);
+    }
+  }
+  // the unique ID follows the array, made up the first time
+  if (pread(fd, chip.unique_id, UNIQUE_ID_SIZE, SIZE) != UNIQUE_ID_SIZE) {
+    getrandom(chip.unique_id, UNIQUE_ID_SIZE, 0);
+    pwrite(fd, chip.unique_id, UNIQUE_ID_SIZE, SIZE);
+  }
+  chip.memory = mmap(NULL, SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  chip.selected = false;
+  chip.status = 0;
+  chip.asleep = false;
+}
+
+// a byte clocked in, sets the one to clock out next
+static void receive(uint8_t data) {
+  if (!chip.count++) {
+    chip.command = data;
+    chip.address = 0;
+    if (chip.asleep && data != CMD_RELEASE_POWER_DOWN) {
+      chip.command = 0; // ignored until released
+    }
+    switch (chip.command) {
+    case CMD_WRITE_ENABLE:
+      chip.status |= STATUS_WEL;
+      break;
+    case CMD_WRITE_DISABLE:
+      chip.status &= ~STATUS_WEL;
+      break;
+    case CMD_READ_STATUS:
+      chip.next = chip.status;
+      break;
+    case CMD_CHIP_ERASE:
+      if (chip.status & STATUS_WEL) {
+        memset(chip.memory, 0xFF, SIZE);
+        chip.status &= ~STATUS_WEL;
+      }
+      break;
+    case CMD_POWER_DOWN:
+      chip.asleep = true;
+      break;
+    case CMD_RELEASE_POWER_DOWN:
+      chip.asleep = false;
+      break;
+    }
+    return;
+  }
+
+  switch (chip.command) {
+  case CMD_READ_STATUS:
+    chip.next = chip.status;
+    return;
+  case CMD_READ_UNIQUE_ID:
+    // after four dummy bytes
+    if (chip.count >= 5) {
+      chip.next = chip.count - 5 < UNIQUE_ID_SIZE ? chip.unique_id[chip.count - 5] : 0xFF;
+    }
+    return;
+  case CMD_READ:
+  case CMD_PAGE_PROGRAM:
+  case CMD_SECTOR_ERASE:
+    break;
+  default:
+    return;
+  }
+  if (chip.count <= 4) {
+    chip.address = ((chip.address << 8) | data) % SIZE;
+    if (chip.count == 4 && chip.command == CMD_READ) {
+      chip.next = chip.memory[chip.address];
+    }
+    return;
+  }
+  if (chip.command == CMD_READ) {
+    chip.address = (chip.address + 1) % SIZE;
+    chip.next = chip.memory[chip.address];
+  } else if (chip.command == CMD_PAGE_PROGRAM && (chip.status & STATUS_WEL)) {
+    // wraps within the page
+    uint32_t page = chip.address & ~(uint32_t)(PAGE_SIZE - 1);
+    uint8_t offset = chip.address + (chip.count - 5);
+    chip.memory[page + offset] &= data;
+  }
+}
+
+void w25x10_cs(bool level) {
+  if (level && chip.selected) {
+    // operations start when CS goes high
+    if (chip.command == CMD_SECTOR_ERASE && chip.count >= 4 && (chip.status & STATUS_WEL)) {
+      memset(&chip.memory[chip.address & ~(uint32_t)(SECTOR_SIZE - 1)], 0xFF, SECTOR_SIZE);
+    }
+    if (chip.command == CMD_SECTOR_ERASE || chip.command == CMD_PAGE_PROGRAM) {
+      chip.status &= ~STATUS_WEL;
+    }
+  } else if (!level && !chip.selected) {
+    chip.bits = 0;
+    chip.count = 0;
+    chip.command = 0;
+    chip.out = chip.next = 0xFF;
+  }
+  chip.selected = !level;
+}
+
+// SPI mode 0: sampled on the rising edge, shifted on the falling one
+void w25x10_clk(bool level) {
+  if (!chip.selected || level == chip.clk) {
+    chip.clk = level;
+    return;
+  }
+  chip.clk = level;
+  if (level) {
+    chip.in = (chip.in << 1) | chip.mosi;
+    if (++chip.bits == 8) {
+      chip.bits = 0;
+      receive(chip.in);
+    }
+  } else if (chip.bits) {
+    chip.out <<= 1;
+  } else {
+    chip.out = chip.next;
+  }
+}
+
+void w25x10_mosi(bool level) {
+  chip.mosi = level;
+}
+
+bool w25x10_miso(void) {
+  return chip.out & 0x80;
+}
@@ -0,0 +1,21 @@
+#ifndef _SIM_W25X10_H_
+#define _SIM_W25X10_H_
+
+#include <stdbool.h>
+
+// Model of the W25X10CL SPI NOR flash for host builds, clocked pin by pin by
+// hal/spiflash.c. Programming can only clear bits, erases set the 4KB
+// sector to 0xFF, nothing takes time. The contents live in a file, so they
+// survive a reset of the model and a restart of the process, and so does
+// the unique ID kept behind them.
+
+// fd of the contents, grown to 128KB of erased flash and a random unique ID
+// when shorter
+void w25x10_model_init(int fd);
+
+void w25x10_cs(bool level);
+void w25x10_clk(bool level);
+void w25x10_mosi(bool level);
+bool w25x10_miso(void);
+
+#endif
@@ -1,60 +1,182 @@
 #include "cobs.h"
+#include "../profile/profile.h"
 
-void cobs_init(CobsState *state) {
-  state->packet_index = 0;
-  state->block = 0;
-  state->code = 0xFF;
+CobsStats __xdata cobs_stats;
+CobsStreamCall __xdata cobs_stream_call;
+
+// frame being received
+static PoolBlock __xdata *rx_block; // NULL while discarding
+static bool rx_in_packet;
+static bool rx_overflow;
+static bool rx_streaming;    // outgrew its block, handed on a block at a time
+static uint16_t rx_size;     // data bytes streamed so far
+static uint8_t rx_remaining; // data bytes left in the current COBS block
+static uint8_t rx_code;
+
+static PoolQueue __xdata rx_frames;
+static CobsStreamHandler rx_on_data;
+static CobsStreamHandler rx_on_end;
+
+static void cobs_rx_reset(void) {
+  rx_block = NULL;
+  rx_in_packet = false;
+  rx_overflow = false;
+  rx_streaming = false;
+  rx_size = 0;
+  rx_remaining = 0;
+  rx_code = 0xFF;
 }
 
-bool cobs_handle(CobsState *state) {
-  uint8_t data;
-  if (!uart_read_byte(&data)) {
-    return false;
+static void cobs_rx_emit(uint8_t value) {
+  if (!rx_block) {
+    return;
+  }
+  if (rx_block->length == POOL_BLOCK_SIZE) {
+    if (!rx_on_data) {
+      rx_overflow = true;
+      return;
+    }
+    cobs_stream_call.data = rx_block->data;
+    cobs_stream_call.length = POOL_BLOCK_SIZE;
+    rx_on_data();
+    rx_streaming = true;
+    rx_size += POOL_BLOCK_SIZE;
+    rx_block->length = 0;
   }
+  rx_block->data[rx_block->length++] = value;
+}
 
-  if (state->packet_index == MAX_PACKET_SIZE) {
-    // packet is too long,
-    cobs_init(state);
+static void cobs_rx_end(void) {
+  bool valid = !rx_remaining && !rx_overflow;
+  if (rx_streaming) {
+    if (rx_block->length) {
+      cobs_stream_call.data = rx_block->data;
+      cobs_stream_call.length = rx_block->length;
+      rx_on_data();
+    }
+    cobs_stream_call.size = rx_size + rx_block->length;
+    cobs_stream_call.valid = valid;
+    rx_on_end();
+    pool_free(rx_block);
+  } else if (!valid) {
+    // truncated or too long for a block
+    cobs_stats.rx_errors++;
+    pool_free(rx_block);
+  } else {
+    pool_queue_push(&rx_frames, rx_block);
   }
+}
 
-  if (state->block) {
-    state->packet[state->packet_index++] = data;
+static void cobs_rx_byte(uint8_t value) {
+  if (!value) {
+    if (!rx_in_packet) {
+      // back to back delimiters
+      return;
+    }
+    if (rx_block) {
+      cobs_rx_end();
+    }
+    cobs_rx_reset();
+    return;
+  }
+
+  if (!rx_in_packet) {
+    rx_in_packet = true;
+    // without a free block the frame is dropped, the peer resends it
+    rx_block = pool_alloc();
+  }
+  if (rx_remaining) {
+    cobs_rx_emit(value);
+    rx_remaining--;
   } else {
-    state->block = data;
-    if (state->block && (state->code != 0xff))
-      state->packet[state->packet_index++] = 0;
-    state->code = state->block;
-    if (!state->code) {
-      state->packet_size = state->packet_index;
-      cobs_init(state);
-      return true;
+    if (rx_code != 0xFF) {
+      cobs_rx_emit(0);
     }
+    rx_code = value;
+    rx_remaining = value - 1;
+  }
+}
+
+void cobs_rx_poll(void) {
+  uint8_t data;
+  PROFILE_ENTER(PROBE_COBS_RX_POLL);
+  while (uart_read_byte(&data)) {
+    cobs_rx_byte(data);
   }
+  PROFILE_EXIT(PROBE_COBS_RX_POLL);
+  uart_rx_arm();
+}
 
-  state->block--;
-  return false;
+void cobs_rx_init(void) {
+  cobs_rx_reset();
+  pool_queue_init(&rx_frames);
+  cobs_stats.rx_errors = 0;
+  uart_rx_arm();
 }
 
-void cobs_send(const uint8_t *data, uint8_t length) {
-  uint8_t index = 0;
-  uint8_t code = 1;
-  while (index < length) {
-    uint8_t value = data[index];
-    if (code == 1) {
-      for (uint8_t i = index; i < length && data[i]; i++) {
-        code++;
-      }
-      uart_send_byte(code);
-    } else {
-      code--;
-    }
-    if (value) {
-      uart_send_byte(value);
+void cobs_rx_stream(CobsStreamHandler on_data, CobsStreamHandler on_end) {
+  rx_on_data = on_data;
+  rx_on_end = on_end;
+}
+
+PoolBlock __xdata *cobs_rx_frame(void) {
+  return pool_queue_pop(&rx_frames);
+}
+
+bool cobs_rx_frame_ready(void) {
+  return !pool_queue_empty(&rx_frames);
+}
+
+bool cobs_rx_pending(void) {
+  return !pool_queue_empty(&rx_frames) || rx_in_packet;
+}
+
+static void cobs_open_block(CobsEncoder *encoder) {
+  // encode straight into the TX buffer, the code byte is patched on close.
+  // Room for a whole block would flush the buffer on every zero byte, the
+  // rest of the frame is all it can hold.
+  uint16_t size = encoder->left + 1;
+  encoder->block = uart_tx_reserve(size < COBS_MAX_BLOCK ? size : COBS_MAX_BLOCK);
+  encoder->code = 1;
+}
+
+static void cobs_close_block(CobsEncoder *encoder) {
+  encoder->block[0] = encoder->code;
+  uart_tx_commit(encoder->code);
+}
+
+void cobs_begin(CobsEncoder *encoder, uint16_t length) {
+  encoder->left = length;
+  cobs_open_block(encoder);
+}
+
+void cobs_write_byte(CobsEncoder *encoder, uint8_t value) {
+  encoder->left--;
+  if (value) {
+    encoder->block[encoder->code++] = value;
+    if (encoder->code != 0xFF) {
+      return;
     }
-    index++;
   }
-  if (code == 1) {
-    uart_send_byte(code);
+  cobs_close_block(encoder);
+  cobs_open_block(encoder);
+}
+
+void cobs_write(CobsEncoder *encoder, const uint8_t *data, uint16_t length) {
+  while (length--) {
+    cobs_write_byte(encoder, *data++);
   }
+}
+
+void cobs_end(CobsEncoder *encoder) {
+  cobs_close_block(encoder);
   uart_send_byte(0);
-}
\ No newline at end of file
+  uart_flush();
+}
+
+void cobs_send(const uint8_t *data, uint16_t length) {
+  CobsEncoder encoder;
+  cobs_begin(&encoder, length);
+  cobs_write(&encoder, data, length);
+  cobs_end(&encoder);
+}
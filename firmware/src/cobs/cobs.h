@@ -3,18 +3,56 @@
 
 #include "../hal/hal.h"
 #include "../hal/uart.h"
+#include "../pool/pool.h"
 
-#define MAX_PACKET_SIZE 128
+// a COBS block is a code byte followed by up to 254 data bytes
+#define COBS_MAX_BLOCK 0xFF
+// a frame of n bytes encoded, with its delimiter
+#define COBS_FRAME_SIZE(n) ((n) + (n) / (COBS_MAX_BLOCK - 1) + 2)
 
 typedef struct {
-  uint8_t packet[MAX_PACKET_SIZE];
-  uint8_t packet_size;
-  uint8_t packet_index;
-  uint8_t block, code;
-} CobsState;
-
-void cobs_init(CobsState *state);
-bool cobs_handle(CobsState *state);
-void cobs_send(const uint8_t *data, uint8_t size);
+  uint16_t rx_errors; // truncated frames and frames too large without a stream handler
+} CobsStats;
+
+extern CobsStats __xdata cobs_stats;
+
+typedef struct {
+  uint8_t __xdata *block; // code byte of the open block, in the TX buffer
+  uint8_t code;
+  uint16_t left; // payload bytes still to come
+} CobsEncoder;
+
+// what the stream handlers are called with, they take no arguments: SDCC
+// only passes them through a function pointer to reentrant functions
+typedef struct {
+  const uint8_t __xdata *data; // on_data: the next part of the frame
+  uint8_t length;
+  uint16_t size; // on_end: of the whole frame
+  bool valid;    // on_end: false if truncated
+} CobsStreamCall;
+
+extern CobsStreamCall __xdata cobs_stream_call;
+
+typedef void (*CobsStreamHandler)(void);
+
+// Frames are decoded from the UART RX ring into pool blocks by
+// cobs_rx_poll, in the task that handles EVENT_UART_RX. It queues the
+// complete ones and rearms the RX wakeup once the ring is drained.
+void cobs_rx_init(void);
+void cobs_rx_poll(void);
+PoolBlock __xdata *cobs_rx_frame(void); // next decoded frame, the caller owns it
+bool cobs_rx_frame_ready(void);
+bool cobs_rx_pending(void); // frames queued or one being received
+// A frame that outgrows its block is streamed instead: on_data gets it a
+// block at a time, on_end the total size. Without handlers it is an error.
+void cobs_rx_stream(CobsStreamHandler on_data, CobsStreamHandler on_end);
+
+// length is the number of payload bytes written until cobs_end, a block
+// takes no more of the TX buffer than they need
+void cobs_begin(CobsEncoder *encoder, uint16_t length);
+void cobs_write_byte(CobsEncoder *encoder, uint8_t value);
+void cobs_write(CobsEncoder *encoder, const uint8_t *data, uint16_t length);
+void cobs_end(CobsEncoder *encoder);
+void cobs_send(const uint8_t *data, uint16_t length);
 
 #endif
@@ -0,0 +1,49 @@
+#include "command.h"
+
+typedef struct {
+  CommandHandler handler;
+  uint8_t min_length;
+} Command;
+
+#define COMMAND_ENTRY(name, handler, min_length) {handler, min_length},
+static __code const Command commands[COMMAND_COUNT] = {COMMAND_LIST(COMMAND_ENTRY)};
+#undef COMMAND_ENTRY
+
+CommandCall __xdata command_call;
+
+uint8_t command_execute(const uint8_t __xdata *data, uint8_t length, uint8_t __xdata *reply) {
+  uint8_t opcode = length ? data[0] : 0xFF;
+  uint8_t status;
+  command_call.reply_length = 0;
+  if (length < COMMAND_REQUEST_HEADER) {
+    status = STATUS_BAD_LENGTH;
+  } else if (opcode >= COMMAND_COUNT) {
+    status = STATUS_UNKNOWN_COMMAND;
+  } else {
+    __code const Command *command = &commands[opcode];
+    uint8_t args_length = length - COMMAND_REQUEST_HEADER;
+    if (args_length < command->min_length) {
+      status = STATUS_BAD_LENGTH;
+    } else {
+      command_call.args = data + COMMAND_REQUEST_HEADER;
+      command_call.length = args_length;
+      command_call.reply = reply + COMMAND_REPLY_HEADER;
+      status = command->handler();
+    }
+  }
+
+  reply[0] = opcode;
+  reply[1] = length > 1 ? data[1] : 0;
+  reply[2] = length > 2 ? data[2] : 0;
+  reply[3] = status;
+  return COMMAND_REPLY_HEADER + command_call.reply_length;
+}
+
+bool command_handle(void) {
+  uint8_t __xdata *reply = transport_reserve();
+  if (!reply) {
+    return false;
+  }
+  transport_commit(command_execute(transport_rx.data, transport_rx.length, reply));
+  return true;
+}
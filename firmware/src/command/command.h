@@ -0,0 +1,17 @@
+#ifndef _COMMAND_H_
+#define _COMMAND_H_
+
+#include "commands.h"
+#include "../transport/transport.h"
+
+#define COMMAND_MAX_REPLY (TRANSPORT_MAX_PAYLOAD - COMMAND_REPLY_HEADER)
+
+// runs a request, the reply (header included, up to TRANSPORT_MAX_PAYLOAD
+// bytes) is written to reply, returns its length
+uint8_t command_execute(const uint8_t __xdata *data, uint8_t length, uint8_t __xdata *reply);
+
+// transport handler for transport_rx, false while no TX slot is free for the
+// reply
+bool command_handle(void);
+
+#endif
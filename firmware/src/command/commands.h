@@ -0,0 +1,82 @@
+#ifndef _COMMANDS_H_
+#define _COMMANDS_H_
+
+#include "../hal/hal.h"
+#include <stdint.h>
+
+// Host link commands. A request is
+//   opcode | id (16 bit) | arguments...
+// and every request gets exactly one reply
+//   opcode | id (16 bit) | status | payload...
+// The id is the requester's, it comes back as is so replies can be matched
+// without regard to order.
+//
+// The opcode is the position in COMMAND_LIST, append new commands at the end.
+// X(name, handler, minimum argument bytes)
+//
+// The gateway's src/commands.ts is generated from this file, run
+// `npm run gen-commands` in gateway-test after changing it.
+#define COMMAND_LIST(X)                      \
+  X(PING, cmd_ping, 0)                       \
+  X(ECHO, cmd_echo, 0)                       \
+  X(STATS, cmd_stats, 0)                     \
+  X(PROFILE, cmd_profile, 1)                 \
+  X(REBOOT, cmd_reboot, 0)                   \
+  X(OTA_BEGIN, cmd_ota_begin, 4)             \
+  X(OTA_WRITE, cmd_ota_write, 2)             \
+  X(OTA_FINISH, cmd_ota_finish, 0)           \
+  X(OTA_CONFIRM, cmd_ota_confirm, 0)         \
+  X(OTA_STATUS, cmd_ota_status, 0)           \
+  X(RADIO_SEND, cmd_radio_send, 1)           \
+  X(MCAST_LISTEN, cmd_mcast_listen, 2)       \
+  X(MCAST_STATUS, cmd_mcast_status, 0)       \
+  X(TDMA_ASSIGN, cmd_tdma_assign, 3)         \
+  X(TDMA_COORDINATE, cmd_tdma_coordinate, 1) \
+  X(TDMA_QUEUE, cmd_tdma_queue, 7)           \
+  X(TDMA_RECEIVE, cmd_tdma_receive, 0)       \
+  X(TDMA_STATUS, cmd_tdma_status, 0)         \
+  X(LABEL_WRITE, cmd_label_write, 3)         \
+  X(LABEL_SHOW, cmd_label_show, 1)
+
+// X(name, value)
+#define STATUS_LIST(X)  \
+  X(OK, 0)              \
+  X(UNKNOWN_COMMAND, 1) \
+  X(BAD_LENGTH, 2)      \
+  X(BAD_ARGUMENT, 3)    \
+  X(BUSY, 4)            \
+  X(UNSUPPORTED, 5)     \
+  X(FAILED, 6)
+
+#define COMMAND_ENUM(name, handler, min_length) COMMAND_##name,
+enum { COMMAND_LIST(COMMAND_ENUM) COMMAND_COUNT };
+#undef COMMAND_ENUM
+
+#define STATUS_ENUM(name, value) STATUS_##name = value,
+enum { STATUS_LIST(STATUS_ENUM) };
+#undef STATUS_ENUM
+
+#define COMMAND_REQUEST_HEADER 3
+#define COMMAND_REPLY_HEADER 4
+
+// Arguments are read in place from the received frame, the reply payload is
+// written straight into the transport's TX slot, at most COMMAND_MAX_REPLY
+// bytes. SDCC only passes arguments through a function pointer to reentrant
+// functions, so handlers find theirs in command_call. They return a STATUS_
+// value, the payload is sent with any status.
+typedef struct {
+  const uint8_t __xdata *args;
+  uint8_t length;
+  uint8_t __xdata *reply;
+  uint8_t reply_length; // 0 until the handler sets it
+} CommandCall;
+
+extern CommandCall __xdata command_call;
+
+typedef uint8_t (*CommandHandler)(void);
+
+#define COMMAND_PROTOTYPE(name, handler, min_length) uint8_t handler(void);
+COMMAND_LIST(COMMAND_PROTOTYPE)
+#undef COMMAND_PROTOTYPE
+
+#endif
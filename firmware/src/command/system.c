@@ -0,0 +1,78 @@
+#include "command.h"
+#include "../cobs/cobs.h"
+#include "../hal/pm.h"
+#include "../hal/time.h"
+#include "../hal/uart.h"
+#include "../pool/pool.h"
+#include "../sched/timer.h"
+#include <string.h>
+
+#define PROTOCOL_VERSION 1
+
+#define REBOOT_DELAY_MS 100 // time for the reply and its ack to go out
+#define WDT_EN BV(3)
+
+static Timer __xdata reboot_timer;
+
+// general purpose commands, feature modules define their own handlers
+
+static uint8_t __xdata *put(uint8_t __xdata *reply, const void __xdata *data, uint8_t size) {
+  // the 8051 is little endian like the wire format
+  memcpy(reply, data, size);
+  return reply + size;
+}
+
+// reply: protocol version, uptime in ms (32 bit)
+uint8_t cmd_ping(void) {
+  uint8_t __xdata *reply = command_call.reply;
+  uint32_t now = millis();
+  reply[0] = PROTOCOL_VERSION;
+  memcpy(reply + 1, &now, sizeof(now));
+  command_call.reply_length = 1 + sizeof(now);
+  return STATUS_OK;
+}
+
+uint8_t cmd_echo(void) {
+  const uint8_t __xdata *args = command_call.args;
+  uint8_t length = command_call.length;
+  uint8_t __xdata *reply = command_call.reply;
+  if (length > COMMAND_MAX_REPLY) {
+    return STATUS_BAD_LENGTH;
+  }
+  memcpy(reply, args, length);
+  command_call.reply_length = length;
+  return STATUS_OK;
+}
+
+// reply: the uart, cobs, transport, pool and pm stats structures back to back
+uint8_t cmd_stats(void) {
+  uint8_t __xdata *reply = command_call.reply;
+  uint8_t __xdata *end = reply;
+  HAL_CRITICAL_STATEMENT({
+    end = put(end, &uart_stats, sizeof(uart_stats));
+    end = put(end, &cobs_stats, sizeof(cobs_stats));
+    end = put(end, &transport_stats, sizeof(transport_stats));
+    end = put(end, &pool_stats, sizeof(pool_stats));
+    end = put(end, &pm_stats, sizeof(pm_stats));
+  });
+  command_call.reply_length = end - reply;
+  return STATUS_OK;
+}
+
+static void reboot(void) {
+  HAL_DISABLE_INTERRUPTS();
+  if (!(WDCTL & WDT_EN)) {
+    WDCTL = WDT_EN | 0x03; // 1.9ms
+  }
+#ifndef BUILD
+  cc2510_reset();
+#endif
+  while (1) {
+    // nothing feeds the watchdog anymore
+  }
+}
+
+uint8_t cmd_reboot(void) {
+  timer_start(&reboot_timer, REBOOT_DELAY_MS, reboot);
+  return STATUS_OK;
+}
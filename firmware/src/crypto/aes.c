@@ -0,0 +1,73 @@
+#include "aes.h"
+#include "../hal/dma.h"
+
+// only the link encryption uses the coprocessor so far, host builds always
+// have it for the tests
+#if defined(LINK_KEY) || !defined(BUILD)
+
+#define ENCCS_ST BV(0)
+#define ENCCS_CMD_ENCRYPT 0x00
+#define ENCCS_CMD_LOAD_KEY 0x04
+#define ENCCS_CMD_LOAD_IV 0x06
+#define ENCCS_RDY BV(3)
+
+#ifdef BUILD
+#define ENC_COMMAND(enccs) st(ENCCS = (enccs);)
+#define ENC_WRITE(value) st(ENCDI = (value);)
+#else
+// host builds run the coprocessor model, see sim/cc2510_aes.c
+#define ENC_COMMAND(enccs) aes_model_command(enccs)
+#define ENC_WRITE(value) aes_model_write(value)
+#endif
+
+static void aes_load(uint8_t enccs, const uint8_t *data) {
+  ENC_COMMAND(enccs | ENCCS_ST);
+  for (uint8_t i = 0; i < AES_BLOCK_SIZE; i++) {
+    ENC_WRITE(data[i]);
+  }
+  while (!(ENCCS & ENCCS_RDY)) {
+  }
+}
+
+void aes_load_key(const uint8_t *key) {
+  aes_load(ENCCS_CMD_LOAD_KEY, key);
+}
+
+void aes_load_iv(uint8_t mode, const uint8_t __xdata *iv) {
+  aes_load(mode | ENCCS_CMD_LOAD_IV, iv);
+}
+
+void aes_encrypt(uint8_t mode, const uint8_t __xdata *in, uint8_t __xdata *out, uint8_t blocks) {
+  uint16_t length = (uint16_t)blocks * AES_BLOCK_SIZE;
+  uint8_t count = out ? 2 : 1;
+  uint8_t channel;
+  uint8_t channels;
+
+  // a transfer of another driver in the background frees its channels soon
+  while ((channel = dma_claim(count)) == DMA_CH_NONE) {
+  }
+  channels = (BV(count) - 1) << channel;
+
+  // the engine raises ENC_DW for every input byte and ENC_UP for every
+  // output byte, the channels run over all blocks
+  DMA_SETUP_TX(DMA_DESC(channel), in, DMA_XADDR_ENCDI, length, DMA_WORDSIZE_BYTE | DMA_TMODE_SINGLE | DMA_TRIG_ENC_DW,
+               DMA_PRI_HIGH);
+  if (out) {
+    DMA_SETUP_RX(DMA_DESC(channel + 1), DMA_XADDR_ENCDO, out, length,
+                 DMA_WORDSIZE_BYTE | DMA_TMODE_SINGLE | DMA_TRIG_ENC_UP, DMA_PRI_HIGH);
+  }
+
+  DMA_CLEAR_IRQ(channels);
+  DMA_ARM_MASK(channels);
+  // ST runs a single block, RDY once it is out
+  while (blocks--) {
+    ENC_COMMAND(mode | ENCCS_CMD_ENCRYPT | ENCCS_ST);
+    while (!(ENCCS & ENCCS_RDY)) {
+    }
+  }
+  while ((DMAIRQ & channels) != channels) {
+  }
+  dma_release(channel, count);
+}
+
+#endif
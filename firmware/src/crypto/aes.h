@@ -0,0 +1,30 @@
+#ifndef _AES_H_
+#define _AES_H_
+
+#include "../hal/hal.h"
+#include <stdint.h>
+
+// AES-128 coprocessor. Blocks are moved in and out by two shared DMA
+// channels claimed for each aes_encrypt, the engine is started once per
+// block. The chaining state (CBC-MAC value, CTR counter) carries over from
+// one aes_encrypt to the next until the IV is loaded again.
+
+#define AES_BLOCK_SIZE 16
+
+// ENCCS MODE
+#define AES_MODE_CBC 0x00
+#define AES_MODE_CTR 0x30
+#define AES_MODE_ECB 0x40
+#define AES_MODE_CBC_MAC 0x50 // no output, finish with one AES_MODE_CBC block
+
+void aes_load_key(const uint8_t *key);
+// mode is the one of the blocks that follow, AES_MODE_CBC_MAC for a MAC
+// that ends with an AES_MODE_CBC block
+void aes_load_iv(uint8_t mode, const uint8_t __xdata *iv);
+
+// blocks of 16 bytes from in to out. Each block is read before the one
+// before it is written back, so out may be in itself or up to 16 bytes below
+// it. out is NULL in AES_MODE_CBC_MAC.
+void aes_encrypt(uint8_t mode, const uint8_t __xdata *in, uint8_t __xdata *out, uint8_t blocks);
+
+#endif
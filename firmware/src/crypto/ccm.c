@@ -0,0 +1,87 @@
+#include "ccm.h"
+#include <string.h>
+
+#if defined(LINK_KEY) || !defined(BUILD)
+
+#define FLAGS_B0 0x09 // MIC of 4 bytes, 2 byte length field
+#define FLAGS_A 0x01  // 2 byte counter field
+
+static uint8_t __xdata block[AES_BLOCK_SIZE]; // B0, counter or a partial block
+static uint8_t __xdata mac[AES_BLOCK_SIZE];
+static uint8_t __xdata mic[CCM_MIC_SIZE];
+
+static void ccm_block(uint8_t flags, const uint8_t __xdata *nonce, uint8_t value) {
+  block[0] = flags;
+  memcpy(block + 1, nonce, CCM_NONCE_SIZE);
+  block[AES_BLOCK_SIZE - 2] = 0;
+  block[AES_BLOCK_SIZE - 1] = value;
+}
+
+// CBC-MAC of B0 and the data into mac, the engine only gives out the value
+// of a block run in plain CBC mode so the last one goes through that
+static void ccm_mac(const uint8_t __xdata *nonce, const uint8_t __xdata *data, uint8_t length) {
+  memset(mac, 0, AES_BLOCK_SIZE);
+  aes_load_iv(length ? AES_MODE_CBC_MAC : AES_MODE_CBC, mac);
+  ccm_block(FLAGS_B0, nonce, length);
+  if (!length) {
+    aes_encrypt(AES_MODE_CBC, block, mac, 1);
+    return;
+  }
+  aes_encrypt(AES_MODE_CBC_MAC, block, NULL, 1);
+
+  uint8_t full = length / AES_BLOCK_SIZE;
+  uint8_t rest = length % AES_BLOCK_SIZE;
+  if (!rest) {
+    full--;
+    rest = AES_BLOCK_SIZE;
+  }
+  if (full) {
+    aes_encrypt(AES_MODE_CBC_MAC, data, NULL, full);
+  }
+  memset(block, 0, AES_BLOCK_SIZE);
+  memcpy(block, data + full * AES_BLOCK_SIZE, rest);
+  aes_encrypt(AES_MODE_CBC, block, mac, 1);
+}
+
+// CTR from counter 0: the first block goes over the MIC in mac, the data
+// follows from counter 1
+static void ccm_ctr(const uint8_t __xdata *nonce, const uint8_t __xdata *in, uint8_t __xdata *out,
+                    uint8_t length) {
+  ccm_block(FLAGS_A, nonce, 0);
+  aes_load_iv(AES_MODE_CTR, block);
+  aes_encrypt(AES_MODE_CTR, mac, mac, 1);
+
+  uint8_t full = length / AES_BLOCK_SIZE;
+  uint8_t rest = length % AES_BLOCK_SIZE;
+  if (full) {
+    aes_encrypt(AES_MODE_CTR, in, out, full);
+  }
+  if (rest) {
+    memcpy(block, in + full * AES_BLOCK_SIZE, rest);
+    aes_encrypt(AES_MODE_CTR, block, block, 1);
+    memcpy(out + full * AES_BLOCK_SIZE, block, rest);
+  }
+}
+
+void ccm_seal(const uint8_t __xdata *nonce, uint8_t __xdata *data, uint8_t length) {
+  ccm_mac(nonce, data, length);
+  ccm_ctr(nonce, data, data, length);
+  memcpy(data + length, mac, CCM_MIC_SIZE);
+}
+
+bool ccm_open(const uint8_t __xdata *nonce, const uint8_t __xdata *in, uint8_t __xdata *out,
+              uint8_t length) {
+  // decrypting the received MIC gives back the one computed by the sender
+  memcpy(mac, in + length, CCM_MIC_SIZE);
+  ccm_ctr(nonce, in, out, length);
+  memcpy(mic, mac, CCM_MIC_SIZE);
+
+  ccm_mac(nonce, out, length);
+  uint8_t diff = 0;
+  for (uint8_t i = 0; i < CCM_MIC_SIZE; i++) {
+    diff |= mic[i] ^ mac[i];
+  }
+  return !diff;
+}
+
+#endif
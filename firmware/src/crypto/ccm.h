@@ -0,0 +1,21 @@
+#ifndef _CCM_H_
+#define _CCM_H_
+
+#include "aes.h"
+
+// AES-CCM (RFC 3610) with a 13 byte nonce, a 4 byte MIC and no associated
+// data, on the key last given to aes_load_key.
+
+#define CCM_NONCE_SIZE 13
+#define CCM_MIC_SIZE 4
+
+// encrypts length bytes in place and writes the MIC behind them
+void ccm_seal(const uint8_t __xdata *nonce, uint8_t __xdata *data, uint8_t length);
+
+// decrypts length bytes followed by their MIC from in to out, out may be in
+// or up to 16 bytes below it. False when the MIC does not match, out then
+// holds garbage.
+bool ccm_open(const uint8_t __xdata *nonce, const uint8_t __xdata *in, uint8_t __xdata *out,
+              uint8_t length);
+
+#endif
@@ -0,0 +1,159 @@
+#include "link.h"
+#include "../cobs/cobs.h"
+#include "../hal/spiflash.h"
+#include <string.h>
+
+#ifdef LINK_KEY
+
+#define EPOCH_RECORD_SIZE 4
+#define EPOCH_RECORDS (SPIFLASH_SECTOR_SIZE / EPOCH_RECORD_SIZE)
+#define EPOCH_SECTOR(i) (LINK_EPOCH_ADDRESS + (uint32_t)(i)*SPIFLASH_SECTOR_SIZE)
+#define EPOCH_EMPTY 0xFFFFFFFFUL
+#define ANNOUNCE_SIZE 4
+#define TX_FRAME_SIZE (LINK_TX_HEADER + LINK_MAX_PLAINTEXT + CCM_MIC_SIZE)
+
+#if COBS_FRAME_SIZE(TX_FRAME_SIZE) > UART_TX_BUFFER_SIZE
+#error "a sealed frame must fit a UART TX buffer"
+#endif
+
+LinkStats __xdata link_stats;
+
+static __code const uint8_t key[AES_BLOCK_SIZE] = {LINK_KEY};
+
+static uint8_t __xdata id[LINK_ID_SIZE];
+static uint32_t epoch;
+static uint32_t tx_counter;
+static uint32_t rx_counter; // last host counter accepted
+static bool announce_pending;
+
+static uint8_t __xdata nonce[CCM_NONCE_SIZE];
+static uint8_t __xdata tx_buffer[TX_FRAME_SIZE];
+
+static void put_u32(uint8_t __xdata *data, uint32_t value) {
+  data[0] = value >> 24;
+  data[1] = value >> 16;
+  data[2] = value >> 8;
+  data[3] = value;
+}
+
+static uint32_t get_u32(const uint8_t __xdata *data) {
+  return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint16_t)data[2] << 8) | data[3];
+}
+
+static uint32_t epoch_read(uint32_t address) {
+  uint32_t value = 0;
+  spiflash_read_begin(address);
+  for (uint8_t i = 0; i < EPOCH_RECORD_SIZE; i++) {
+    value = (value << 8) | spiflash_read_byte();
+  }
+  spiflash_read_end();
+  return value;
+}
+
+// records are appended in order, the programmed ones form a prefix
+static uint16_t epoch_count(uint32_t sector) {
+  uint16_t low = 0;
+  uint16_t high = EPOCH_RECORDS;
+  while (low < high) {
+    uint16_t middle = (low + high) / 2;
+    if (epoch_read(sector + middle * EPOCH_RECORD_SIZE) == EPOCH_EMPTY) {
+      high = middle;
+    } else {
+      low = middle + 1;
+    }
+  }
+  return low;
+}
+
+// An interrupted program only clears some of the bits, which leaves a value
+// above the intended one, so the last record of a sector is its largest. A
+// full sector is continued in the other one, erased first, so the largest
+// value survives an erase that is cut short.
+static void epoch_next(void) {
+  uint16_t count[2];
+  uint32_t last[2];
+  for (uint8_t i = 0; i < 2; i++) {
+    count[i] = epoch_count(EPOCH_SECTOR(i));
+    last[i] = count[i] ? epoch_read(EPOCH_SECTOR(i) + (count[i] - 1) * EPOCH_RECORD_SIZE) : 0;
+  }
+
+  uint8_t sector = last[1] > last[0];
+  epoch = last[sector] + 1;
+  if (count[sector] == EPOCH_RECORDS) {
+    sector ^= 1;
+    spiflash_erase_sector(EPOCH_SECTOR(sector));
+    count[sector] = 0;
+  }
+  put_u32(tx_buffer, epoch);
+  spiflash_program(EPOCH_SECTOR(sector) + count[sector] * EPOCH_RECORD_SIZE, tx_buffer,
+                   EPOCH_RECORD_SIZE);
+}
+
+static void link_nonce(uint8_t direction, uint32_t counter) {
+  nonce[0] = direction;
+  put_u32(nonce + 1, epoch);
+  put_u32(nonce + 5, counter);
+  memcpy(nonce + 9, id, LINK_ID_SIZE);
+}
+
+void link_init(void) {
+  spiflash_unique_id(tx_buffer);
+  for (uint8_t i = 0; i < LINK_ID_SIZE; i++) {
+    id[i] = tx_buffer[i] ^ tx_buffer[i + LINK_ID_SIZE];
+  }
+  epoch_next();
+  tx_counter = 0;
+  rx_counter = 0;
+  link_stats.rx_rejected = 0;
+  link_stats.announces = 0;
+  // tell the host the new epoch as soon as it talks to us
+  announce_pending = true;
+}
+
+uint8_t __xdata *link_tx_buffer(void) {
+  return tx_buffer + LINK_TX_HEADER;
+}
+
+static void link_seal(uint32_t counter, uint8_t length) {
+  memcpy(tx_buffer, id, LINK_ID_SIZE);
+  put_u32(tx_buffer + LINK_ID_SIZE, epoch);
+  put_u32(tx_buffer + LINK_ID_SIZE + 4, counter);
+  link_nonce(0, counter);
+  // the key is lost in PM2
+  aes_load_key(key);
+  ccm_seal(nonce, tx_buffer + LINK_TX_HEADER, length);
+  cobs_send(tx_buffer, LINK_TX_HEADER + length + CCM_MIC_SIZE);
+}
+
+void link_send(uint8_t length) {
+  link_seal(++tx_counter, length);
+}
+
+bool link_open(PoolBlock __xdata *frame) {
+  if (frame->length >= LINK_RX_OVERHEAD) {
+    uint32_t counter = get_u32(frame->data);
+    uint8_t length = frame->length - LINK_RX_OVERHEAD;
+    link_nonce(1, counter);
+    aes_load_key(key);
+    if (counter > rx_counter && ccm_open(nonce, frame->data + LINK_RX_HEADER, frame->data, length)) {
+      rx_counter = counter;
+      frame->length = length;
+      return true;
+    }
+  }
+  link_stats.rx_rejected++;
+  announce_pending = true;
+  return false;
+}
+
+void link_poll(void) {
+  if (!announce_pending) {
+    return;
+  }
+  announce_pending = false;
+  link_stats.announces++;
+  put_u32(link_tx_buffer(), rx_counter + 1);
+  link_seal(++tx_counter | LINK_ANNOUNCE, ANNOUNCE_SIZE);
+}
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef _LINK_H_
+#define _LINK_H_
+
+#include "../hal/hal.h"
+#include "../pool/pool.h"
+#include "ccm.h"
+#include <stdint.h>
+
+// Encrypted and authenticated host link, built in by defining LINK_KEY as
+// the 16 comma separated bytes of the key (make LINK_KEY=<32 hex digits>).
+// The transport frame is sealed with AES-CCM and its CRC left out:
+//   tag to host:  id | epoch | counter | ciphertext | mic
+//   host to tag:  counter | ciphertext | mic
+// Counters count frames per direction, big endian. The epoch goes up on
+// every boot and is kept in the external flash, both nonces include it:
+//   tag:   0 | epoch | counter | id
+//   host:  1 | epoch | counter | id
+// so nothing recorded before a reboot is accepted, and a host frame is only
+// accepted with a counter above the last one. All tags share the key, the id
+// keeps their nonces apart: the factory unique ID of the flash folded to 32
+// bits, which the host reads off the tag's frames. A host frame that is
+// refused is answered with an announcement, a tag frame with LINK_ANNOUNCE
+// set in its counter carrying the next host counter the tag accepts.
+
+#define LINK_ID_SIZE 4
+#define LINK_TX_HEADER (LINK_ID_SIZE + 8)
+#define LINK_RX_HEADER 4
+#define LINK_RX_OVERHEAD (LINK_RX_HEADER + CCM_MIC_SIZE)
+#define LINK_MAX_PLAINTEXT (POOL_BLOCK_SIZE - LINK_RX_OVERHEAD)
+
+#define LINK_ANNOUNCE 0x80000000UL
+
+// two sectors of epoch records, written alternately
+#define LINK_EPOCH_ADDRESS 0x11000UL
+
+typedef struct {
+  uint16_t rx_rejected; // failed the MIC or replayed
+  uint16_t announces;
+} LinkStats;
+
+extern LinkStats __xdata link_stats;
+
+void link_init(void); // after ota_init, needs the external flash
+
+// room for LINK_MAX_PLAINTEXT bytes of the next frame, link_send seals the
+// first length of them and hands the frame to COBS
+uint8_t __xdata *link_tx_buffer(void);
+void link_send(uint8_t length);
+
+// decrypts a received frame in place, its data then starts with the
+// plaintext. False when it was refused.
+bool link_open(PoolBlock __xdata *frame);
+
+// sends a pending announcement
+void link_poll(void);
+
+#endif
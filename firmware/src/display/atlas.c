@@ -0,0 +1,691 @@
+// generated by firmware/tools/gen-fonts.js from firmware/tools/fonts.json,
+// do not edit
+#include "text.h"
+
+// sans_16: Lato-Regular.ttf at 16px, 19px lines
+static __code const uint8_t sans_16_bitmaps[1124] = {
+    0x01, 0x80, 0x06, 0xC0, 0x01, 0x80, 0x02, 0x00, 0x02, 0xC0, 0x90, 0xD0,
+    0xD0, 0xD0, 0x90, 0x12, 0x36, 0x26, 0x24, 0xFF, 0x64, 0x6C, 0xFE, 0xFE,
+    0x48, 0xC8, 0xD8, 0x08, 0x3C, 0x7E, 0xDA, 0xD8, 0xD8, 0x78, 0x3E, 0x1E,
+    0x13, 0x13, 0xD6, 0x7C, 0x10, 0x10, 0x30, 0x20, 0x78, 0x60, 0xCC, 0xC0,
+    0xCD, 0x80, 0x4D, 0x00, 0x7B, 0x00, 0x06, 0xE0, 0x0D, 0xF0, 0x09, 0x10,
+    0x19, 0x10, 0x31, 0xB0, 0x60, 0xE0, 0x1C, 0x00, 0x3E, 0x00, 0x62, 0x00,
+    0x60, 0x00, 0x60, 0x00, 0x30, 0x00, 0x78, 0x80, 0xCD, 0x80, 0x87, 0x80,
+    0x83, 0x00, 0xC7, 0x80, 0x7C, 0xC0, 0x80, 0xC0, 0xC0, 0xC0, 0x80, 0x20,
+    0x60, 0x40, 0xC0, 0xC0, 0xC0, 0x80, 0x80, 0xC0, 0xC0, 0xC0, 0x40, 0x60,
+    0x20, 0xC0, 0x60, 0x60, 0x20, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x20,
+    0x60, 0x60, 0xC0, 0x20, 0xF8, 0x70, 0xF8, 0x20, 0x10, 0x10, 0x10, 0xFF,
+    0x18, 0x10, 0x10, 0x10, 0xC0, 0xC0, 0xC0, 0x80, 0xF0, 0xF0, 0xC0, 0xC0,
+    0x04, 0x0C, 0x08, 0x18, 0x18, 0x10, 0x30, 0x20, 0x60, 0x60, 0x40, 0xC0,
+    0x80, 0x1C, 0x00, 0x3F, 0x00, 0x63, 0x00, 0x61, 0x80, 0xC1, 0x80, 0xC1,
+    0x80, 0xC1, 0x80, 0xC1, 0x80, 0x41, 0x80, 0x61, 0x00, 0x77, 0x00, 0x3E,
+    0x00, 0x10, 0x30, 0xF0, 0xD0, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0xFE, 0x38, 0x7E, 0xC6, 0xC2, 0x06, 0x06, 0x0C, 0x18, 0x30, 0x60, 0xE0,
+    0xFF, 0x3C, 0x7E, 0xC6, 0xC2, 0x06, 0x1E, 0x1E, 0x02, 0x03, 0xC3, 0xE6,
+    0x7C, 0x02, 0x00, 0x06, 0x00, 0x0E, 0x00, 0x1A, 0x00, 0x1A, 0x00, 0x32,
+    0x00, 0x62, 0x00, 0xE3, 0x00, 0xFF, 0x80, 0x02, 0x00, 0x02, 0x00, 0x02,
+    0x00, 0x7E, 0x7E, 0x40, 0x40, 0x40, 0xFC, 0x06, 0x06, 0x02, 0x06, 0xCE,
+    0xFC, 0x0C, 0x1C, 0x18, 0x30, 0x60, 0x7C, 0xE6, 0xC3, 0x83, 0xC3, 0xE6,
+    0x7C, 0xFF, 0xFF, 0x02, 0x06, 0x04, 0x0C, 0x08, 0x18, 0x10, 0x30, 0x20,
+    0x60, 0x38, 0x7E, 0xC6, 0xC2, 0xC6, 0x7C, 0x7E, 0xC6, 0x83, 0xC3, 0xC6,
+    0x7C, 0x3C, 0x7E, 0xC3, 0xC3, 0xC3, 0xC7, 0x7E, 0x0E, 0x0C, 0x18, 0x38,
+    0x30, 0x02, 0xC0, 0x04, 0x00, 0x02, 0xC0, 0xC0, 0xC0, 0x00, 0x00, 0x00,
+    0x00, 0xC0, 0xC0, 0x40, 0x80, 0x06, 0x1C, 0x78, 0xE0, 0x70, 0x1C, 0x06,
+    0xFE, 0x00, 0xFE, 0xFE, 0x80, 0xE0, 0x38, 0x1C, 0x38, 0xE0, 0x80, 0x38,
+    0xFC, 0x0C, 0x0C, 0x0C, 0x18, 0x30, 0x30, 0x00, 0x00, 0x30, 0x30, 0x1F,
+    0x00, 0x39, 0xC0, 0x60, 0x60, 0xC7, 0x20, 0x8F, 0xB0, 0x99, 0x30, 0x91,
+    0x30, 0x93, 0x20, 0x9F, 0xE0, 0xCD, 0x80, 0x60, 0x00, 0x30, 0xE0, 0x1F,
+    0x80, 0x04, 0x00, 0x0E, 0x00, 0x0E, 0x00, 0x1B, 0x00, 0x1B, 0x00, 0x33,
+    0x00, 0x31, 0x80, 0x31, 0x80, 0x7F, 0xC0, 0x60, 0xC0, 0xC0, 0xC0, 0xC0,
+    0x60, 0x7C, 0x00, 0xFF, 0x00, 0xC3, 0x00, 0xC3, 0x00, 0xC3, 0x00, 0xCE,
+    0x00, 0xFE, 0x00, 0xC3, 0x00, 0xC1, 0x80, 0xC1, 0x80, 0xC7, 0x00, 0xFE,
+    0x00, 0x1E, 0x00, 0x3F, 0x80, 0x60, 0x80, 0xC0, 0x00, 0xC0, 0x00, 0xC0,
+    0x00, 0x80, 0x00, 0xC0, 0x00, 0xC0, 0x00, 0xE0, 0x00, 0x73, 0x80, 0x3F,
+    0x00, 0x7C, 0x00, 0xFF, 0x00, 0xC1, 0x80, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0,
+    0x40, 0xC0, 0x40, 0xC0, 0xC0, 0xC0, 0xC0, 0xC1, 0xC0, 0xC7, 0x80, 0xFF,
+    0x00, 0x7E, 0xFF, 0xC0, 0xC0, 0xC0, 0xFC, 0xFE, 0xC0, 0xC0, 0xC0, 0xC0,
+    0xFF, 0x01, 0x7E, 0x01, 0xFF, 0x04, 0xC0, 0x01, 0xFE, 0x05, 0xC0, 0x1F,
+    0x00, 0x3F, 0xC0, 0x60, 0x80, 0xC0, 0x00, 0xC0, 0x00, 0xC0, 0x00, 0x83,
+    0xC0, 0xC3, 0xC0, 0xC0, 0xC0, 0xE0, 0xC0, 0x71, 0xC0, 0x3F, 0x80, 0x01,
+    0x40, 0xC0, 0x05, 0xC0, 0xC0, 0x01, 0xFF, 0xC0, 0x05, 0xC0, 0xC0, 0x0C,
+    0x80, 0x0A, 0x0C, 0x01, 0x18, 0x01, 0xF8, 0x40, 0x80, 0xC1, 0x80, 0xC3,
+    0x00, 0xC6, 0x00, 0xCC, 0x00, 0xF8, 0x00, 0xF8, 0x00, 0xCC, 0x00, 0xC6,
+    0x00, 0xC3, 0x00, 0xC3, 0x80, 0xC1, 0xC0, 0x01, 0x40, 0x0A, 0xC0, 0x01,
+    0xFE, 0x40, 0x10, 0xE0, 0x30, 0xE0, 0x30, 0xF0, 0x70, 0xF0, 0xD0, 0xD8,
+    0xD0, 0xC9, 0x90, 0xCD, 0x90, 0xC7, 0x10, 0xC7, 0x10, 0xC0, 0x10, 0xC0,
+    0x10, 0x40, 0xC0, 0xC0, 0xC0, 0xE0, 0xC0, 0xF0, 0xC0, 0xD8, 0xC0, 0xDC,
+    0xC0, 0xCC, 0xC0, 0xC6, 0xC0, 0xC3, 0xC0, 0xC3, 0xC0, 0xC1, 0xC0, 0xC0,
+    0xC0, 0x1E, 0x00, 0x3F, 0x80, 0x60, 0xC0, 0xC0, 0x60, 0xC0, 0x60, 0xC0,
+    0x60, 0x80, 0x60, 0xC0, 0x60, 0xC0, 0x60, 0xE0, 0xC0, 0x7B, 0xC0, 0x3F,
+    0x00, 0x78, 0xFE, 0xC3, 0xC3, 0xC3, 0xC3, 0xFF, 0xFC, 0xC0, 0xC0, 0xC0,
+    0xC0, 0x1E, 0x00, 0x3F, 0x80, 0x60, 0xC0, 0xC0, 0x60, 0xC0, 0x60, 0xC0,
+    0x60, 0x80, 0x60, 0xC0, 0x60, 0xC0, 0x60, 0xE0, 0xC0, 0x7B, 0xC0, 0x3F,
+    0x80, 0x00, 0xC0, 0x00, 0x60, 0x78, 0x00, 0xFE, 0x00, 0xC3, 0x00, 0xC3,
+    0x00, 0xC3, 0x00, 0xC7, 0x00, 0xFE, 0x00, 0xDC, 0x00, 0xC6, 0x00, 0xC6,
+    0x00, 0xC3, 0x00, 0xC1, 0x80, 0x1C, 0x3F, 0x62, 0x60, 0x60, 0x7C, 0x1E,
+    0x03, 0x03, 0x03, 0xE7, 0x7E, 0x02, 0xFF, 0x80, 0x0A, 0x0C, 0x00, 0x01,
+    0xC0, 0x80, 0x07, 0xC0, 0xC0, 0x01, 0xC0, 0x80, 0x01, 0xE1, 0x80, 0x01,
+    0x77, 0x80, 0x01, 0x3F, 0x00, 0x02, 0xC0, 0x60, 0x02, 0x60, 0xC0, 0x01,
+    0x61, 0x80, 0x02, 0x31, 0x80, 0x02, 0x1B, 0x00, 0x01, 0x1E, 0x00, 0x02,
+    0x0E, 0x00, 0xC0, 0x81, 0xC1, 0x83, 0xE1, 0xC3, 0x63, 0xC7, 0x63, 0xC6,
+    0x73, 0x66, 0x36, 0x66, 0x36, 0x6C, 0x3C, 0x3C, 0x1C, 0x3C, 0x1C, 0x38,
+    0x18, 0x18, 0xC0, 0xC0, 0x60, 0xC0, 0x71, 0x80, 0x33, 0x00, 0x1F, 0x00,
+    0x1E, 0x00, 0x0E, 0x00, 0x1E, 0x00, 0x33, 0x00, 0x31, 0x80, 0x61, 0x80,
+    0xC0, 0xC0, 0x01, 0xC0, 0xC0, 0x01, 0xE0, 0xC0, 0x01, 0x61, 0x80, 0x02,
+    0x33, 0x00, 0x02, 0x1E, 0x00, 0x05, 0x0C, 0x00, 0xFF, 0xFF, 0x03, 0x06,
+    0x0C, 0x1C, 0x18, 0x30, 0x70, 0x60, 0xE0, 0xFF, 0x01, 0xE0, 0x0C, 0x80,
+    0x01, 0xE0, 0x80, 0xC0, 0x40, 0x60, 0x60, 0x20, 0x30, 0x10, 0x18, 0x18,
+    0x08, 0x0C, 0x04, 0x01, 0xE0, 0x0C, 0x60, 0x01, 0xE0, 0x10, 0x38, 0x38,
+    0x6C, 0x44, 0xC6, 0xFC, 0x80, 0xC0, 0x40, 0xFC, 0xCC, 0x04, 0x3C, 0xFC,
+    0x84, 0x8C, 0xF4, 0xC0, 0xC0, 0xC0, 0xC0, 0xFC, 0xE6, 0xC2, 0xC2, 0xC2,
+    0xC6, 0xC6, 0xFC, 0x3E, 0x62, 0x60, 0xC0, 0xC0, 0x60, 0x62, 0x3E, 0x03,
+    0x03, 0x03, 0x03, 0x3F, 0x63, 0x63, 0xC3, 0xC3, 0x43, 0x67, 0x3F, 0x3E,
+    0x63, 0x43, 0xFF, 0xC0, 0x60, 0x63, 0x3E, 0x01, 0x18, 0x01, 0x38, 0x02,
+    0x60, 0x01, 0xF8, 0x07, 0x60, 0x7F, 0x66, 0x46, 0x66, 0x3C, 0x60, 0x7E,
+    0x7F, 0xC3, 0xE7, 0x7C, 0x04, 0xC0, 0x01, 0xFC, 0x07, 0xC6, 0x02, 0xC0,
+    0x02, 0x00, 0x08, 0xC0, 0x02, 0x30, 0x02, 0x00, 0x0A, 0x30, 0x01, 0xE0,
+    0xC0, 0xC0, 0xC0, 0xC0, 0xC6, 0xCC, 0xD8, 0xF0, 0xF8, 0xD8, 0xCC, 0xC6,
+    0x0C, 0xC0, 0x01, 0xFF, 0xE0, 0x01, 0xCE, 0x60, 0x01, 0xC6, 0x20, 0x05,
+    0xC4, 0x20, 0x01, 0xFC, 0x07, 0xC6, 0x3E, 0x63, 0x63, 0xC1, 0xC1, 0x63,
+    0x63, 0x3E, 0xFC, 0xC6, 0xC6, 0xC2, 0xC2, 0xC6, 0xC6, 0xFC, 0xC0, 0xC0,
+    0xC0, 0x3F, 0x63, 0x63, 0xC3, 0xC3, 0x43, 0x67, 0x3F, 0x03, 0x03, 0x03,
+    0x01, 0xF8, 0x01, 0xE0, 0x06, 0xC0, 0xF8, 0x88, 0xC0, 0xF0, 0x38, 0x08,
+    0x98, 0xF8, 0x03, 0x20, 0x01, 0xFC, 0x06, 0x20, 0x01, 0x3C, 0x06, 0xC6,
+    0x01, 0xCE, 0x01, 0x7E, 0xC3, 0x43, 0x66, 0x66, 0x34, 0x3C, 0x1C, 0x18,
+    0xC6, 0x30, 0xC7, 0x30, 0x6F, 0x30, 0x6F, 0x60, 0x69, 0xE0, 0x39, 0xE0,
+    0x39, 0xC0, 0x30, 0xC0, 0x62, 0x66, 0x3C, 0x18, 0x3C, 0x3C, 0x66, 0xC3,
+    0xC3, 0x63, 0x66, 0x66, 0x34, 0x3C, 0x18, 0x18, 0x18, 0x30, 0x30, 0x7E,
+    0x06, 0x0C, 0x18, 0x30, 0x30, 0x60, 0xFE, 0x70, 0x60, 0x40, 0x60, 0x60,
+    0x60, 0xC0, 0xC0, 0x60, 0x60, 0x60, 0x40, 0x60, 0x70, 0x0F, 0x80, 0x01,
+    0xC0, 0x0C, 0x60, 0x01, 0xC0, 0x72, 0xFE, 0x80,
+};
+
+static __code const FontGlyph sans_16_glyphs[95] = {
+    {0x0000, 0, 0, 0, 0, 3}, // ' '
+    {0x8000, 2, 12, 2, 4, 5}, // '!'
+    {0x000A, 4, 5, 1, 4, 6}, // '"'
+    {0x000F, 8, 12, 1, 4, 9}, // '#'
+    {0x001B, 8, 15, 1, 3, 9}, // '$'
+    {0x002A, 12, 12, 0, 4, 13}, // '%'
+    {0x0042, 10, 12, 1, 4, 11}, // '&'
+    {0x005A, 2, 5, 1, 4, 4}, // '\''
+    {0x005F, 3, 14, 1, 4, 5}, // '('
+    {0x006D, 4, 14, 0, 4, 5}, // ')'
+    {0x007B, 5, 5, 1, 4, 6}, // '*'
+    {0x0080, 8, 8, 1, 7, 9}, // '+'
+    {0x0088, 2, 4, 1, 14, 3}, // ','
+    {0x008C, 4, 2, 1, 10, 6}, // '-'
+    {0x008E, 2, 2, 1, 14, 3}, // '.'
+    {0x0090, 6, 13, 0, 4, 6}, // '/'
+    {0x009D, 9, 12, 0, 4, 9}, // '0'
+    {0x00B5, 7, 12, 2, 4, 9}, // '1'
+    {0x00C1, 8, 12, 1, 4, 9}, // '2'
+    {0x00CD, 8, 12, 1, 4, 9}, // '3'
+    {0x00D9, 9, 12, 0, 4, 9}, // '4'
+    {0x00F1, 7, 12, 1, 4, 9}, // '5'
+    {0x00FD, 8, 12, 1, 4, 9}, // '6'
+    {0x0109, 8, 12, 1, 4, 9}, // '7'
+    {0x0115, 8, 12, 1, 4, 9}, // '8'
+    {0x0121, 8, 12, 1, 4, 9}, // '9'
+    {0x812D, 2, 8, 1, 8, 4}, // ':'
+    {0x0133, 2, 10, 1, 8, 4}, // ';'
+    {0x013D, 7, 7, 1, 7, 9}, // '<'
+    {0x0144, 7, 4, 1, 9, 9}, // '='
+    {0x0148, 6, 7, 2, 7, 9}, // '>'
+    {0x014F, 6, 12, 0, 4, 6}, // '?'
+    {0x015B, 12, 13, 1, 5, 13}, // '@'
+    {0x0175, 11, 12, 0, 4, 11}, // 'A'
+    {0x018D, 9, 12, 1, 4, 10}, // 'B'
+    {0x01A5, 9, 12, 1, 4, 11}, // 'C'
+    {0x01BD, 10, 12, 1, 4, 12}, // 'D'
+    {0x01D5, 8, 12, 1, 4, 9}, // 'E'
+    {0x81E1, 8, 12, 1, 4, 9}, // 'F'
+    {0x01EB, 10, 12, 1, 4, 12}, // 'G'
+    {0x8203, 10, 12, 1, 4, 12}, // 'H'
+    {0x820F, 1, 12, 2, 4, 5}, // 'I'
+    {0x8211, 6, 12, 0, 4, 7}, // 'J'
+    {0x0217, 10, 12, 1, 4, 11}, // 'K'
+    {0x822F, 7, 12, 1, 4, 8}, // 'L'
+    {0x0235, 12, 12, 1, 4, 15}, // 'M'
+    {0x024D, 10, 12, 1, 4, 12}, // 'N'
+    {0x0265, 11, 12, 1, 4, 13}, // 'O'
+    {0x027D, 8, 12, 1, 4, 10}, // 'P'
+    {0x0289, 11, 14, 1, 4, 13}, // 'Q'
+    {0x02A5, 9, 12, 1, 4, 10}, // 'R'
+    {0x02BD, 8, 12, 0, 4, 8}, // 'S'
+    {0x82C9, 9, 12, 0, 4, 9}, // 'T'
+    {0x82CF, 10, 12, 1, 4, 12}, // 'U'
+    {0x82E1, 11, 12, 0, 4, 11}, // 'V'
+    {0x02F6, 16, 12, 0, 4, 16}, // 'W'
+    {0x030E, 10, 12, 0, 4, 10}, // 'X'
+    {0x8326, 10, 12, 0, 4, 10}, // 'Y'
+    {0x0338, 8, 12, 1, 4, 10}, // 'Z'
+    {0x8344, 3, 14, 1, 4, 5}, // '['
+    {0x034A, 6, 13, 0, 4, 6}, // '\\'
+    {0x8357, 3, 14, 1, 4, 5}, // ']'
+    {0x035D, 7, 6, 1, 4, 9}, // '^'
+    {0x0363, 6, 1, 0, 17, 6}, // '_'
+    {0x0364, 2, 3, 1, 4, 5}, // '`'
+    {0x0367, 6, 8, 1, 8, 8}, // 'a'
+    {0x036F, 7, 12, 1, 4, 9}, // 'b'
+    {0x037B, 7, 8, 0, 8, 7}, // 'c'
+    {0x0383, 8, 12, 0, 4, 9}, // 'd'
+    {0x038F, 8, 8, 0, 8, 8}, // 'e'
+    {0x8397, 5, 12, 0, 4, 5}, // 'f'
+    {0x03A1, 8, 11, 0, 8, 8}, // 'g'
+    {0x83AC, 7, 12, 1, 4, 9}, // 'h'
+    {0x83B2, 2, 12, 1, 4, 4}, // 'i'
+    {0x83B8, 4, 15, -1, 4, 4}, // 'j'
+    {0x03C0, 7, 12, 1, 4, 8}, // 'k'
+    {0x83CC, 2, 12, 1, 4, 4}, // 'l'
+    {0x83CE, 11, 8, 1, 8, 13}, // 'm'
+    {0x83DA, 7, 8, 1, 8, 9}, // 'n'
+    {0x03DE, 8, 8, 0, 8, 9}, // 'o'
+    {0x03E6, 7, 11, 1, 8, 9}, // 'p'
+    {0x03F1, 8, 11, 0, 8, 9}, // 'q'
+    {0x83FC, 5, 8, 1, 8, 6}, // 'r'
+    {0x0402, 5, 8, 1, 8, 7}, // 's'
+    {0x840A, 6, 11, 0, 5, 6}, // 't'
+    {0x8412, 7, 8, 1, 8, 9}, // 'u'
+    {0x0418, 8, 8, 0, 8, 8}, // 'v'
+    {0x0420, 12, 8, 0, 8, 12}, // 'w'
+    {0x0430, 8, 8, 0, 8, 8}, // 'x'
+    {0x0438, 8, 11, 0, 8, 8}, // 'y'
+    {0x0443, 7, 8, 0, 8, 7}, // 'z'
+    {0x044B, 4, 14, 0, 4, 5}, // '{'
+    {0x8459, 1, 15, 2, 4, 5}, // '|'
+    {0x845B, 3, 14, 1, 4, 5}, // '}'
+    {0x0461, 7, 3, 1, 10, 9}, // '~'
+};
+
+static __code const FontKern sans_16_kerning[307] = {
+    {'"', '&', -1},
+    {'"', ',', -2},
+    {'"', '-', -1},
+    {'"', '.', -2},
+    {'"', '/', -1},
+    {'"', 'A', -1},
+    {'"', 'a', -1},
+    {'"', 'c', -1},
+    {'"', 'd', -1},
+    {'"', 'e', -1},
+    {'"', 'o', -1},
+    {'"', 'q', -1},
+    {'\'', '&', -1},
+    {'\'', ',', -2},
+    {'\'', '-', -1},
+    {'\'', '.', -2},
+    {'\'', '/', -1},
+    {'\'', 'A', -1},
+    {'\'', 'a', -1},
+    {'\'', 'c', -1},
+    {'\'', 'd', -1},
+    {'\'', 'e', -1},
+    {'\'', 'o', -1},
+    {'\'', 'q', -1},
+    {'*', '&', -1},
+    {'*', ',', -2},
+    {'*', '-', -1},
+    {'*', '.', -2},
+    {'*', '/', -1},
+    {'*', 'A', -1},
+    {'*', 'a', -1},
+    {'*', 'c', -1},
+    {'*', 'd', -1},
+    {'*', 'e', -1},
+    {'*', 'o', -1},
+    {'*', 'q', -1},
+    {',', '"', -2},
+    {',', '\'', -2},
+    {',', '*', -2},
+    {',', '-', -1},
+    {',', 'T', -1},
+    {',', 'V', -1},
+    {',', 'W', -1},
+    {',', 'Y', -1},
+    {',', '\\', -1},
+    {',', 'v', -1},
+    {',', 'y', -1},
+    {'-', '"', -1},
+    {'-', '\'', -1},
+    {'-', '*', -1},
+    {'-', ',', -1},
+    {'-', '.', -1},
+    {'-', 'T', -1},
+    {'-', 'V', -1},
+    {'-', 'Y', -1},
+    {'-', '\\', -1},
+    {'.', '"', -2},
+    {'.', '\'', -2},
+    {'.', '*', -2},
+    {'.', '-', -1},
+    {'.', 'T', -1},
+    {'.', 'V', -1},
+    {'.', 'W', -1},
+    {'.', 'Y', -1},
+    {'.', '\\', -1},
+    {'.', 'v', -1},
+    {'.', 'y', -1},
+    {'/', '&', -1},
+    {'/', ',', -2},
+    {'/', '-', -1},
+    {'/', '.', -2},
+    {'/', '/', -1},
+    {'/', ':', -1},
+    {'/', ';', -1},
+    {'/', 'A', -1},
+    {'/', 'J', -1},
+    {'/', 'a', -1},
+    {'/', 'c', -1},
+    {'/', 'd', -1},
+    {'/', 'e', -1},
+    {'/', 'g', -1},
+    {'/', 'm', -1},
+    {'/', 'n', -1},
+    {'/', 'o', -1},
+    {'/', 'p', -1},
+    {'/', 'q', -1},
+    {'/', 'r', -1},
+    {'/', 's', -1},
+    {'/', 'u', -1},
+    {'/', 'z', -1},
+    {'@', 'T', -1},
+    {'@', 'Y', -1},
+    {'@', 'Z', -1},
+    {'A', '"', -1},
+    {'A', '\'', -1},
+    {'A', '*', -1},
+    {'A', 'T', -1},
+    {'A', 'V', -1},
+    {'A', 'W', -1},
+    {'A', 'Y', -1},
+    {'A', '\\', -1},
+    {'A', 'v', -1},
+    {'A', 'y', -1},
+    {'C', '-', -1},
+    {'D', 'T', -1},
+    {'D', 'Y', -1},
+    {'D', 'Z', -1},
+    {'F', '&', -1},
+    {'F', ',', -1},
+    {'F', '.', -1},
+    {'F', '/', -1},
+    {'F', 'A', -1},
+    {'F', 'J', -2},
+    {'F', 'c', -1},
+    {'F', 'd', -1},
+    {'F', 'e', -1},
+    {'F', 'o', -1},
+    {'F', 'q', -1},
+    {'K', 't', -1},
+    {'K', 'v', -1},
+    {'K', 'y', -1},
+    {'L', '"', -2},
+    {'L', '\'', -2},
+    {'L', '*', -2},
+    {'L', '-', -2},
+    {'L', '@', -1},
+    {'L', 'C', -1},
+    {'L', 'G', -1},
+    {'L', 'O', -1},
+    {'L', 'Q', -1},
+    {'L', 'T', -1},
+    {'L', 'V', -1},
+    {'L', 'W', -1},
+    {'L', 'Y', -2},
+    {'L', '\\', -1},
+    {'L', 'v', -1},
+    {'L', 'w', -1},
+    {'L', 'y', -1},
+    {'O', 'T', -1},
+    {'O', 'Y', -1},
+    {'O', 'Z', -1},
+    {'P', '&', -1},
+    {'P', ',', -2},
+    {'P', '.', -2},
+    {'P', '/', -1},
+    {'P', 'A', -1},
+    {'P', 'J', -1},
+    {'Q', 'T', -1},
+    {'Q', 'Y', -1},
+    {'Q', 'Z', -1},
+    {'T', '&', -1},
+    {'T', ',', -1},
+    {'T', '-', -1},
+    {'T', '.', -1},
+    {'T', '/', -1},
+    {'T', ':', -1},
+    {'T', ';', -1},
+    {'T', '@', -1},
+    {'T', 'A', -1},
+    {'T', 'C', -1},
+    {'T', 'G', -1},
+    {'T', 'J', -2},
+    {'T', 'O', -1},
+    {'T', 'Q', -1},
+    {'T', 'a', -2},
+    {'T', 'c', -2},
+    {'T', 'd', -2},
+    {'T', 'e', -2},
+    {'T', 'g', -2},
+    {'T', 'm', -1},
+    {'T', 'n', -1},
+    {'T', 'o', -2},
+    {'T', 'p', -1},
+    {'T', 'q', -2},
+    {'T', 'r', -1},
+    {'T', 's', -1},
+    {'T', 'u', -1},
+    {'T', 'v', -1},
+    {'T', 'w', -1},
+    {'T', 'x', -1},
+    {'T', 'y', -1},
+    {'T', 'z', -1},
+    {'V', '&', -1},
+    {'V', ',', -2},
+    {'V', '-', -1},
+    {'V', '.', -2},
+    {'V', '/', -1},
+    {'V', ':', -1},
+    {'V', ';', -1},
+    {'V', 'A', -1},
+    {'V', 'J', -1},
+    {'V', 'a', -1},
+    {'V', 'c', -1},
+    {'V', 'd', -1},
+    {'V', 'e', -1},
+    {'V', 'g', -1},
+    {'V', 'm', -1},
+    {'V', 'n', -1},
+    {'V', 'o', -1},
+    {'V', 'p', -1},
+    {'V', 'q', -1},
+    {'V', 'r', -1},
+    {'V', 's', -1},
+    {'V', 'u', -1},
+    {'V', 'z', -1},
+    {'W', '&', -1},
+    {'W', ',', -1},
+    {'W', '.', -1},
+    {'W', '/', -1},
+    {'W', 'A', -1},
+    {'W', 'J', -1},
+    {'W', 'a', -1},
+    {'W', 'g', -1},
+    {'X', 't', -1},
+    {'X', 'v', -1},
+    {'X', 'y', -1},
+    {'Y', '&', -1},
+    {'Y', ',', -1},
+    {'Y', '-', -1},
+    {'Y', '.', -1},
+    {'Y', '/', -1},
+    {'Y', ':', -1},
+    {'Y', ';', -1},
+    {'Y', '@', -1},
+    {'Y', 'A', -1},
+    {'Y', 'C', -1},
+    {'Y', 'G', -1},
+    {'Y', 'J', -2},
+    {'Y', 'O', -1},
+    {'Y', 'Q', -1},
+    {'Y', 'a', -1},
+    {'Y', 'c', -1},
+    {'Y', 'd', -1},
+    {'Y', 'e', -1},
+    {'Y', 'g', -1},
+    {'Y', 'm', -1},
+    {'Y', 'n', -1},
+    {'Y', 'o', -1},
+    {'Y', 'p', -1},
+    {'Y', 'q', -1},
+    {'Y', 'r', -1},
+    {'Y', 's', -1},
+    {'Y', 'u', -1},
+    {'Y', 'v', -1},
+    {'Y', 'w', -1},
+    {'Y', 'x', -1},
+    {'Y', 'y', -1},
+    {'Z', '-', -1},
+    {'\\', '"', -1},
+    {'\\', '\'', -1},
+    {'\\', '*', -1},
+    {'\\', 'T', -1},
+    {'\\', 'V', -1},
+    {'\\', 'W', -1},
+    {'\\', 'Y', -1},
+    {'\\', '\\', -1},
+    {'\\', 'v', -1},
+    {'\\', 'y', -1},
+    {'a', '"', -1},
+    {'a', '\'', -1},
+    {'a', '*', -1},
+    {'b', '"', -1},
+    {'b', '\'', -1},
+    {'b', '*', -1},
+    {'b', 'V', -1},
+    {'b', '\\', -1},
+    {'e', '"', -1},
+    {'e', '\'', -1},
+    {'e', '*', -1},
+    {'e', 'V', -1},
+    {'e', '\\', -1},
+    {'f', '"', 1},
+    {'f', '\'', 1},
+    {'f', '*', 1},
+    {'f', ',', -1},
+    {'f', '.', -1},
+    {'h', '"', -1},
+    {'h', '\'', -1},
+    {'h', '*', -1},
+    {'m', '"', -1},
+    {'m', '\'', -1},
+    {'m', '*', -1},
+    {'n', '"', -1},
+    {'n', '\'', -1},
+    {'n', '*', -1},
+    {'o', '"', -1},
+    {'o', '\'', -1},
+    {'o', '*', -1},
+    {'o', 'V', -1},
+    {'o', '\\', -1},
+    {'p', '"', -1},
+    {'p', '\'', -1},
+    {'p', '*', -1},
+    {'p', 'V', -1},
+    {'p', '\\', -1},
+    {'r', ',', -1},
+    {'r', '.', -1},
+    {'v', '&', -1},
+    {'v', ',', -1},
+    {'v', '.', -1},
+    {'v', '/', -1},
+    {'v', 'A', -1},
+    {'y', '&', -1},
+    {'y', ',', -1},
+    {'y', '.', -1},
+    {'y', '/', -1},
+    {'y', 'A', -1},
+};
+
+// digits_18: SourceCodePro-Bold.ttf at 18px, 23px lines
+static __code const uint8_t digits_18_bitmaps[318] = {
+    0x08, 0x18, 0x18, 0x3E, 0x7F, 0x62, 0x70, 0x7C, 0x3F, 0x07, 0x43, 0xFF,
+    0x7E, 0x18, 0x18, 0x18, 0x30, 0x00, 0x78, 0x40, 0x4C, 0xC0, 0xCD, 0x80,
+    0x6F, 0x00, 0x78, 0x00, 0x03, 0x80, 0x17, 0xC0, 0x36, 0xC0, 0x66, 0xC0,
+    0x66, 0xC0, 0x03, 0x80, 0x03, 0x18, 0x00, 0x02, 0xFF, 0x80, 0x03, 0x18,
+    0x00, 0x70, 0x70, 0x78, 0x78, 0x38, 0x30, 0xE0, 0x40, 0x02, 0xFF, 0x80,
+    0x70, 0xF0, 0xF0, 0x70, 0x03, 0x03, 0x07, 0x06, 0x06, 0x0C, 0x0C, 0x1C,
+    0x18, 0x18, 0x38, 0x30, 0x30, 0x60, 0x60, 0xE0, 0x1C, 0x00, 0x3E, 0x00,
+    0x7F, 0x00, 0xE3, 0x00, 0xE3, 0x80, 0xDF, 0x80, 0xDF, 0x80, 0xEB, 0x80,
+    0xE3, 0x80, 0x63, 0x00, 0x7F, 0x00, 0x3E, 0x00, 0x01, 0x0C, 0x00, 0x02,
+    0x7C, 0x00, 0x07, 0x1C, 0x00, 0x02, 0xFF, 0x80, 0x18, 0x00, 0x7E, 0x00,
+    0xFF, 0x00, 0x07, 0x00, 0x07, 0x00, 0x07, 0x00, 0x0E, 0x00, 0x1C, 0x00,
+    0x38, 0x00, 0x78, 0x00, 0xFF, 0x80, 0xFF, 0x80, 0x1C, 0x00, 0x7E, 0x00,
+    0x7F, 0x00, 0x07, 0x00, 0x07, 0x00, 0x1E, 0x00, 0x3E, 0x00, 0x07, 0x00,
+    0x03, 0x80, 0x47, 0x80, 0xFF, 0x00, 0x7E, 0x00, 0x06, 0x00, 0x0F, 0x00,
+    0x1F, 0x00, 0x3F, 0x00, 0x37, 0x00, 0x67, 0x00, 0xE7, 0x00, 0xFF, 0x80,
+    0xFF, 0x80, 0x07, 0x00, 0x07, 0x00, 0x07, 0x00, 0x7F, 0x00, 0x7F, 0x00,
+    0x7F, 0x00, 0x60, 0x00, 0x60, 0x00, 0x7E, 0x00, 0x7F, 0x00, 0x03, 0x80,
+    0x03, 0x80, 0x47, 0x00, 0xFF, 0x00, 0x7E, 0x00, 0x0C, 0x00, 0x3F, 0x00,
+    0x7F, 0x00, 0x60, 0x00, 0xE0, 0x00, 0xFF, 0x00, 0xFF, 0x00, 0xE3, 0x80,
+    0xE3, 0x80, 0x63, 0x80, 0x7F, 0x00, 0x3E, 0x00, 0xFF, 0x00, 0xFF, 0x80,
+    0xFF, 0x00, 0x07, 0x00, 0x06, 0x00, 0x0C, 0x00, 0x0C, 0x00, 0x1C, 0x00,
+    0x1C, 0x00, 0x18, 0x00, 0x18, 0x00, 0x38, 0x00, 0x1C, 0x00, 0x7E, 0x00,
+    0x67, 0x00, 0xE3, 0x00, 0x63, 0x00, 0x7E, 0x00, 0x3E, 0x00, 0x67, 0x00,
+    0xE3, 0x80, 0xE3, 0x80, 0xFF, 0x00, 0x7E, 0x00, 0x18, 0x00, 0x7E, 0x00,
+    0xE7, 0x00, 0xE3, 0x00, 0xC3, 0x80, 0xE7, 0x80, 0x7F, 0x80, 0x3B, 0x80,
+    0x03, 0x00, 0x47, 0x00, 0xFE, 0x00, 0x7C, 0x00, 0x70, 0xF0, 0xF8, 0x70,
+    0x00, 0x00, 0x70, 0xF0, 0xF0, 0x70,
+};
+
+static __code const FontGlyph digits_18_glyphs[27] = {
+    {0x0000, 0, 0, 0, 0, 11}, // ' '
+    {0x0000, 0, 0, 0, 0, 0}, // '!'
+    {0x0000, 0, 0, 0, 0, 0}, // '"'
+    {0x0000, 0, 0, 0, 0, 0}, // '#'
+    {0x0000, 8, 16, 1, 4, 11}, // '$'
+    {0x0010, 10, 12, 0, 6, 11}, // '%'
+    {0x0000, 0, 0, 0, 0, 0}, // '&'
+    {0x0000, 0, 0, 0, 0, 0}, // '\''
+    {0x0000, 0, 0, 0, 0, 0}, // '('
+    {0x0000, 0, 0, 0, 0, 0}, // ')'
+    {0x0000, 0, 0, 0, 0, 0}, // '*'
+    {0x8028, 9, 8, 1, 8, 11}, // '+'
+    {0x0031, 5, 8, 3, 14, 11}, // ','
+    {0x8039, 9, 2, 1, 11, 11}, // '-'
+    {0x003C, 4, 4, 3, 14, 11}, // '.'
+    {0x0040, 8, 16, 1, 5, 11}, // '/'
+    {0x0050, 9, 12, 1, 6, 11}, // '0'
+    {0x8068, 9, 12, 1, 6, 11}, // '1'
+    {0x0074, 9, 12, 1, 6, 11}, // '2'
+    {0x008C, 9, 12, 1, 6, 11}, // '3'
+    {0x00A4, 9, 12, 1, 6, 11}, // '4'
+    {0x00BC, 9, 12, 1, 6, 11}, // '5'
+    {0x00D4, 9, 12, 1, 6, 11}, // '6'
+    {0x00EC, 9, 12, 1, 6, 11}, // '7'
+    {0x0104, 9, 12, 1, 6, 11}, // '8'
+    {0x011C, 9, 12, 1, 6, 11}, // '9'
+    {0x0134, 5, 10, 3, 8, 11}, // ':'
+};
+
+// digits_36: SourceCodePro-Bold.ttf at 36px, 45px lines
+static __code const uint8_t digits_36_bitmaps[945] = {
+    0x05, 0x01, 0xE0, 0x00, 0x01, 0x07, 0xF8, 0x00, 0x01, 0x1F, 0xFE, 0x00,
+    0x02, 0x3F, 0xFF, 0x00, 0x01, 0x7E, 0x1E, 0x00, 0x01, 0x7C, 0x04, 0x00,
+    0x01, 0x7E, 0x00, 0x00, 0x01, 0x3F, 0x80, 0x00, 0x01, 0x3F, 0xE0, 0x00,
+    0x01, 0x1F, 0xFC, 0x00, 0x01, 0x0F, 0xFE, 0x00, 0x01, 0x03, 0xFF, 0x00,
+    0x01, 0x00, 0x7F, 0x00, 0x01, 0x00, 0x1F, 0x80, 0x01, 0x00, 0x0F, 0x80,
+    0x01, 0x38, 0x0F, 0x80, 0x01, 0x7F, 0xFF, 0x00, 0x01, 0xFF, 0xFF, 0x00,
+    0x01, 0x7F, 0xFE, 0x00, 0x01, 0x1F, 0xFC, 0x00, 0x01, 0x03, 0xE0, 0x00,
+    0x05, 0x01, 0xE0, 0x00, 0x3F, 0x00, 0x00, 0x7F, 0x80, 0x40, 0x7F, 0xC0,
+    0xE0, 0xF1, 0xC1, 0xF0, 0xF1, 0xE3, 0xE0, 0xF1, 0xE7, 0xC0, 0xF1, 0xEF,
+    0x00, 0xF1, 0xCE, 0x00, 0xF3, 0xCC, 0x00, 0x7F, 0xC0, 0x00, 0x3F, 0x80,
+    0x00, 0x0E, 0x07, 0x00, 0x00, 0x1F, 0xC0, 0x02, 0x3F, 0xE0, 0x07, 0x3D,
+    0xE0, 0x0F, 0x78, 0xF0, 0x1E, 0x78, 0xF0, 0x3C, 0x78, 0xF0, 0x78, 0x78,
+    0xF0, 0xF0, 0x78, 0xE0, 0x70, 0x3F, 0xE0, 0x20, 0x3F, 0xC0, 0x00, 0x1F,
+    0x80, 0x00, 0x02, 0x00, 0x01, 0x01, 0xC0, 0x00, 0x06, 0x01, 0xE0, 0x00,
+    0x01, 0x7F, 0xFF, 0x80, 0x03, 0xFF, 0xFF, 0x80, 0x06, 0x01, 0xE0, 0x00,
+    0x01, 0x01, 0xC0, 0x00, 0x18, 0x00, 0x7E, 0x00, 0xFF, 0x00, 0xFF, 0x00,
+    0xFF, 0x00, 0xFF, 0x80, 0x7F, 0x80, 0x1F, 0x00, 0x0F, 0x00, 0x0F, 0x00,
+    0x1F, 0x00, 0x3E, 0x00, 0xFC, 0x00, 0xF8, 0x00, 0xF0, 0x00, 0x40, 0x00,
+    0x01, 0x7F, 0xFF, 0x80, 0x03, 0xFF, 0xFF, 0x80, 0x3C, 0xFE, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFE, 0x7E, 0x10, 0x00, 0x0E, 0x00, 0x1F, 0x00, 0x1E, 0x00,
+    0x3E, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x7C, 0x00, 0x78, 0x00, 0xF8, 0x00,
+    0xF8, 0x00, 0xF0, 0x01, 0xF0, 0x01, 0xE0, 0x01, 0xE0, 0x03, 0xE0, 0x03,
+    0xC0, 0x07, 0xC0, 0x07, 0xC0, 0x07, 0x80, 0x0F, 0x80, 0x0F, 0x00, 0x0F,
+    0x00, 0x1F, 0x00, 0x1E, 0x00, 0x3E, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x7C,
+    0x00, 0x78, 0x00, 0x78, 0x00, 0xF8, 0x00, 0xF0, 0x00, 0x07, 0xF8, 0x00,
+    0x0F, 0xFC, 0x00, 0x1F, 0xFE, 0x00, 0x3F, 0xFF, 0x00, 0x7E, 0x1F, 0x00,
+    0x7C, 0x0F, 0x80, 0x78, 0x0F, 0x80, 0xF8, 0x0F, 0x80, 0xF8, 0x07, 0x80,
+    0xF9, 0xE7, 0xC0, 0xFB, 0xE7, 0xC0, 0xFB, 0xF7, 0xC0, 0xFB, 0xE7, 0xC0,
+    0xF9, 0xE7, 0xC0, 0xF8, 0x07, 0x80, 0xF8, 0x0F, 0x80, 0x78, 0x0F, 0x80,
+    0x7C, 0x0F, 0x80, 0x7E, 0x1F, 0x00, 0x3F, 0xFF, 0x00, 0x1F, 0xFE, 0x00,
+    0x1F, 0xFC, 0x00, 0x07, 0xF8, 0x00, 0x00, 0x80, 0x00, 0x01, 0x03, 0xE0,
+    0x01, 0x0F, 0xE0, 0x03, 0x7F, 0xE0, 0x01, 0x3F, 0xE0, 0x0D, 0x03, 0xE0,
+    0x04, 0xFF, 0xFF, 0x0F, 0xF0, 0x00, 0x3F, 0xFC, 0x00, 0x7F, 0xFE, 0x00,
+    0xFF, 0xFE, 0x00, 0x78, 0x3F, 0x00, 0x20, 0x1F, 0x00, 0x00, 0x1F, 0x00,
+    0x00, 0x1F, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x3E, 0x00,
+    0x00, 0x7E, 0x00, 0x00, 0xFC, 0x00, 0x01, 0xF8, 0x00, 0x03, 0xF0, 0x00,
+    0x07, 0xE0, 0x00, 0x0F, 0xC0, 0x00, 0x1F, 0x80, 0x00, 0x3F, 0x3F, 0x80,
+    0x7F, 0xFF, 0x80, 0xFF, 0xFF, 0x80, 0xFF, 0xFF, 0x80, 0xFF, 0xFF, 0x80,
+    0x0F, 0xF8, 0x00, 0x3F, 0xFC, 0x00, 0xFF, 0xFE, 0x00, 0x7F, 0xFF, 0x00,
+    0x38, 0x3F, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x1F, 0x00,
+    0x00, 0x3F, 0x00, 0x07, 0xFE, 0x00, 0x07, 0xF8, 0x00, 0x07, 0xF8, 0x00,
+    0x07, 0xFE, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x1F, 0x80, 0x00, 0x0F, 0x80,
+    0x00, 0x0F, 0x80, 0x60, 0x0F, 0x80, 0x78, 0x3F, 0x80, 0xFF, 0xFF, 0x00,
+    0xFF, 0xFF, 0x00, 0x7F, 0xFE, 0x00, 0x1F, 0xF8, 0x00, 0x01, 0x80, 0x00,
+    0x01, 0x00, 0x3F, 0x00, 0x01, 0x00, 0x7F, 0x00, 0x01, 0x00, 0xFF, 0x00,
+    0x02, 0x01, 0xFF, 0x00, 0x01, 0x03, 0xFF, 0x00, 0x02, 0x07, 0xDF, 0x00,
+    0x01, 0x0F, 0x9F, 0x00, 0x01, 0x1F, 0x1F, 0x00, 0x01, 0x1E, 0x1F, 0x00,
+    0x01, 0x3E, 0x1F, 0x00, 0x01, 0x7C, 0x1F, 0x00, 0x04, 0xFF, 0xFF, 0xE0,
+    0x01, 0x7F, 0xFF, 0xE0, 0x05, 0x00, 0x1F, 0x00, 0x05, 0x3F, 0xFF, 0x00,
+    0x02, 0x3E, 0x00, 0x00, 0x01, 0x3C, 0x00, 0x00, 0x01, 0x3D, 0xE0, 0x00,
+    0x01, 0x3F, 0xFC, 0x00, 0x01, 0x7F, 0xFE, 0x00, 0x01, 0x3F, 0xFF, 0x00,
+    0x01, 0x18, 0x3F, 0x80, 0x01, 0x00, 0x1F, 0x80, 0x03, 0x00, 0x0F, 0x80,
+    0x01, 0x20, 0x1F, 0x80, 0x01, 0x78, 0x3F, 0x80, 0x01, 0xFF, 0xFF, 0x00,
+    0x01, 0xFF, 0xFE, 0x00, 0x01, 0x7F, 0xFC, 0x00, 0x01, 0x1F, 0xF8, 0x00,
+    0x01, 0x01, 0x80, 0x00, 0x03, 0xFC, 0x00, 0x0F, 0xFF, 0x00, 0x1F, 0xFF,
+    0x80, 0x1F, 0xFF, 0x00, 0x3F, 0x07, 0x00, 0x7E, 0x00, 0x00, 0x7C, 0x00,
+    0x00, 0x7C, 0x00, 0x00, 0xF8, 0x00, 0x00, 0xF9, 0xFC, 0x00, 0xFB, 0xFF,
+    0x00, 0xFF, 0xFF, 0x80, 0xFF, 0xFF, 0x80, 0xFC, 0x0F, 0x80, 0xF8, 0x07,
+    0xC0, 0xF8, 0x07, 0xC0, 0x7C, 0x07, 0xC0, 0x7C, 0x0F, 0x80, 0x7E, 0x0F,
+    0x80, 0x3F, 0xFF, 0x80, 0x1F, 0xFF, 0x00, 0x0F, 0xFE, 0x00, 0x07, 0xFC,
+    0x00, 0x00, 0x40, 0x00, 0x01, 0xFF, 0xFF, 0x80, 0x02, 0xFF, 0xFF, 0xC0,
+    0x01, 0xFF, 0xFF, 0x80, 0x01, 0x7F, 0xFF, 0x00, 0x01, 0x00, 0x1F, 0x00,
+    0x01, 0x00, 0x3E, 0x00, 0x01, 0x00, 0x3C, 0x00, 0x01, 0x00, 0x7C, 0x00,
+    0x02, 0x00, 0xF8, 0x00, 0x02, 0x01, 0xF0, 0x00, 0x01, 0x01, 0xE0, 0x00,
+    0x03, 0x03, 0xE0, 0x00, 0x04, 0x07, 0xE0, 0x00, 0x02, 0x07, 0xC0, 0x00,
+    0x07, 0xF8, 0x00, 0x1F, 0xFE, 0x00, 0x3F, 0xFE, 0x00, 0x3F, 0xFF, 0x00,
+    0x7C, 0x1F, 0x00, 0x7C, 0x0F, 0x80, 0x7C, 0x0F, 0x00, 0x7C, 0x0F, 0x00,
+    0x3F, 0x1F, 0x00, 0x3F, 0xFE, 0x00, 0x1F, 0xFC, 0x00, 0x0F, 0xFC, 0x00,
+    0x1F, 0xFE, 0x00, 0x3C, 0xFF, 0x00, 0x78, 0x1F, 0x80, 0xF8, 0x0F, 0x80,
+    0xF8, 0x0F, 0xC0, 0xF8, 0x0F, 0xC0, 0xFC, 0x0F, 0x80, 0x7E, 0x1F, 0x80,
+    0x7F, 0xFF, 0x00, 0x3F, 0xFE, 0x00, 0x0F, 0xFC, 0x00, 0x00, 0xC0, 0x00,
+    0x0F, 0xF0, 0x00, 0x1F, 0xFC, 0x00, 0x3F, 0xFE, 0x00, 0x7F, 0xFE, 0x00,
+    0xFC, 0x1F, 0x00, 0xF8, 0x1F, 0x00, 0xF8, 0x0F, 0x80, 0xF8, 0x0F, 0x80,
+    0xF8, 0x0F, 0x80, 0xF8, 0x1F, 0x80, 0xFE, 0x7F, 0x80, 0x7F, 0xFF, 0x80,
+    0x3F, 0xFF, 0x80, 0x1F, 0xCF, 0x80, 0x02, 0x0F, 0x80, 0x00, 0x0F, 0x80,
+    0x00, 0x1F, 0x80, 0x00, 0x1F, 0x00, 0x38, 0x3F, 0x00, 0x7F, 0xFE, 0x00,
+    0xFF, 0xFC, 0x00, 0x7F, 0xF8, 0x00, 0x1F, 0xF0, 0x00, 0x01, 0x00, 0x00,
+    0x18, 0x7E, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x7E, 0x3C, 0x00, 0x00, 0x00,
+    0x3C, 0xFE, 0xFF, 0xFF, 0xFF, 0xFF, 0xFE, 0x7E, 0x10,
+};
+
+static __code const FontGlyph digits_36_glyphs[27] = {
+    {0x0000, 0, 0, 0, 0, 22}, // ' '
+    {0x0000, 0, 0, 0, 0, 0}, // '!'
+    {0x0000, 0, 0, 0, 0, 0}, // '"'
+    {0x0000, 0, 0, 0, 0, 0}, // '#'
+    {0x8000, 17, 31, 2, 8, 22}, // '$'
+    {0x0058, 20, 24, 1, 12, 22}, // '%'
+    {0x0000, 0, 0, 0, 0, 0}, // '&'
+    {0x0000, 0, 0, 0, 0, 0}, // '\''
+    {0x0000, 0, 0, 0, 0, 0}, // '('
+    {0x0000, 0, 0, 0, 0, 0}, // ')'
+    {0x0000, 0, 0, 0, 0, 0}, // '*'
+    {0x80A0, 17, 18, 2, 14, 22}, // '+'
+    {0x00B8, 9, 16, 7, 27, 22}, // ','
+    {0x80D8, 17, 4, 2, 21, 22}, // '-'
+    {0x00E0, 8, 9, 7, 27, 22}, // '.'
+    {0x00E9, 16, 32, 3, 9, 22}, // '/'
+    {0x0129, 18, 24, 2, 12, 22}, // '0'
+    {0x8171, 16, 23, 3, 12, 22}, // '1'
+    {0x0183, 17, 23, 2, 12, 22}, // '2'
+    {0x01C8, 17, 24, 2, 12, 22}, // '3'
+    {0x8210, 19, 23, 1, 12, 22}, // '4'
+    {0x8248, 17, 24, 2, 12, 22}, // '5'
+    {0x028C, 18, 24, 2, 12, 22}, // '6'
+    {0x82D4, 18, 23, 2, 12, 22}, // '7'
+    {0x030C, 18, 24, 2, 12, 22}, // '8'
+    {0x0354, 17, 24, 2, 12, 22}, // '9'
+    {0x039C, 8, 21, 7, 15, 22}, // ':'
+};
+
+__code const uint8_t text_atlas_count = 3;
+
+__code const FontAtlas text_atlases[3] = {
+    {' ', '~', 19, sans_16_glyphs, sans_16_bitmaps, sans_16_kerning, 307},
+    {' ', ':', 23, digits_18_glyphs, digits_18_bitmaps, 0, 0},
+    {' ', ':', 45, digits_36_glyphs, digits_36_bitmaps, 0, 0},
+};
@@ -0,0 +1,524 @@
+#include "bitmap.h"
+#include "../profile/profile.h"
+#include <string.h>
+
+// bitmap_transpose8 arguments, the kernel loads them in this order
+static struct {
+  const uint8_t __xdata *src;
+  int16_t src_stride;
+  uint8_t __xdata *dst;
+  int16_t dst_stride;
+} __xdata tr;
+
+// a bitmap_blit row, the kernel loads it in this order
+static struct {
+  const uint8_t __xdata *src;
+  uint8_t __xdata *dst;
+  uint8_t count;    // dst bytes touched
+  uint8_t head;     // mask of the first one
+  uint8_t tail;     // and of the last
+  uint8_t mult;     // 1 << (8 - shift): MUL AB splits a byte at the shift. 0 when aligned
+  uint8_t ink;      // 0xFF or 0x00
+  uint8_t prefetch; // src starts further into its byte than dst, the first byte is split ahead
+} __xdata blit;
+
+#ifdef BUILD
+
+// The top half of the bit addressable RAM, clear of the compiler's __bit
+// variables that fill it from 0x20 up. Row j bit b is bit 0x40 + 8 j + b.
+static __data __at(0x28) uint8_t bits[8];
+
+static void transpose(void) __naked {
+  __asm
+  ; src into DPTR, its stride into r5:r4
+  mov dptr,#_tr
+  movx a,@dptr
+  mov r6,a
+  inc dptr
+  movx a,@dptr
+  mov r7,a
+  inc dptr
+  movx a,@dptr
+  mov r4,a
+  inc dptr
+  movx a,@dptr
+  mov r5,a
+  mov dpl,r6
+  mov dph,r7
+
+  ; src rows into bits
+  mov r0,#_bits
+  mov r2,#8
+00101$:
+  movx a,@dptr
+  mov @r0,a
+  inc r0
+  mov a,dpl
+  add a,r4
+  mov dpl,a
+  mov a,dph
+  addc a,r5
+  mov dph,a
+  djnz r2,00101$
+
+  ; dst into DPTR, its stride into r5:r4
+  mov dptr,#(_tr + 4)
+  movx a,@dptr
+  mov r6,a
+  inc dptr
+  movx a,@dptr
+  mov r7,a
+  inc dptr
+  movx a,@dptr
+  mov r4,a
+  inc dptr
+  movx a,@dptr
+  mov r5,a
+  mov dpl,r6
+  mov dph,r7
+
+  ; a bit move a pixel
+  ; dst row 0: bit 7 of each src row
+  mov c,0x47
+  mov acc.7,c
+  mov c,0x4f
+  mov acc.6,c
+  mov c,0x57
+  mov acc.5,c
+  mov c,0x5f
+  mov acc.4,c
+  mov c,0x67
+  mov acc.3,c
+  mov c,0x6f
+  mov acc.2,c
+  mov c,0x77
+  mov acc.1,c
+  mov c,0x7f
+  mov acc.0,c
+  movx @dptr,a
+  mov a,dpl
+  add a,r4
+  mov dpl,a
+  mov a,dph
+  addc a,r5
+  mov dph,a
+  ; dst row 1: bit 6 of each src row
+  mov c,0x46
+  mov acc.7,c
+  mov c,0x4e
+  mov acc.6,c
+  mov c,0x56
+  mov acc.5,c
+  mov c,0x5e
+  mov acc.4,c
+  mov c,0x66
+  mov acc.3,c
+  mov c,0x6e
+  mov acc.2,c
+  mov c,0x76
+  mov acc.1,c
+  mov c,0x7e
+  mov acc.0,c
+  movx @dptr,a
+  mov a,dpl
+  add a,r4
+  mov dpl,a
+  mov a,dph
+  addc a,r5
+  mov dph,a
+  ; dst row 2: bit 5 of each src row
+  mov c,0x45
+  mov acc.7,c
+  mov c,0x4d
+  mov acc.6,c
+  mov c,0x55
+  mov acc.5,c
+  mov c,0x5d
+  mov acc.4,c
+  mov c,0x65
+  mov acc.3,c
+  mov c,0x6d
+  mov acc.2,c
+  mov c,0x75
+  mov acc.1,c
+  mov c,0x7d
+  mov acc.0,c
+  movx @dptr,a
+  mov a,dpl
+  add a,r4
+  mov dpl,a
+  mov a,dph
+  addc a,r5
+  mov dph,a
+  ; dst row 3: bit 4 of each src row
+  mov c,0x44
+  mov acc.7,c
+  mov c,0x4c
+  mov acc.6,c
+  mov c,0x54
+  mov acc.5,c
+  mov c,0x5c
+  mov acc.4,c
+  mov c,0x64
+  mov acc.3,c
+  mov c,0x6c
+  mov acc.2,c
+  mov c,0x74
+  mov acc.1,c
+  mov c,0x7c
+  mov acc.0,c
+  movx @dptr,a
+  mov a,dpl
+  add a,r4
+  mov dpl,a
+  mov a,dph
+  addc a,r5
+  mov dph,a
+  ; dst row 4: bit 3 of each src row
+  mov c,0x43
+  mov acc.7,c
+  mov c,0x4b
+  mov acc.6,c
+  mov c,0x53
+  mov acc.5,c
+  mov c,0x5b
+  mov acc.4,c
+  mov c,0x63
+  mov acc.3,c
+  mov c,0x6b
+  mov acc.2,c
+  mov c,0x73
+  mov acc.1,c
+  mov c,0x7b
+  mov acc.0,c
+  movx @dptr,a
+  mov a,dpl
+  add a,r4
+  mov dpl,a
+  mov a,dph
+  addc a,r5
+  mov dph,a
+  ; dst row 5: bit 2 of each src row
+  mov c,0x42
+  mov acc.7,c
+  mov c,0x4a
+  mov acc.6,c
+  mov c,0x52
+  mov acc.5,c
+  mov c,0x5a
+  mov acc.4,c
+  mov c,0x62
+  mov acc.3,c
+  mov c,0x6a
+  mov acc.2,c
+  mov c,0x72
+  mov acc.1,c
+  mov c,0x7a
+  mov acc.0,c
+  movx @dptr,a
+  mov a,dpl
+  add a,r4
+  mov dpl,a
+  mov a,dph
+  addc a,r5
+  mov dph,a
+  ; dst row 6: bit 1 of each src row
+  mov c,0x41
+  mov acc.7,c
+  mov c,0x49
+  mov acc.6,c
+  mov c,0x51
+  mov acc.5,c
+  mov c,0x59
+  mov acc.4,c
+  mov c,0x61
+  mov acc.3,c
+  mov c,0x69
+  mov acc.2,c
+  mov c,0x71
+  mov acc.1,c
+  mov c,0x79
+  mov acc.0,c
+  movx @dptr,a
+  mov a,dpl
+  add a,r4
+  mov dpl,a
+  mov a,dph
+  addc a,r5
+  mov dph,a
+  ; dst row 7: bit 0 of each src row
+  mov c,0x40
+  mov acc.7,c
+  mov c,0x48
+  mov acc.6,c
+  mov c,0x50
+  mov acc.5,c
+  mov c,0x58
+  mov acc.4,c
+  mov c,0x60
+  mov acc.3,c
+  mov c,0x68
+  mov acc.2,c
+  mov c,0x70
+  mov acc.1,c
+  mov c,0x78
+  mov acc.0,c
+  movx @dptr,a
+  ret
+  __endasm;
+}
+
+// Interrupts stay off while DPS selects DPTR1: an ISR saves DPL and DPH, the
+// DPTR0 registers, and would clobber DPTR1.
+static void blit_row(void) __naked {
+  __asm
+  mov dptr,#_blit
+  movx a,@dptr
+  mov r0,a
+  inc dptr
+  movx a,@dptr
+  mov r1,a
+  inc dptr
+  movx a,@dptr
+  mov _DPL1,a
+  inc dptr
+  movx a,@dptr
+  mov _DPH1,a
+  inc dptr
+  movx a,@dptr
+  mov r2,a
+  inc dptr
+  movx a,@dptr
+  mov r4,a
+  inc dptr
+  movx a,@dptr
+  mov r5,a
+  inc dptr
+  movx a,@dptr
+  mov r6,a
+  inc dptr
+  movx a,@dptr
+  mov r7,a
+  inc dptr
+  movx a,@dptr
+  mov dpl,r0
+  mov dph,r1
+  mov r3,#0
+  jz 00101$
+  movx a,@dptr
+  inc dptr
+  mov b,r6
+  mul ab
+  mov r3,a
+
+00101$:
+  ; the next src byte, shifted: b = byte >> shift, a = the rest
+  movx a,@dptr
+  inc dptr
+  cjne r6,#0,00102$
+  sjmp 00103$
+00102$:
+  mov b,r6
+  mul ab
+  xch a,r3
+  orl a,b
+
+00103$:
+  anl a,r4
+  mov r4,#0xff
+  cjne r2,#1,00104$
+  anl a,r5
+00104$:
+  ; dst ^= (dst ^ ink) & bits
+  mov r1,a
+  mov _DPS,#1
+  movx a,@dptr
+  mov r0,a
+  xrl a,r7
+  anl a,r1
+  xrl a,r0
+  movx @dptr,a
+  inc dptr
+  mov _DPS,#0
+  djnz r2,00101$
+  ret
+  __endasm;
+}
+
+// the bits of value in reverse order, through the bit addressable B
+static uint8_t reverse(uint8_t value) __naked {
+  (void)value;
+  __asm
+  mov b,dpl
+  mov c,b.0
+  mov acc.7,c
+  mov c,b.1
+  mov acc.6,c
+  mov c,b.2
+  mov acc.5,c
+  mov c,b.3
+  mov acc.4,c
+  mov c,b.4
+  mov acc.3,c
+  mov c,b.5
+  mov acc.2,c
+  mov c,b.6
+  mov acc.1,c
+  mov c,b.7
+  mov acc.0,c
+  mov dpl,a
+  ret
+  __endasm;
+}
+
+#else
+
+static void transpose(void) {
+  uint8_t in[8];
+  const uint8_t __xdata *src = tr.src;
+  uint8_t __xdata *dst = tr.dst;
+  for (uint8_t j = 0; j < 8; j++, src += tr.src_stride) {
+    in[j] = *src;
+  }
+  for (uint8_t i = 0; i < 8; i++, dst += tr.dst_stride) {
+    uint8_t out = 0;
+    for (uint8_t j = 0; j < 8; j++) {
+      out |= ((in[j] >> (7 - i)) & 1) << (7 - j);
+    }
+    *dst = out;
+  }
+}
+
+static void blit_row(void) {
+  const uint8_t __xdata *src = blit.src;
+  uint8_t __xdata *dst = blit.dst;
+  uint8_t mask = blit.head;
+  uint8_t carry = 0;
+  if (blit.prefetch) {
+    carry = *src++ * blit.mult;
+  }
+  for (uint8_t n = blit.count; n; n--, dst++) {
+    uint16_t split = *src++ * blit.mult;
+    uint8_t out = blit.mult ? carry | (split >> 8) : src[-1];
+    carry = split;
+    out &= mask;
+    mask = 0xFF;
+    if (n == 1) {
+      out &= blit.tail;
+    }
+    *dst ^= (*dst ^ blit.ink) & out;
+  }
+}
+
+static uint8_t reverse(uint8_t value) {
+  uint8_t out = 0;
+  for (uint8_t b = 0; b < 8; b++, value >>= 1) {
+    out = (out << 1) | (value & 1);
+  }
+  return out;
+}
+
+#endif
+
+void bitmap_span(uint8_t __xdata *line, uint8_t x0, uint8_t x1, bool ink) {
+  uint8_t __xdata *p = line + (x0 >> 3);
+  uint8_t whole = ((x1 - 1) >> 3) - (x0 >> 3); // bytes after the first
+  uint8_t head = 0xFF >> (x0 & 7);
+  uint8_t tail = 0xFF << (7 - ((x1 - 1) & 7));
+  if (x0 >= x1) {
+    return;
+  }
+  PROFILE_ENTER(PROBE_BITMAP_SPAN);
+  if (!whole) {
+    head &= tail;
+  }
+  *p = ink ? *p | head : *p & ~head;
+  if (whole) {
+    uint8_t fill = ink ? 0xFF : 0x00;
+    while (--whole) {
+      *++p = fill;
+    }
+    p++;
+    *p = ink ? *p | tail : *p & ~tail;
+  }
+  PROFILE_EXIT(PROBE_BITMAP_SPAN);
+}
+
+void bitmap_blit(uint8_t __xdata *dst, uint8_t dst_stride, uint8_t x, const uint8_t __xdata *src,
+                 uint8_t src_stride, uint8_t src_x, uint8_t width, uint8_t rows, bool ink) {
+  uint8_t shift = ((x & 7) - (src_x & 7)) & 7;
+  if (!width || !rows) {
+    return;
+  }
+  PROFILE_ENTER(PROBE_BITMAP_BLIT);
+  blit.src = src + (src_x >> 3);
+  blit.dst = dst + (x >> 3);
+  blit.count = ((uint16_t)(x & 7) + width + 7) >> 3;
+  blit.head = 0xFF >> (x & 7);
+  blit.tail = 0xFF << (7 - ((x + width - 1) & 7));
+  blit.mult = shift ? 1 << (8 - shift) : 0;
+  blit.prefetch = (x & 7) < (src_x & 7);
+  blit.ink = ink ? 0xFF : 0x00;
+  for (; rows; rows--) {
+    HAL_CRITICAL_STATEMENT(blit_row());
+    blit.src += src_stride;
+    blit.dst += dst_stride;
+  }
+  PROFILE_EXIT(PROBE_BITMAP_BLIT);
+}
+
+void bitmap_transpose8(const uint8_t __xdata *src, int16_t src_stride, uint8_t __xdata *dst,
+                       int16_t dst_stride) {
+  PROFILE_ENTER(PROBE_BITMAP_TRANSPOSE);
+  tr.src = src;
+  tr.src_stride = src_stride;
+  tr.dst = dst;
+  tr.dst_stride = dst_stride;
+  transpose();
+  PROFILE_EXIT(PROBE_BITMAP_TRANSPOSE);
+}
+
+void bitmap_rotate(const uint8_t __xdata *src, uint8_t src_stride, uint16_t width, uint16_t height,
+                   uint8_t __xdata *dst, uint8_t dst_stride, uint8_t rotation) {
+  uint8_t columns = width / 8;
+  uint8_t blocks = height / 8;
+  PROFILE_ENTER(PROBE_BITMAP_ROTATE);
+  switch (rotation) {
+  case BITMAP_ROTATE_90:
+    // dst row x is src column x, read bottom up
+    for (uint8_t by = 0; by < blocks; by++) {
+      for (uint8_t bx = 0; bx < columns; bx++) {
+        bitmap_transpose8(src + (by * 8 + 7) * (uint16_t)src_stride + bx, -src_stride,
+                          dst + bx * 8 * (uint16_t)dst_stride + blocks - 1 - by, dst_stride);
+      }
+    }
+    break;
+
+  case BITMAP_ROTATE_270:
+    // dst row y is src column width - 1 - y
+    for (uint8_t by = 0; by < blocks; by++) {
+      for (uint8_t bx = 0; bx < columns; bx++) {
+        bitmap_transpose8(src + by * 8 * (uint16_t)src_stride + bx, src_stride,
+                          dst + ((columns - bx) * 8 - 1) * (uint16_t)dst_stride + by, -dst_stride);
+      }
+    }
+    break;
+
+  case BITMAP_ROTATE_180:
+    for (uint16_t y = 0; y < height; y++) {
+      const uint8_t __xdata *s = src + y * src_stride;
+      uint8_t __xdata *d = dst + (height - 1 - y) * dst_stride + columns;
+      for (uint8_t n = columns; n; n--) {
+        *--d = reverse(*s++);
+      }
+    }
+    break;
+
+  default:
+    for (uint16_t y = 0; y < height; y++) {
+      memcpy(dst + y * dst_stride, src + y * src_stride, columns);
+    }
+    break;
+  }
+  PROFILE_EXIT(PROBE_BITMAP_ROTATE);
+}
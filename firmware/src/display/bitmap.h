@@ -0,0 +1,42 @@
+#ifndef _BITMAP_H_
+#define _BITMAP_H_
+
+#include "../hal/hal.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// 1bpp kernels for rendering, on bitmaps in panel format: rows of bytes a
+// stride apart, the leftmost pixel in the MSB. Lines are at most 255 pixels,
+// a band or a glyph, never a whole plane. ink is the bit value drawn.
+//
+// The hot loops are 8051 assembly in BUILD: the transpose goes through
+// bit addressable RAM with one bit move per pixel, the blit keeps the
+// source in DPTR0 and the destination in DPTR1 and shifts with MUL AB.
+// Host builds use the C versions. PROBE_BITMAP_* count their cycles.
+
+enum {
+  BITMAP_ROTATE_0, // clockwise
+  BITMAP_ROTATE_90,
+  BITMAP_ROTATE_180,
+  BITMAP_ROTATE_270,
+};
+
+// sets or clears pixels x0 to x1 - 1 of line
+void bitmap_span(uint8_t __xdata *line, uint8_t x0, uint8_t x1, bool ink);
+
+// draws ink where src has a set bit: width pixels from src_x on, onto dst
+// from x on, for rows rows. A src_stride of 0 repeats the first row. src is
+// read up to a byte past the last pixel.
+void bitmap_blit(uint8_t __xdata *dst, uint8_t dst_stride, uint8_t x, const uint8_t __xdata *src,
+                 uint8_t src_stride, uint8_t src_x, uint8_t width, uint8_t rows, bool ink);
+
+// an 8x8 block: dst row i is src column i, MSB first. Strides may be
+// negative to mirror, src and dst may be the same block.
+void bitmap_transpose8(const uint8_t __xdata *src, int16_t src_stride, uint8_t __xdata *dst,
+                       int16_t dst_stride);
+
+// src, width x height pixels (multiples of 8), turned by rotation into dst
+void bitmap_rotate(const uint8_t __xdata *src, uint8_t src_stride, uint16_t width, uint16_t height,
+                   uint8_t __xdata *dst, uint8_t dst_stride, uint8_t rotation);
+
+#endif
@@ -1,6 +1,11 @@
 #include "epd.h"
 #include "../hal/hal.h"
-#include "../hal/time.h"
+#include "../hal/port.h"
+#include "../hal/uart.h"
+#include "../profile/profile.h"
+#include "../sched/sched.h"
+#include "../sched/timer.h"
+#include <string.h>
 
 #define B_PWR 0   // P0_0
 #define B_CS 1    // P0_1
@@ -19,102 +24,219 @@
 #define RESET_ON EPD_RESET = 0
 #define RESET_OFF EPD_RESET = 1
 
-// #define HRES 104
-// #define VRES 212
-
-#define HRES 152
-#define VRES 296
-#define BUFFER_SIZE (HRES / 8 * VRES)
+#define POWER_UP_MS 10 // supply rise, BUSY means nothing before
+#define RESET_MS 10 // held low, then again before BUSY means anything
+#define REFRESH_START_MS 100 // before BUSY goes low for the refresh
+
+// panel bring-up, transfer and shutdown as a sequence of steps, each one runs
+// when the previous delay or BUSY wait completes
+enum {
+  STEP_IDLE,
+  STEP_RESET,
+  STEP_RESET_RELEASE,
+  STEP_RESET_WAIT,
+  STEP_BOOSTER,
+  STEP_PANEL_SETTINGS,
+  STEP_SEND_BLACK,
+  STEP_SEND_RED,
+  STEP_REFRESH,
+  STEP_SLEEP,
+  STEP_POWER_OFF,
+};
+
+static uint8_t epd_state = STEP_IDLE;
+static bool epd_waiting = false; // for BUSY to be released
+static uint16_t epd_row;         // rows of the current plane sent
+static EpdSource epd_source;
+static EpdDone epd_done;
+static Timer __xdata epd_timer;
+static uint8_t __xdata epd_band[EPD_BAND_SIZE];
+
+EpdSourceCall __xdata epd_source_call;
 
 static void inline sendCommand(uint8_t cmd);
 static void inline sendData(uint8_t data);
 
-static void inline epd_waitBusy() {
-  do {
-    // sendCommand(0x71);
-  } while (EPD_BUSY == 0);
-  delay_ms(200);
+static void epd_step(void);
+
+static void epd_delay(uint8_t next, uint16_t milliseconds) {
+  epd_state = next;
+  timer_start(&epd_timer, milliseconds, epd_step);
+}
+
+static void epd_waitBusy(uint8_t next) {
+  epd_state = next;
+  epd_waiting = true;
+  port_watch_busy();
+}
+
+static void epd_continue(uint8_t next) {
+  epd_state = next;
+  sched_post(EVENT_EPD_STEP);
+}
+
+static void epd_ready(void) {
+  if (epd_waiting) {
+    epd_waiting = false;
+    epd_step();
+  }
 }
 
-static void epd_clearDisplay() {
-  sendCommand(0x10);
-  for (uint16_t i = 0; i < BUFFER_SIZE; i++)
-    sendData(0xff);
+// sends a band per scheduler step, returns true once the whole plane is out
+static bool epd_sendBand(uint8_t plane) {
+  PROFILE_ENTER(PROBE_EPD_BAND);
+  if (epd_source) {
+    epd_source_call.plane = plane;
+    epd_source_call.row = epd_row;
+    epd_source_call.band = epd_band;
+    epd_source();
+  } else {
+    memset(epd_band, 0xff, EPD_BAND_SIZE);
+  }
+  for (uint8_t i = 0; i < EPD_BAND_SIZE; i++)
+    sendData(epd_band[i]);
+  epd_row += EPD_BAND_ROWS;
+  PROFILE_EXIT(PROBE_EPD_BAND);
+  return epd_row == EPD_VRES;
+}
 
-  sendCommand(0x13);
-  for (uint16_t i = 0; i < BUFFER_SIZE; i++)
-    sendData(0xff);
+static void epd_step(void) {
+  // the host link is deaf while a step talks to the panel, see
+  // uart_release_rx
+  uart_release_rx();
+  switch (epd_state) {
+  case STEP_RESET:
+    RESET_ON;
+    epd_delay(STEP_RESET_RELEASE, RESET_MS);
+    break;
+
+  case STEP_RESET_RELEASE:
+    RESET_OFF;
+    // the controller only pulls BUSY low a while after the release, a wait
+    // started right away could see it still high from before
+    epd_delay(STEP_RESET_WAIT, RESET_MS);
+    break;
+
+  case STEP_RESET_WAIT:
+    // BUSY stays low until the controller is through its own reset
+    epd_waitBusy(STEP_BOOSTER);
+    break;
+
+  case STEP_BOOSTER:
+    sendCommand(6);
+    sendData(0x17);
+    sendData(0x17);
+    sendData(0x17);
+
+    sendCommand(4);
+    epd_waitBusy(STEP_PANEL_SETTINGS);
+    break;
+
+  case STEP_PANEL_SETTINGS:
+    sendCommand(0);
+    sendData(0x0f);
+    sendData(0x0d);
+
+    sendCommand(0x61);
+    sendData(EPD_HRES);
+    sendData(EPD_VRES >> 8);
+    sendData(EPD_VRES & 0xFF);
+
+    sendCommand(0x50);
+    sendData(0x77);
+
+    sendCommand(0x10);
+    epd_row = 0;
+    epd_continue(STEP_SEND_BLACK);
+    break;
+
+  case STEP_SEND_BLACK:
+    if (epd_sendBand(EPD_PLANE_BLACK)) {
+      sendCommand(0x13);
+      epd_row = 0;
+      epd_state = STEP_SEND_RED;
+    }
+    sched_post(EVENT_EPD_STEP);
+    break;
+
+  case STEP_SEND_RED:
+    if (!epd_sendBand(EPD_PLANE_RED)) {
+      sched_post(EVENT_EPD_STEP);
+      break;
+    }
+    sendCommand(0x12);
+    epd_delay(STEP_REFRESH, REFRESH_START_MS);
+    break;
+
+  case STEP_REFRESH:
+    epd_waitBusy(STEP_SLEEP);
+    break;
+
+  case STEP_SLEEP:
+    sendCommand(0x02);
+    epd_waitBusy(STEP_POWER_OFF);
+    break;
+
+  case STEP_POWER_OFF:
+    sendCommand(0x07);
+    sendData(0xA5);
+    PWR_OFF;
+    epd_state = STEP_IDLE;
+    if (epd_done) {
+      epd_done();
+    }
+    break;
+  }
+  uart_claim_rx();
 }
 
-static void epd_refresh() {
-  sendCommand(0x12);
-  delay_ms(100);
-  epd_waitBusy();
+bool epd_busy() {
+  return epd_state != STEP_IDLE;
 }
 
-static void epd_sleep(void) {
-  sendCommand(0x02);
-  epd_waitBusy();
-  sendCommand(0x07);
-  sendData(0xA5);
+bool epd_show(EpdSource source, EpdDone done) {
+  if (epd_busy()) {
+    return false;
+  }
+  epd_source = source;
+  epd_done = done;
+  PWR_ON;
+  epd_delay(STEP_RESET, POWER_UP_MS);
+  return true;
 }
 
 void epd_init() {
+  sched_handle(EVENT_EPD_READY, epd_ready);
+  sched_handle(EVENT_EPD_STEP, epd_step);
+
   PERCFG &= ~(0x01);  // USART0 alternative 1 location
   U0CSR = 0;          // SPI mode/master/clear flags
   U0GCR = BV(5) | 17; // SCK-low idle, DATA-1st clock edge, MSB first + baud E
   U0BAUD = 0;         // baud M
   U0CSR |= BV(6);     // enable SPI
 
-  P0SEL |= BV(3) | BV(5);                        // MISO/MOSI/CLK peripheral functions
-  P0DIR |= BV(3) | BV(5) | BV(B_PWR) | BV(B_CS); // MOSI/CLK, PWR/CS output
+  PWR_OFF; // until there is something to show
+  EPD_CS = 1;
+  // CLK is the UART RX pin, it is only an output while epd_step has it
+  P0SEL |= BV(3);                        // MOSI peripheral function
+  P0DIR |= BV(3) | BV(B_PWR) | BV(B_CS); // MOSI, PWR/CS output
   P1DIR |= BV(B_DC);
   P1DIR &= ~BV(B_BUSY);
   P2DIR |= BV(B_RESET);
-
-  PWR_ON;
-  delay_ms(1000);
-  RESET_ON;
-  delay_ms(100);
-  RESET_OFF;
-  delay_ms(100);
-
-  sendCommand(6);
-  sendData(0x17);
-  sendData(0x17);
-  sendData(0x17);
-
-  sendCommand(4);
-  epd_waitBusy();
-
-  sendCommand(0);
-  sendData(0x0f);
-  sendData(0x0d);
-
-  sendCommand(0x61);
-  sendData(HRES);
-  sendData(VRES >> 8);
-  sendData(VRES);
-
-  sendCommand(0x50);
-  sendData(0x77);
-
-  epd_clearDisplay();
-  epd_refresh();
-  // delay(20e3);
-  // epd_image(gImage_black2, gImage_red2);
-  // epd_refresh();
-  epd_sleep();
-
-  PWR_OFF;
 }
 
 static void inline sendData(uint8_t data) {
+  PROFILE_ENTER(PROBE_EPD_SEND_DATA);
   EPD_CS = 0;
+#ifdef BUILD
   U0DBUF = data;
   while (U0CSR & 0x01) {
   }
+#else
+  usart0_model_write(data);
+#endif
   EPD_CS = 1;
+  PROFILE_EXIT(PROBE_EPD_SEND_DATA);
 }
 
 static void inline sendCommand(uint8_t cmd) {
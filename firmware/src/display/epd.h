@@ -1,8 +1,54 @@
 #ifndef _EPD_H_
 #define _EPD_H_
 
+#include "../hal/hal.h"
+#include <stdbool.h>
 #include <stdint.h>
 
+// #define EPD_HRES 104
+// #define EPD_VRES 212
+
+#define EPD_HRES 152
+#define EPD_VRES 296
+#define EPD_ROW_BYTES (EPD_HRES / 8)
+#define EPD_PLANE_SIZE (EPD_ROW_BYTES * EPD_VRES)
+
+// A plane is sent row by row from the top, EPD_ROW_BYTES a row with the
+// leftmost pixel in the MSB. A set bit is white, a clear bit black in
+// EPD_PLANE_BLACK and red in EPD_PLANE_RED.
+#define EPD_BAND_ROWS 8
+#define EPD_BAND_SIZE (EPD_BAND_ROWS * EPD_ROW_BYTES)
+
+#if EPD_VRES % EPD_BAND_ROWS
+#error "bands must tile the panel"
+#endif
+
+enum {
+  EPD_PLANE_BLACK,
+  EPD_PLANE_RED,
+};
+
+// what the source is asked for, it takes no arguments: SDCC only passes them
+// through a function pointer to reentrant functions
+typedef struct {
+  uint8_t plane;
+  uint16_t row;
+  uint8_t __xdata *band;
+} EpdSourceCall;
+
+extern EpdSourceCall __xdata epd_source_call;
+
+// fills the EPD_BAND_ROWS rows of plane from row on into band
+typedef void (*EpdSource)(void);
+// the refresh completed and the panel is off again
+typedef void (*EpdDone)(void);
+
+// sets up the SPI, the panel stays as it is
 void epd_init();
+bool epd_busy();
+// powers the panel up, sends both planes from source (NULL clears) and
+// refreshes, in the background, then calls done (optional). Bring-up waits
+// on BUSY rather than fixed delays. false while busy.
+bool epd_show(EpdSource source, EpdDone done);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,20 @@
+#ifndef _FONT_H_
+#define _FONT_H_
+
+#include "../hal/hal.h"
+#include <stdint.h>
+
+// 5x7 ASCII font, 0x20 to 0x7E. A glyph is FONT_WIDTH columns, bit 0 the
+// top row, lowercase descenders use bit 7. Text advances FONT_ADVANCE
+// pixels a character.
+
+#define FONT_FIRST 0x20
+#define FONT_LAST 0x7E
+#define FONT_WIDTH 5
+#define FONT_HEIGHT 8
+#define FONT_ADVANCE 6
+
+// the columns of c, anything outside the font shows as '?'
+__code const uint8_t *font_glyph(char c);
+
+#endif
@@ -0,0 +1,549 @@
+#include "label.h"
+#include "font.h"
+#include "text.h"
+#include "../command/command.h"
+#include "../hal/crc.h"
+#include "../hal/spiflash.h"
+#include "../kv/kv.h"
+#include "../profile/profile.h"
+#include <string.h>
+
+#define NO_VALUE 0xFF
+#define TEXT_MAX 24 // characters of a formatted value
+
+#define EAN_MODULES 95
+
+// KV_SCREEN: template | CRC16 of the values
+#define SCREEN_SIZE 3
+
+typedef struct {
+  uint8_t type;
+  uint8_t height;
+  uint16_t x;
+  uint16_t y;
+  uint16_t width;
+  uint8_t style;
+  uint8_t colors;
+  uint8_t fonts;
+  uint8_t reserved;
+} LabelField;
+
+static LabelField __xdata fields[LABEL_MAX_FIELDS];
+static uint8_t field_count;
+static uint8_t rotation;
+static uint8_t shown; // template being sent to the panel
+static uint8_t __xdata screen[SCREEN_SIZE]; // what it will show
+static uint8_t __xdata values[LABEL_MAX_VALUES];
+static uint8_t __xdata value_at[LABEL_MAX_FIELDS]; // offset of the length byte, or NO_VALUE
+static char __xdata text[TEXT_MAX];
+// bit rows drawn with bitmap_blit, which reads a byte past the end
+static uint8_t __xdata bars[(EAN_MODULES + 7) / 8 + 1];
+static uint8_t __xdata glyph[8 + 1]; // rows of a character
+static uint8_t __xdata wide[(FONT_WIDTH * LABEL_STYLE_SCALE + 7) / 8 + 1]; // a glyph row scaled
+// a rotated band in label orientation, drawn on and then turned onto the panel
+static uint8_t __xdata canvas[EPD_BAND_SIZE];
+
+// LABEL_WRITE target, its sectors are erased when first written to
+static uint8_t writing = LABEL_TEMPLATES;
+static uint8_t erased;
+
+// the band being rendered, in label pixels: its bits, origin and size, and
+// the box drawing is clipped to
+static uint8_t __xdata *__xdata band;
+static uint8_t __xdata band_stride;
+static uint16_t __xdata band_x, band_y;
+static uint16_t __xdata band_width, band_height;
+static uint16_t __xdata clip_x0, clip_x1;
+static uint16_t __xdata clip_y0, clip_y1;
+static bool ink; // the bit value drawing writes to this plane
+
+// EAN-13 left hand odd parity codes, right hand codes are their complement
+// and even parity ones the complement reversed
+static __code const uint8_t ean_codes[10] = {0x0D, 0x19, 0x13, 0x3D, 0x23, 0x31, 0x2F, 0x3B, 0x37, 0x0B};
+// even parity digits of the left half, by the first digit, MSB first
+static __code const uint8_t ean_parity[10] = {0x00, 0x0B, 0x0D, 0x0E, 0x13, 0x19, 0x1C, 0x15, 0x16, 0x1A};
+
+static uint16_t read_u16(const uint8_t __xdata *data) {
+  return data[0] | ((uint16_t)data[1] << 8);
+}
+
+// ---- drawing ----
+
+// paper or ink for a color in the plane being rendered, false for none
+static bool set_color(uint8_t plane, uint8_t color) {
+  if (color == LABEL_COLOR_NONE) {
+    return false;
+  }
+  ink = plane == EPD_PLANE_BLACK ? color != LABEL_COLOR_BLACK : color != LABEL_COLOR_RED;
+  return true;
+}
+
+// a rectangle, clipped to the field and the band
+static void fill(uint16_t x, uint16_t y, uint16_t width, uint8_t height) {
+  uint16_t x1 = x + width;
+  uint16_t y1 = y + height;
+  if (x < clip_x0) {
+    x = clip_x0;
+  }
+  if (x1 > clip_x1) {
+    x1 = clip_x1;
+  }
+  if (y < clip_y0) {
+    y = clip_y0;
+  }
+  if (y1 > clip_y1) {
+    y1 = clip_y1;
+  }
+  for (; y < y1 && x < x1; y++) {
+    bitmap_span(band + (y - band_y) * band_stride, x - band_x, x1 - band_x, ink);
+  }
+}
+
+// a row of bits, MSB first, repeated height times and clipped like fill
+static void draw_bits(uint16_t x, uint16_t y, const uint8_t __xdata *bits, uint8_t width, uint8_t height) {
+  uint16_t x0 = x > clip_x0 ? x : clip_x0;
+  uint16_t x1 = x + width < clip_x1 ? x + width : clip_x1;
+  uint16_t y0 = y > clip_y0 ? y : clip_y0;
+  uint16_t y1 = y + height < clip_y1 ? y + height : clip_y1;
+  if (x0 >= x1 || y0 >= y1) {
+    return;
+  }
+  bitmap_blit(band + (y0 - band_y) * band_stride, band_stride, x0 - band_x, bits, 0, x0 - x, x1 - x0, y1 - y0,
+              ink);
+}
+
+// TextBlit
+static void draw_glyph_rows(void) {
+  draw_bits(text_blit_call.x, text_blit_call.y, text_blit_call.bits, text_blit_call.width, text_blit_call.rows);
+}
+
+static bool in_band(uint16_t y, uint8_t height) {
+  return y < clip_y1 && y + height > clip_y0;
+}
+
+// in the built-in font, returns the x after the text
+static uint16_t draw_builtin(uint16_t x, uint16_t y, const char __xdata *s, uint8_t length, uint8_t scale) {
+  uint8_t width = FONT_WIDTH * scale;
+  if (!in_band(y, FONT_HEIGHT * scale)) {
+    return x + length * FONT_ADVANCE * scale;
+  }
+  for (; length; length--, s++, x += FONT_ADVANCE * scale) {
+    if (x >= clip_x1 || x + width <= clip_x0) {
+      continue;
+    }
+    // font columns into rows, top row first
+    memcpy(glyph, font_glyph(*s), FONT_WIDTH);
+    memset(glyph + FONT_WIDTH, 0, 8 - FONT_WIDTH);
+    bitmap_transpose8(glyph, 1, glyph + 7, -1);
+    for (uint8_t row = 0; row < FONT_HEIGHT; row++) {
+      const uint8_t __xdata *bits = glyph + row;
+      uint16_t top = y + row * scale;
+      if (!*bits || !in_band(top, scale)) {
+        continue;
+      }
+      if (scale > 1) {
+        memset(wide, 0, sizeof(wide));
+        for (uint8_t column = 0; column < FONT_WIDTH; column++) {
+          if (*bits & (0x80 >> column)) {
+            bitmap_span(wide, column * scale, (column + 1) * scale, true);
+          }
+        }
+        bits = wide;
+      }
+      draw_bits(x, top, bits, width, scale);
+    }
+  }
+  return x;
+}
+
+static uint16_t aligned(LabelField __xdata *field, uint16_t width) {
+  uint16_t room = width < field->width ? field->width - width : 0;
+  switch (LABEL_STYLE_ALIGN(field->style)) {
+  case LABEL_ALIGN_CENTER:
+    return field->x + room / 2;
+  case LABEL_ALIGN_RIGHT:
+    return field->x + room;
+  default:
+    return field->x;
+  }
+}
+
+static uint16_t centered(LabelField __xdata *field, uint8_t height) {
+  return field->y + (height < field->height ? (field->height - height) / 2 : 0);
+}
+
+// font 0 is the built-in one at scale, n the atlas n - 1
+static uint8_t line_height(uint8_t font, uint8_t scale) {
+  return font ? text_height(font - 1) : FONT_HEIGHT * scale;
+}
+
+static uint16_t line_width(uint8_t font, const char __xdata *s, uint8_t length, uint8_t scale) {
+  if (font) {
+    return text_width(font - 1, s, length);
+  }
+  return length ? (length * FONT_ADVANCE - 1) * scale : 0;
+}
+
+static uint16_t line_advance(uint8_t font, const char __xdata *s, uint8_t length, uint8_t scale) {
+  return font ? text_advance(font - 1, s, length) : length * FONT_ADVANCE * scale;
+}
+
+// returns the x after the text
+static uint16_t draw_line(uint8_t font, uint16_t x, uint16_t y, const char __xdata *s, uint8_t length,
+                          uint8_t scale) {
+  if (font) {
+    return text_draw(font - 1, x, y, s, length, clip_y0, clip_y1, draw_glyph_rows);
+  }
+  return draw_builtin(x, y, s, length, scale);
+}
+
+static void draw_text(LabelField __xdata *field, uint8_t font, uint8_t length, uint8_t scale) {
+  draw_line(font, aligned(field, line_width(font, text, length, scale)),
+            centered(field, line_height(font, scale)), text, length, scale);
+}
+
+// ---- values ----
+
+static uint8_t format_digits(char __xdata *out, uint32_t value, uint8_t min_digits) {
+  char __xdata digits[10];
+  uint8_t n = 0;
+  do {
+    digits[n++] = '0' + value % 10;
+    value /= 10;
+  } while (value || n < min_digits);
+  for (uint8_t i = 0; i < n; i++) {
+    out[i] = digits[n - 1 - i];
+  }
+  return n;
+}
+
+static uint8_t format_date(const uint8_t __xdata *value, bool iso) {
+  uint8_t n;
+  if (iso) {
+    n = format_digits(text, 2000 + value[2], 4);
+    text[n++] = '-';
+    n += format_digits(text + n, value[1], 2);
+    text[n++] = '-';
+    n += format_digits(text + n, value[0], 2);
+  } else {
+    n = format_digits(text, value[0], 2);
+    text[n++] = '.';
+    n += format_digits(text + n, value[1], 2);
+    text[n++] = '.';
+    n += format_digits(text + n, 2000 + value[2], 4);
+  }
+  return n;
+}
+
+// the 95 modules of an EAN-13 symbol into bars, false for a bad number
+static bool encode_ean(const uint8_t __xdata *digits, uint8_t length) {
+  uint8_t __xdata d[13];
+  uint8_t sum = 0;
+  uint8_t m = 0;
+  if (length != 12 && length != 13) {
+    return false;
+  }
+  for (uint8_t i = 0; i < length; i++) {
+    if (digits[i] < '0' || digits[i] > '9') {
+      return false;
+    }
+    d[i] = digits[i] - '0';
+  }
+  for (uint8_t i = 0; i < 12; i++) {
+    sum += i & 1 ? 3 * d[i] : d[i];
+  }
+  d[12] = (10 - sum % 10) % 10;
+  if (length == 13 && digits[12] - '0' != d[12]) {
+    return false;
+  }
+
+  memset(bars, 0, sizeof(bars));
+#define MODULES(code, count)                     \
+  for (uint8_t b = count; b--; m++) {            \
+    if ((code) & BV(b)) {                        \
+      bars[m >> 3] |= 0x80 >> (m & 7);           \
+    }                                            \
+  }
+  MODULES(0x05, 3);
+  for (uint8_t i = 1; i < 7; i++) {
+    uint8_t code = ean_codes[d[i]];
+    if (ean_parity[d[0]] & BV(6 - i)) {
+      // even parity: the right hand code reversed
+      uint8_t right = ~code & 0x7F;
+      code = 0;
+      for (uint8_t b = 0; b < 7; b++) {
+        code = (code << 1) | ((right >> b) & 1);
+      }
+    }
+    MODULES(code, 7);
+  }
+  MODULES(0x0A, 5);
+  for (uint8_t i = 7; i < 13; i++) {
+    MODULES(~ean_codes[d[i]] & 0x7F, 7);
+  }
+  MODULES(0x05, 3);
+#undef MODULES
+  return true;
+}
+
+static void draw_field(LabelField __xdata *field, const uint8_t __xdata *value, uint8_t length) {
+  uint8_t scale = field->style & LABEL_STYLE_SCALE;
+  bool alt = field->style & LABEL_STYLE_ALT;
+  uint8_t font = field->fonts & 0x0F;
+  uint8_t n;
+  uint16_t x;
+
+  if (!scale) {
+    scale = 1;
+  }
+  switch (field->type) {
+  case LABEL_TEXT:
+    n = length < TEXT_MAX ? length : TEXT_MAX;
+    memcpy(text, value, n);
+    draw_text(field, font, n, scale);
+    break;
+
+  case LABEL_PRICE: {
+    uint32_t minor;
+    uint8_t small = alt && scale > 1 ? scale / 2 : scale;
+    uint8_t cents = field->fonts >> 4 ? field->fonts >> 4 : font;
+    uint8_t whole;
+    if (length != 4) {
+      break;
+    }
+    minor = read_u16(value) | ((uint32_t)read_u16(value + 2) << 16);
+    whole = format_digits(text, minor / 100, 1);
+    if (!alt) {
+      text[whole] = '.';
+      n = whole + 1 + format_digits(text + whole + 1, minor % 100, 2);
+      draw_text(field, font, n, scale);
+    } else {
+      // cents raised to the top of the digits
+      uint16_t y = centered(field, line_height(font, scale));
+      format_digits(text + whole, minor % 100, 2);
+      x = aligned(field, line_advance(font, text, whole, scale) + line_width(cents, text + whole, 2, small));
+      x = draw_line(font, x, y, text, whole, scale);
+      draw_line(cents, x, y, text + whole, 2, small);
+    }
+    break;
+  }
+
+  case LABEL_DATE:
+    if (length != 3) {
+      break;
+    }
+    n = format_date(value, alt);
+    draw_text(field, font, n, scale);
+    break;
+
+  case LABEL_BARCODE:
+    if (!encode_ean(value, length)) {
+      break;
+    }
+    x = aligned(field, EAN_MODULES * scale);
+    if (scale == 1) {
+      draw_bits(x, field->y, bars, EAN_MODULES, field->height);
+      break;
+    }
+    for (uint8_t m = 0; m < EAN_MODULES; m++, x += scale) {
+      if (bars[m >> 3] & (0x80 >> (m & 7))) {
+        fill(x, field->y, scale, field->height);
+      }
+    }
+    break;
+  }
+}
+
+// the label pixels of panel rows row to row + EPD_BAND_ROWS - 1
+static void locate_band(uint16_t row) {
+  switch (rotation) {
+  case BITMAP_ROTATE_90:
+  case BITMAP_ROTATE_270:
+    band_stride = 1;
+    band_x = rotation == BITMAP_ROTATE_90 ? row : EPD_VRES - EPD_BAND_ROWS - row;
+    band_y = 0;
+    band_width = EPD_BAND_ROWS;
+    band_height = EPD_HRES;
+    break;
+  default:
+    band_stride = EPD_ROW_BYTES;
+    band_x = 0;
+    band_y = rotation == BITMAP_ROTATE_180 ? EPD_VRES - EPD_BAND_ROWS - row : row;
+    band_width = EPD_HRES;
+    band_height = EPD_BAND_ROWS;
+    break;
+  }
+}
+
+// EpdSource: the artwork of the band, then the fields crossing it
+static void render(void) {
+  uint8_t plane = epd_source_call.plane;
+  uint16_t row = epd_source_call.row;
+  uint8_t __xdata *out = epd_source_call.band;
+  PROFILE_ENTER(PROBE_LABEL_RENDER);
+  spiflash_read(LABEL_TEMPLATE_ADDRESS(shown) + LABEL_ART_OFFSET + plane * (uint32_t)EPD_PLANE_SIZE +
+                    row * EPD_ROW_BYTES,
+                out, EPD_BAND_SIZE);
+  locate_band(row);
+  band = out;
+  if (rotation != BITMAP_ROTATE_0) {
+    // the artwork is in panel orientation, turn it back
+    band = canvas;
+    bitmap_rotate(out, EPD_ROW_BYTES, EPD_HRES, EPD_BAND_ROWS, canvas, band_stride, (4 - rotation) & 3);
+  }
+  for (uint8_t i = 0; i < field_count; i++) {
+    LabelField __xdata *field = &fields[i];
+    clip_x0 = field->x > band_x ? field->x : band_x;
+    clip_x1 = field->x + field->width < band_x + band_width ? field->x + field->width : band_x + band_width;
+    clip_y0 = field->y > band_y ? field->y : band_y;
+    clip_y1 = field->y + field->height < band_y + band_height ? field->y + field->height : band_y + band_height;
+    if (clip_x0 >= clip_x1 || clip_y0 >= clip_y1) {
+      continue;
+    }
+    if (set_color(plane, field->colors >> 4)) {
+      fill(field->x, field->y, field->width, field->height);
+    }
+    if (value_at[i] != NO_VALUE && set_color(plane, field->colors & 0x0F)) {
+      draw_field(field, values + value_at[i] + 1, values[value_at[i]]);
+    }
+  }
+  if (rotation != BITMAP_ROTATE_0) {
+    bitmap_rotate(canvas, band_stride, band_width, band_height, out, EPD_ROW_BYTES, rotation);
+  }
+  if (plane == EPD_PLANE_RED && row + EPD_BAND_ROWS == EPD_VRES) {
+    spiflash_sleep();
+  }
+  PROFILE_EXIT(PROBE_LABEL_RENDER);
+}
+
+// ---- templates ----
+
+static bool load(uint8_t template) {
+  uint8_t __xdata header[LABEL_HEADER_SIZE];
+  uint32_t address = LABEL_TEMPLATE_ADDRESS(template);
+  spiflash_read(address, header, LABEL_HEADER_SIZE);
+  if (header[0] != LABEL_MAGIC || header[1] > LABEL_MAX_FIELDS || header[2] > BITMAP_ROTATE_270) {
+    return false;
+  }
+  field_count = header[1];
+  rotation = header[2];
+  spiflash_read(address + LABEL_HEADER_SIZE, (uint8_t __xdata *)fields, field_count * LABEL_FIELD_SIZE);
+  for (uint8_t i = 0; i < field_count; i++) {
+    LabelField __xdata *field = &fields[i];
+    if (field->x > LABEL_WIDTH(rotation) || field->width > LABEL_WIDTH(rotation) - field->x ||
+        field->y > LABEL_HEIGHT(rotation) || field->height > LABEL_HEIGHT(rotation) - field->y ||
+        (field->fonts & 0x0F) > text_atlas_count || field->fonts >> 4 > text_atlas_count) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// EpdDone: the panel holds the label now
+static void shown_done(void) {
+  kv_put(KV_SCREEN, screen, SCREEN_SIZE);
+}
+
+// the label already on the panel, kept across resets
+static bool on_screen(uint8_t template, const uint8_t __xdata *data, uint8_t length) {
+  uint8_t __xdata stored[SCREEN_SIZE];
+  uint16_t crc;
+  CRC16_INIT(0);
+  for (uint8_t i = 0; i < length; i++) {
+    CRC16_UPDATE(data[i]);
+  }
+  crc = CRC16_VALUE();
+  screen[0] = template;
+  screen[1] = crc;
+  screen[2] = crc >> 8;
+  return kv_get(KV_SCREEN, stored, SCREEN_SIZE) == SCREEN_SIZE && !memcmp(stored, screen, SCREEN_SIZE);
+}
+
+bool label_show(uint8_t template, const uint8_t __xdata *data, uint8_t length) {
+  uint8_t at = 0;
+  if (template >= LABEL_TEMPLATES || length > LABEL_MAX_VALUES || epd_busy()) {
+    return false;
+  }
+  if (on_screen(template, data, length)) {
+    // a refresh takes seconds and would change nothing
+    return true;
+  }
+  if (!load(template)) {
+    return false;
+  }
+  memcpy(values, data, length);
+  memset(value_at, NO_VALUE, sizeof(value_at));
+  for (uint8_t i = 0; i < field_count && at < length; i++) {
+    if (at + 1 + values[at] > length) {
+      return false;
+    }
+    value_at[i] = at;
+    at += 1 + values[at];
+  }
+  shown = template;
+  // a reset before the refresh is through leaves the panel in between
+  kv_put(KV_SCREEN, NULL, 0);
+  return epd_show(render, shown_done);
+}
+
+void label_init(void) {
+  writing = LABEL_TEMPLATES;
+}
+
+// args: template, values. Renders and shows the label in the background.
+uint8_t cmd_label_show(void) {
+  const uint8_t __xdata *args = command_call.args;
+  uint8_t length = command_call.length;
+  if (epd_busy()) {
+    return STATUS_BUSY;
+  }
+  return label_show(args[0], args + 1, length - 1) ? STATUS_OK : STATUS_BAD_ARGUMENT;
+}
+
+// args: template, offset (16 bit), data. Offset 0 starts the template over,
+// the rest follows in order.
+uint8_t cmd_label_write(void) {
+  const uint8_t __xdata *args = command_call.args;
+  uint8_t length = command_call.length;
+  uint8_t template = args[0];
+  uint16_t offset = read_u16(args + 1);
+  const uint8_t __xdata *data = args + 3;
+  length -= 3;
+  if (template >= LABEL_TEMPLATES || (uint32_t)offset + length > LABEL_TEMPLATE_SIZE) {
+    return STATUS_BAD_ARGUMENT;
+  }
+  if (epd_busy() && shown == template) {
+    return STATUS_BUSY;
+  }
+  if (!offset) {
+    uint8_t __xdata stored[SCREEN_SIZE];
+    writing = template;
+    erased = 0;
+    if (kv_get(KV_SCREEN, stored, SCREEN_SIZE) && stored[0] == template) {
+      // the same values may look different now
+      kv_put(KV_SCREEN, NULL, 0);
+    }
+  } else if (writing != template) {
+    return STATUS_FAILED;
+  }
+
+  while (length) {
+    uint32_t address = LABEL_TEMPLATE_ADDRESS(template) + offset;
+    uint8_t sector = offset / SPIFLASH_SECTOR_SIZE;
+    if (!(erased & BV(sector))) {
+      spiflash_erase_sector(address & ~(uint32_t)(SPIFLASH_SECTOR_SIZE - 1));
+      erased |= BV(sector);
+    }
+    // up to the end of the flash page
+    uint16_t chunk = SPIFLASH_PAGE_SIZE - (offset & (SPIFLASH_PAGE_SIZE - 1));
+    if (chunk > length) {
+      chunk = length;
+    }
+    spiflash_program(address, data, chunk);
+    offset += chunk;
+    data += chunk;
+    length -= chunk;
+  }
+  spiflash_sleep();
+  return STATUS_OK;
+}
@@ -0,0 +1,89 @@
+#ifndef _LABEL_H_
+#define _LABEL_H_
+
+#include "bitmap.h"
+#include "epd.h"
+#include <stdint.h>
+
+// Label templates: static artwork plus typed fields, stored in the SPI flash
+// once (COMMAND_LABEL_WRITE, or a multicast to MCAST_TARGET_TEMPLATE + n).
+// Showing a label takes a template number and the field values
+// (COMMAND_LABEL_SHOW), the tag renders the frame band by band while it is
+// sent to the panel. The label on the panel is kept in KV_SCREEN, showing it
+// again does nothing, also after a reset.
+//
+// A template slot holds
+//   0x000  magic | field count | rotation | reserved
+//   0x004  fields, LABEL_FIELD_SIZE each
+//   0x100  black plane, then red plane, EPD_PLANE_SIZE each, panel format
+// and a field is
+//   type | height | x (16 bit) | y (16 bit) | width (16 bit) | style | colors |
+//   fonts | reserved
+// with the box in label pixels. Rotation (BITMAP_ROTATE_*) turns the label
+// onto the panel clockwise, a label at 90 or 270 is EPD_VRES wide and
+// EPD_HRES high; the artwork stays in panel orientation. Style is the scale
+// in bits 0 - 2 (1 is the 6x8 font cell), the alignment in bits 3 - 4 and
+// LABEL_STYLE_ALT. Colors hold the ink in the low nibble and the box
+// background in the high one, LABEL_COLOR_NONE keeps the artwork. Fonts hold
+// the font of the text in the low nibble, 0 for the built-in one at the
+// scale or n for text_atlases[n - 1], and that of ALT cents in the high one,
+// 0 for the same.
+//
+// Values follow the template number in field order, each one
+//   length | bytes
+//   LABEL_TEXT     ASCII
+//   LABEL_PRICE    minor units (32 bit), 2 decimals; ALT draws them at
+//                  half size, raised
+//   LABEL_DATE     day | month | year - 2000, DD.MM.YYYY; ALT YYYY-MM-DD
+//   LABEL_BARCODE  12 or 13 digits, EAN-13, bars scale pixels a module
+// A field without a value, or with length 0, stays empty.
+
+#define LABEL_TEMPLATES 3
+#define LABEL_ADDRESS 0x13000UL
+#define LABEL_TEMPLATE_SIZE 0x3000
+#define LABEL_TEMPLATE_ADDRESS(n) (LABEL_ADDRESS + (uint32_t)(n) * LABEL_TEMPLATE_SIZE)
+
+#define LABEL_MAGIC 0x4C
+#define LABEL_HEADER_SIZE 4
+#define LABEL_FIELD_SIZE 12
+#define LABEL_MAX_FIELDS 12
+#define LABEL_ART_OFFSET 0x100
+#define LABEL_MAX_VALUES 96 // bytes of values, with their lengths
+
+#define LABEL_WIDTH(rotation) ((rotation) & 1 ? EPD_VRES : EPD_HRES)
+#define LABEL_HEIGHT(rotation) ((rotation) & 1 ? EPD_HRES : EPD_VRES)
+
+#if LABEL_ART_OFFSET + 2 * EPD_PLANE_SIZE > LABEL_TEMPLATE_SIZE || \
+    LABEL_HEADER_SIZE + LABEL_MAX_FIELDS * LABEL_FIELD_SIZE > LABEL_ART_OFFSET
+#error "label template layout"
+#endif
+
+enum {
+  LABEL_TEXT,
+  LABEL_PRICE,
+  LABEL_DATE,
+  LABEL_BARCODE,
+};
+
+enum {
+  LABEL_ALIGN_LEFT,
+  LABEL_ALIGN_CENTER,
+  LABEL_ALIGN_RIGHT,
+};
+
+#define LABEL_STYLE_SCALE 0x07
+#define LABEL_STYLE_ALIGN(style) (((style) >> 3) & 0x03)
+#define LABEL_STYLE_ALT BV(5)
+
+enum {
+  LABEL_COLOR_NONE,
+  LABEL_COLOR_WHITE,
+  LABEL_COLOR_BLACK,
+  LABEL_COLOR_RED,
+};
+
+void label_init(void);
+// false while the panel is busy or the template is not valid
+bool label_show(uint8_t template, const uint8_t __xdata *values, uint8_t length);
+
+#endif
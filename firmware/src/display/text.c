@@ -0,0 +1,121 @@
+#include "text.h"
+#include "../profile/profile.h"
+#include <string.h>
+
+TextBlitCall __xdata text_blit_call;
+
+static __code const FontAtlas *atlas;
+static uint8_t __xdata row[TEXT_MAX_WIDTH / 8 + 1]; // for the blit, which reads a byte ahead
+static uint16_t pen, right;
+
+// the glyph of c, or of '?' for a character the atlas lacks, NULL if both are
+static __code const FontGlyph *glyph_of(char c) {
+  if (c < atlas->first || c > atlas->last || !atlas->glyphs[c - atlas->first].advance) {
+    c = '?';
+    if (c < atlas->first || c > atlas->last || !atlas->glyphs[c - atlas->first].advance) {
+      return NULL;
+    }
+  }
+  return &atlas->glyphs[c - atlas->first];
+}
+
+static int8_t kerning(char left, char right) {
+  uint16_t key = ((uint16_t)(uint8_t)left << 8) | (uint8_t)right;
+  uint16_t low = 0;
+  uint16_t high = atlas->kerning_count;
+  while (low < high) {
+    uint16_t middle = (low + high) / 2;
+    __code const FontKern *pair = &atlas->kerning[middle];
+    uint16_t at = ((uint16_t)(uint8_t)pair->left << 8) | (uint8_t)pair->right;
+    if (at == key) {
+      return pair->adjust;
+    }
+    if (at < key) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return 0;
+}
+
+static void draw_glyph(__code const FontGlyph *glyph, uint16_t x, uint16_t y, uint16_t y0, uint16_t y1,
+                       TextBlit blit) {
+  __code const uint8_t *bits = atlas->bitmaps + (glyph->offset & ~FONT_GLYPH_RLE);
+  uint8_t row_bytes = (glyph->width + 7) >> 3;
+  bool rle = glyph->offset & FONT_GLYPH_RLE;
+  for (uint8_t done = 0; done < glyph->height && y < y1;) {
+    uint8_t repeat = rle ? *bits++ : 1;
+    if (y + repeat > y0) {
+      memcpy(row, bits, row_bytes);
+      text_blit_call.x = x;
+      text_blit_call.y = y;
+      text_blit_call.bits = row;
+      text_blit_call.width = glyph->width;
+      text_blit_call.rows = repeat;
+      blit();
+    }
+    bits += row_bytes;
+    done += repeat;
+    y += repeat;
+  }
+}
+
+uint8_t text_height(uint8_t index) {
+  return text_atlases[index].height;
+}
+
+// sets pen and right for s
+static void measure(uint8_t index, const char __xdata *s, uint8_t length) {
+  char previous = 0;
+  pen = 0;
+  right = 0;
+  atlas = &text_atlases[index];
+  for (; length; length--, s++) {
+    __code const FontGlyph *glyph = glyph_of(*s);
+    if (!glyph) {
+      continue;
+    }
+    if (previous) {
+      pen += kerning(previous, *s);
+    }
+    if (glyph->width) {
+      right = pen + glyph->left + glyph->width;
+    }
+    pen += glyph->advance;
+    previous = *s;
+  }
+}
+
+uint16_t text_width(uint8_t index, const char __xdata *s, uint8_t length) {
+  measure(index, s, length);
+  return right;
+}
+
+uint16_t text_advance(uint8_t index, const char __xdata *s, uint8_t length) {
+  measure(index, s, length);
+  return pen;
+}
+
+uint16_t text_draw(uint8_t index, uint16_t x, uint16_t y, const char __xdata *s, uint8_t length, uint16_t y0,
+                   uint16_t y1, TextBlit blit) {
+  char previous = 0;
+  PROFILE_ENTER(PROBE_TEXT_DRAW);
+  atlas = &text_atlases[index];
+  for (; length; length--, s++) {
+    __code const FontGlyph *glyph = glyph_of(*s);
+    if (!glyph) {
+      continue;
+    }
+    if (previous) {
+      x += kerning(previous, *s);
+    }
+    if (glyph->width && y + glyph->top < y1 && y + glyph->top + glyph->height > y0) {
+      draw_glyph(glyph, x + glyph->left, y + glyph->top, y0, y1, blit);
+    }
+    x += glyph->advance;
+    previous = *s;
+  }
+  PROFILE_EXIT(PROBE_TEXT_DRAW);
+  return x;
+}
@@ -0,0 +1,71 @@
+#ifndef _TEXT_H_
+#define _TEXT_H_
+
+#include "../hal/hal.h"
+#include <stdint.h>
+
+// Proportional text from glyph atlases rasterized at build time:
+// tools/gen-fonts.js renders the fonts in tools/fonts.json into atlas.c.
+// A glyph is the box around its ink, rows byte aligned with the leftmost
+// pixel in the MSB like the panel, placed relative to the pen and the top of
+// the line. FONT_GLYPH_RLE glyphs store every run of equal rows once after
+// its repeat count, so a stem is a single blit. Kerning pairs are sorted by
+// left, then right character.
+
+#define TEXT_MAX_WIDTH 64 // pixels of a glyph row
+
+#define FONT_GLYPH_RLE 0x8000
+
+typedef struct {
+  uint16_t offset; // into the bitmaps, | FONT_GLYPH_RLE
+  uint8_t width;   // 0 for none, and no advance for a missing character
+  uint8_t height;
+  int8_t left;     // from the pen
+  uint8_t top;     // from the top of the line
+  uint8_t advance;
+} FontGlyph;
+
+typedef struct {
+  char left;
+  char right;
+  int8_t adjust;
+} FontKern;
+
+typedef struct {
+  char first;
+  char last;
+  uint8_t height; // of a line
+  __code const FontGlyph *glyphs;
+  __code const uint8_t *bitmaps;
+  __code const FontKern *kerning;
+  uint16_t kerning_count;
+} FontAtlas;
+
+extern __code const uint8_t text_atlas_count;
+extern __code const FontAtlas text_atlases[];
+
+// what the blit is asked to draw, it takes no arguments: SDCC only passes
+// them through a function pointer to reentrant functions
+typedef struct {
+  uint16_t x, y;
+  const uint8_t __xdata *bits;
+  uint8_t width;
+  uint8_t rows;
+} TextBlitCall;
+
+extern TextBlitCall __xdata text_blit_call;
+
+// draws rows copies of a row of width pixels with its top left at x, y
+typedef void (*TextBlit)(void);
+
+uint8_t text_height(uint8_t atlas);
+// from the pen to the right edge of the last glyph's ink
+uint16_t text_width(uint8_t atlas, const char __xdata *s, uint8_t length);
+// from the pen to the pen after the text
+uint16_t text_advance(uint8_t atlas, const char __xdata *s, uint8_t length);
+// s with the line's top left at x, y, drawing only rows y0 to y1 - 1.
+// Returns the pen after the text.
+uint16_t text_draw(uint8_t atlas, uint16_t x, uint16_t y, const char __xdata *s, uint8_t length, uint16_t y0,
+                   uint16_t y1, TextBlit blit);
+
+#endif
@@ -1,14 +1,30 @@
+#include "clock.h"
 #include "hal.h"
 
 void init_clock(void) {
+  // both oscillators up, the crystal may have been stopped by clock_use_rcosc
+  SLEEP &= ~0x04;
   CLKCON = 0x80; // 32 KHz clock osc, 26MHz crystal osc.
 
   // wait for selection to be active
   while (!CLOCKSOURCE_XOSC_STABLE()) {
   }
+  while (CLKCON & 0x40) {
+  }
   NOP();
 
   // power down the unused oscillator
   SLEEP |= 0x04;
- 
-}
\ No newline at end of file
+}
+
+// run from the HS RC oscillator, needed before PM1/PM2
+void clock_use_rcosc(void) {
+  SLEEP &= ~0x04;
+  while (!(SLEEP & 0x20)) {
+    // HFRC_STB
+  }
+  CLKCON = 0xC9; // 32 KHz clock osc, 13MHz RC osc.
+  while (!(CLKCON & 0x40)) {
+  }
+  SLEEP |= 0x04;
+}
@@ -2,5 +2,6 @@
 #define _CLOCK_H_
 
 void init_clock(void);
+void clock_use_rcosc(void);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,21 @@
+#ifndef _CRC_H_
+#define _CRC_H_
+
+#include "hal.h"
+#include <stdint.h>
+
+// CRC16 (X16 + X15 + X2 + 1, poly 0x8005, MSB first) computed by the random
+// number generator LFSR, matches the gateway's crc16() when seeded with 0.
+// Writing RNDL twice loads the seed high byte first, each write to RNDH
+// clocks one byte through the CRC.
+#ifdef BUILD
+#define CRC16_INIT(seed) st(RNDL = (uint16_t)(seed) >> 8; RNDL = (uint8_t)(seed);)
+#define CRC16_UPDATE(value) st(RNDH = (value);)
+#define CRC16_VALUE() (((uint16_t)RNDH << 8) | RNDL)
+#else
+#define CRC16_INIT(seed) st(rng_model_seed((uint16_t)(seed) >> 8); rng_model_seed((uint8_t)(seed));)
+#define CRC16_UPDATE(value) rng_model_update(value)
+#define CRC16_VALUE() rng_model_value()
+#endif
+
+#endif
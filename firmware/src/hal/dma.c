@@ -0,0 +1,75 @@
+#include "dma.h"
+#include <string.h>
+
+DmaDesc __xdata dma_desc0;
+DmaDesc __xdata dma_desc[4];
+
+static DmaDone __xdata dma_done[DMA_CHANNELS];
+static uint8_t dma_claimed; // shared channels, a bit each
+
+INTERRUPT(dma_isr, DMA_VECTOR) {
+  uint8_t bit = 1;
+  DMAIF = 0;
+
+  for (uint8_t ch = 0; ch < DMA_CHANNELS; ch++, bit <<= 1) {
+    if ((DMAIRQ & bit) && dma_done[ch]) {
+      DMA_CLEAR_IRQ(bit);
+      dma_done[ch]();
+    }
+  }
+}
+
+void dma_init(void) {
+  DMA_ABORT_MASK(0x1F); // all channels
+  DMAIRQ = 0;
+  memset(dma_done, 0, sizeof(dma_done));
+  dma_claimed = 0;
+#ifdef BUILD
+  DMA0CFGH = (uint16_t)&dma_desc0 >> 8;
+  DMA0CFGL = (uint16_t)&dma_desc0;
+  DMA1CFGH = (uint16_t)dma_desc >> 8;
+  DMA1CFGL = (uint16_t)dma_desc;
+#else
+  // the model walks the descriptors directly, the registers only get the low
+  // bits of the host addresses
+  DMA0CFGH = (uintptr_t)&dma_desc0 >> 8;
+  DMA0CFGL = (uintptr_t)&dma_desc0;
+  DMA1CFGH = (uintptr_t)dma_desc >> 8;
+  DMA1CFGL = (uintptr_t)dma_desc;
+#endif
+  DMAIE = 1;
+}
+
+void dma_on_done(uint8_t channel, DmaDone done) {
+  HAL_CRITICAL_STATEMENT(dma_done[channel] = done;);
+}
+
+uint8_t dma_claim(uint8_t count) {
+  uint8_t mask = (BV(count) - 1) << DMA_CH_SHARED;
+  uint8_t channel = DMA_CH_SHARED;
+  uint8_t claimed = DMA_CH_NONE;
+  for (; channel + count <= DMA_CHANNELS; channel++, mask <<= 1) {
+    HAL_CRITICAL_STATEMENT({
+      if (!(dma_claimed & mask)) {
+        dma_claimed |= mask;
+        claimed = channel;
+      }
+    });
+    if (claimed != DMA_CH_NONE) {
+      break;
+    }
+  }
+  return claimed;
+}
+
+void dma_release(uint8_t channel, uint8_t count) {
+  uint8_t mask = (BV(count) - 1) << channel;
+  HAL_CRITICAL_STATEMENT({
+    DMA_ABORT_MASK(mask);
+    DMA_CLEAR_IRQ(mask);
+    for (uint8_t ch = channel; ch < channel + count; ch++) {
+      dma_done[ch] = NULL;
+    }
+    dma_claimed &= ~mask;
+  });
+}
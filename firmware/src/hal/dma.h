@@ -0,0 +1,143 @@
+#ifndef _DMA_H_
+#define _DMA_H_
+
+#include "hal.h"
+#include <stdint.h>
+
+// DMA descriptor layout as read by the controller (8 bytes, big endian addresses)
+typedef struct {
+  uint8_t src_h, src_l;
+  uint8_t dst_h, dst_l;
+  uint8_t len_h; // VLEN[7:5] LEN[12:8]
+  uint8_t len_l; // LEN[7:0]
+  uint8_t cfg0;  // WORDSIZE[7] TMODE[6:5] TRIG[4:0]
+  uint8_t cfg1;  // SRCINC[7:6] DESTINC[5:4] IRQMASK[3] M8[2] PRIORITY[1:0]
+#ifndef BUILD
+  // host builds keep the whole pointers for the model, 16 bits do not reach
+  uint8_t *src, *dst;
+#endif
+} DmaDesc;
+
+#define DMA_WORDSIZE_BYTE 0x00
+#define DMA_WORDSIZE_WORD 0x80
+
+#define DMA_TMODE_SINGLE 0x00
+#define DMA_TMODE_BLOCK 0x20
+#define DMA_TMODE_REPEATED_SINGLE 0x40
+#define DMA_TMODE_REPEATED_BLOCK 0x60
+
+#define DMA_TRIG_NONE 0
+#define DMA_TRIG_PREV 1
+#define DMA_TRIG_URX0 14
+#define DMA_TRIG_UTX0 15
+#define DMA_TRIG_URX1 16
+#define DMA_TRIG_UTX1 17
+#define DMA_TRIG_FLASH 18
+#define DMA_TRIG_RADIO 19
+#define DMA_TRIG_ENC_DW 29
+#define DMA_TRIG_ENC_UP 30
+
+#define DMA_SRCINC_0 0x00
+#define DMA_SRCINC_1 0x40
+#define DMA_SRCINC_2 0x80
+#define DMA_SRCINC_M1 0xC0
+#define DMA_DESTINC_0 0x00
+#define DMA_DESTINC_1 0x10
+#define DMA_DESTINC_2 0x20
+#define DMA_DESTINC_M1 0x30
+#define DMA_IRQMASK BV(3)
+#define DMA_M8_7BIT BV(2)
+#define DMA_PRI_LOW 0x00
+#define DMA_PRI_GUARANTEED 0x01
+#define DMA_PRI_HIGH 0x02
+
+// SFRs as seen from the DMA controller (XDATA space)
+#define DMA_XADDR_FWDATA 0xDFAF
+#define DMA_XADDR_U0DBUF 0xDFC1
+#define DMA_XADDR_U1DBUF 0xDFF9
+#define DMA_XADDR_ENCDI 0xDFB1
+#define DMA_XADDR_ENCDO 0xDFB2
+#define DMA_XADDR_RFD 0xDFD9
+
+#define DMA_VLEN_LEN 0x00      // LEN bytes
+#define DMA_VLEN_FIRST_1 0x20  // first byte n, then n more
+#define DMA_VLEN_FIRST_3 0x80  // first byte n, then n + 2 more
+
+#define DMA_CHANNELS 5
+
+// Channels 0 - 2 belong to the drivers that keep them armed, the bootloader
+// uses channel 0 for the flash controller. The rest are shared, a driver
+// claims them for a transfer and releases them after: dma_claim() hands out
+// consecutive channels, which a DMA_TRIG_PREV chain needs (each channel
+// starts when the one before completes).
+#define DMA_CH_RADIO 0
+#define DMA_CH_UART_RX 1
+#define DMA_CH_UART_TX 2
+#define DMA_CH_SHARED 3 // first shared one
+#define DMA_CH_NONE 0xFF
+
+// descriptors for channels 1-4 must be contiguous, DMA1CFG points at the
+// first, channel 0 has its own in DMA0CFG
+extern DmaDesc __xdata dma_desc0;
+extern DmaDesc __xdata dma_desc[4];
+#define DMA_DESC(ch) (dma_desc[(ch)-1])
+
+#ifdef BUILD
+#define DMA_SET_SRC(d, a) st((d).src_h = (uint16_t)(a) >> 8; (d).src_l = (uint16_t)(a);)
+#define DMA_SET_DST(d, a) st((d).dst_h = (uint16_t)(a) >> 8; (d).dst_l = (uint16_t)(a);)
+#else
+#define DMA_SET_SRC(d, a) \
+  st((d).src_h = (uint16_t)(uintptr_t)(a) >> 8; (d).src_l = (uint8_t)(uintptr_t)(a); (d).src = (uint8_t *)(uintptr_t)(a);)
+#define DMA_SET_DST(d, a) \
+  st((d).dst_h = (uint16_t)(uintptr_t)(a) >> 8; (d).dst_l = (uint8_t)(uintptr_t)(a); (d).dst = (uint8_t *)(uintptr_t)(a);)
+#endif
+#define DMA_SET_LEN(d, l) st((d).len_h = ((uint16_t)(l) >> 8) & 0x1F; (d).len_l = (uint16_t)(l);)
+#define DMA_SET_VLEN(d, l, vlen) st((d).len_h = (((uint16_t)(l) >> 8) & 0x1F) | (vlen); (d).len_l = (uint16_t)(l);)
+
+// Descriptor builders by direction. cfg0 is the word size, transfer mode and
+// trigger, cfg1 the IRQ mask and priority, the increments follow from the
+// direction. Macros, so interrupt handlers can use them too.
+// memory to a peripheral register (DMA_XADDR_*)
+#define DMA_SETUP_TX(d, buffer, xaddr, length, cfg0_, cfg1_) \
+  st(DMA_SET_SRC(d, buffer); DMA_SET_DST(d, xaddr); DMA_SET_LEN(d, length); (d).cfg0 = (cfg0_); \
+     (d).cfg1 = DMA_SRCINC_1 | DMA_DESTINC_0 | (cfg1_);)
+// a peripheral register to memory
+#define DMA_SETUP_RX(d, xaddr, buffer, length, cfg0_, cfg1_) \
+  st(DMA_SET_SRC(d, xaddr); DMA_SET_DST(d, buffer); DMA_SET_LEN(d, length); (d).cfg0 = (cfg0_); \
+     (d).cfg1 = DMA_SRCINC_0 | DMA_DESTINC_1 | (cfg1_);)
+// memory to memory in one go, once triggered with DMA_TRIGGER()
+#define DMA_SETUP_COPY(d, src, dst, length, cfg1_) \
+  st(DMA_SET_SRC(d, src); DMA_SET_DST(d, dst); DMA_SET_LEN(d, length); \
+     (d).cfg0 = DMA_WORDSIZE_BYTE | DMA_TMODE_BLOCK | DMA_TRIG_NONE; \
+     (d).cfg1 = DMA_SRCINC_1 | DMA_DESTINC_1 | (cfg1_);)
+
+#ifdef BUILD
+#define DMA_ARM_MASK(mask) st(DMAARM |= (mask);)
+#define DMA_ABORT_MASK(mask) st(DMAARM = 0x80 | (mask);)
+#define DMA_TRIGGER(ch) st(DMAREQ |= BV(ch);)
+// writing 0 clears a flag, 1 leaves it
+#define DMA_CLEAR_IRQ(mask) st(DMAIRQ = ~(mask);)
+#else
+// host builds run the transfers in the model, see sim/cc2510.h
+#define DMA_ARM_MASK(mask) dma_model_arm(mask)
+#define DMA_ABORT_MASK(mask) dma_model_abort(mask)
+#define DMA_TRIGGER(ch) dma_model_request(BV(ch))
+#define DMA_CLEAR_IRQ(mask) dma_model_clear_irq(mask)
+#endif
+#define DMA_ARM(ch) DMA_ARM_MASK(BV(ch))
+#define DMA_ABORT(ch) DMA_ABORT_MASK(BV(ch))
+#define DMA_IS_ARMED(ch) (DMAARM & BV(ch))
+
+// runs in the DMA interrupt when a channel with DMA_IRQMASK completes
+typedef void (*DmaDone)(void);
+
+void dma_init(void);
+// done for the channel, NULL for none. Channels without one are left to
+// poll DMAIRQ.
+void dma_on_done(uint8_t channel, DmaDone done);
+// the first of count consecutive shared channels, DMA_CH_NONE when they are
+// taken. Release aborts them and drops their callbacks.
+uint8_t dma_claim(uint8_t count);
+void dma_release(uint8_t channel, uint8_t count);
+
+#endif
@@ -9,6 +9,8 @@
 #undef __SDCC
 #define INTERRUPT(name, vector) void name(void)
 #define __xdata
+#define __code
+#define __reentrant
 
 #endif
 
@@ -20,13 +22,22 @@
     x         \
   } while (__LINE__ == -1)
 
+#ifdef BUILD
 #define HAL_ENABLE_INTERRUPTS() st(EA = 1;)
+#else
+// host builds take the interrupts that became pending meanwhile, see sim/cc2510fx.h
+#define HAL_ENABLE_INTERRUPTS() st(EA = 1; cc2510_interrupts();)
+#endif
 #define HAL_DISABLE_INTERRUPTS() st(EA = 0;)
 #define HAL_INTERRUPTS_ARE_ENABLED() (EA)
 
 typedef unsigned char halIntState_t;
 #define HAL_ENTER_CRITICAL_SECTION(x) st(x = EA; HAL_DISABLE_INTERRUPTS();)
+#ifdef BUILD
 #define HAL_EXIT_CRITICAL_SECTION(x) st(EA = x;)
+#else
+#define HAL_EXIT_CRITICAL_SECTION(x) st(EA = x; cc2510_interrupts();)
+#endif
 #define HAL_CRITICAL_STATEMENT(x) st(halIntState_t _s; HAL_ENTER_CRITICAL_SECTION(_s); x; HAL_EXIT_CRITICAL_SECTION(_s);)
 
 #define CLOCKSOURCE_XOSC_STABLE() (SLEEP & 0x40)
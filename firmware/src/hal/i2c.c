@@ -0,0 +1,139 @@
+#include "i2c.h"
+
+// Open drain: a line is pulled low by making it an output, its latch is 0,
+// and released to the pull-up by making it an input.
+#ifdef BUILD
+#define SDA_LOW() st(P0DIR |= BV(I2C_SDA);)
+#define SDA_RELEASE() st(P0DIR &= ~BV(I2C_SDA);)
+#define SDA_READ() (P0_4)
+#define SCL_LOW() st(P0DIR |= BV(I2C_SCL);)
+#define SCL_RELEASE() st(P0DIR &= ~BV(I2C_SCL);)
+#define SCL_READ() (P0_6)
+#else
+// host builds drive the simulated bus
+#include "../../sim/i2c_bus.h"
+#define SDA_LOW() i2c_bus_sda(false)
+#define SDA_RELEASE() i2c_bus_sda(true)
+#define SDA_READ() i2c_bus_read_sda()
+#define SCL_LOW() i2c_bus_scl(false)
+#define SCL_RELEASE() i2c_bus_scl(true)
+#define SCL_READ() i2c_bus_read_scl()
+#endif
+
+#define STRETCH_LIMIT 200 // half periods a slave may hold SCL low
+
+static void i2c_delay(void) {
+  // about 5us at 26MHz
+  for (uint8_t i = 0; i < 12; i++) {
+    NOP();
+  }
+}
+
+static bool i2c_scl_high(void) {
+  SCL_RELEASE();
+  for (uint8_t i = 0; i < STRETCH_LIMIT; i++) {
+    if (SCL_READ()) {
+      return true;
+    }
+    i2c_delay();
+  }
+  return false;
+}
+
+static void i2c_start(void) {
+  SDA_RELEASE();
+  i2c_scl_high();
+  i2c_delay();
+  SDA_LOW();
+  i2c_delay();
+  SCL_LOW();
+}
+
+static void i2c_stop(void) {
+  SDA_LOW();
+  i2c_delay();
+  i2c_scl_high();
+  i2c_delay();
+  SDA_RELEASE();
+  i2c_delay();
+}
+
+// returns true on ACK
+static bool i2c_write_byte(uint8_t value) {
+  for (uint8_t i = 0; i < 8; i++) {
+    if (value & 0x80) {
+      SDA_RELEASE();
+    } else {
+      SDA_LOW();
+    }
+    value <<= 1;
+    i2c_delay();
+    if (!i2c_scl_high()) {
+      return false;
+    }
+    i2c_delay();
+    SCL_LOW();
+  }
+
+  SDA_RELEASE();
+  i2c_delay();
+  bool ack = i2c_scl_high() && !SDA_READ();
+  i2c_delay();
+  SCL_LOW();
+  return ack;
+}
+
+static uint8_t i2c_read_byte(bool ack) {
+  uint8_t value = 0;
+  SDA_RELEASE();
+  for (uint8_t i = 0; i < 8; i++) {
+    i2c_delay();
+    i2c_scl_high();
+    value = (value << 1) | (SDA_READ() ? 1 : 0);
+    i2c_delay();
+    SCL_LOW();
+  }
+
+  if (ack) {
+    SDA_LOW();
+  }
+  i2c_delay();
+  i2c_scl_high();
+  i2c_delay();
+  SCL_LOW();
+  SDA_RELEASE();
+  return value;
+}
+
+void i2c_init(void) {
+  P0SEL &= ~(BV(I2C_SDA) | BV(I2C_SCL));
+  P0INP &= ~(BV(I2C_SDA) | BV(I2C_SCL)); // pull-up (P2INP.PDUP0 = 0)
+  P0_4 = 0;
+  P0_6 = 0;
+  SDA_RELEASE();
+  SCL_RELEASE();
+}
+
+bool i2c_write(uint8_t address, const uint8_t __xdata *data, uint8_t length) {
+  bool ok;
+  i2c_start();
+  ok = i2c_write_byte(address << 1);
+  while (ok && length--) {
+    ok = i2c_write_byte(*data++);
+  }
+  i2c_stop();
+  return ok;
+}
+
+bool i2c_read(uint8_t address, uint8_t __xdata *data, uint8_t length) {
+  bool ok;
+  i2c_start();
+  ok = i2c_write_byte((address << 1) | 1);
+  if (ok) {
+    while (length--) {
+      *data++ = i2c_read_byte(length != 0);
+    }
+  }
+  i2c_stop();
+  return ok;
+}
@@ -0,0 +1,20 @@
+#ifndef _I2C_H_
+#define _I2C_H_
+
+#include "hal.h"
+#include <stdint.h>
+
+// Bit-banged I2C master, SDA on P0_4 and SCL on P0_6 (the NFC chip). SDA
+// shares its pin with the UART TX (USART1 alt 1), see uart_release_tx.
+// About 100kHz, slaves may stretch the clock.
+
+#define I2C_SDA 4
+#define I2C_SCL 6
+
+void i2c_init(void);
+
+// 7 bit address, false when the slave did not acknowledge
+bool i2c_write(uint8_t address, const uint8_t __xdata *data, uint8_t length);
+bool i2c_read(uint8_t address, uint8_t __xdata *data, uint8_t length);
+
+#endif
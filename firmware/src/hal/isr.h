@@ -1,3 +1,9 @@
-INTERRUPT(timer3_isr, T3_VECTOR);
-INTERRUPT(uart_tx_isr, UTX1_VECTOR);
+INTERRUPT(sleep_timer_isr, ST_VECTOR);
+INTERRUPT(dma_isr, DMA_VECTOR);
 INTERRUPT(uart_rx_isr, URX1_VECTOR);
+INTERRUPT(port1_isr, P1INT_VECTOR);
+INTERRUPT(port0_isr, P0INT_VECTOR);
+INTERRUPT(radio_isr, RF_VECTOR);
+#ifdef PROFILE
+INTERRUPT(profile_timer_isr, T1_VECTOR);
+#endif
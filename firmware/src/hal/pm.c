@@ -0,0 +1,73 @@
+#include "pm.h"
+#include "clock.h"
+#include "port.h"
+#include "radio.h"
+#include "time.h"
+#include "uart.h"
+
+#ifdef BUILD
+#define IDLE() st(PCON |= 0x01;)
+#else
+// host builds wait for the host clock and the pty in the model
+#define IDLE() cc2510_idle()
+#endif
+
+PmStats __xdata pm_stats;
+
+static volatile uint8_t holds = 0;
+
+void pm_hold(uint8_t reason) {
+  HAL_CRITICAL_STATEMENT(holds |= reason);
+}
+
+void pm_release(uint8_t reason) {
+  HAL_CRITICAL_STATEMENT(holds &= ~reason);
+}
+
+static uint8_t pm_select(void) {
+  if (holds || uart_tx_busy() || radio_active()) {
+    return 0;
+  }
+  uint32_t left = time_until_alarm();
+  if (left < TIME_MS_TO_TICKS(PM1_MIN_MS)) {
+    return 0;
+  }
+  if (left < TIME_MS_TO_TICKS(PM2_MIN_MS)) {
+    return 1;
+  }
+  return 2;
+}
+
+void pm_idle(void) {
+  uint8_t mode = pm_select();
+  uint32_t start = time_ticks();
+
+  if (!mode) {
+    // The instruction after setting EA always executes, no interrupt can
+    // slip in between.
+    HAL_ENABLE_INTERRUPTS();
+    IDLE();
+  } else {
+    port_wake_on_rx(true);
+    clock_use_rcosc();
+
+    // the sleep timer must have ticked since the last wakeup, or the
+    // chip goes down without it, and the flash cache has to be off
+    uint8_t tick = WORTIME0;
+    while (tick == WORTIME0) {
+    }
+    MEMCTR |= 0x02;
+    SLEEP = (SLEEP & ~0x03) | mode;
+    HAL_ENABLE_INTERRUPTS();
+    IDLE();
+    NOP();
+
+    SLEEP &= ~0x03;
+    MEMCTR &= ~0x02;
+    init_clock();
+    port_wake_on_rx(false);
+  }
+
+  pm_stats.ticks[mode] += time_ticks() - start;
+  pm_stats.entries[mode]++;
+}
@@ -0,0 +1,36 @@
+#ifndef _PM_H_
+#define _PM_H_
+
+#include "hal.h"
+#include <stdint.h>
+
+#define PM_MODES 3 // PM0 (idle), PM1, PM2
+
+// reasons to stay in PM0, the crystal keeps running
+#define PM_HOLD_LINK BV(0) // host link active, the UART needs its baud clock
+#define PM_HOLD_NFC BV(1)  // NFC session, the I2C bit timing runs off the CPU clock
+
+// deadlines closer than this are not worth the oscillator restart
+#ifndef PM1_MIN_MS
+#define PM1_MIN_MS 3
+#endif
+// PM1 keeps the voltage regulator up and wakes faster than PM2
+#ifndef PM2_MIN_MS
+#define PM2_MIN_MS 10
+#endif
+
+typedef struct {
+  uint32_t ticks[PM_MODES]; // sleep timer ticks spent in each mode
+  uint16_t entries[PM_MODES];
+} PmStats;
+
+extern PmStats __xdata pm_stats;
+
+void pm_hold(uint8_t reason);
+void pm_release(uint8_t reason);
+
+// called with interrupts disabled and nothing to do, returns after wakeup
+// with interrupts enabled
+void pm_idle(void);
+
+#endif
@@ -0,0 +1,70 @@
+#include "port.h"
+#include "../sched/sched.h"
+
+// Port 1 has a single edge setting for all its pins. It stays on falling
+// edges for NFC field detect, and is switched to rising edges only while
+// waiting for the display to release BUSY.
+#define EDGE_FALLING() st(PICTL |= BV(1);)
+#define EDGE_RISING() st(PICTL &= ~BV(1);)
+
+INTERRUPT(port1_isr, P1INT_VECTOR) {
+  uint8_t flags = P1IFG;
+  P1IFG = ~flags;
+  P1IF = 0;
+
+  if ((flags & BV(PORT_EPD_BUSY)) && (P1IEN & BV(PORT_EPD_BUSY))) {
+    P1IEN &= ~BV(PORT_EPD_BUSY);
+    EDGE_FALLING();
+    sched_post_isr(EVENT_EPD_READY);
+    if (!P1_1) {
+      // the field may have come up while we listened for the other edge
+      sched_post_isr(EVENT_NFC_FIELD);
+    }
+  }
+  if (flags & BV(PORT_NFC_FD)) {
+    sched_post_isr(EVENT_NFC_FIELD);
+  }
+}
+
+// RX start bit while asleep: the USART can not receive without the crystal,
+// the byte is lost but the link task gets to run and the transport resends
+INTERRUPT(port0_isr, P0INT_VECTOR) {
+  P0IFG = 0;
+  P0IF = 0;
+  P0IE = 0;
+  sched_post_isr(EVENT_UART_RX);
+}
+
+void port_init(void) {
+  P1DIR &= ~(BV(PORT_NFC_FD) | BV(PORT_EPD_BUSY));
+  EDGE_FALLING();
+  P1IFG = 0;
+  P1IEN |= BV(PORT_NFC_FD);
+  IEN2 |= BV(4); // P1IE
+}
+
+// post EVENT_EPD_READY once BUSY goes high, right away if it already is
+void port_watch_busy(void) {
+  HAL_CRITICAL_STATEMENT({
+    EDGE_RISING();
+    P1IFG = ~BV(PORT_EPD_BUSY);
+    P1IEN |= BV(PORT_EPD_BUSY);
+    if (P1_3) {
+      P1IEN &= ~BV(PORT_EPD_BUSY);
+      EDGE_FALLING();
+      sched_post_isr(EVENT_EPD_READY);
+    }
+  });
+}
+
+void port_wake_on_rx(bool enable) {
+  if (enable) {
+    PICTL |= BV(0) | BV(4); // falling edge, P0.4 - P0.7
+    P0IFG = 0;
+    P0IF = 0;
+    P0IE = 1;
+  } else {
+    P0IE = 0;
+    PICTL &= ~BV(4);
+  }
+}
@@ -0,0 +1,14 @@
+#ifndef _PORT_H_
+#define _PORT_H_
+
+#include "hal.h"
+#include <stdint.h>
+
+#define PORT_NFC_FD 1   // P1_1 - NFC field detect, low while a field is present
+#define PORT_EPD_BUSY 3 // P1_3 - EPD busy, low while busy
+
+void port_init(void);
+void port_watch_busy(void);
+void port_wake_on_rx(bool enable); // posts EVENT_UART_RX on the UART RX pin
+
+#endif
@@ -0,0 +1,307 @@
+#include "radio.h"
+#include "dma.h"
+#include "time.h"
+#include "../sched/sched.h"
+#include <string.h>
+
+#ifdef BUILD
+#define STROBE(cmd) st(RFST = (cmd);)
+#else
+// host builds run against a model of the radio registers
+#include "../../sim/cc2510_radio.h"
+#define STROBE(cmd) radio_model_strobe(cmd)
+#endif
+
+#define RFST_SRX 0x02
+#define RFST_STX 0x03
+#define RFST_SIDLE 0x04
+
+#define RFIF_IRQ_DONE BV(4)
+#define RFIF_IRQ_RXOVF BV(6)
+#define PKTSTATUS_SFD BV(3)
+#define LQI_CRC_OK BV(7)
+#define RSSI_OFFSET 71
+
+// the length and address bytes, in the block's header
+#define PACKET_HEADER POOL_HEADER_SIZE
+
+enum {
+  STATE_IDLE,
+  STATE_RX,
+  STATE_TX,
+};
+
+// SmartRF Studio values for 26MHz, MSK with 30/32 sync bits above 2.4k
+typedef struct {
+  uint8_t fsctrl1;
+  uint8_t mdmcfg4;
+  uint8_t mdmcfg3;
+  uint8_t mdmcfg2;
+  uint8_t deviatn;
+  uint8_t foccfg;
+  uint8_t bscfg;
+  uint8_t agcctrl2;
+  uint8_t agcctrl1;
+  uint8_t agcctrl0;
+  uint8_t frend1;
+} RadioRate;
+
+static __code const RadioRate rates[RADIO_RATE_COUNT] = {
+    {0x06, 0x86, 0x83, 0x03, 0x44, 0x16, 0x6C, 0x03, 0x40, 0x91, 0x56}, // 2.4k
+    {0x0A, 0x2D, 0x3B, 0x73, 0x00, 0x1D, 0x1C, 0xC7, 0x00, 0xB2, 0xB6}, // 250k
+    {0x10, 0x0E, 0x3B, 0x73, 0x00, 0x1D, 0x1C, 0xC7, 0x40, 0xB2, 0xB6}, // 500k
+};
+
+RadioStats __xdata radio_stats;
+RadioRxInfo __xdata radio_rx_info;
+
+static volatile uint8_t state = STATE_IDLE;
+static uint8_t listening = 0; // reasons
+static PoolBlock __xdata *rx_block; // armed for the next packet
+static PoolBlock __xdata *tx_block; // on air
+static PoolQueue __xdata rx_frames;
+static PoolQueue __xdata tx_frames;
+
+// not retained in PM2
+static void radio_restore(void) {
+  FSCAL3 = 0xEA;
+  FSCAL2 = 0x0A;
+  FSCAL1 = 0x00;
+  FSCAL0 = 0x11;
+  TEST2 = 0x88;
+  TEST1 = 0x31;
+  TEST0 = 0x09;
+  PA_TABLE0 = 0xFE; // +1dBm
+}
+
+// everything down to radio_isr also runs in the RF interrupt
+#pragma save
+#pragma nooverlay
+static void radio_dma(uint8_t __xdata *packet, bool tx, uint8_t length) {
+  DmaDesc __xdata *desc = &dma_desc0;
+  DMA_ABORT(DMA_CH_RADIO);
+  if (tx) {
+    DMA_SETUP_TX(*desc, packet, DMA_XADDR_RFD, length, DMA_WORDSIZE_BYTE | DMA_TMODE_SINGLE | DMA_TRIG_RADIO,
+                 DMA_PRI_HIGH);
+  } else {
+    // as long as the length byte says, plus the status bytes
+    DMA_SETUP_RX(*desc, DMA_XADDR_RFD, packet, length, DMA_WORDSIZE_BYTE | DMA_TMODE_SINGLE | DMA_TRIG_RADIO,
+                 DMA_PRI_HIGH);
+    DMA_SET_VLEN(*desc, length, DMA_VLEN_FIRST_3);
+  }
+  DMA_ARM(DMA_CH_RADIO);
+#ifndef BUILD
+  radio_model_dma(packet);
+#endif
+}
+
+static void radio_rx_start(void) {
+  if (!rx_block) {
+    rx_block = pool_alloc();
+  }
+  if (!rx_block) {
+    // out of blocks, radio_rx_frame resumes once the caller freed some
+    STROBE(RFST_SIDLE);
+    state = STATE_IDLE;
+    return;
+  }
+  radio_dma(rx_block->packet, false, PKTLEN + 1 + RADIO_STATUS_SIZE);
+  state = STATE_RX;
+  STROBE(RFST_SRX);
+}
+
+static void radio_tx_start(void) {
+  PoolBlock __xdata *block = pool_queue_pop(&tx_frames);
+  uint8_t length = block->length;
+  uint8_t __xdata *packet = block->packet;
+  // radio_send parked the address behind the payload
+  packet[1] = block->data[length];
+  packet[0] = length + 1;
+  tx_block = block;
+
+  STROBE(RFST_SIDLE);
+  radio_dma(packet, true, length + PACKET_HEADER);
+  state = STATE_TX;
+  STROBE(RFST_STX);
+}
+
+// queued packets go out first, then back to listening
+static void radio_next(void) {
+  if (!pool_queue_empty(&tx_frames)) {
+    radio_tx_start();
+  } else if (listening) {
+    radio_rx_start();
+  } else {
+    STROBE(RFST_SIDLE);
+    state = STATE_IDLE;
+  }
+}
+
+static void radio_rx_done(void) {
+  PoolBlock __xdata *block = rx_block;
+  uint8_t length = block->header[0];
+
+  if (DMA_IS_ARMED(DMA_CH_RADIO) || !length) {
+    // the address or length filter hit after the DMA took the first bytes
+    radio_stats.rx_dropped++;
+  } else if (!(block->data[length] & LQI_CRC_OK)) {
+    radio_stats.rx_crc_errors++;
+  } else {
+    uint16_t stamp = time_ticks_isr();
+    block->data[length + 1] = stamp;
+    block->data[length + 2] = stamp >> 8;
+    block->length = length - 1;
+    pool_queue_push(&rx_frames, block);
+    rx_block = NULL;
+    radio_stats.rx_packets++;
+    sched_post_isr(EVENT_RADIO_RX);
+  }
+}
+#pragma restore
+
+INTERRUPT(radio_isr, RF_VECTOR) {
+  uint8_t flags = RFIF;
+  RFIF = ~flags;
+  S1CON = 0;
+
+  if (flags & RFIF_IRQ_DONE) {
+    if (state == STATE_TX) {
+      pool_free(tx_block);
+      tx_block = NULL;
+      radio_stats.tx_packets++;
+    } else if (state == STATE_RX) {
+      // complete even when the next one overflowed behind it
+      radio_rx_done();
+    }
+  }
+  if (flags & RFIF_IRQ_RXOVF) {
+    // the DMA was not armed in time
+    radio_stats.rx_dropped++;
+    STROBE(RFST_SIDLE);
+  }
+  if (flags & (RFIF_IRQ_DONE | RFIF_IRQ_RXOVF)) {
+    radio_next();
+  }
+}
+
+void radio_init(uint8_t address) {
+  memset(&radio_stats, 0, sizeof(radio_stats));
+  pool_queue_init(&rx_frames);
+  pool_queue_init(&tx_frames);
+  rx_block = NULL;
+  tx_block = NULL;
+  listening = 0;
+  state = STATE_IDLE;
+  STROBE(RFST_SIDLE);
+
+  SYNC1 = 0xD3;
+  SYNC0 = 0x91;
+  PKTLEN = RADIO_MAX_PAYLOAD + 1;
+  PKTCTRL1 = 0x06; // append status, address check with 0x00 broadcast
+  PKTCTRL0 = 0x45; // whitening, CRC, variable length
+  ADDR = address;
+  FSCTRL0 = 0x00;
+  FREQ2 = 0x5D; // 2433MHz
+  FREQ1 = 0x93;
+  FREQ0 = 0xB1;
+  MDMCFG1 = 0x22; // 4 preamble bytes, 200kHz channel spacing
+  MDMCFG0 = 0xF8;
+  MCSM1 = 0x0C; // stay in RX after a packet, idle after TX
+  MCSM0 = 0x14; // calibrate when leaving idle
+  FREND0 = 0x10;
+  radio_restore();
+  radio_configure(RADIO_RATE_250K, 0);
+
+  RFIF = 0;
+  S1CON = 0;
+  RFIM = RFIF_IRQ_DONE | RFIF_IRQ_RXOVF;
+  IEN2 |= BV(0); // RFIE
+}
+
+void radio_configure(uint8_t rate, uint8_t channel) {
+  __code const RadioRate *config = &rates[rate];
+  FSCTRL1 = config->fsctrl1;
+  MDMCFG4 = config->mdmcfg4;
+  MDMCFG3 = config->mdmcfg3;
+  MDMCFG2 = config->mdmcfg2;
+  DEVIATN = config->deviatn;
+  FOCCFG = config->foccfg;
+  BSCFG = config->bscfg;
+  AGCCTRL2 = config->agcctrl2;
+  AGCCTRL1 = config->agcctrl1;
+  AGCCTRL0 = config->agcctrl0;
+  FREND1 = config->frend1;
+  CHANNR = channel;
+}
+
+void radio_listen(uint8_t reason, bool enable) {
+  HAL_CRITICAL_STATEMENT({
+    if (enable) {
+      listening |= reason;
+    } else {
+      listening &= ~reason;
+    }
+    if (listening && state == STATE_IDLE) {
+      radio_restore();
+      radio_rx_start();
+    } else if (!listening && state == STATE_RX) {
+      DMA_ABORT(DMA_CH_RADIO);
+      STROBE(RFST_SIDLE);
+      state = STATE_IDLE;
+    }
+  });
+}
+
+bool radio_active(void) {
+  return state != STATE_IDLE;
+}
+
+bool radio_send(uint8_t address, const uint8_t *data, uint8_t length) {
+  if (length > RADIO_MAX_PAYLOAD) {
+    return false;
+  }
+  PoolBlock __xdata *block = pool_alloc();
+  if (!block) {
+    return false;
+  }
+  memcpy(block->data, data, length);
+  block->length = length;
+  radio_send_block(address, block);
+  return true;
+}
+
+void radio_send_block(uint8_t address, PoolBlock __xdata *block) {
+  block->data[block->length] = address;
+
+  HAL_CRITICAL_STATEMENT({
+    pool_queue_push(&tx_frames, block);
+    // a packet being received is finished first, radio_next picks this up
+    if (state == STATE_IDLE || (state == STATE_RX && !(PKTSTATUS & PKTSTATUS_SFD))) {
+      if (state == STATE_IDLE) {
+        radio_restore();
+      }
+      radio_tx_start();
+    }
+  });
+}
+
+PoolBlock __xdata *radio_rx_frame(void) {
+  PoolBlock __xdata *frame = pool_queue_pop(&rx_frames);
+  if (frame) {
+    const uint8_t __xdata *status = frame->data + frame->length;
+    radio_rx_info.rssi = (int8_t)status[0] / 2 - RSSI_OFFSET;
+    radio_rx_info.lqi = status[1] & ~LQI_CRC_OK;
+    radio_rx_info.stamp = status[2] | ((uint16_t)status[3] << 8);
+  } else {
+    HAL_CRITICAL_STATEMENT({
+      if (listening && state == STATE_IDLE) {
+        radio_rx_start();
+      }
+    });
+  }
+  return frame;
+}
+
+bool radio_rx_frame_ready(void) {
+  return !pool_queue_empty(&rx_frames);
+}
@@ -0,0 +1,71 @@
+#ifndef _RADIO_H_
+#define _RADIO_H_
+
+#include "hal.h"
+#include "../pool/pool.h"
+#include <stdint.h>
+
+// 2.4GHz packet radio. On air a packet is
+//   length | address | payload... | crc16
+// with the length covering address and payload, CRC and address filtering
+// (0x00 is broadcast) done by the radio. Packets go through RFD by DMA
+// straight to and from pool blocks: length and address go in the block's
+// header, in front of data, RSSI, LQI and the arrival time land behind the
+// payload. A received block therefore holds the bare payload,
+// like a frame from the COBS link, and the interface follows cobs.h.
+
+#define RADIO_BROADCAST 0x00
+#define RADIO_STATUS_SIZE 2 // RSSI and LQI appended on receive
+#define RADIO_STAMP_SIZE 2  // arrival time, added by the interrupt
+#define RADIO_MAX_PAYLOAD (POOL_BLOCK_SIZE - RADIO_STATUS_SIZE - RADIO_STAMP_SIZE)
+
+// reasons to keep receiving, the radio listens while any is set
+#define RADIO_LISTEN_MCAST BV(0)
+#define RADIO_LISTEN_TDMA BV(1)
+
+#ifndef RADIO_ADDRESS
+#define RADIO_ADDRESS 0x01
+#endif
+
+enum {
+  RADIO_RATE_2K4, // 2-FSK, longest range
+  RADIO_RATE_250K,
+  RADIO_RATE_500K,
+  RADIO_RATE_COUNT,
+};
+
+typedef struct {
+  uint16_t rx_packets;
+  uint16_t rx_crc_errors;
+  uint16_t rx_dropped; // filtered after the DMA started, or no free block
+  uint16_t tx_packets;
+} RadioStats;
+
+typedef struct {
+  int8_t rssi;    // dBm
+  uint8_t lqi;    // correlation, lower is better
+  uint16_t stamp; // low 16 bits of time_ticks() when the packet was complete
+} RadioRxInfo;
+
+extern RadioStats __xdata radio_stats;
+// of the frame last returned by radio_rx_frame
+extern RadioRxInfo __xdata radio_rx_info;
+
+void radio_init(uint8_t address);
+// 2433MHz + channel * 200kHz, only while not listening and nothing is queued
+void radio_configure(uint8_t rate, uint8_t channel);
+
+// receive whenever not transmitting while any reason holds, frames are
+// queued and EVENT_RADIO_RX is posted
+void radio_listen(uint8_t reason, bool enable);
+bool radio_active(void); // listening or transmitting, the crystal is needed
+
+// copies the payload to a pool block and queues it, false without one
+bool radio_send(uint8_t address, const uint8_t *data, uint8_t length);
+// queues a block holding the payload at data, the radio owns it from here
+void radio_send_block(uint8_t address, PoolBlock __xdata *block);
+
+PoolBlock __xdata *radio_rx_frame(void); // next received frame, the caller owns it
+bool radio_rx_frame_ready(void);
+
+#endif
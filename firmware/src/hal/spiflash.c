@@ -0,0 +1,147 @@
+#include "spiflash.h"
+
+#define FLASH_POWER P1_0
+#ifdef BUILD
+#define FLASH_CS(level) st(P1_4 = (level);)
+#define FLASH_CLK(level) st(P1_5 = (level);)
+#define FLASH_MOSI(level) st(P1_6 = (level);)
+#define FLASH_MISO() (P1_7)
+#else
+// host builds clock the flash model
+#include "../../sim/w25x10.h"
+#define FLASH_CS(level) w25x10_cs(level)
+#define FLASH_CLK(level) w25x10_clk(level)
+#define FLASH_MOSI(level) w25x10_mosi(level)
+#define FLASH_MISO() w25x10_miso()
+#endif
+
+#define CMD_WRITE_ENABLE 0x06
+#define CMD_READ_STATUS 0x05
+#define CMD_READ 0x03
+#define CMD_PAGE_PROGRAM 0x02
+#define CMD_SECTOR_ERASE 0x20
+#define CMD_POWER_DOWN 0xB9
+#define CMD_RELEASE_POWER_DOWN 0xAB
+#define CMD_READ_UNIQUE_ID 0x4B
+
+#define STATUS_BUSY BV(0)
+
+static bool asleep = true;
+
+static uint8_t spiflash_transfer(uint8_t value) {
+  // SPI mode 0, MSB first
+  for (uint8_t i = 0; i < 8; i++) {
+    FLASH_MOSI((value & 0x80) ? 1 : 0);
+    FLASH_CLK(1);
+    value = (value << 1) | FLASH_MISO();
+    FLASH_CLK(0);
+  }
+  return value;
+}
+
+static void spiflash_command(uint8_t command) {
+  FLASH_CS(0);
+  spiflash_transfer(command);
+}
+
+static void spiflash_release(void) {
+  FLASH_CS(1);
+}
+
+static void spiflash_wake(void) {
+  if (!asleep) {
+    return;
+  }
+  spiflash_command(CMD_RELEASE_POWER_DOWN);
+  spiflash_release();
+  // tRES1 is 3us
+  for (uint8_t i = 0; i < 20; i++) {
+    NOP();
+  }
+  asleep = false;
+}
+
+static void spiflash_address(uint8_t command, uint32_t address) {
+  spiflash_wake();
+  spiflash_command(command);
+  spiflash_transfer(address >> 16);
+  spiflash_transfer(address >> 8);
+  spiflash_transfer(address);
+}
+
+static void spiflash_wait(void) {
+  spiflash_command(CMD_READ_STATUS);
+  while (spiflash_transfer(0) & STATUS_BUSY) {
+  }
+  spiflash_release();
+}
+
+static void spiflash_write_enable(void) {
+  spiflash_wake();
+  spiflash_command(CMD_WRITE_ENABLE);
+  spiflash_release();
+}
+
+void spiflash_init(void) {
+  P1SEL &= ~(BV(0) | BV(4) | BV(5) | BV(6) | BV(7));
+  P1DIR |= BV(0) | BV(4) | BV(5) | BV(6);
+  P1DIR &= ~BV(7);
+  FLASH_CS(1);
+  FLASH_CLK(0);
+  FLASH_POWER = 1;
+  asleep = true;
+  spiflash_wake();
+}
+
+void spiflash_sleep(void) {
+  spiflash_command(CMD_POWER_DOWN);
+  spiflash_release();
+  asleep = true;
+}
+
+void spiflash_read_begin(uint32_t address) {
+  spiflash_address(CMD_READ, address);
+}
+
+uint8_t spiflash_read_byte(void) {
+  return spiflash_transfer(0);
+}
+
+void spiflash_read_end(void) {
+  spiflash_release();
+}
+
+void spiflash_read(uint32_t address, uint8_t __xdata *data, uint16_t length) {
+  spiflash_read_begin(address);
+  while (length--) {
+    *data++ = spiflash_transfer(0);
+  }
+  spiflash_read_end();
+}
+
+void spiflash_unique_id(uint8_t __xdata *id) {
+  // four dummy bytes, the first three where an address would be
+  spiflash_address(CMD_READ_UNIQUE_ID, 0);
+  spiflash_transfer(0);
+  for (uint8_t i = 0; i < SPIFLASH_UNIQUE_ID_SIZE; i++) {
+    id[i] = spiflash_transfer(0);
+  }
+  spiflash_release();
+}
+
+void spiflash_program(uint32_t address, const uint8_t __xdata *data, uint16_t length) {
+  spiflash_write_enable();
+  spiflash_address(CMD_PAGE_PROGRAM, address);
+  while (length--) {
+    spiflash_transfer(*data++);
+  }
+  spiflash_release();
+  spiflash_wait();
+}
+
+void spiflash_erase_sector(uint32_t address) {
+  spiflash_write_enable();
+  spiflash_address(CMD_SECTOR_ERASE, address);
+  spiflash_release();
+  spiflash_wait();
+}
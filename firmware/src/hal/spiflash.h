@@ -0,0 +1,34 @@
+#ifndef _SPIFLASH_H_
+#define _SPIFLASH_H_
+
+#include "hal.h"
+#include <stdint.h>
+
+// W25X10CL, 128KB NOR flash on P1_4 - P1_7, powered together with the NFC
+// chip from P1_0. The pins are USART1 alt 2 but USART1 serves the host link,
+// so SPI is bit-banged.
+
+#define SPIFLASH_SIZE 0x20000UL
+#define SPIFLASH_PAGE_SIZE 256    // program granularity
+#define SPIFLASH_SECTOR_SIZE 4096 // erase granularity
+#define SPIFLASH_UNIQUE_ID_SIZE 8
+
+void spiflash_init(void);
+void spiflash_sleep(void); // deep power down, the next access wakes it
+
+void spiflash_read(uint32_t address, uint8_t __xdata *data, uint16_t length);
+
+// the 64 bit ID programmed into every chip at the factory
+void spiflash_unique_id(uint8_t __xdata *id);
+
+// streaming read, for checksumming without a buffer
+void spiflash_read_begin(uint32_t address);
+uint8_t spiflash_read_byte(void);
+void spiflash_read_end(void);
+
+// programs within a single page, the bytes must have been erased. Both wait
+// for the operation to complete.
+void spiflash_program(uint32_t address, const uint8_t __xdata *data, uint16_t length);
+void spiflash_erase_sector(uint32_t address);
+
+#endif
@@ -1,22 +1,124 @@
 #include "time.h"
+#include "../sched/sched.h"
 
-static volatile uint32_t currentTime = 0;
+// The sleep timer counts the 32kHz RC oscillator, calibrated against the
+// crystal to 26MHz / 750, that is 104 ticks every 3ms, and keeps running in
+// PM1/PM2. It is a 16-bit counter restarted by its Event 0 match. The
+// interrupt adds each finished period to the running time and programs the
+// next one to end at the nearest alarm, or as late as possible without one.
+// There is no periodic tick.
 
-INTERRUPT(timer3_isr, T3_VECTOR) {
-  T3OVFIF = 0; // clear overflow flag
-  currentTime += 1;
+#define EVENT0_MASK BV(4)
+#define EVENT0_FLAG BV(0)
+
+#define PERIOD_MAX 0xFFFF
+#define TICKS_AHEAD 3 // a compare value closer than this to the count may be missed
+
+static volatile uint32_t __xdata base_ticks = 0; // ticks before the current period
+static volatile uint32_t __xdata base_ms = 0;    // same in milliseconds
+static volatile uint8_t base_rest = 0;           // remainder of base_ms, in 1/104 ms
+static volatile uint16_t __xdata period = PERIOD_MAX;
+static volatile uint32_t __xdata alarm_ticks = 0; // from the period start, 0 when disarmed
+
+static void time_set_period(uint16_t ticks) {
+  period = ticks;
+  WOREVT1 = ticks >> 8;
+  WOREVT0 = ticks;
+}
+
+// the two below also run in the RF interrupt, through time_ticks_isr
+#pragma save
+#pragma nooverlay
+static uint16_t time_read_count(void) {
+  uint8_t low = WORTIME0; // latches WORTIME1
+  return ((uint16_t)WORTIME1 << 8) | low;
+}
+
+// ticks since the start of the current period, interrupts disabled
+static uint32_t time_pending_ticks(void) {
+  while (1) {
+    bool ended = WORIRQ & EVENT0_FLAG;
+    uint16_t count = time_read_count();
+    if (ended == (bool)(WORIRQ & EVENT0_FLAG)) {
+      // the period may have ended without the interrupt running yet
+      return ended ? (uint32_t)period + count : count;
+    }
+  }
+}
+
+uint32_t time_ticks_isr(void) {
+  uint32_t value;
+  HAL_CRITICAL_STATEMENT(value = base_ticks + time_pending_ticks());
+  return value;
+}
+#pragma restore
+
+INTERRUPT(sleep_timer_isr, ST_VECTOR) {
+  WORIRQ &= ~EVENT0_FLAG;
+  STIF = 0;
+
+  uint16_t elapsed = period;
+  uint32_t rest = base_rest + (uint32_t)elapsed * 3;
+  base_ticks += elapsed;
+  base_ms += rest / 104;
+  base_rest = rest % 104;
+
+  if (alarm_ticks) {
+    if (alarm_ticks <= elapsed) {
+      alarm_ticks = 0;
+      sched_post_isr(EVENT_TIMER);
+    } else {
+      alarm_ticks -= elapsed;
+    }
+  }
+  time_set_period(alarm_ticks && alarm_ticks < PERIOD_MAX ? alarm_ticks : PERIOD_MAX);
 }
 
 void time_init() {
-  T3CTL = (uint8_t)((0b111 << 5) | BV(1) | BV(3)); // clk/128, modulo mode, overflow interrupt en
-  T3CC0 = 203;                                     // ~1ms intrerval
-  T3IE = BV(0);                                    // enable timer3 interrupt
-  T3CTL |= BV(4);                                  // start Timer 3
+  WORCTRL = BV(2); // reset the timer, resolution of 1 period
+  time_set_period(PERIOD_MAX);
+  WORIRQ = EVENT0_MASK;
+  STIE = 1;
 }
 
-volatile uint32_t millis() {
+void time_set_alarm(uint16_t milliseconds) {
+  HAL_CRITICAL_STATEMENT({
+    if (!milliseconds) {
+      alarm_ticks = 0;
+    } else {
+      uint32_t now = time_pending_ticks();
+      alarm_ticks = now + TIME_MS_TO_TICKS(milliseconds);
+      if (alarm_ticks < period && now + TICKS_AHEAD < period) {
+        // end the current period early
+        if (alarm_ticks < now + TICKS_AHEAD) {
+          alarm_ticks = now + TICKS_AHEAD;
+        }
+        time_set_period(alarm_ticks);
+      }
+    }
+  });
+}
+
+uint32_t time_until_alarm(void) {
+  uint32_t left = TIME_NO_ALARM;
+  HAL_CRITICAL_STATEMENT({
+    if (alarm_ticks) {
+      uint32_t now = time_pending_ticks();
+      left = alarm_ticks > now ? alarm_ticks - now : 0;
+    }
+  });
+  return left;
+}
+
+uint32_t time_ticks(void) {
+  uint32_t value;
+  HAL_CRITICAL_STATEMENT(value = base_ticks + time_pending_ticks());
+  return value;
+}
+
+uint32_t millis() {
   uint32_t value;
-  HAL_CRITICAL_STATEMENT(value = currentTime);
+  HAL_CRITICAL_STATEMENT(value = base_ms + (base_rest + time_pending_ticks() * 3) / 104);
   return value;
 }
 
@@ -24,4 +126,4 @@ void delay_ms(uint16_t milliseconds) {
   uint32_t start = millis();
   while (millis() - start < milliseconds) {
   }
-}
\ No newline at end of file
+}
@@ -4,8 +4,17 @@
 #include "hal.h"
 #include <stdint.h>
 
+// sleep timer ticks, 34666.67 per second
+#define TIME_TICKS_PER_SECOND 34667
+#define TIME_MS_TO_TICKS(ms) (((uint32_t)(ms) * 104 + 2) / 3)
+#define TIME_NO_ALARM 0xFFFFFFFF
+
 void time_init();
 uint32_t millis();
+uint32_t time_ticks(void);
+uint32_t time_ticks_isr(void); // same, for interrupt handlers
 void delay_ms(uint16_t millis);
+void time_set_alarm(uint16_t milliseconds);
+uint32_t time_until_alarm(void);
 
-#endif
\ No newline at end of file
+#endif
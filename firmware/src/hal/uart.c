@@ -1,45 +1,68 @@
 #include "uart.h"
+#include "dma.h"
+#include "../sched/sched.h"
 #include <stdbool.h>
 #include <string.h>
 
-#define UART_TX_BUFFER_SIZE 128
-#define UART_RX_BUFFER_SIZE 128
-
-uint8_t __xdata tx_buffer[UART_TX_BUFFER_SIZE];
-volatile uint8_t tx_buffer_head = 0;
-volatile uint8_t tx_buffer_tail = 0;
-volatile bool tx_in_progress = false;
-volatile bool tx_buffer_full = false;
-
-uint8_t __xdata rx_buffer[UART_TX_BUFFER_SIZE];
-volatile uint8_t rx_buffer_head = 0;
-volatile uint8_t rx_buffer_tail = 0;
-volatile bool rx_buffer_full = false;
-
-INTERRUPT(uart_tx_isr, UTX1_VECTOR) {
-  UTX1IF = 0;
-
-  if (tx_buffer_head == tx_buffer_tail && !tx_buffer_full) {
-    // buffer is empty, nothing to send
-    tx_in_progress = false;
-  } else {
-    U1DBUF = tx_buffer[tx_buffer_tail];
-    tx_buffer_tail = (tx_buffer_tail + 1) % UART_TX_BUFFER_SIZE;
-    tx_buffer_full = false;
-  }
-}
+#define UART_RX_BUFFER_SIZE 128 // slots, must be a power of 2
+
+// The RX DMA moves 16-bit words starting at U1DBUF, so every slot receives the
+// data byte followed by U1BAUD. The reader marks consumed slots with ~U1BAUD,
+// a slot holding the U1BAUD value is therefore one the DMA has written since.
+// This is how the reader follows the DMA write position, the controller does
+// not expose its current address.
+typedef struct {
+  uint8_t data;
+  uint8_t mark;
+} RxSlot;
+
+#define RX_MARK_NEW U1BAUD
+#define RX_MARK_READ ((uint8_t)~U1BAUD)
+
+UartStats __xdata uart_stats;
+
+static RxSlot __xdata rx_buffer[UART_RX_BUFFER_SIZE];
+static uint8_t rx_buffer_tail = 0;
+static uint8_t rx_lap = 0;              // laps completed by the reader
+static volatile uint8_t rx_dma_lap = 0; // laps completed by the DMA
+
+static uint8_t __xdata tx_buffer[2][UART_TX_BUFFER_SIZE];
+static uint8_t tx_fill = 0;        // buffer being filled by the writers
+static uint16_t tx_fill_size = 0;  // bytes queued in the fill buffer
+static volatile bool tx_in_progress = false;
 
 INTERRUPT(uart_rx_isr, URX1_VECTOR) {
+  // the DMA already moved the byte, this only wakes the link task
   URX1IF = 0;
+  URX1IE = 0;
+  sched_post_isr(EVENT_UART_RX);
+}
 
-  if (rx_buffer_full) {
-    // buffer is full, discard the byte, flag an error
-    return;
+// DmaDone, in the DMA interrupt. A lap is as much as the ring holds, the
+// reader gets to run even if it left the RX interrupt disarmed.
+static void uart_dma_rx_done(void) {
+  rx_dma_lap++;
+  sched_post_isr(EVENT_UART_RX);
+}
+
+static void uart_dma_tx_done(void) {
+  tx_in_progress = false;
+}
+
+static void uart_rx_start(void) {
+  DmaDesc __xdata *desc = &DMA_DESC(DMA_CH_UART_RX);
+
+  DMA_ABORT(DMA_CH_UART_RX);
+  for (uint8_t i = 0; i < UART_RX_BUFFER_SIZE; i++) {
+    rx_buffer[i].mark = RX_MARK_READ;
   }
+  rx_buffer_tail = 0;
+  rx_lap = 0;
+  rx_dma_lap = 0;
 
-  rx_buffer[rx_buffer_head] = U1DBUF;
-  rx_buffer_head = (rx_buffer_head + 1) % UART_RX_BUFFER_SIZE;
-  rx_buffer_full = rx_buffer_head == rx_buffer_tail;
+  DMA_SETUP_RX(*desc, DMA_XADDR_U1DBUF, rx_buffer, UART_RX_BUFFER_SIZE,
+               DMA_WORDSIZE_WORD | DMA_TMODE_REPEATED_SINGLE | DMA_TRIG_URX1, DMA_IRQMASK | DMA_PRI_HIGH);
+  DMA_ARM(DMA_CH_UART_RX);
 }
 
 void uart_init(void) {
@@ -55,31 +78,98 @@ void uart_init(void) {
   U1CSR |= BV(7) | BV(6); // uart mode + enable RX
   U1UCR = BV(1);          // high stop bit
 
-  // 115200 baud, 26MHz clock
+  // 26MHz clock, see UART_BAUD_E
   U1BAUD = 34;
-  U1GCR = 12;
+  U1GCR = UART_BAUD_E;
+
+  // source and length are filled in for every flush
+  DmaDesc __xdata *desc = &DMA_DESC(DMA_CH_UART_TX);
+  DMA_SETUP_TX(*desc, tx_buffer[0], DMA_XADDR_U1DBUF, 0, DMA_WORDSIZE_BYTE | DMA_TMODE_SINGLE | DMA_TRIG_UTX1,
+               DMA_IRQMASK | DMA_PRI_GUARANTEED);
+  dma_on_done(DMA_CH_UART_RX, uart_dma_rx_done);
+  dma_on_done(DMA_CH_UART_TX, uart_dma_tx_done);
 
-  IEN2 |= BV(3); // enable TX interrupt
-  URX1IE = 1;    // enable RX interrupt
+  uart_rx_start();
 }
 
-void uart_send_byte(uint8_t data) {
-  while (tx_buffer_full) {
-    // buffer is full, wait for a byte to be sent
+void uart_flush(void) {
+  if (!tx_fill_size) {
+    return;
+  }
+
+  if (tx_in_progress) {
+    uart_stats.tx_stalls++;
+    while (tx_in_progress) {
+      // wait for the other buffer to be sent
+    }
+  }
+  while (U1CSR & 0x01) {
+    // let the last byte of the previous frame leave the shift register
+  }
+
+  DmaDesc __xdata *desc = &DMA_DESC(DMA_CH_UART_TX);
+  DMA_SET_SRC(*desc, tx_buffer[tx_fill]);
+  DMA_SET_LEN(*desc, tx_fill_size);
+
+  tx_in_progress = true;
+  DMA_ARM(DMA_CH_UART_TX);
+  NOP(); // arming takes effect after 9 system clocks
+  NOP();
+  NOP();
+  DMA_TRIGGER(DMA_CH_UART_TX); // first byte, the rest is paced by UTX1
+
+  tx_fill ^= 1;
+  tx_fill_size = 0;
+}
+
+void uart_release_tx(void) {
+  uart_flush();
+  while (uart_tx_busy()) {
   }
+  P0SEL &= ~BV(4);
+  P0DIR &= ~BV(4);
+}
 
-  tx_buffer[tx_buffer_head] = data;
+void uart_claim_tx(void) {
+  P0DIR |= BV(4);
+  P0SEL |= BV(4);
+}
 
-  HAL_CRITICAL_STATEMENT({
-    tx_buffer_head = (tx_buffer_head + 1) % UART_TX_BUFFER_SIZE;
-    tx_buffer_full = tx_buffer_head == tx_buffer_tail;
-  });
+void uart_release_rx(void) {
+  U1CSR &= ~BV(6);
+  P2DIR &= 0x3F; // USART0 has priority
+  P0DIR |= BV(5);
+}
 
-  if (!tx_in_progress) {
-    // kick off a transmission
-    tx_in_progress = true;
-    UTX1IF = 1;
+void uart_claim_rx(void) {
+  P0DIR &= ~BV(5);
+  P2DIR = (P2DIR & 0x3F) | BV(6);
+  U1CSR |= BV(6);
+}
+
+bool uart_tx_busy(void) {
+  return tx_in_progress || (U1CSR & 0x01);
+}
+
+void uart_send_byte(uint8_t data) {
+  if (tx_fill_size == UART_TX_BUFFER_SIZE) {
+    uart_flush();
+  }
+  tx_buffer[tx_fill][tx_fill_size++] = data;
+}
+
+uint8_t __xdata *uart_tx_reserve(uint16_t size) {
+  if (size > UART_TX_BUFFER_SIZE) {
+    return NULL;
+  }
+  if (UART_TX_BUFFER_SIZE - tx_fill_size < size) {
+    uart_flush();
   }
+  return &tx_buffer[tx_fill][tx_fill_size];
+}
+
+void uart_tx_commit(uint16_t size) {
+  tx_fill_size += size;
 }
 
 void uart_send(const uint8_t *data, size_t len) {
@@ -89,32 +179,54 @@ void uart_send(const uint8_t *data, size_t len) {
 }
 
 void uart_send_str(const char *str) {
-  uart_send(str, strlen(str));
+  uart_send((const uint8_t *)str, strlen(str));
 }
 
-uint8_t uart_available() {
-  uint8_t head, tail;
-  HAL_CRITICAL_STATEMENT({
-    head = rx_buffer_head;
-    tail = rx_buffer_tail;
-  });
-  if (head >= tail) {
-    return head - tail;
+static bool uart_rx_check_overflow(void) {
+  uint8_t laps;
+  // a lap the DMA completed without its interrupt having run yet counts too
+  HAL_CRITICAL_STATEMENT(laps = rx_dma_lap - rx_lap + ((DMAIRQ & BV(DMA_CH_UART_RX)) ? 1 : 0););
+  if (!laps) {
+    return false;
+  }
+  // A lap ahead, the slots the DMA wrote in its new lap read as new again.
+  // The one before the reader is still marked read as long as the DMA has
+  // not reached it, once it has, the ring is full and the next byte goes
+  // over one not read yet.
+  if (laps == 1 && rx_buffer_tail && rx_buffer[rx_buffer_tail - 1].mark != RX_MARK_NEW) {
+    return false;
+  }
+  // the DMA caught up with the reader, there is no telling which slots still
+  // hold valid data: start over
+  uart_stats.rx_overflows++;
+  uart_rx_start();
+  return true;
+}
+
+bool uart_rx_pending(void) {
+  return rx_buffer[rx_buffer_tail].mark == RX_MARK_NEW;
+}
+
+void uart_rx_arm(void) {
+  URX1IF = 0;
+  URX1IE = 1;
+  if (uart_rx_pending()) {
+    // arrived before the interrupt was enabled
+    sched_post(EVENT_UART_RX);
   }
-  return UART_RX_BUFFER_SIZE - tail + head;
 }
 
 bool uart_read_byte(uint8_t *data) {
-  bool isBufferEmpty;
-  HAL_CRITICAL_STATEMENT({
-    isBufferEmpty = rx_buffer_head == rx_buffer_tail && !rx_buffer_full;
-  });
-  if (isBufferEmpty) {
+  RxSlot __xdata *slot = &rx_buffer[rx_buffer_tail];
+  if (slot->mark != RX_MARK_NEW || uart_rx_check_overflow()) {
     return false;
   }
 
-  *data = rx_buffer[rx_buffer_tail];
-  rx_buffer_tail = (rx_buffer_tail + 1) % UART_RX_BUFFER_SIZE;
-  rx_buffer_full = false;
+  *data = slot->data;
+  slot->mark = RX_MARK_READ;
+  rx_buffer_tail = (rx_buffer_tail + 1) & (UART_RX_BUFFER_SIZE - 1);
+  if (!rx_buffer_tail) {
+    rx_lap++;
+  }
   return true;
 }
@@ -5,13 +5,52 @@
 #include <stdint.h>
 #include <string.h>
 
+// U1GCR baud exponent with U1BAUD = 34 @ 26MHz:
+// 12 = 115200, 13 = 230400, 14 = 460800, 15 = 921600
+#ifndef UART_BAUD_E
+#define UART_BAUD_E 12
+#endif
+
+// per buffer, two are used ping-pong. cobs_end flushes every frame, so a
+// buffer holds the longest frame encoded, see crypto/link.c
+#define UART_TX_BUFFER_SIZE 152
+
+typedef struct {
+  uint16_t rx_overflows; // RX DMA lapped the reader, unread bytes were lost
+  uint16_t tx_stalls;    // a writer had to wait for the TX DMA to free a buffer
+} UartStats;
+
+extern UartStats __xdata uart_stats;
+
 void uart_init(void);
 
 void uart_send_byte(uint8_t data);
 void uart_send(const uint8_t *data, size_t len);
 void uart_send_str(const char *str);
+void uart_flush(void);
+bool uart_tx_busy(void); // bytes still on their way out, the baud clock is needed
+
+// P0_4 doubles as the NFC chip's SDA: release drains the TX and hands the pin
+// over, bytes sent until it is claimed back are lost
+void uart_release_tx(void);
+void uart_claim_tx(void);
+
+// P0_5 doubles as the panel's SPI clock (USART0 alt 1): release turns the
+// receiver off and gives USART0 the pin, bytes arriving until it is claimed
+// back are lost. The RX ring keeps what it holds.
+void uart_release_rx(void);
+void uart_claim_rx(void);
+
+// direct access to the TX buffer: reserve returns room for size contiguous
+// bytes (flushing first if needed), NULL for more than a buffer holds.
+// commit queues the bytes written there.
+uint8_t __xdata *uart_tx_reserve(uint16_t size);
+void uart_tx_commit(uint16_t size);
 
-uint8_t uart_available();
+// The RX DMA fills a ring that is read from task context. The RX interrupt
+// posts EVENT_UART_RX once per arming, every lap of the DMA posts it too.
+void uart_rx_arm(void);
+bool uart_rx_pending(void);
 bool uart_read_byte(uint8_t *data);
 
-#endif
\ No newline at end of file
+#endif
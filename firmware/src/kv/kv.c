@@ -0,0 +1,175 @@
+#include "kv.h"
+#include "../hal/crc.h"
+#include "../hal/spiflash.h"
+#include <string.h>
+
+#define KV_HEADER 0xFE
+#define KV_EMPTY 0xFF // an erased key byte
+
+#define RECORDS (SPIFLASH_SECTOR_SIZE / sizeof(KvRecord))
+#define SECTOR(i) (KV_ADDRESS + (uint32_t)(i)*SPIFLASH_SECTOR_SIZE)
+#define NOT_FOUND 0 // slot 0 is the header
+
+typedef struct {
+  uint8_t key;
+  uint8_t length;
+  uint8_t value[KV_MAX_VALUE];
+  uint16_t crc; // CRC16 of the fields above
+} KvRecord;
+
+static KvRecord __xdata record;
+static uint8_t __xdata sector;         // the active one
+static uint16_t __xdata used;          // slots of the active sector, with the header
+static uint16_t __xdata generation;    // of the active sector
+static uint8_t __xdata found[KV_KEYS]; // slot of the newest record of each key
+
+static uint16_t record_crc(void) {
+  const uint8_t __xdata *data = (const uint8_t __xdata *)&record;
+  CRC16_INIT(0);
+  for (uint8_t i = 0; i < sizeof(KvRecord) - sizeof(uint16_t); i++) {
+    CRC16_UPDATE(data[i]);
+  }
+  return CRC16_VALUE();
+}
+
+static uint32_t slot_address(uint8_t in, uint16_t slot) {
+  return SECTOR(in) + slot * sizeof(KvRecord);
+}
+
+// into record, false when it is broken or was never written
+static bool read_record(uint8_t in, uint16_t slot) {
+  spiflash_read(slot_address(in, slot), (uint8_t __xdata *)&record, sizeof(KvRecord));
+  return record.key != KV_EMPTY && record.length <= KV_MAX_VALUE && record.crc == record_crc();
+}
+
+static void write_record(uint8_t in, uint16_t slot) {
+  record.crc = record_crc();
+  // records are 16 bytes, never crossing a page
+  spiflash_program(slot_address(in, slot), (const uint8_t __xdata *)&record, sizeof(KvRecord));
+}
+
+static bool read_header(uint8_t in, uint16_t __xdata *value) {
+  if (!read_record(in, 0) || record.key != KV_HEADER) {
+    return false;
+  }
+  *value = record.value[0] | ((uint16_t)record.value[1] << 8);
+  return true;
+}
+
+static void write_header(uint8_t in, uint16_t value) {
+  memset(&record, 0, sizeof(record));
+  record.key = KV_HEADER;
+  record.length = 2;
+  record.value[0] = value;
+  record.value[1] = value >> 8;
+  write_record(in, 0);
+}
+
+static uint8_t key_at(uint8_t in, uint16_t slot) {
+  uint8_t key;
+  spiflash_read_begin(slot_address(in, slot));
+  key = spiflash_read_byte();
+  spiflash_read_end();
+  return key;
+}
+
+// records are appended in order, the programmed ones form a prefix
+static uint16_t count(uint8_t in) {
+  uint16_t low = 1;
+  uint16_t high = RECORDS;
+  while (low < high) {
+    uint16_t middle = (low + high) / 2;
+    if (key_at(in, middle) == KV_EMPTY) {
+      high = middle;
+    } else {
+      low = middle + 1;
+    }
+  }
+  return low;
+}
+
+// the newest records, walking back from the end until every key has one
+static void scan(void) {
+  uint8_t missing = KV_KEYS;
+  memset(found, NOT_FOUND, sizeof(found));
+  for (uint16_t slot = used; missing && --slot;) {
+    if (read_record(sector, slot) && record.key < KV_KEYS && found[record.key] == NOT_FOUND) {
+      found[record.key] = slot;
+      missing--;
+    }
+  }
+}
+
+// the newest record of every key into the other sector, deleted ones are
+// left behind
+static void compact(void) {
+  uint8_t to = sector ^ 1;
+  uint16_t slot = 1;
+  spiflash_erase_sector(SECTOR(to));
+  for (uint8_t key = 0; key < KV_KEYS; key++) {
+    if (found[key] != NOT_FOUND && read_record(sector, found[key]) && record.length) {
+      write_record(to, slot);
+      found[key] = slot++;
+    } else {
+      found[key] = NOT_FOUND;
+    }
+  }
+  write_header(to, ++generation);
+  sector = to;
+  used = slot;
+}
+
+void kv_init(void) {
+  uint16_t __xdata header[2];
+  bool valid[2];
+  for (uint8_t i = 0; i < 2; i++) {
+    valid[i] = read_header(i, &header[i]);
+  }
+  if (!valid[0] && !valid[1]) {
+    // a blank store, or one never completed
+    spiflash_erase_sector(SECTOR(0));
+    generation = 0;
+    write_header(0, generation);
+    sector = 0;
+  } else {
+    sector = !valid[0] || (valid[1] && (int16_t)(header[1] - header[0]) > 0);
+    generation = header[sector];
+  }
+  used = count(sector);
+  scan();
+  spiflash_sleep();
+}
+
+uint8_t kv_get(uint8_t key, uint8_t __xdata *value, uint8_t size) {
+  uint8_t length = 0;
+  if (found[key] != NOT_FOUND && read_record(sector, found[key])) {
+    length = record.length;
+    memcpy(value, record.value, length < size ? length : size);
+  }
+  spiflash_sleep();
+  return length;
+}
+
+static bool unchanged(uint8_t key, const uint8_t __xdata *value, uint8_t length) {
+  if (found[key] == NOT_FOUND) {
+    return !length;
+  }
+  return read_record(sector, found[key]) && record.length == length && !memcmp(record.value, value, length);
+}
+
+void kv_put(uint8_t key, const uint8_t __xdata *value, uint8_t length) {
+  if (unchanged(key, value, length)) {
+    spiflash_sleep();
+    return;
+  }
+  if (used == RECORDS) {
+    compact();
+  }
+  memset(&record, 0, sizeof(record));
+  record.key = key;
+  record.length = length;
+  memcpy(record.value, value, length);
+  write_record(sector, used);
+  found[key] = used++;
+  spiflash_sleep();
+}
@@ -0,0 +1,35 @@
+#ifndef _KV_H_
+#define _KV_H_
+
+#include "../hal/hal.h"
+#include <stdint.h>
+
+// State that outlives a reset, so a tag coming back from a brownout or the
+// watchdog picks up where it was instead of starting over. A small key/value
+// store in two sectors of the SPI flash: every put appends a record
+//   key | length | value (KV_MAX_VALUE bytes) | crc16
+// to the active sector and the newest valid record of a key wins. A full
+// sector is compacted into the other one, erased first: the newest record
+// of each key is copied over and the header in slot 0
+//   KV_HEADER | 2 | generation (16 bit) | ... | crc16
+// goes in last, so a compaction cut short leaves the old sector in charge.
+// The sectors take turns, which spreads the erases over both.
+
+#define KV_ADDRESS 0x1C000UL // two sectors, next to the areas in ota/image.h
+#define KV_MAX_VALUE 12
+
+enum {
+  KV_SCREEN,    // the label on the panel, see display/label.c
+  KV_TDMA,      // slot assignment and drift, see tdma/tdma.c
+  KV_TRANSPORT, // sequence number of the last start, see transport/transport.c
+  KV_KEYS,
+};
+
+// finds the newest records, a few flash reads. Needs spiflash_init().
+void kv_init(void);
+// copies up to size bytes of the value, returns its length, 0 for none
+uint8_t kv_get(uint8_t key, uint8_t __xdata *value, uint8_t size);
+// length 0 deletes the key. Nothing is written when the value is the same.
+void kv_put(uint8_t key, const uint8_t __xdata *value, uint8_t length);
+
+#endif
@@ -1,44 +1,146 @@
 #include "display/epd.h"
+#include "display/label.h"
 
 #include "hal/clock.h"
+#include "hal/dma.h"
 #include "hal/hal.h"
 #include "hal/isr.h"
 #include "hal/led.h"
+#include "hal/pm.h"
+#include "hal/port.h"
+#include "hal/radio.h"
 #include "hal/time.h"
 #include "hal/uart.h"
 
 #include "cobs/cobs.h"
+#include "command/command.h"
+#include "crypto/link.h"
+#include "kv/kv.h"
+#include "mcast/mcast.h"
+#include "nfc/nfc.h"
+#include "ota/ota.h"
+#include "pool/pool.h"
+#include "profile/profile.h"
+#include "sched/sched.h"
+#include "sched/timer.h"
+#include "tdma/tdma.h"
+#include "transport/transport.h"
+
+// frames handled per run of the link task before yielding to other tasks,
+// more arriving meanwhile are queued in pool blocks by the RX interrupt
+#define LINK_FRAMES_PER_RUN 4
+// radio packets handled per run of the radio task
+#define RADIO_FRAMES_PER_RUN 4
+// keep the crystal running this long after the last link activity, the
+// first byte arriving in PM1/PM2 is lost
+#define LINK_IDLE_MS 2000
+// the LED blinks this many times after a reset, alongside the rest of boot
+#define BOOT_BLINKS 10
+#define BOOT_BLINK_MS 50
+
+static Timer __xdata link_timer;
+static Timer __xdata link_idle_timer;
+static Timer __xdata blink_timer;
+static uint8_t blinks;
+
+static void blink(void) {
+  LED_TOGGLE;
+  if (--blinks) {
+    timer_start(&blink_timer, BOOT_BLINK_MS, blink);
+  }
+}
+
+static void link_idle(void) {
+  if (transport_idle()) {
+    pm_release(PM_HOLD_LINK);
+  } else {
+    timer_start(&link_idle_timer, LINK_IDLE_MS, link_idle);
+  }
+}
+
+static void link_task(void) {
+  pm_hold(PM_HOLD_LINK);
+  timer_start(&link_idle_timer, LINK_IDLE_MS, link_idle);
+
+  cobs_rx_poll();
+  for (uint8_t i = 0; i < LINK_FRAMES_PER_RUN; i++) {
+    PoolBlock __xdata *frame = cobs_rx_frame();
+    if (!frame) {
+      break;
+    }
+    transport_receive(frame);
+  }
+  transport_poll();
+
+  if (cobs_rx_frame_ready()) {
+    sched_post(EVENT_UART_RX);
+  }
+  if (!transport_idle()) {
+    // come back for retransmissions and delayed acks
+    timer_start(&link_timer, TRANSPORT_RTO_MS, link_task);
+  }
+}
+
+// radio packets go to the module their first byte belongs to
+static void radio_task(void) {
+  for (uint8_t i = 0; i < RADIO_FRAMES_PER_RUN; i++) {
+    PoolBlock __xdata *frame = radio_rx_frame();
+    if (!frame) {
+      break;
+    }
+    bool kept = false;
+    switch (frame->length ? frame->data[0] : 0) {
+    case MCAST_ANNOUNCE:
+    case MCAST_SYMBOL:
+      mcast_receive(frame->data, frame->length);
+      break;
+    case TDMA_BEACON:
+    case TDMA_DATA:
+      kept = tdma_receive(frame);
+      break;
+    }
+    if (!kept) {
+      pool_free(frame);
+    }
+  }
+  if (radio_rx_frame_ready()) {
+    sched_post(EVENT_RADIO_RX);
+  }
+}
 
 void main(void) {
   init_clock();
   time_init();
+  dma_init();
   uart_init();
-  
+  port_init();
+  sched_init();
+  profile_init();
+  ota_init();
+  kv_init();
+#ifdef LINK_KEY
+  link_init();
+#endif
+
   HAL_ENABLE_INTERRUPTS();
   LED_INIT;
+  blinks = BOOT_BLINKS;
+  blink();
 
-  for (uint8_t i = 0; i < 10; i++) {
-    LED_TOGGLE;
-    delay_ms(50);
-  }
-
-  // epd_init();
+  epd_init();
 
   LED_BOOST_ON;
 
-  CobsState __xdata cobsState;
-  cobs_init(&cobsState);
+  pool_init();
+  transport_init(command_handle);
+  sched_handle(EVENT_UART_RX, link_task);
+  cobs_rx_init();
+  radio_init(RADIO_ADDRESS);
+  sched_handle(EVENT_RADIO_RX, radio_task);
+  mcast_init();
+  tdma_init(RADIO_ADDRESS);
+  label_init();
+  nfc_init();
 
-  uint32_t __xdata next = 0;
-  while (1) {
-    if (cobs_handle(&cobsState)) {
-      cobs_send(cobsState.packet, cobsState.packet_size);
-      LED_TOGGLE;
-    }
-
-    // if (millis() >= next) {
-    //   next += 1000;
-    //   LED_TOGGLE;
-    // }
-  }
+  sched_run();
 }
\ No newline at end of file
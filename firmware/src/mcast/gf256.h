@@ -0,0 +1,20 @@
+#ifndef _GF256_H_
+#define _GF256_H_
+
+#include "../hal/hal.h"
+#include <stdint.h>
+
+// GF(2^8) arithmetic over the polynomial 0x11D, by log and exp tables in
+// code memory. Addition is XOR. The gateway's multicast.ts uses the same
+// field.
+
+extern __code const uint8_t gf_exp[2 * 255]; // doubled, a log sum needs no modulo
+extern __code const uint8_t gf_log[256];
+
+uint8_t gf_mul(uint8_t a, uint8_t b);
+uint8_t gf_inv(uint8_t a); // a must not be 0
+
+// dst += factor * src, element wise
+void gf_mul_add(uint8_t __xdata *dst, const uint8_t __xdata *src, uint8_t factor, uint8_t length);
+
+#endif
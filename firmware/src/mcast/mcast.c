@@ -0,0 +1,377 @@
+#include "mcast.h"
+#include "gf256.h"
+#include "../command/command.h"
+#include "../display/label.h"
+#include "../hal/radio.h"
+#include "../hal/spiflash.h"
+#include "../ota/ota.h"
+#include "../sched/timer.h"
+#include <string.h>
+
+// scratch slot: generation | esi | symbol, within one flash page
+#define SLOT_SIZE 128
+#define SLOT_HEADER 2
+#define SCRATCH_SLOTS (MCAST_SCRATCH_SIZE / SLOT_SIZE)
+#define SLOTS_PER_SECTOR (SPIFLASH_SECTOR_SIZE / SLOT_SIZE)
+
+#define STAGE_CAPACITY (OTA_BACKUP_ADDRESS - OTA_STAGE_ADDRESS)
+#define MAX_SYMBOLS ((STAGE_CAPACITY + MCAST_SYMBOL_SIZE - 1) / MCAST_SYMBOL_SIZE)
+#define MAX_GENERATIONS ((MAX_SYMBOLS + MCAST_GENERATION - 1) / MCAST_GENERATION)
+
+#define CHUNK_SIZE 8 // symbol bytes rebuilt per pass over a generation
+#define DECODED 0xFF  // generation count once it is complete in the target area
+#define NOT_MISSING 0xFF
+
+#define LISTEN_TICK_MS 1000
+
+#if MCAST_GENERATION > 16 || SLOT_HEADER + MCAST_SYMBOL_SIZE > SLOT_SIZE || MCAST_SYMBOL_SIZE % CHUNK_SIZE || \
+    LABEL_TEMPLATE_SIZE > STAGE_CAPACITY
+#error "multicast symbol geometry"
+#endif
+
+McastStats __xdata mcast_stats;
+
+static Timer __xdata listen_timer;
+static uint16_t listen_left; // seconds
+
+static uint8_t state = MCAST_IDLE;
+static uint8_t session; // 0 before the first announce
+static uint8_t target;
+static uint32_t __xdata base;
+static uint16_t __xdata size;
+static uint16_t __xdata crc;
+static uint16_t __xdata symbols;
+static uint8_t generations;
+static uint8_t generations_left;
+static uint8_t scratch_used; // slots
+static uint16_t __xdata erased; // target area sectors, by bit
+
+static uint8_t __xdata received[(MAX_SYMBOLS + 7) / 8]; // source symbols in the target area
+static uint8_t __xdata counts[MAX_GENERATIONS];         // symbols held, or DECODED
+static uint8_t __xdata last_repair[MAX_GENERATIONS];    // highest repair esi stored
+
+// decoder work space: the repair matrix, inverted in place and then turned
+// into the combined coefficients row by row, and the rebuilt chunks
+static uint8_t __xdata matrix[MCAST_GENERATION * MCAST_GENERATION];
+static uint8_t __xdata rebuilt[MCAST_GENERATION * CHUNK_SIZE];
+static uint8_t __xdata chunk[CHUNK_SIZE];
+static uint8_t __xdata missing[MCAST_GENERATION];  // source esi not received
+static uint8_t __xdata position[MCAST_GENERATION]; // index into missing, or NOT_MISSING
+static uint8_t __xdata repair_slot[MCAST_GENERATION];
+static uint8_t __xdata repair_esi[MCAST_GENERATION];
+
+static uint16_t read_u16(const uint8_t __xdata *data) {
+  return data[0] | ((uint16_t)data[1] << 8);
+}
+
+static uint8_t generation_size(uint8_t generation) {
+  uint16_t left = symbols - generation * MCAST_GENERATION;
+  return left < MCAST_GENERATION ? left : MCAST_GENERATION;
+}
+
+static uint32_t symbol_address(uint16_t index) {
+  return base + (uint32_t)index * MCAST_SYMBOL_SIZE;
+}
+
+static uint32_t slot_address(uint8_t slot) {
+  return MCAST_SCRATCH_ADDRESS + (uint16_t)slot * SLOT_SIZE;
+}
+
+// sectors of the target area are erased when first written to
+static void target_write(uint32_t address, const uint8_t __xdata *data, uint8_t length) {
+  while (length) {
+    uint8_t sector = (address - base) / SPIFLASH_SECTOR_SIZE;
+    if (!(erased & BV(sector))) {
+      spiflash_erase_sector(address & ~(uint32_t)(SPIFLASH_SECTOR_SIZE - 1));
+      erased |= BV(sector);
+    }
+    uint16_t room = SPIFLASH_PAGE_SIZE - ((uint8_t)address);
+    uint8_t part = room < length ? room : length;
+    spiflash_program(address, data, part);
+    address += part;
+    data += part;
+    length -= part;
+  }
+}
+
+// the square Cauchy matrix of repairs by missing symbols: all its leading
+// minors are non zero, Gauss-Jordan without pivoting inverts it in place
+static void invert(uint8_t n) {
+  for (uint8_t k = 0; k < n; k++) {
+    uint8_t __xdata *row = matrix + k * MCAST_GENERATION;
+    uint8_t pivot = gf_inv(row[k]);
+    row[k] = 1;
+    for (uint8_t j = 0; j < n; j++) {
+      row[j] = gf_mul(row[j], pivot);
+    }
+    for (uint8_t i = 0; i < n; i++) {
+      uint8_t __xdata *other = matrix + i * MCAST_GENERATION;
+      if (i != k) {
+        uint8_t factor = other[k];
+        other[k] = 0;
+        gf_mul_add(other, row, factor, n);
+      }
+    }
+  }
+}
+
+// missing = inverse * (repairs + known part of each repair), folded into one
+// coefficient per input symbol and missing symbol. Column c of the
+// coefficients is source symbol c if it was received, else the repair taking
+// its place.
+static void decode(uint8_t generation) {
+  uint16_t first = generation * MCAST_GENERATION;
+  uint8_t k = generation_size(generation);
+  uint8_t m = 0;
+  for (uint8_t c = 0; c < k; c++) {
+    uint16_t index = first + c;
+    position[c] = NOT_MISSING;
+    if (!(received[index >> 3] & BV(index & 7))) {
+      position[c] = m;
+      missing[m++] = c;
+    }
+  }
+  if (!m) {
+    return;
+  }
+
+  // the generation's repairs, the first m stored are all there are
+  uint8_t found = 0;
+  for (uint8_t slot = 0; found < m && slot < scratch_used; slot++) {
+    spiflash_read(slot_address(slot), chunk, SLOT_HEADER);
+    if (chunk[0] == generation) {
+      repair_slot[found] = slot;
+      repair_esi[found++] = chunk[1];
+    }
+  }
+
+  for (uint8_t r = 0; r < m; r++) {
+    for (uint8_t i = 0; i < m; i++) {
+      matrix[r * MCAST_GENERATION + i] = gf_inv(repair_esi[r] ^ missing[i]);
+    }
+  }
+  invert(m);
+
+  // a row of coefficients only needs its own row of the inverse, it is
+  // built in rebuilt (free until the chunks) and copied over it
+  for (uint8_t i = 0; i < m; i++) {
+    uint8_t __xdata *row = matrix + i * MCAST_GENERATION;
+    for (uint8_t c = 0; c < k; c++) {
+      if (position[c] != NOT_MISSING) {
+        rebuilt[c] = row[position[c]];
+      } else {
+        uint8_t value = 0;
+        for (uint8_t r = 0; r < m; r++) {
+          value ^= gf_mul(row[r], gf_inv(repair_esi[r] ^ c));
+        }
+        rebuilt[c] = value;
+      }
+    }
+    memcpy(row, rebuilt, k);
+  }
+
+  for (uint8_t offset = 0; offset < MCAST_SYMBOL_SIZE; offset += CHUNK_SIZE) {
+    memset(rebuilt, 0, m * CHUNK_SIZE);
+    for (uint8_t c = 0; c < k; c++) {
+      uint32_t address = position[c] == NOT_MISSING ? symbol_address(first + c)
+                                                    : slot_address(repair_slot[position[c]]) + SLOT_HEADER;
+      spiflash_read(address + offset, chunk, CHUNK_SIZE);
+      for (uint8_t i = 0; i < m; i++) {
+        gf_mul_add(rebuilt + i * CHUNK_SIZE, chunk, matrix[i * MCAST_GENERATION + c], CHUNK_SIZE);
+      }
+    }
+    for (uint8_t i = 0; i < m; i++) {
+      target_write(symbol_address(first + missing[i]) + offset, rebuilt + i * CHUNK_SIZE, CHUNK_SIZE);
+    }
+  }
+  mcast_stats.decoded++;
+}
+
+static void finish(void) {
+  if (ota_flash_crc(base, size) != crc) {
+    state = MCAST_FAILED;
+  } else {
+    state = MCAST_DONE;
+    if (target == MCAST_TARGET_FIRMWARE) {
+      ota_stage_done(size, crc);
+    }
+  }
+  spiflash_sleep();
+  mcast_listen(0);
+}
+
+static void announce(const uint8_t __xdata *packet) {
+  uint8_t id = packet[1];
+  uint16_t length = read_u16(packet + 3);
+  uint16_t count = length / MCAST_SYMBOL_SIZE + (length % MCAST_SYMBOL_SIZE != 0);
+  if (!id || id == session || !length) {
+    return;
+  }
+  if (packet[2] == MCAST_TARGET_FIRMWARE) {
+    if (length > OTA_APP_SIZE || (uint32_t)count * MCAST_SYMBOL_SIZE > STAGE_CAPACITY || !ota_stage_claim()) {
+      return;
+    }
+    base = OTA_STAGE_ADDRESS;
+  } else if ((uint8_t)(packet[2] - MCAST_TARGET_TEMPLATE) < LABEL_TEMPLATES) {
+    if ((uint32_t)count * MCAST_SYMBOL_SIZE > LABEL_TEMPLATE_SIZE) {
+      return;
+    }
+    base = LABEL_TEMPLATE_ADDRESS(packet[2] - MCAST_TARGET_TEMPLATE);
+  } else {
+    return;
+  }
+
+  session = id;
+  target = packet[2];
+  size = length;
+  crc = read_u16(packet + 5);
+  symbols = count;
+  generations = (count + MCAST_GENERATION - 1) / MCAST_GENERATION;
+  generations_left = generations;
+  scratch_used = 0;
+  erased = 0;
+  memset(received, 0, sizeof(received));
+  memset(counts, 0, sizeof(counts));
+  memset(last_repair, 0, sizeof(last_repair));
+  state = MCAST_RECEIVING;
+}
+
+// false when the symbol adds nothing
+static bool store(const uint8_t __xdata *packet) {
+  uint8_t generation = packet[2];
+  uint8_t esi = packet[3];
+  if (generation >= generations || counts[generation] == DECODED) {
+    return false;
+  }
+
+  if (esi < generation_size(generation)) {
+    uint16_t index = generation * MCAST_GENERATION + esi;
+    if (received[index >> 3] & BV(index & 7)) {
+      return false;
+    }
+    target_write(symbol_address(index), packet + MCAST_SYMBOL_HEADER, MCAST_SYMBOL_SIZE);
+    received[index >> 3] |= BV(index & 7);
+  } else {
+    // increasing esi keeps a generation's repairs distinct without a lookup
+    if (esi < MCAST_GENERATION || esi <= last_repair[generation]) {
+      return false;
+    }
+    if (scratch_used == SCRATCH_SLOTS) {
+      state = MCAST_STALLED;
+      spiflash_sleep();
+      mcast_listen(0);
+      return false;
+    }
+    uint32_t address = slot_address(scratch_used);
+    if (!(scratch_used % SLOTS_PER_SECTOR)) {
+      spiflash_erase_sector(address);
+    }
+    // generation and esi already sit in front of the symbol
+    spiflash_program(address, packet + 2, SLOT_HEADER + MCAST_SYMBOL_SIZE);
+    scratch_used++;
+    last_repair[generation] = esi;
+    mcast_stats.repairs++;
+  }
+
+  if (++counts[generation] == generation_size(generation)) {
+    decode(generation);
+    counts[generation] = DECODED;
+    if (!--generations_left) {
+      finish();
+    }
+  }
+  return true;
+}
+
+void mcast_receive(const uint8_t __xdata *packet, uint8_t length) {
+  if (packet[0] == MCAST_ANNOUNCE && length == MCAST_ANNOUNCE_SIZE) {
+    announce(packet);
+  } else if (packet[0] == MCAST_SYMBOL && length == MCAST_SYMBOL_HEADER + MCAST_SYMBOL_SIZE) {
+    if (state != MCAST_RECEIVING || packet[1] != session) {
+      return;
+    }
+    if (store(packet)) {
+      mcast_stats.symbols++;
+    } else {
+      mcast_stats.dropped++;
+    }
+  } else {
+    return;
+  }
+  if (state == MCAST_RECEIVING && listen_left < MCAST_IDLE_S) {
+    listen_left = MCAST_IDLE_S;
+  }
+}
+
+static void listen_tick(void) {
+  if (!--listen_left) {
+    radio_listen(RADIO_LISTEN_MCAST, false);
+    spiflash_sleep();
+  } else {
+    timer_start(&listen_timer, LISTEN_TICK_MS, listen_tick);
+  }
+}
+
+void mcast_listen(uint16_t seconds) {
+  listen_left = seconds;
+  if (seconds) {
+    timer_start(&listen_timer, LISTEN_TICK_MS, listen_tick);
+    radio_listen(RADIO_LISTEN_MCAST, true);
+  } else {
+    timer_stop(&listen_timer);
+    radio_listen(RADIO_LISTEN_MCAST, false);
+  }
+}
+
+void mcast_init(void) {
+  memset(&mcast_stats, 0, sizeof(mcast_stats));
+}
+
+// args: seconds to listen for multicast packets (16 bit), 0 stops
+uint8_t cmd_mcast_listen(void) {
+  const uint8_t __xdata *args = command_call.args;
+  mcast_listen(read_u16(args));
+  return STATUS_OK;
+}
+
+// reply: state, session, symbols still needed (16 bit), most needed by one
+// generation, McastStats, then a bitmap of the generations not complete
+uint8_t cmd_mcast_status(void) {
+  uint8_t __xdata *reply = command_call.reply;
+  uint8_t __xdata *pending = reply + 5 + sizeof(mcast_stats);
+  uint16_t needed = 0;
+  uint8_t worst = 0;
+  memset(pending, 0, (generations + 7) / 8);
+  if (state == MCAST_RECEIVING) {
+    for (uint8_t g = 0; g < generations; g++) {
+      if (counts[g] != DECODED) {
+        uint8_t short_of = generation_size(g) - counts[g];
+        needed += short_of;
+        if (short_of > worst) {
+          worst = short_of;
+        }
+        pending[g >> 3] |= BV(g & 7);
+      }
+    }
+  }
+  reply[0] = state;
+  reply[1] = session;
+  reply[2] = needed;
+  reply[3] = needed >> 8;
+  reply[4] = worst;
+  memcpy(reply + 5, &mcast_stats, sizeof(mcast_stats));
+  command_call.reply_length = pending - reply + (generations + 7) / 8;
+  return STATUS_OK;
+}
+
+// args: address, payload. Makes this tag the gateway's radio, for
+// multicast packets and anything else.
+uint8_t cmd_radio_send(void) {
+  const uint8_t __xdata *args = command_call.args;
+  uint8_t length = command_call.length;
+  if (length - 1 > RADIO_MAX_PAYLOAD) {
+    return STATUS_BAD_LENGTH;
+  }
+  // without a free pool block the gateway tries again
+  return radio_send(args[0], args + 1, length - 1) ? STATUS_OK : STATUS_BUSY;
+}
@@ -0,0 +1,77 @@
+#ifndef _MCAST_H_
+#define _MCAST_H_
+
+#include "../hal/hal.h"
+#include <stdint.h>
+
+// Multicast transfer of a blob into the SPI flash, for any number of tags at
+// once. The gateway broadcasts through a bridge tag (COMMAND_RADIO_SEND)
+//   MCAST_ANNOUNCE | session | target | size (16 bit) | crc16 (16 bit)
+//   MCAST_SYMBOL | session | generation | esi | symbol...
+// The blob is cut in MCAST_SYMBOL_SIZE symbols, the last one zero padded,
+// and those are grouped in generations of MCAST_GENERATION (k, the last
+// generation may be shorter). Symbol esi < k of a generation is source
+// symbol esi, esi e >= MCAST_GENERATION is the repair symbol
+//   sum over j < k of source_j / (e ^ j)
+// in GF(256): a systematic Cauchy Reed-Solomon code, any k distinct symbols
+// of a generation rebuild it. Repair symbols of a generation are sent with
+// increasing esi, a tag keeps the ones it needs in the scratch area.
+//
+// Tags pick up an announce for a new session any time and ignore repeats,
+// the gateway sends it again between symbols so late listeners can join.
+// Source symbols go straight to their place in the target area, a
+// generation short of some is decoded from the flash in CHUNK sized passes,
+// so RAM use stays independent of the blob size. The finished blob is
+// checked against the announced CRC16. A tag losing more than the scratch
+// area holds stops and waits for a unicast transfer instead. A firmware blob
+// is then staged like one sent with OTA_WRITE, OTA_FINISH and REBOOT install
+// it.
+//
+// Tags only receive while told to listen (COMMAND_MCAST_LISTEN), every
+// multicast packet extends that to at least MCAST_IDLE_S.
+
+#define MCAST_ANNOUNCE 0xA0
+#define MCAST_SYMBOL 0xA1
+
+#define MCAST_ANNOUNCE_SIZE 7
+#define MCAST_SYMBOL_HEADER 4
+#define MCAST_SYMBOL_SIZE 112
+#define MCAST_GENERATION 16 // source symbols per generation, at most 16
+
+enum {
+  MCAST_TARGET_FIRMWARE, // the OTA staging area
+  MCAST_TARGET_TEMPLATE, // label template n is MCAST_TARGET_TEMPLATE + n
+};
+
+enum {
+  MCAST_IDLE,
+  MCAST_RECEIVING,
+  MCAST_DONE,
+  MCAST_FAILED,  // complete but the CRC did not match
+  MCAST_STALLED, // out of scratch space, the blob needs a unicast transfer
+};
+
+// external flash, next to the areas in ota/image.h
+#define MCAST_SCRATCH_ADDRESS 0x1F000UL
+#define MCAST_SCRATCH_SIZE 0x1000
+
+#ifndef MCAST_IDLE_S
+#define MCAST_IDLE_S 30
+#endif
+
+typedef struct {
+  uint16_t symbols; // accepted, source and repair
+  uint16_t repairs; // stored in the scratch area
+  uint16_t dropped; // not needed, out of order or no scratch left
+  uint16_t decoded; // generations rebuilt from repair symbols
+} McastStats;
+
+extern McastStats __xdata mcast_stats;
+
+void mcast_init(void);
+// a received MCAST_ANNOUNCE or MCAST_SYMBOL packet
+void mcast_receive(const uint8_t __xdata *packet, uint8_t length);
+// receive multicast packets for this long, 0 stops
+void mcast_listen(uint16_t seconds);
+
+#endif
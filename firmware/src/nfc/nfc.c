@@ -0,0 +1,174 @@
+#include "nfc.h"
+#include "../command/command.h"
+#include "../hal/i2c.h"
+#include "../hal/pm.h"
+#include "../hal/uart.h"
+#include "../pool/pool.h"
+#include "../sched/sched.h"
+#include "../sched/timer.h"
+#include "../transport/transport.h"
+
+#define NC_SESSION_MASK                                                                            \
+  (NT3H_NC_PTHRU_ON | NT3H_NC_PTHRU_DIR_RF | NT3H_NC_FD_ON_MASK | NT3H_NC_FD_OFF_MASK)
+
+NfcStats __xdata nfc_stats;
+
+static Timer __xdata poll_timer;
+static bool active = false;
+
+static uint8_t __xdata sram[NT3H_SRAM_SIZE];
+static PoolBlock __xdata *rx_frame; // request being reassembled
+static PoolBlock __xdata *tx_frame; // reply being handed out, holds the SRAM
+static uint8_t tx_offset;
+
+// the direction may only change with the pass-through off, FD then signals
+// SRAM data for whichever side has to read it
+static bool nfc_direction(bool from_rf) {
+  uint8_t config = NT3H_NC_FD_ON_PTHRU | NT3H_NC_FD_OFF_PTHRU | (from_rf ? NT3H_NC_PTHRU_DIR_RF : 0);
+  return nt3h_write_register(NT3H_REG_NC, NC_SESSION_MASK, config) &&
+         nt3h_write_register(NT3H_REG_NC, NT3H_NC_PTHRU_ON, NT3H_NC_PTHRU_ON);
+}
+
+static void nfc_drop(PoolBlock __xdata *__xdata *frame) {
+  if (*frame) {
+    pool_free(*frame);
+    *frame = NULL;
+  }
+}
+
+static void nfc_start(void) {
+  active = true;
+  nfc_stats.sessions++;
+  pm_hold(PM_HOLD_NFC);
+  uart_release_tx();
+  i2c_init();
+  if (!nfc_direction(true)) {
+    nfc_stats.errors++;
+  }
+}
+
+static void nfc_stop(void) {
+  // back to FD following the field, for the next tap
+  nt3h_write_register(NT3H_REG_NC, NC_SESSION_MASK, 0);
+  nfc_drop(&rx_frame);
+  nfc_drop(&tx_frame);
+  timer_stop(&poll_timer);
+  uart_claim_tx();
+  pm_release(PM_HOLD_NFC);
+  active = false;
+}
+
+static void nfc_execute(void) {
+  tx_frame = pool_alloc();
+  if (!tx_frame) {
+    // the phone times out and asks again
+    nfc_stats.errors++;
+  } else {
+    tx_frame->length = command_execute(rx_frame->data, rx_frame->length, tx_frame->data);
+    tx_offset = 0;
+    nfc_stats.frames++;
+    if (!nfc_direction(false)) {
+      nfc_stats.errors++;
+      nfc_drop(&tx_frame);
+    }
+  }
+  nfc_drop(&rx_frame);
+}
+
+static void nfc_receive_fragment(void) {
+  if (!nt3h_read_sram(sram)) {
+    nfc_stats.errors++;
+    return;
+  }
+  uint8_t flags = sram[0];
+  uint8_t length = sram[1];
+  if (flags & NFC_FLAG_FIRST) {
+    if (!rx_frame) {
+      rx_frame = pool_alloc();
+    }
+    if (!rx_frame) {
+      nfc_stats.errors++;
+      return;
+    }
+    rx_frame->length = 0;
+  } else if (!rx_frame) {
+    // the start of this frame was lost
+    nfc_stats.errors++;
+    return;
+  }
+
+  if (length > NFC_FRAGMENT_DATA || rx_frame->length + length > TRANSPORT_MAX_PAYLOAD) {
+    nfc_stats.errors++;
+    nfc_drop(&rx_frame);
+    return;
+  }
+  memcpy(rx_frame->data + rx_frame->length, sram + NFC_FRAGMENT_HEADER, length);
+  rx_frame->length += length;
+
+  if (flags & NFC_FLAG_LAST) {
+    nfc_execute();
+  }
+}
+
+// called once the phone took the previous fragment out of the SRAM
+static void nfc_send_fragment(void) {
+  uint8_t length = tx_frame->length - tx_offset;
+  if (!length) {
+    // all of it was read, listen again
+    nfc_drop(&tx_frame);
+    if (!nfc_direction(true)) {
+      nfc_stats.errors++;
+    }
+    return;
+  }
+  if (length > NFC_FRAGMENT_DATA) {
+    length = NFC_FRAGMENT_DATA;
+  }
+  sram[0] = (tx_offset ? 0 : NFC_FLAG_FIRST) | (tx_offset + length == tx_frame->length ? NFC_FLAG_LAST : 0);
+  sram[1] = length;
+  memcpy(sram + NFC_FRAGMENT_HEADER, tx_frame->data + tx_offset, length);
+  if (nt3h_write_sram(sram)) {
+    tx_offset += length;
+  } else {
+    nfc_stats.errors++;
+  }
+}
+
+static void nfc_task(void) {
+  static uint8_t __xdata status;
+
+  if (!active) {
+    if (P1_1) {
+      // field gone again before we got here
+      return;
+    }
+    nfc_start();
+  }
+
+  if (!nt3h_read_register(NT3H_REG_NS, &status) || !(status & NT3H_NS_RF_FIELD_PRESENT)) {
+    nfc_stop();
+    return;
+  }
+  if (tx_frame) {
+    if (!(status & NT3H_NS_SRAM_RF_READY)) {
+      nfc_send_fragment();
+    }
+  } else if (status & NT3H_NS_SRAM_I2C_READY) {
+    nfc_receive_fragment();
+  }
+
+  // FD falls when the SRAM changes hands, polling covers missed edges and
+  // the field going away
+  timer_start(&poll_timer, NFC_POLL_MS, nfc_task);
+}
+
+void nfc_init(void) {
+  nfc_stats.sessions = 0;
+  nfc_stats.frames = 0;
+  nfc_stats.errors = 0;
+  sched_handle(EVENT_NFC_FIELD, nfc_task);
+  if (!P1_1) {
+    // tapped while booting
+    sched_post(EVENT_NFC_FIELD);
+  }
+}
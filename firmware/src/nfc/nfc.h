@@ -0,0 +1,36 @@
+#ifndef _NFC_H_
+#define _NFC_H_
+
+#include "../hal/hal.h"
+#include "nt3h.h"
+#include <stdint.h>
+
+// Command frames from a phone through the NT3H2111 SRAM pass-through. Field
+// detect posts EVENT_NFC_FIELD, the session lasts while the field is
+// present. Every 64 byte SRAM page carries one fragment
+//   flags | length | data...
+// and a complete frame is the same command request as on the host
+// link, its reply goes back the same way. The UART TX pin is lent to the
+// I2C bus for the session.
+
+#define NFC_FRAGMENT_HEADER 2
+#define NFC_FRAGMENT_DATA (NT3H_SRAM_SIZE - NFC_FRAGMENT_HEADER)
+
+#define NFC_FLAG_FIRST BV(0)
+#define NFC_FLAG_LAST BV(1)
+
+#ifndef NFC_POLL_MS
+#define NFC_POLL_MS 5 // status checks while a field is present
+#endif
+
+typedef struct {
+  uint16_t sessions;
+  uint16_t frames;
+  uint16_t errors; // I2C failures and malformed or unhandled fragments
+} NfcStats;
+
+extern NfcStats __xdata nfc_stats;
+
+void nfc_init(void);
+
+#endif
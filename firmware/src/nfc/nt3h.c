@@ -0,0 +1,50 @@
+#include "nt3h.h"
+#include "../hal/i2c.h"
+
+static uint8_t __xdata command[4];
+
+bool nt3h_read_block(uint8_t block, uint8_t __xdata *data) {
+  command[0] = block;
+  return i2c_write(NT3H_ADDRESS, command, 1) && i2c_read(NT3H_ADDRESS, data, NT3H_BLOCK_SIZE);
+}
+
+bool nt3h_write_block(uint8_t block, const uint8_t __xdata *data) {
+  static uint8_t __xdata buffer[1 + NT3H_BLOCK_SIZE];
+  buffer[0] = block;
+  for (uint8_t i = 0; i < NT3H_BLOCK_SIZE; i++) {
+    buffer[1 + i] = data[i];
+  }
+  return i2c_write(NT3H_ADDRESS, buffer, sizeof(buffer));
+}
+
+bool nt3h_read_register(uint8_t reg, uint8_t __xdata *value) {
+  command[0] = NT3H_SESSION_BLOCK;
+  command[1] = reg;
+  return i2c_write(NT3H_ADDRESS, command, 2) && i2c_read(NT3H_ADDRESS, value, 1);
+}
+
+bool nt3h_write_register(uint8_t reg, uint8_t mask, uint8_t value) {
+  command[0] = NT3H_SESSION_BLOCK;
+  command[1] = reg;
+  command[2] = mask;
+  command[3] = value;
+  return i2c_write(NT3H_ADDRESS, command, 4);
+}
+
+bool nt3h_read_sram(uint8_t __xdata *data) {
+  for (uint8_t i = 0; i < NT3H_SRAM_SIZE / NT3H_BLOCK_SIZE; i++) {
+    if (!nt3h_read_block(NT3H_SRAM_BLOCK + i, data + i * NT3H_BLOCK_SIZE)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool nt3h_write_sram(const uint8_t __xdata *data) {
+  for (uint8_t i = 0; i < NT3H_SRAM_SIZE / NT3H_BLOCK_SIZE; i++) {
+    if (!nt3h_write_block(NT3H_SRAM_BLOCK + i, data + i * NT3H_BLOCK_SIZE)) {
+      return false;
+    }
+  }
+  return true;
+}
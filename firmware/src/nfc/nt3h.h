@@ -0,0 +1,41 @@
+#ifndef _NT3H_H_
+#define _NT3H_H_
+
+#include "../hal/hal.h"
+#include <stdint.h>
+
+// NT3H2111 over I2C. Memory is accessed in 16 byte blocks, the session
+// registers one byte at a time.
+
+#define NT3H_ADDRESS 0x55
+#define NT3H_BLOCK_SIZE 16
+#define NT3H_SRAM_BLOCK 0xF8
+#define NT3H_SRAM_SIZE 64
+#define NT3H_SESSION_BLOCK 0xFE
+
+#define NT3H_REG_NC 0
+#define NT3H_REG_NS 6
+
+// NC_REG
+#define NT3H_NC_PTHRU_DIR_RF BV(0) // pass-through from RF to I2C, clear for I2C to RF
+#define NT3H_NC_FD_ON_MASK 0x0C
+#define NT3H_NC_FD_ON_PTHRU 0x0C   // FD low when the SRAM has data for the other side
+#define NT3H_NC_FD_OFF_MASK 0x30
+#define NT3H_NC_FD_OFF_PTHRU 0x30  // FD released once it was taken
+#define NT3H_NC_PTHRU_ON BV(6)
+
+// NS_REG
+#define NT3H_NS_RF_FIELD_PRESENT BV(0)
+#define NT3H_NS_SRAM_RF_READY BV(3)  // I2C wrote the SRAM, RF did not read it yet
+#define NT3H_NS_SRAM_I2C_READY BV(4) // RF wrote the SRAM, I2C did not read it yet
+
+bool nt3h_read_block(uint8_t block, uint8_t __xdata *data);
+bool nt3h_write_block(uint8_t block, const uint8_t __xdata *data);
+bool nt3h_read_register(uint8_t reg, uint8_t __xdata *value);
+bool nt3h_write_register(uint8_t reg, uint8_t mask, uint8_t value);
+
+// the whole 64 byte SRAM, finishing it hands the SRAM to the RF side
+bool nt3h_read_sram(uint8_t __xdata *data);
+bool nt3h_write_sram(const uint8_t __xdata *data);
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef _OTA_IMAGE_H_
+#define _OTA_IMAGE_H_
+
+#include "../hal/hal.h"
+#include <stdint.h>
+
+// Shared between the application and the bootloader in firmware/boot.
+//
+// Internal flash:
+//   0x0000 - 0x07FF  bootloader, forwards the interrupt vectors
+//   0x0800 - 0x7BFF  application
+//   0x7C00 - 0x7FFF  left alone, holds the lock bits
+// External flash:
+//   0x00000 - 0x07FFF  staged image
+//   0x08000 - 0x0FFFF  backup of the image it replaced
+//   0x10000 - 0x10FFF  state records, first sector
+//   0x11000 - 0x12FFF  link epoch records, see crypto/link.h
+//   0x13000 - 0x1BFFF  label templates, see display/label.h
+//   0x1C000 - 0x1DFFF  key/value records, see kv/kv.h
+//   0x1E000 - 0x1EFFF  state records, second sector
+//   0x1F000 - 0x1FFFF  multicast repair symbols
+
+#define OTA_APP_START 0x0800
+#define OTA_APP_SIZE 0x7400
+#define OTA_PAGE_SIZE 1024 // internal flash page
+
+#define OTA_STAGE_ADDRESS 0x00000UL
+#define OTA_BACKUP_ADDRESS 0x08000UL
+#define OTA_META_ADDRESS 0x10000UL
+#define OTA_META_ADDRESS_2 0x1E000UL
+
+enum {
+  OTA_IDLE,       // running image is confirmed
+  OTA_PENDING,    // staged image verified, install on next boot
+  OTA_INSTALLING, // backup done, programming the staged image
+  OTA_TRIAL,      // new image booted, waiting for confirmation
+  OTA_REVERTING,  // programming the backup
+};
+
+#define OTA_FLAG_ROLLED_BACK BV(0) // the last update was reverted
+
+// a new image gets this many boots to be confirmed
+#define OTA_MAX_ATTEMPTS 3
+
+// State records are appended to one of two sectors, the last valid one of
+// the sector with the higher generation wins. Once that sector is full the
+// other one is erased and continued with the next generation, so a reset
+// during the erase still leaves the previous record. Records are 16 bytes so
+// none crosses a flash page.
+#define OTA_META_MAGIC 0xA5
+
+typedef struct {
+  uint8_t magic;
+  uint8_t state;
+  uint8_t attempts; // boots in OTA_TRIAL
+  uint8_t flags;
+  uint16_t image_size;
+  uint16_t image_crc;
+  uint16_t backup_size;
+  uint16_t backup_crc;
+  uint16_t generation; // of the sector holding the record, set by ota_meta_write
+  uint16_t crc; // CRC16 of the fields above
+} OtaMeta;
+
+// false without a valid record, meta is then reset to OTA_IDLE
+bool ota_meta_read(OtaMeta __xdata *meta);
+void ota_meta_write(OtaMeta __xdata *meta);
+
+// CRC16 of length bytes of external flash
+uint16_t ota_flash_crc(uint32_t address, uint16_t length);
+
+#endif
@@ -0,0 +1,102 @@
+#include "image.h"
+#include "../hal/crc.h"
+#include "../hal/spiflash.h"
+#include <string.h>
+
+#define META_RECORDS (SPIFLASH_SECTOR_SIZE / sizeof(OtaMeta))
+
+static uint16_t meta_crc(const OtaMeta __xdata *meta) {
+  const uint8_t __xdata *data = (const uint8_t __xdata *)meta;
+  CRC16_INIT(0);
+  for (uint8_t i = 0; i < sizeof(OtaMeta) - sizeof(uint16_t); i++) {
+    CRC16_UPDATE(data[i]);
+  }
+  return CRC16_VALUE();
+}
+
+#define META_SECTOR(sector) ((sector) ? OTA_META_ADDRESS_2 : OTA_META_ADDRESS)
+#define META_NONE 0xFF
+
+// index of the first free record of a sector, META_RECORDS when full
+static uint16_t meta_free_slot(uint8_t sector) {
+  uint16_t slot = 0;
+  for (; slot < META_RECORDS; slot++) {
+    spiflash_read_begin(META_SECTOR(sector) + slot * sizeof(OtaMeta));
+    uint8_t magic = spiflash_read_byte();
+    spiflash_read_end();
+    if (magic == 0xFF) {
+      break;
+    }
+  }
+  return slot;
+}
+
+// the last valid record of a sector into meta, false when it has none
+static bool meta_last(uint8_t sector, OtaMeta __xdata *meta) {
+  uint16_t slot = meta_free_slot(sector);
+  // an interrupted write leaves a broken last record, fall back to the one before
+  while (slot--) {
+    spiflash_read(META_SECTOR(sector) + slot * sizeof(OtaMeta), (uint8_t __xdata *)meta, sizeof(OtaMeta));
+    if (meta->magic == OTA_META_MAGIC && meta->crc == meta_crc(meta)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// the sector with the newest record, that record into meta. META_NONE when
+// neither sector has one.
+static uint8_t meta_newest(OtaMeta __xdata *meta) {
+  bool first = meta_last(0, meta);
+  uint16_t generation = meta->generation;
+  if (meta_last(1, meta) && (!first || (int16_t)(meta->generation - generation) > 0)) {
+    return 1;
+  }
+  if (!first) {
+    return META_NONE;
+  }
+  meta_last(0, meta);
+  return 0;
+}
+
+bool ota_meta_read(OtaMeta __xdata *meta) {
+  if (meta_newest(meta) != META_NONE) {
+    return true;
+  }
+  memset(meta, 0, sizeof(OtaMeta));
+  meta->state = OTA_IDLE;
+  return false;
+}
+
+void ota_meta_write(OtaMeta __xdata *meta) {
+  static OtaMeta __xdata newest;
+  uint8_t sector = meta_newest(&newest);
+  uint16_t generation = newest.generation;
+  if (sector == META_NONE) {
+    sector = 0;
+    generation = 0;
+  }
+  uint16_t slot = meta_free_slot(sector);
+  if (slot == META_RECORDS) {
+    // the full sector keeps the newest record until the other one has its successor
+    sector = !sector;
+    spiflash_erase_sector(META_SECTOR(sector));
+    generation++;
+    slot = 0;
+  }
+  meta->magic = OTA_META_MAGIC;
+  meta->generation = generation;
+  meta->crc = meta_crc(meta);
+  // records are 16 bytes, never crossing a page
+  spiflash_program(META_SECTOR(sector) + slot * sizeof(OtaMeta), (const uint8_t __xdata *)meta, sizeof(OtaMeta));
+}
+
+uint16_t ota_flash_crc(uint32_t address, uint16_t length) {
+  spiflash_read_begin(address);
+  CRC16_INIT(0);
+  while (length--) {
+    CRC16_UPDATE(spiflash_read_byte());
+  }
+  spiflash_read_end();
+  return CRC16_VALUE();
+}
@@ -0,0 +1,159 @@
+#include "ota.h"
+#include "../command/command.h"
+#include "../hal/spiflash.h"
+#include "../sched/timer.h"
+#include <string.h>
+
+#define STAGE_SECTORS (OTA_APP_SIZE / SPIFLASH_SECTOR_SIZE + 1)
+
+#define WDT_EN BV(3)
+#define WDT_FEED_MS 500 // the bootloader sets a 1s interval
+
+static OtaMeta __xdata meta;
+static bool receiving = false;
+static uint16_t image_size;
+static uint16_t image_crc;
+static uint8_t erased[(STAGE_SECTORS + 7) / 8]; // sectors of the staging area erased so far
+
+static Timer __xdata wdt_timer;
+
+static void ota_feed_watchdog(void) {
+  WDCTL = (WDCTL & 0x0F) | 0xA0;
+  WDCTL = (WDCTL & 0x0F) | 0x50;
+  timer_start(&wdt_timer, WDT_FEED_MS, ota_feed_watchdog);
+}
+
+void ota_init(void) {
+  spiflash_init();
+  ota_meta_read(&meta);
+  spiflash_sleep();
+
+  if (WDCTL & WDT_EN) {
+    // on trial, once enabled the watchdog can not be stopped again
+    ota_feed_watchdog();
+  }
+}
+
+bool ota_stage_claim(void) {
+  if (meta.state == OTA_TRIAL) {
+    // confirm the running image first, it becomes the next backup
+    return false;
+  }
+  if (meta.state == OTA_PENDING) {
+    // replacing a staged image that was not installed yet
+    meta.state = OTA_IDLE;
+    ota_meta_write(&meta);
+  }
+  receiving = false;
+  return true;
+}
+
+void ota_stage_done(uint16_t size, uint16_t crc) {
+  image_size = size;
+  image_crc = crc;
+  receiving = true;
+}
+
+static uint16_t read_u16(const uint8_t __xdata *data) {
+  return data[0] | ((uint16_t)data[1] << 8);
+}
+
+// args: image size, image CRC16 (16 bit each)
+uint8_t cmd_ota_begin(void) {
+  const uint8_t __xdata *args = command_call.args;
+  uint16_t size = read_u16(args);
+  if (!size || size > OTA_APP_SIZE) {
+    return STATUS_BAD_ARGUMENT;
+  }
+  if (!ota_stage_claim()) {
+    return STATUS_BUSY;
+  }
+  image_size = size;
+  image_crc = read_u16(args + 2);
+  memset(erased, 0, sizeof(erased));
+  receiving = true;
+  return STATUS_OK;
+}
+
+// args: offset (16 bit), data. Sectors are erased when first written to.
+uint8_t cmd_ota_write(void) {
+  const uint8_t __xdata *args = command_call.args;
+  uint8_t length = command_call.length;
+  if (!receiving) {
+    return STATUS_FAILED;
+  }
+  uint16_t offset = read_u16(args);
+  const uint8_t __xdata *data = args + 2;
+  length -= 2;
+  if ((uint32_t)offset + length > image_size) {
+    return STATUS_BAD_ARGUMENT;
+  }
+
+  while (length) {
+    uint32_t address = OTA_STAGE_ADDRESS + offset;
+    uint8_t sector = offset / SPIFLASH_SECTOR_SIZE;
+    if (!(erased[sector >> 3] & BV(sector & 7))) {
+      spiflash_erase_sector(address & ~(uint32_t)(SPIFLASH_SECTOR_SIZE - 1));
+      erased[sector >> 3] |= BV(sector & 7);
+    }
+    // up to the end of the flash page
+    uint16_t chunk = SPIFLASH_PAGE_SIZE - (offset & (SPIFLASH_PAGE_SIZE - 1));
+    if (chunk > length) {
+      chunk = length;
+    }
+    spiflash_program(address, data, chunk);
+    offset += chunk;
+    data += chunk;
+    length -= chunk;
+  }
+  return STATUS_OK;
+}
+
+// reply: CRC16 of the staged image
+uint8_t cmd_ota_finish(void) {
+  uint8_t __xdata *reply = command_call.reply;
+  if (!receiving) {
+    return STATUS_FAILED;
+  }
+  receiving = false;
+  uint16_t crc = ota_flash_crc(OTA_STAGE_ADDRESS, image_size);
+  reply[0] = crc;
+  reply[1] = crc >> 8;
+  command_call.reply_length = 2;
+  if (crc != image_crc) {
+    spiflash_sleep();
+    return STATUS_FAILED;
+  }
+
+  meta.state = OTA_PENDING;
+  meta.image_size = image_size;
+  meta.image_crc = image_crc;
+  ota_meta_write(&meta);
+  spiflash_sleep();
+  return STATUS_OK;
+}
+
+uint8_t cmd_ota_confirm(void) {
+  if (meta.state == OTA_TRIAL) {
+    meta.state = OTA_IDLE;
+    meta.attempts = 0;
+    meta.flags = 0;
+    ota_meta_write(&meta);
+    spiflash_sleep();
+  }
+  return STATUS_OK;
+}
+
+// reply: state, attempts, flags, image size, image CRC16 (16 bit each)
+uint8_t cmd_ota_status(void) {
+  uint8_t __xdata *reply = command_call.reply;
+  reply[0] = meta.state;
+  reply[1] = meta.attempts;
+  reply[2] = meta.flags;
+  reply[3] = meta.image_size;
+  reply[4] = meta.image_size >> 8;
+  reply[5] = meta.image_crc;
+  reply[6] = meta.image_crc >> 8;
+  command_call.reply_length = 7;
+  return STATUS_OK;
+}
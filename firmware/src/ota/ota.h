@@ -0,0 +1,19 @@
+#ifndef _OTA_H_
+#define _OTA_H_
+
+#include "image.h"
+
+// Firmware update over the host link: COMMAND_OTA_BEGIN, then OTA_WRITE
+// chunks in any order, OTA_FINISH verifies the staged image and marks it
+// for the bootloader, REBOOT installs it. The new image runs on trial until
+// OTA_CONFIRM, the bootloader reverts to the backup after OTA_MAX_ATTEMPTS
+// unconfirmed boots. The watchdog it enables for those boots is serviced here.
+void ota_init(void);
+
+// for writers of the staging area other than OTA_WRITE (mcast): claim
+// refuses while the running image is on trial, done hands a complete image to
+// OTA_FINISH for verification
+bool ota_stage_claim(void);
+void ota_stage_done(uint16_t size, uint16_t crc);
+
+#endif
@@ -0,0 +1,80 @@
+#include "pool.h"
+
+PoolStats __xdata pool_stats;
+
+static PoolBlock __xdata blocks[POOL_BLOCKS];
+static PoolBlock __xdata *free_list;
+
+void pool_init(void) {
+  free_list = NULL;
+  for (uint8_t i = 0; i < POOL_BLOCKS; i++) {
+    blocks[i].next = free_list;
+    free_list = &blocks[i];
+  }
+  pool_stats.in_use = 0;
+  pool_stats.high_water = 0;
+  pool_stats.alloc_failures = 0;
+}
+
+void pool_queue_init(PoolQueue __xdata *queue) {
+  queue->head = NULL;
+  queue->tail = NULL;
+}
+
+// reentrant, see pool.h
+PoolBlock __xdata *pool_alloc(void) __reentrant {
+  PoolBlock __xdata *block;
+  HAL_CRITICAL_STATEMENT({
+    block = free_list;
+    if (block) {
+      free_list = block->next;
+      block->next = NULL;
+      block->length = 0;
+      if (++pool_stats.in_use > pool_stats.high_water) {
+        pool_stats.high_water = pool_stats.in_use;
+      }
+    } else {
+      pool_stats.alloc_failures++;
+    }
+  });
+  return block;
+}
+
+void pool_free(PoolBlock __xdata *block) __reentrant {
+  HAL_CRITICAL_STATEMENT({
+    block->next = free_list;
+    free_list = block;
+    pool_stats.in_use--;
+  });
+}
+
+void pool_queue_push(PoolQueue __xdata *queue, PoolBlock __xdata *block) __reentrant {
+  block->next = NULL;
+  HAL_CRITICAL_STATEMENT({
+    if (queue->tail) {
+      queue->tail->next = block;
+    } else {
+      queue->head = block;
+    }
+    queue->tail = block;
+  });
+}
+
+PoolBlock __xdata *pool_queue_pop(PoolQueue __xdata *queue) __reentrant {
+  PoolBlock __xdata *block;
+  HAL_CRITICAL_STATEMENT({
+    block = queue->head;
+    if (block) {
+      queue->head = block->next;
+      if (!queue->head) {
+        queue->tail = NULL;
+      }
+      block->next = NULL;
+    }
+  });
+  return block;
+}
+
+bool pool_queue_empty(PoolQueue __xdata *queue) __reentrant {
+  return !queue->head;
+}
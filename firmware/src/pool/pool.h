@@ -0,0 +1,66 @@
+#ifndef _POOL_H_
+#define _POOL_H_
+
+#include "../hal/hal.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Fixed size packet buffers in XDATA, shared between interrupts and the main
+// loop. A block has a single owner at a time: the pool, a queue or whoever
+// took it out of one.
+
+#ifndef POOL_BLOCKS
+#define POOL_BLOCKS 6
+#endif
+
+// a full transport frame: header, 120 bytes payload and CRC, with LINK_KEY
+// the counter and MIC instead of the CRC. Four more for the status bytes the
+// radio appends and its arrival time.
+#ifdef LINK_KEY
+#define POOL_BLOCK_SIZE 136
+#else
+#define POOL_BLOCK_SIZE 130
+#endif
+
+// room in front of data for the header of a radio packet
+#define POOL_HEADER_SIZE 2
+
+typedef struct PoolBlock {
+  struct PoolBlock __xdata *next;
+  uint8_t length; // of data
+  union {
+    // header and data as one buffer, what the radio DMA moves
+    uint8_t packet[POOL_HEADER_SIZE + POOL_BLOCK_SIZE];
+    struct {
+      uint8_t header[POOL_HEADER_SIZE];
+      uint8_t data[POOL_BLOCK_SIZE];
+    };
+  };
+} PoolBlock;
+
+typedef struct {
+  PoolBlock __xdata *head;
+  PoolBlock __xdata *tail;
+} PoolQueue;
+
+typedef struct {
+  uint8_t in_use;
+  uint8_t high_water; // most blocks in use at once
+  uint16_t alloc_failures;
+} PoolStats;
+
+extern PoolStats __xdata pool_stats;
+
+void pool_init(void);
+void pool_queue_init(PoolQueue __xdata *queue);
+
+// Called from the radio interrupt as well as the main loop: reentrant, so an
+// interrupted call keeps its arguments and locals on the stack, and the
+// lists only change with interrupts off.
+PoolBlock __xdata *pool_alloc(void) __reentrant; // NULL when exhausted
+void pool_free(PoolBlock __xdata *block) __reentrant;
+void pool_queue_push(PoolQueue __xdata *queue, PoolBlock __xdata *block) __reentrant;
+PoolBlock __xdata *pool_queue_pop(PoolQueue __xdata *queue) __reentrant; // NULL when empty
+bool pool_queue_empty(PoolQueue __xdata *queue) __reentrant;
+
+#endif
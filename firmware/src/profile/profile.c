@@ -0,0 +1,126 @@
+#include "profile.h"
+#include "../command/command.h"
+#include <string.h>
+
+#ifdef PROFILE
+
+#define T1_OVFIF BV(4)
+
+typedef struct {
+  uint32_t start;
+  uint16_t count;
+  uint32_t total;
+  uint32_t max;
+} Probe;
+
+static Probe __xdata probes[PROBE_COUNT];
+static volatile uint16_t overflows = 0;
+static uint16_t overhead = 0; // cycles of an empty enter/exit pair
+
+INTERRUPT(profile_timer_isr, T1_VECTOR) {
+  T1CTL &= ~T1_OVFIF;
+  T1IF = 0;
+  overflows++;
+}
+
+// called with interrupts disabled
+#pragma save
+#pragma nooverlay
+static uint32_t profile_now(void) {
+  uint8_t low = T1CNTL; // latches T1CNTH
+  uint8_t high = T1CNTH;
+  uint16_t upper = overflows;
+  if ((T1CTL & T1_OVFIF) && !(high & 0x80)) {
+    // wrapped, the interrupt did not run yet
+    upper++;
+  }
+  return ((uint32_t)upper << 16) | ((uint16_t)high << 8) | low;
+}
+#pragma restore
+
+static void profile_clear(void) {
+  HAL_CRITICAL_STATEMENT(memset(probes, 0, sizeof(probes)));
+}
+
+void profile_init(void) {
+  T1CTL = 0x01; // tick frequency, free running
+  T1IF = 0;
+  T1IE = 1;
+
+  // calibrate so an empty region measures 0
+  overhead = 0;
+  profile_enter(0);
+  profile_exit(0);
+  overhead = probes[0].total;
+  profile_clear();
+}
+
+#pragma save
+#pragma nooverlay
+void profile_enter(uint8_t probe) {
+  HAL_CRITICAL_STATEMENT(probes[probe].start = profile_now());
+}
+
+void profile_exit(uint8_t probe) {
+  HAL_CRITICAL_STATEMENT({
+    Probe __xdata *p = &probes[probe];
+    uint32_t cycles = profile_now() - p->start;
+    cycles = cycles > overhead ? cycles - overhead : 0;
+    p->count++;
+    p->total += cycles;
+    if (cycles > p->max) {
+      p->max = cycles;
+    }
+  });
+}
+#pragma restore
+
+#else
+
+void profile_init(void) {
+}
+
+void profile_enter(uint8_t probe) {
+  (void)probe;
+}
+
+void profile_exit(uint8_t probe) {
+  (void)probe;
+}
+
+#endif
+
+// args: first probe, flags (optional, PROFILE_FLAG_RESET)
+// reply: first probe | probe count | entries...
+uint8_t cmd_profile(void) {
+#ifdef PROFILE
+  const uint8_t __xdata *args = command_call.args;
+  uint8_t __xdata *reply = command_call.reply;
+  uint8_t first = args[0];
+  uint8_t count = 0;
+  uint8_t __xdata *entry = reply + PROFILE_REPLY_HEADER;
+
+  reply[0] = first;
+  reply[1] = PROBE_COUNT;
+  for (uint8_t i = first; i < PROBE_COUNT; i++) {
+    if (PROFILE_REPLY_HEADER + (count + 1) * PROFILE_ENTRY_SIZE > COMMAND_MAX_REPLY) {
+      break;
+    }
+    // the 8051 is little endian like the wire format
+    HAL_CRITICAL_STATEMENT({
+      memcpy(entry, &probes[i].count, sizeof(uint16_t));
+      memcpy(entry + 2, &probes[i].total, sizeof(uint32_t));
+      memcpy(entry + 6, &probes[i].max, sizeof(uint32_t));
+    });
+    entry += PROFILE_ENTRY_SIZE;
+    count++;
+  }
+  if (command_call.length > 1 && (args[1] & PROFILE_FLAG_RESET) && first + count == PROBE_COUNT) {
+    profile_clear();
+  }
+  command_call.reply_length = PROFILE_REPLY_HEADER + count * PROFILE_ENTRY_SIZE;
+  return STATUS_OK;
+#else
+  return STATUS_UNSUPPORTED;
+#endif
+}
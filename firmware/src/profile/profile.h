@@ -0,0 +1,50 @@
+#ifndef _PROFILE_H_
+#define _PROFILE_H_
+
+#include "../hal/hal.h"
+#include <stdint.h>
+
+// Cycle counting probes, built with `make PROFILE=1`. Without PROFILE the
+// macros expand to nothing. Each probe accumulates how often its region ran,
+// the total and the longest run in CPU cycles, Timer 1 counts the system
+// clock and an overflow interrupt extends it to 32 bits.
+//
+// A probe must not be entered again before it exits, probes used from an
+// interrupt need their own ID.
+
+// keep in sync with gateway-test/src/profile.ts
+enum {
+  PROBE_COBS_RX_POLL,
+  PROBE_TRANSPORT_RECEIVE,
+  PROBE_TRANSPORT_SEND,
+  PROBE_EPD_SEND_DATA,
+  PROBE_EPD_BAND,
+  PROBE_LABEL_RENDER,
+  PROBE_BITMAP_SPAN,
+  PROBE_BITMAP_BLIT,
+  PROBE_BITMAP_TRANSPOSE,
+  PROBE_BITMAP_ROTATE,
+  PROBE_TEXT_DRAW,
+  PROBE_COUNT,
+};
+
+// COMMAND_PROFILE dumps the table a page at a time, see cmd_profile. Entries
+// are count (16 bit), total and max cycles (32 bit), little endian.
+#define PROFILE_FLAG_RESET BV(0) // clear the table once its last page was read
+
+#define PROFILE_REPLY_HEADER 2
+#define PROFILE_ENTRY_SIZE 10
+
+#ifdef PROFILE
+#define PROFILE_ENTER(probe) profile_enter(probe)
+#define PROFILE_EXIT(probe) profile_exit(probe)
+#else
+#define PROFILE_ENTER(probe)
+#define PROFILE_EXIT(probe)
+#endif
+
+void profile_init(void);
+void profile_enter(uint8_t probe);
+void profile_exit(uint8_t probe);
+
+#endif
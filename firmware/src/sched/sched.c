@@ -0,0 +1,85 @@
+#include "sched.h"
+#include "timer.h"
+#include "../hal/pm.h"
+
+#define SCHED_QUEUE_SIZE 16 // power of 2, at least EVENT_COUNT
+
+static SchedHandler __xdata handlers[EVENT_COUNT];
+
+static uint8_t __xdata queue[SCHED_QUEUE_SIZE];
+static uint8_t queue_head = 0;
+static uint8_t queue_tail = 0;
+static uint16_t __xdata queued = 0; // bitmask of events in the queue
+
+void sched_init(void) {
+  for (uint8_t i = 0; i < EVENT_COUNT; i++) {
+    handlers[i] = NULL;
+  }
+  timer_init();
+  sched_handle(EVENT_TIMER, timer_expire);
+}
+
+void sched_handle(uint8_t event, SchedHandler handler) {
+  handlers[event] = handler;
+}
+
+// interrupts are not nested, so this is only raced by sched_post which
+// keeps them disabled while touching the queue
+#pragma save
+#pragma nooverlay
+void sched_post_isr(uint8_t event) {
+  uint16_t mask = BV(event);
+  if (queued & mask) {
+    return;
+  }
+  queued |= mask;
+  queue[queue_head] = event;
+  queue_head = (queue_head + 1) & (SCHED_QUEUE_SIZE - 1);
+}
+#pragma restore
+
+void sched_post(uint8_t event) {
+  HAL_CRITICAL_STATEMENT(sched_post_isr(event));
+}
+
+void sched_run(void) {
+  while (1) {
+    uint8_t event;
+
+    HAL_DISABLE_INTERRUPTS();
+    if (queue_head == queue_tail) {
+      // nothing to do, sleep until the next interrupt
+      pm_idle();
+      continue;
+    }
+    event = queue[queue_tail];
+    queue_tail = (queue_tail + 1) & (SCHED_QUEUE_SIZE - 1);
+    queued &= ~BV(event);
+    HAL_ENABLE_INTERRUPTS();
+
+    if (handlers[event]) {
+      handlers[event]();
+    }
+  }
+}
+
+#ifndef BUILD
+bool sched_step(void) {
+  uint8_t event;
+
+  HAL_DISABLE_INTERRUPTS();
+  if (queue_head == queue_tail) {
+    HAL_ENABLE_INTERRUPTS();
+    return false;
+  }
+  event = queue[queue_tail];
+  queue_tail = (queue_tail + 1) & (SCHED_QUEUE_SIZE - 1);
+  queued &= ~BV(event);
+  HAL_ENABLE_INTERRUPTS();
+
+  if (handlers[event]) {
+    handlers[event]();
+  }
+  return true;
+}
+#endif
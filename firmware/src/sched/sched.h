@@ -0,0 +1,32 @@
+#ifndef _SCHED_H_
+#define _SCHED_H_
+
+#include "../hal/hal.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Events are posted by interrupts and tasks and run one handler each, to
+// completion, in the order they were posted. An event that is already
+// queued is not queued twice, handlers drain whatever work is pending.
+#define EVENT_UART_RX 0   // frame decoded or RX wakeup on the host link
+#define EVENT_TIMER 1     // a timer deadline passed
+#define EVENT_EPD_READY 2 // display released BUSY
+#define EVENT_EPD_STEP 3  // display driver continues its sequence
+#define EVENT_NFC_FIELD 4 // NFC field detected
+#define EVENT_RADIO_RX 5  // radio packet received
+#define EVENT_COUNT 6
+
+typedef void (*SchedHandler)(void);
+
+void sched_init(void);
+void sched_handle(uint8_t event, SchedHandler handler);
+void sched_post(uint8_t event);
+void sched_post_isr(uint8_t event);
+void sched_run(void);
+#ifndef BUILD
+// host tests run the handlers themselves: dispatches the next queued event,
+// false when there was none
+bool sched_step(void);
+#endif
+
+#endif
@@ -0,0 +1,106 @@
+#include "timer.h"
+#include "../hal/time.h"
+
+#define WHEEL_MASK (TIMER_WHEEL_SIZE - 1)
+
+// hashed timing wheel: a timer sits in the slot of its deadline's low bits,
+// a slot only has to be looked at when the clock passes it
+static Timer __xdata *__xdata wheel[TIMER_WHEEL_SIZE];
+static uint32_t __xdata wheel_time; // last millisecond that was processed
+
+// No timer expires before earliest while armed. A start only ever moves it
+// closer, a stop leaves it: the alarm may then fire for nothing, and only
+// once it has passed are the timers walked for the next one.
+static uint32_t __xdata earliest;
+static bool armed = false;
+
+// arm the tick interrupt for earliest, 0 when there is no timer
+static void timer_set_alarm(uint32_t now) {
+  int32_t left = earliest - now;
+  if (!armed) {
+    left = 0;
+  } else if (left <= 0) {
+    left = 1;
+  } else if (left > 0xFFFF) {
+    left = 0xFFFF;
+  }
+  time_set_alarm(left);
+}
+
+static void timer_find_earliest(void) {
+  armed = false;
+  for (uint8_t i = 0; i < TIMER_WHEEL_SIZE; i++) {
+    for (Timer __xdata *timer = wheel[i]; timer; timer = timer->next) {
+      if (!armed || (int32_t)(timer->expires - earliest) < 0) {
+        earliest = timer->expires;
+        armed = true;
+      }
+    }
+  }
+}
+
+void timer_init(void) {
+  for (uint8_t i = 0; i < TIMER_WHEEL_SIZE; i++) {
+    wheel[i] = NULL;
+  }
+  wheel_time = millis();
+  armed = false;
+}
+
+void timer_stop(Timer __xdata *timer) {
+  if (!timer->active) {
+    return;
+  }
+  Timer __xdata *__xdata *link = &wheel[timer->expires & WHEEL_MASK];
+  while (*link != timer) {
+    link = &(*link)->next;
+  }
+  *link = timer->next;
+  timer->active = false;
+}
+
+void timer_start(Timer __xdata *timer, uint16_t delay, TimerCallback callback) {
+  timer_stop(timer);
+  if (!delay) {
+    delay = 1;
+  }
+  timer->expires = millis() + delay;
+  timer->callback = callback;
+  timer->active = true;
+
+  Timer __xdata *__xdata *slot = &wheel[timer->expires & WHEEL_MASK];
+  timer->next = *slot;
+  *slot = timer;
+  if (!armed || (int32_t)(timer->expires - earliest) < 0) {
+    earliest = timer->expires;
+    armed = true;
+    time_set_alarm(delay);
+  }
+}
+
+void timer_expire(void) {
+  uint32_t now = millis();
+  uint32_t elapsed = now - wheel_time;
+  uint8_t steps = elapsed >= TIMER_WHEEL_SIZE ? TIMER_WHEEL_SIZE : elapsed;
+
+  while (steps--) {
+    Timer __xdata *__xdata *slot = &wheel[++wheel_time & WHEEL_MASK];
+    Timer __xdata *timer = *slot;
+    while (timer) {
+      if ((int32_t)(timer->expires - now) > 0) {
+        // a later round of the wheel
+        timer = timer->next;
+        continue;
+      }
+      timer_stop(timer);
+      timer->callback();
+      // the callback may have changed this slot, start over
+      timer = *slot;
+    }
+  }
+  wheel_time = now;
+  if (armed && (int32_t)(earliest - now) <= 0) {
+    timer_find_earliest();
+  }
+  timer_set_alarm(now);
+}
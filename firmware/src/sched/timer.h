@@ -0,0 +1,24 @@
+#ifndef _TIMER_H_
+#define _TIMER_H_
+
+#include "../hal/hal.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define TIMER_WHEEL_SIZE 8 // slots, power of 2
+
+typedef void (*TimerCallback)(void);
+
+typedef struct Timer {
+  struct Timer __xdata *next;
+  uint32_t expires; // millis() deadline, also picks the wheel slot
+  TimerCallback callback;
+  bool active;
+} Timer;
+
+void timer_init(void);
+void timer_start(Timer __xdata *timer, uint16_t delay, TimerCallback callback);
+void timer_stop(Timer __xdata *timer);
+void timer_expire(void);
+
+#endif
@@ -0,0 +1,466 @@
+#include "tdma.h"
+#include "../command/command.h"
+#include "../hal/radio.h"
+#include "../hal/time.h"
+#include "../kv/kv.h"
+#include "../sched/timer.h"
+#include <string.h>
+
+// queued request: address | frame (16 bit) | slot, then the TDMA_DATA packet
+#define QUEUE_HEADER 4
+#define MAX_QUEUED 3 // requests held by the coordinator, half the pool
+#define MAX_INBOX 2  // replies waiting for COMMAND_TDMA_RECEIVE
+
+#define SLOT_TICKS TIME_MS_TO_TICKS(TDMA_SLOT_MS)
+#define FRAME_TICKS TIME_MS_TO_TICKS((uint32_t)TDMA_SLOTS * TDMA_SLOT_MS)
+
+// drift is in 2^-20 of the elapsed time, the limit keeps corrections and
+// the rate update within 32 bits over TDMA_MAX_MISSES longest periods
+#define DRIFT_LIMIT 1000
+// the listen window opens this much before the predicted beacon: a fixed
+// margin for timer resolution and radio startup, plus 61ppm (2^-14) of the
+// time since the last beacon once the drift is known, 488ppm (2^-11, worse
+// than any crystal) before
+#define GUARD_MIN_TICKS TIME_MS_TO_TICKS(3)
+#define GUARD_SHIFT_CALIBRATED 14
+#define GUARD_SHIFT_UNCALIBRATED 11
+// a beacon with a full address list on air at 250kbit/s, its arrival time
+// is taken at the end
+#define BEACON_TICKS TIME_MS_TO_TICKS(2)
+#define SLOT_TAIL_MS 5 // listed tags stop listening this long before the slot ends
+#define SEARCH_MS (2 * TDMA_SLOTS * TDMA_SLOT_MS)
+#define SEARCH_BACKOFF_MS 60000
+#define SLEEP_MAX_MS 60000 // longer sleeps are split, timers take 16 bit
+// KV_TDMA: slot | period | phase | calibrated | drift (16 bit), the drift is
+// saved again once it moved this far (15ppm), not with every beacon
+#define SAVED_SIZE 6
+#define SAVE_DRIFT_STEP 16
+
+#if TDMA_BEACON_HEADER + TDMA_MAX_LISTED > RADIO_MAX_PAYLOAD || SEARCH_MS > 0xFFFF
+#error "TDMA frame geometry"
+#endif
+
+TdmaStats __xdata tdma_stats;
+
+static Timer __xdata timer;
+static uint8_t own_address;
+static uint8_t __xdata state = TDMA_OFF;
+
+// member
+static uint8_t own_slot;
+static uint8_t period; // wakes every 2^period frames
+static uint8_t phase;
+static bool calibrated; // drift measured
+static uint8_t misses;  // own beacons in a row
+static uint32_t __xdata anchor; // sleep timer ticks at the end of the beacon of own_slot in anchor_frame
+static uint16_t anchor_frame;
+static uint16_t wake_frame;
+static uint16_t guard; // of the window waiting for the beacon of wake_frame
+static int16_t saved_drift;
+
+// coordinator
+static uint16_t __xdata frame;
+static uint8_t __xdata slot;
+static uint32_t __xdata next_beacon; // millis()
+static PoolQueue __xdata outbox;
+static PoolQueue __xdata inbox;
+static uint8_t outbox_count;
+static uint8_t inbox_count;
+static uint8_t __xdata beacon[TDMA_BEACON_HEADER + TDMA_MAX_LISTED];
+
+static void member_schedule(void);
+static void search(void);
+
+static uint16_t read_u16(const uint8_t __xdata *data) {
+  return data[0] | ((uint16_t)data[1] << 8);
+}
+
+static uint32_t ticks_to_ms(uint32_t ticks) {
+  return ticks * 3 / 104;
+}
+
+// the assignment and what was learned about the clock, for after a reset
+static void save(void) {
+  uint8_t __xdata saved[SAVED_SIZE];
+  saved[0] = own_slot;
+  saved[1] = period;
+  saved[2] = phase;
+  saved[3] = calibrated;
+  saved[4] = tdma_stats.drift;
+  saved[5] = tdma_stats.drift >> 8;
+  saved_drift = tdma_stats.drift;
+  kv_put(KV_TDMA, saved, SAVED_SIZE);
+}
+
+static void drain(PoolQueue __xdata *queue) {
+  PoolBlock __xdata *block;
+  while ((block = pool_queue_pop(queue))) {
+    pool_free(block);
+  }
+}
+
+static void stop(void) {
+  timer_stop(&timer);
+  radio_listen(RADIO_LISTEN_TDMA, false);
+  drain(&outbox);
+  drain(&inbox);
+  outbox_count = 0;
+  inbox_count = 0;
+  state = TDMA_OFF;
+}
+
+// ---- member ----
+
+// nominal ticks times the measured rate difference
+static int32_t correction(uint32_t elapsed) {
+  return (int32_t)(elapsed >> 10) * tdma_stats.drift / 1024;
+}
+
+static uint16_t window_guard(uint32_t elapsed) {
+  return GUARD_MIN_TICKS + (elapsed >> (calibrated ? GUARD_SHIFT_CALIBRATED : GUARD_SHIFT_UNCALIBRATED));
+}
+
+static uint32_t predicted(uint16_t at) {
+  uint32_t elapsed = (uint16_t)(at - anchor_frame) * FRAME_TICKS;
+  return anchor + elapsed + correction(elapsed);
+}
+
+// end of the packet last returned by radio_rx_frame, in full sleep timer
+// ticks: the interrupt only keeps the low 16 bits, enough for 1.8s
+static uint32_t arrival(void) {
+  uint32_t now = time_ticks();
+  return now - (uint16_t)((uint16_t)now - radio_rx_info.stamp);
+}
+
+static void member_slot_end(void) {
+  radio_listen(RADIO_LISTEN_TDMA, false);
+  member_schedule();
+}
+
+static void member_window_end(void) {
+  radio_listen(RADIO_LISTEN_TDMA, false);
+  tdma_stats.misses++;
+  if (++misses > TDMA_MAX_MISSES) {
+    search();
+  } else {
+    member_schedule();
+  }
+}
+
+static void member_wake(void) {
+  state = TDMA_WINDOW;
+  tdma_stats.window = 2 * guard + BEACON_TICKS;
+  radio_listen(RADIO_LISTEN_TDMA, true);
+  timer_start(&timer, ticks_to_ms(tdma_stats.window) + 1, member_window_end);
+}
+
+// sleeps until the window of the next frame of ours that is still ahead
+static void member_schedule(void) {
+  uint16_t mask = BV(period) - 1;
+  uint16_t at = anchor_frame + 1;
+  uint32_t now = time_ticks();
+  int32_t wait;
+
+  state = TDMA_SLEEP;
+  at += (phase - at) & mask;
+  for (;;) {
+    uint32_t elapsed = (uint16_t)(at - anchor_frame) * FRAME_TICKS;
+    guard = window_guard(elapsed);
+    wait = predicted(at) - guard - BEACON_TICKS - now;
+    if (wait > 0) {
+      break;
+    }
+    at += mask + 1;
+  }
+  wake_frame = at;
+
+  if (ticks_to_ms(wait) > SLEEP_MAX_MS) {
+    timer_start(&timer, SLEEP_MAX_MS, member_schedule);
+  } else {
+    timer_start(&timer, ticks_to_ms(wait), member_wake);
+  }
+}
+
+// any beacon gives the position of our slot in its frame
+static void member_sync(const uint8_t __xdata *packet) {
+  anchor = arrival() + ((int16_t)own_slot - packet[3]) * (int32_t)SLOT_TICKS;
+  anchor_frame = read_u16(packet + 1);
+  misses = 0;
+  timer_stop(&timer);
+  radio_listen(RADIO_LISTEN_TDMA, false);
+  member_schedule();
+}
+
+static void member_beacon(const uint8_t __xdata *packet, uint8_t length) {
+  uint16_t at = read_u16(packet + 1);
+  if (state == TDMA_SEARCH || (state == TDMA_WINDOW && packet[3] != own_slot)) {
+    member_sync(packet);
+    return;
+  }
+  if (state != TDMA_WINDOW) {
+    return;
+  }
+  timer_stop(&timer);
+  tdma_stats.beacons++;
+  if (at == wake_frame) {
+    // what is left of the error after the correction is the drift still
+    // unaccounted for, a first measurement counts fully
+    uint32_t elapsed = (uint16_t)(at - anchor_frame) * FRAME_TICKS;
+    int32_t error = (int32_t)(arrival() - predicted(at));
+    int32_t drift = error * 1024 / (int32_t)(elapsed >> 10);
+    drift = tdma_stats.drift + (calibrated ? drift / 2 : drift);
+    if (drift > DRIFT_LIMIT) {
+      drift = DRIFT_LIMIT;
+    } else if (drift < -DRIFT_LIMIT) {
+      drift = -DRIFT_LIMIT;
+    }
+    tdma_stats.drift = drift;
+    if (!calibrated || drift - saved_drift > SAVE_DRIFT_STEP || saved_drift - drift > SAVE_DRIFT_STEP) {
+      calibrated = true;
+      save();
+    }
+  }
+  anchor = arrival();
+  anchor_frame = at;
+  misses = 0;
+
+  for (uint8_t i = TDMA_BEACON_HEADER; i < length; i++) {
+    if (packet[i] == own_address) {
+      state = TDMA_SLOT;
+      timer_start(&timer, TDMA_SLOT_MS - SLOT_TAIL_MS, member_slot_end);
+      return;
+    }
+  }
+  radio_listen(RADIO_LISTEN_TDMA, false);
+  member_schedule();
+}
+
+// runs the request and answers its source, the gateway queues the request
+// again if either gets lost
+static void member_data(const uint8_t __xdata *packet, uint8_t length) {
+  PoolBlock __xdata *reply = pool_alloc();
+  if (!reply) {
+    return;
+  }
+  reply->data[0] = TDMA_DATA;
+  reply->data[1] = own_address;
+  reply->length =
+      TDMA_DATA_HEADER + command_execute(packet + TDMA_DATA_HEADER, length - TDMA_DATA_HEADER, reply->data + TDMA_DATA_HEADER);
+  radio_send_block(packet[1], reply);
+  tdma_stats.requests++;
+}
+
+static void search_backoff(void) {
+  radio_listen(RADIO_LISTEN_TDMA, false);
+  timer_start(&timer, SEARCH_BACKOFF_MS, search);
+}
+
+static void search(void) {
+  state = TDMA_SEARCH;
+  radio_listen(RADIO_LISTEN_TDMA, true);
+  timer_start(&timer, SEARCH_MS, search_backoff);
+}
+
+// ---- coordinator ----
+
+static void coordinator_slot(void) {
+  PoolQueue __xdata due;
+  PoolBlock __xdata *block;
+  uint8_t length = TDMA_BEACON_HEADER;
+  int32_t wait;
+
+  // requests for this slot go out behind the beacon, ones for slots
+  // already past are dropped
+  pool_queue_init(&due);
+  for (uint8_t i = outbox_count; i; i--) {
+    block = pool_queue_pop(&outbox);
+    int16_t frames = read_u16(block->data + 1) - frame;
+    uint8_t at = block->data[3];
+    if (frames < 0 || (!frames && at < slot)) {
+      pool_free(block);
+      outbox_count--;
+      tdma_stats.expired++;
+    } else if (!frames && at == slot && length < sizeof(beacon)) {
+      if (!memchr(beacon + TDMA_BEACON_HEADER, block->data[0], length - TDMA_BEACON_HEADER)) {
+        beacon[length++] = block->data[0];
+      }
+      pool_queue_push(&due, block);
+    } else {
+      pool_queue_push(&outbox, block);
+    }
+  }
+
+  beacon[0] = TDMA_BEACON;
+  beacon[1] = frame;
+  beacon[2] = frame >> 8;
+  beacon[3] = slot;
+  if (radio_send(RADIO_BROADCAST, beacon, length)) {
+    tdma_stats.beacons++;
+  }
+  while ((block = pool_queue_pop(&due))) {
+    uint8_t address = block->data[0];
+    block->length -= QUEUE_HEADER;
+    memmove(block->data, block->data + QUEUE_HEADER, block->length);
+    radio_send_block(address, block);
+    outbox_count--;
+    tdma_stats.requests++;
+  }
+
+  if (++slot == TDMA_SLOTS) {
+    slot = 0;
+    frame++;
+  }
+  // beacons keep to the schedule even when a slot ran late
+  next_beacon += TDMA_SLOT_MS;
+  wait = next_beacon - millis();
+  timer_start(&timer, wait > 0 ? wait : 0, coordinator_slot);
+}
+
+static void coordinator_data(PoolBlock __xdata *block) {
+  if (inbox_count == MAX_INBOX) {
+    pool_free(block);
+    return;
+  }
+  pool_queue_push(&inbox, block);
+  inbox_count++;
+}
+
+// ----
+
+bool tdma_receive(PoolBlock __xdata *block) {
+  const uint8_t __xdata *packet = block->data;
+  uint8_t length = block->length;
+  if (packet[0] == TDMA_BEACON && length >= TDMA_BEACON_HEADER) {
+    if (state != TDMA_OFF && state != TDMA_COORDINATOR) {
+      member_beacon(packet, length);
+    }
+  } else if (packet[0] == TDMA_DATA && length > TDMA_DATA_HEADER) {
+    if (state == TDMA_COORDINATOR) {
+      coordinator_data(block);
+      return true;
+    } else if (state != TDMA_OFF) {
+      member_data(packet, length);
+    }
+  }
+  return false;
+}
+
+void tdma_init(uint8_t address) {
+  uint8_t __xdata saved[SAVED_SIZE];
+  own_address = address;
+  pool_queue_init(&outbox);
+  pool_queue_init(&inbox);
+  memset(&tdma_stats, 0, sizeof(tdma_stats));
+  if (kv_get(KV_TDMA, saved, SAVED_SIZE) == SAVED_SIZE && saved[0] < TDMA_SLOTS && saved[1] <= TDMA_MAX_PERIOD &&
+      saved[2] < BV(saved[1])) {
+    // back from a reset, find the own slot again without the gateway
+    own_slot = saved[0];
+    period = saved[1];
+    phase = saved[2];
+    calibrated = saved[3];
+    tdma_stats.drift = saved[4] | ((uint16_t)saved[5] << 8);
+    saved_drift = tdma_stats.drift;
+    search();
+  }
+}
+
+// args: slot, period, phase. Wakes for the slot in every frame with
+// frame % 2^period == phase, slot 0xFF stops.
+uint8_t cmd_tdma_assign(void) {
+  const uint8_t __xdata *args = command_call.args;
+  if (args[0] == 0xFF) {
+    stop();
+    kv_put(KV_TDMA, NULL, 0);
+    return STATUS_OK;
+  }
+  if (args[0] >= TDMA_SLOTS || args[1] > TDMA_MAX_PERIOD || args[2] >= BV(args[1])) {
+    return STATUS_BAD_ARGUMENT;
+  }
+  stop();
+  own_slot = args[0];
+  period = args[1];
+  phase = args[2];
+  save();
+  search();
+  return STATUS_OK;
+}
+
+// args: 1 to send beacons, 0 stops
+uint8_t cmd_tdma_coordinate(void) {
+  const uint8_t __xdata *args = command_call.args;
+  stop();
+  if (args[0]) {
+    kv_put(KV_TDMA, NULL, 0);
+    state = TDMA_COORDINATOR;
+    radio_listen(RADIO_LISTEN_TDMA, true);
+    next_beacon = millis();
+    coordinator_slot();
+  }
+  return STATUS_OK;
+}
+
+// args: address, frame (16 bit), slot, request. Sent after the beacon of
+// that slot, the gateway picks it from the tag's assignment.
+uint8_t cmd_tdma_queue(void) {
+  const uint8_t __xdata *args = command_call.args;
+  uint8_t length = command_call.length;
+  PoolBlock __xdata *block;
+  if (state != TDMA_COORDINATOR) {
+    return STATUS_UNSUPPORTED;
+  }
+  if (length + TDMA_DATA_HEADER > QUEUE_HEADER + RADIO_MAX_PAYLOAD) {
+    return STATUS_BAD_LENGTH;
+  }
+  if (args[3] >= TDMA_SLOTS) {
+    return STATUS_BAD_ARGUMENT;
+  }
+  if (outbox_count == MAX_QUEUED || !(block = pool_alloc())) {
+    return STATUS_BUSY;
+  }
+  memcpy(block->data, args, QUEUE_HEADER);
+  block->data[QUEUE_HEADER] = TDMA_DATA;
+  block->data[QUEUE_HEADER + 1] = own_address;
+  memcpy(block->data + QUEUE_HEADER + TDMA_DATA_HEADER, args + QUEUE_HEADER, length - QUEUE_HEADER);
+  block->length = length + TDMA_DATA_HEADER;
+  pool_queue_push(&outbox, block);
+  outbox_count++;
+  return STATUS_OK;
+}
+
+// reply: source address and the command reply of the oldest answer heard by
+// the coordinator, empty without one
+uint8_t cmd_tdma_receive(void) {
+  uint8_t __xdata *reply = command_call.reply;
+  PoolBlock __xdata *block = pool_queue_pop(&inbox);
+  if (block) {
+    uint8_t size = block->length - 1;
+    if (size > COMMAND_MAX_REPLY) {
+      size = COMMAND_MAX_REPLY;
+    }
+    memcpy(reply, block->data + 1, size);
+    command_call.reply_length = size;
+    pool_free(block);
+    inbox_count--;
+  }
+  return STATUS_OK;
+}
+
+// reply: state, slot, period, phase, frame (16 bit), queued requests,
+// waiting replies, TdmaStats. A coordinator reports the slot and frame of
+// its next beacon, a member its own slot and the frame of its last beacon.
+uint8_t cmd_tdma_status(void) {
+  uint8_t __xdata *reply = command_call.reply;
+  bool coordinator = state == TDMA_COORDINATOR;
+  uint16_t at = coordinator ? frame : anchor_frame;
+  reply[0] = state;
+  reply[1] = coordinator ? slot : own_slot;
+  reply[2] = period;
+  reply[3] = phase;
+  reply[4] = at;
+  reply[5] = at >> 8;
+  reply[6] = outbox_count;
+  reply[7] = inbox_count;
+  memcpy(reply + 8, &tdma_stats, sizeof(tdma_stats));
+  command_call.reply_length = 8 + sizeof(tdma_stats);
+  return STATUS_OK;
+}
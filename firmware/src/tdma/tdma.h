@@ -0,0 +1,71 @@
+#ifndef _TDMA_H_
+#define _TDMA_H_
+
+#include "../hal/hal.h"
+#include "../pool/pool.h"
+#include <stdint.h>
+
+// Time slotted wake windows. A coordinator, the tag on the gateway's serial
+// link (COMMAND_TDMA_COORDINATE), broadcasts a beacon at the start of every
+// slot
+//   TDMA_BEACON | frame (16 bit) | slot | addresses...
+// listing the tags it holds requests for in that slot. A frame is
+// TDMA_SLOTS slots of TDMA_SLOT_MS. The gateway assigns each tag a slot, a
+// period and a phase (COMMAND_TDMA_ASSIGN): the tag wakes for the beacon of
+// its slot in every frame with frame % 2^period == phase, and stays for the
+// rest of the slot only when it is listed. Requests and replies travel as
+//   TDMA_DATA | source address | command request or reply
+// and the coordinator sends a request right after the beacon of the slot it
+// was queued for (COMMAND_TDMA_QUEUE).
+//
+// A tag times its wakeups from the arrival of its last beacon. The error
+// between predicted and actual arrival tracks the rate of its sleep timer
+// against the coordinator's, later wakeups are corrected by it, and the
+// listen window widens with the time since the last beacon. After
+// TDMA_MAX_MISSES missed beacons the tag searches again: it listens for up
+// to two frames for any beacon, and retries later if none comes.
+
+#define TDMA_BEACON 0xB0
+#define TDMA_DATA 0xB1
+
+#define TDMA_BEACON_HEADER 4
+#define TDMA_DATA_HEADER 2
+#define TDMA_MAX_LISTED 8 // addresses per beacon
+
+#ifndef TDMA_SLOT_MS
+#define TDMA_SLOT_MS 50
+#endif
+#ifndef TDMA_SLOTS
+#define TDMA_SLOTS 64
+#endif
+#define TDMA_MAX_PERIOD 4 // every 16th frame, 51s with the defaults
+
+#ifndef TDMA_MAX_MISSES
+#define TDMA_MAX_MISSES 4
+#endif
+
+enum {
+  TDMA_OFF,
+  TDMA_SEARCH, // listening for any beacon
+  TDMA_SLEEP,  // until the next own slot
+  TDMA_WINDOW, // listening for the own beacon
+  TDMA_SLOT,   // listed in the beacon, listening for requests
+  TDMA_COORDINATOR,
+};
+
+typedef struct {
+  uint16_t beacons;  // own beacons heard, or sent as coordinator
+  uint16_t misses;   // own beacons not heard
+  uint16_t requests; // handled, or sent as coordinator
+  uint16_t expired;  // coordinator: requests queued for a slot already past
+  int16_t drift;     // sleep timer rate against the coordinator, 2^-20
+  uint16_t window;   // last listen window, sleep timer ticks
+} TdmaStats;
+
+extern TdmaStats __xdata tdma_stats;
+
+void tdma_init(uint8_t address);
+// a received TDMA_BEACON or TDMA_DATA packet, true when the frame was kept
+bool tdma_receive(PoolBlock __xdata *frame);
+
+#endif
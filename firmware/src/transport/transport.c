@@ -0,0 +1,317 @@
+#include "transport.h"
+#include "../cobs/cobs.h"
+#include "../hal/crc.h"
+#include "../hal/time.h"
+#include "../hal/uart.h"
+#include "../kv/kv.h"
+#include "../profile/profile.h"
+
+#define WINDOW_MASK (TRANSPORT_WINDOW - 1)
+#define SEQ_IN_WINDOW(seq, base) ((uint8_t)((seq) - (base)) < TRANSPORT_WINDOW)
+
+#if !defined(LINK_KEY) && \
+    COBS_FRAME_SIZE(TRANSPORT_HEADER_SIZE + TRANSPORT_MAX_PAYLOAD + TRANSPORT_CRC_SIZE) > UART_TX_BUFFER_SIZE
+#error "a transport frame must fit a UART TX buffer"
+#endif
+
+typedef struct {
+  bool acked;
+  bool fast_retransmit; // already resent because a later frame was sacked
+  uint8_t retries;
+  uint8_t length;
+  uint16_t sent_at;
+  uint8_t data[TRANSPORT_MAX_PAYLOAD];
+} TxSlot;
+
+TransportStats __xdata transport_stats;
+TransportPayload __xdata transport_rx;
+
+static TransportHandler rx_handler;
+
+// received frames waiting for their turn, length excludes the CRC
+static PoolBlock __xdata *__xdata rx_slots[TRANSPORT_WINDOW];
+static uint8_t rx_next = 0; // next sequence number to deliver
+static bool ack_pending = false;
+static bool peer_syn = false; // the peer's frames of this session carry SYN
+
+static TxSlot __xdata tx_slots[TRANSPORT_WINDOW];
+static uint8_t tx_base = 0; // oldest unacknowledged sequence number
+static uint8_t tx_count = 0;
+static bool tx_synced = false; // peer acknowledged us since we started
+
+static void send_frame(uint8_t flags, uint8_t seq, const uint8_t __xdata *data, uint8_t length) {
+  uint8_t sack = 0;
+  for (uint8_t i = 0; i < TRANSPORT_WINDOW - 1; i++) {
+    if (rx_slots[(uint8_t)(rx_next + 1 + i) & WINDOW_MASK]) {
+      sack |= BV(i);
+    }
+  }
+
+  uint8_t header[TRANSPORT_HEADER_SIZE];
+  PROFILE_ENTER(PROBE_TRANSPORT_SEND);
+  header[0] = flags | TRANSPORT_FLAG_ACK | (tx_synced ? 0 : TRANSPORT_FLAG_SYN);
+  header[1] = seq;
+  header[2] = rx_next;
+  header[3] = sack;
+
+#ifdef LINK_KEY
+  uint8_t __xdata *frame = link_tx_buffer();
+  memcpy(frame, header, TRANSPORT_HEADER_SIZE);
+  if (length) {
+    memcpy(frame + TRANSPORT_HEADER_SIZE, data, length);
+  }
+  link_send(TRANSPORT_HEADER_SIZE + length);
+#else
+  CobsEncoder encoder;
+  cobs_begin(&encoder, TRANSPORT_HEADER_SIZE + length + TRANSPORT_CRC_SIZE);
+#if TRANSPORT_CRC
+  CRC16_INIT(0);
+  for (uint8_t i = 0; i < TRANSPORT_HEADER_SIZE; i++) {
+    CRC16_UPDATE(header[i]);
+    cobs_write_byte(&encoder, header[i]);
+  }
+  for (uint8_t i = 0; i < length; i++) {
+    CRC16_UPDATE(data[i]);
+    cobs_write_byte(&encoder, data[i]);
+  }
+  uint16_t crc = CRC16_VALUE();
+  cobs_write_byte(&encoder, crc >> 8);
+  cobs_write_byte(&encoder, crc);
+#else
+  for (uint8_t i = 0; i < TRANSPORT_HEADER_SIZE; i++) {
+    cobs_write_byte(&encoder, header[i]);
+  }
+  for (uint8_t i = 0; i < length; i++) {
+    cobs_write_byte(&encoder, data[i]);
+  }
+#endif
+  cobs_end(&encoder);
+#endif
+
+  ack_pending = false;
+  transport_stats.tx_frames++;
+  PROFILE_EXIT(PROBE_TRANSPORT_SEND);
+}
+
+static void send_slot(uint8_t seq) {
+  TxSlot __xdata *slot = &tx_slots[seq & WINDOW_MASK];
+  slot->sent_at = millis();
+  send_frame(TRANSPORT_FLAG_DATA, seq, slot->data, slot->length);
+}
+
+static void tx_acknowledge(uint8_t ack, uint8_t sack) {
+  uint8_t advance = ack - tx_base;
+  if (advance > tx_count) {
+    // stale ack from before a retransmission
+    return;
+  }
+  if (advance) {
+    tx_synced = true;
+  }
+  while (advance--) {
+    TxSlot __xdata *slot = &tx_slots[tx_base & WINDOW_MASK];
+    slot->acked = false;
+    slot->fast_retransmit = false;
+    slot->retries = 0;
+    tx_base++;
+    tx_count--;
+  }
+
+  for (uint8_t i = 0; sack; i++, sack >>= 1) {
+    uint8_t seq = ack + 1 + i;
+    if ((sack & 1) && (uint8_t)(seq - tx_base) < tx_count) {
+      tx_slots[seq & WINDOW_MASK].acked = true;
+    }
+  }
+
+  // a later frame got through, the one the peer waits for was most likely lost
+  TxSlot __xdata *first = &tx_slots[tx_base & WINDOW_MASK];
+  if (tx_count && !first->acked && !first->fast_retransmit && tx_count > 1 &&
+      tx_slots[(uint8_t)(tx_base + 1) & WINDOW_MASK].acked) {
+    first->fast_retransmit = true;
+    transport_stats.tx_retransmits++;
+    send_slot(tx_base);
+  }
+}
+
+static void rx_reset(void) {
+  for (uint8_t i = 0; i < TRANSPORT_WINDOW; i++) {
+    if (rx_slots[i]) {
+      pool_free(rx_slots[i]);
+      rx_slots[i] = NULL;
+    }
+  }
+}
+
+// frames in flight are given up, numbering goes on from the next one
+static void tx_drop(void) {
+  tx_base += tx_count;
+  tx_count = 0;
+  tx_synced = false;
+  for (uint8_t i = 0; i < TRANSPORT_WINDOW; i++) {
+    tx_slots[i].acked = false;
+    tx_slots[i].fast_retransmit = false;
+    tx_slots[i].retries = 0;
+  }
+}
+
+void transport_init(TransportHandler handler) {
+  uint8_t __xdata start = 0;
+  rx_handler = handler;
+  rx_reset();
+  rx_next = 0;
+  peer_syn = false;
+  // a gateway that never acked the last start still expects its numbers
+  if (kv_get(KV_TRANSPORT, &start, 1)) {
+    start += 0x80;
+  }
+  kv_put(KV_TRANSPORT, &start, 1);
+  tx_base = start;
+  tx_drop();
+  ack_pending = false;
+}
+
+// false for a damaged or forged frame, otherwise its length is cut to
+// header and payload
+static bool rx_check(PoolBlock __xdata *frame) {
+#ifdef LINK_KEY
+  return link_open(frame) && frame->length >= TRANSPORT_HEADER_SIZE;
+#elif !TRANSPORT_CRC
+  return frame->length >= TRANSPORT_HEADER_SIZE;
+#else
+  uint8_t size = frame->length;
+  CRC16_INIT(0);
+  for (uint8_t i = 0; i < size; i++) {
+    CRC16_UPDATE(frame->data[i]);
+  }
+  // a CRC over data and its own big endian CRC comes out as 0
+  if (size < TRANSPORT_HEADER_SIZE + TRANSPORT_CRC_SIZE || CRC16_VALUE() != 0) {
+    return false;
+  }
+  frame->length = size - TRANSPORT_CRC_SIZE;
+  return true;
+#endif
+}
+
+// returns true when the frame was kept for delivery
+static bool rx_accept(PoolBlock __xdata *frame) {
+  const uint8_t __xdata *header = frame->data;
+
+  if (!rx_check(frame)) {
+    transport_stats.rx_crc_errors++;
+    return false;
+  }
+  transport_stats.rx_frames++;
+
+  uint8_t flags = header[0];
+  uint8_t seq = header[1];
+  if (flags & TRANSPORT_FLAG_ACK) {
+    tx_acknowledge(header[2], header[3]);
+  }
+  if (!(flags & TRANSPORT_FLAG_DATA)) {
+    return false;
+  }
+
+  ack_pending = true;
+  if (!(flags & TRANSPORT_FLAG_SYN)) {
+    peer_syn = false;
+  } else if (!peer_syn || (!SEQ_IN_WINDOW(seq, rx_next) && (uint8_t)(rx_next - seq) > TRANSPORT_WINDOW)) {
+    // SYN after plain frames, or neither new nor a late duplicate: the peer
+    // restarted its numbering, follow it. The link keeps the order, a SYN
+    // frame of the old session cannot turn up after a plain one. What we
+    // still had in flight was meant for the old session, it is dropped.
+    rx_reset();
+    rx_next = seq;
+    tx_drop();
+    peer_syn = true;
+  }
+
+  PoolBlock __xdata *__xdata *slot = &rx_slots[seq & WINDOW_MASK];
+  if (!SEQ_IN_WINDOW(seq, rx_next) || *slot) {
+    transport_stats.rx_dropped++;
+    return false;
+  }
+  *slot = frame;
+  return true;
+}
+
+void transport_receive(PoolBlock __xdata *frame) {
+  PROFILE_ENTER(PROBE_TRANSPORT_RECEIVE);
+  if (!rx_accept(frame)) {
+    pool_free(frame);
+  }
+  PROFILE_EXIT(PROBE_TRANSPORT_RECEIVE);
+}
+
+void transport_poll(void) {
+  PoolBlock __xdata *__xdata *slot;
+  while (*(slot = &rx_slots[rx_next & WINDOW_MASK])) {
+    PoolBlock __xdata *frame = *slot;
+    transport_rx.data = frame->data + TRANSPORT_HEADER_SIZE;
+    transport_rx.length = frame->length - TRANSPORT_HEADER_SIZE;
+    if (!rx_handler()) {
+      break;
+    }
+    pool_free(frame);
+    *slot = NULL;
+    rx_next++;
+    ack_pending = true;
+  }
+
+  uint16_t now = millis();
+  for (uint8_t i = 0; i < tx_count; i++) {
+    uint8_t seq = tx_base + i;
+    TxSlot __xdata *tx = &tx_slots[seq & WINDOW_MASK];
+    if (!tx->acked && (uint16_t)(now - tx->sent_at) >= TRANSPORT_RTO_MS) {
+      if (tx->retries == TRANSPORT_MAX_RETRIES) {
+        // the peer is gone or no longer follows our numbering, the next
+        // frames go out with SYN and start over
+        transport_stats.link_failures++;
+        tx_drop();
+        break;
+      }
+      tx->retries++;
+      transport_stats.tx_retransmits++;
+      send_slot(seq);
+    }
+  }
+
+  // hold the ack back while more frames are queued, one ack covers them all
+  if (ack_pending && !cobs_rx_pending()) {
+    send_frame(0, 0, NULL, 0);
+  }
+#ifdef LINK_KEY
+  link_poll();
+#endif
+}
+
+bool transport_idle(void) {
+  return !tx_count && !ack_pending;
+}
+
+uint8_t __xdata *transport_reserve(void) {
+  if (tx_count == TRANSPORT_WINDOW) {
+    return NULL;
+  }
+  return tx_slots[(uint8_t)(tx_base + tx_count) & WINDOW_MASK].data;
+}
+
+void transport_commit(uint8_t length) {
+  uint8_t seq = tx_base + tx_count++;
+  TxSlot __xdata *slot = &tx_slots[seq & WINDOW_MASK];
+  slot->acked = false;
+  slot->fast_retransmit = false;
+  slot->retries = 0;
+  slot->length = length;
+  send_slot(seq);
+}
+
+bool transport_send(const uint8_t *data, uint8_t length) {
+  uint8_t __xdata *payload = transport_reserve();
+  if (!payload || length > TRANSPORT_MAX_PAYLOAD) {
+    return false;
+  }
+  memcpy(payload, data, length);
+  transport_commit(length);
+  return true;
+}
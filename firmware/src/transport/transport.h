@@ -0,0 +1,95 @@
+#ifndef _TRANSPORT_H_
+#define _TRANSPORT_H_
+
+#include "../hal/hal.h"
+#include "../pool/pool.h"
+#ifdef LINK_KEY
+#include "../crypto/link.h"
+#endif
+#include <stdint.h>
+
+// Selective repeat ARQ over the COBS link. Every frame is
+//   flags | seq | ack | sack | payload... | crc16 (big endian)
+// ack is the next sequence number the sender expects, bit i of sack
+// acknowledges ack + 1 + i. The CRC covers header and payload. With
+// LINK_KEY frames are sealed by crypto/link instead, the MIC replaces the CRC.
+// TRANSPORT_CRC 0 (make CRC=0) leaves it out, to measure what it costs or
+// on a link that does not lose bytes.
+
+#ifndef TRANSPORT_WINDOW
+#define TRANSPORT_WINDOW 4 // frames in flight per direction, power of 2, max 8
+#endif
+
+#ifndef TRANSPORT_MAX_PAYLOAD
+#define TRANSPORT_MAX_PAYLOAD 120
+#endif
+
+#ifndef TRANSPORT_RTO_MS
+#define TRANSPORT_RTO_MS 50 // retransmission timeout
+#endif
+
+#ifndef TRANSPORT_MAX_RETRIES
+#define TRANSPORT_MAX_RETRIES 10 // then the frames in flight are given up
+#endif
+
+#ifndef TRANSPORT_CRC
+#define TRANSPORT_CRC 1
+#endif
+
+#define TRANSPORT_HEADER_SIZE 4
+#define TRANSPORT_CRC_SIZE (TRANSPORT_CRC ? 2 : 0)
+
+#ifdef LINK_KEY
+#if TRANSPORT_HEADER_SIZE + TRANSPORT_MAX_PAYLOAD > LINK_MAX_PLAINTEXT
+#error "a sealed transport frame must fit in a pool block"
+#endif
+#elif TRANSPORT_HEADER_SIZE + TRANSPORT_MAX_PAYLOAD + TRANSPORT_CRC_SIZE > POOL_BLOCK_SIZE
+#error "a transport frame must fit in a pool block"
+#endif
+
+#define TRANSPORT_FLAG_DATA BV(0) // seq and payload are valid
+#define TRANSPORT_FLAG_ACK BV(1)  // ack and sack are valid
+#define TRANSPORT_FLAG_SYN BV(2)  // sender (re)started, receiver adopts seq
+
+// The payload for the handler, which takes no arguments: SDCC only passes
+// them through a function pointer to reentrant functions.
+typedef struct {
+  const uint8_t __xdata *data;
+  uint8_t length;
+} TransportPayload;
+
+extern TransportPayload __xdata transport_rx;
+
+// returns false when the payload cannot be consumed yet, it is offered again
+// on the next transport_poll and the peer is not allowed past it meanwhile
+typedef bool (*TransportHandler)(void);
+
+typedef struct {
+  uint16_t rx_frames;
+  uint16_t rx_crc_errors; // or refused by the link encryption
+  uint16_t rx_dropped; // duplicates or out of window
+  uint16_t tx_frames;
+  uint16_t tx_retransmits;
+  uint16_t link_failures; // frames given up after TRANSPORT_MAX_RETRIES
+} TransportStats;
+
+extern TransportStats __xdata transport_stats;
+
+// Needs kv_init(): every start numbers its frames half the sequence space
+// away from the last one, so a peer still holding the old numbering does not
+// take them for duplicates.
+void transport_init(TransportHandler handler);
+void transport_poll(void);
+bool transport_idle(void); // nothing to retransmit or acknowledge
+bool transport_send(const uint8_t *data, uint8_t length);
+
+// build the next frame in place: reserve returns room for
+// TRANSPORT_MAX_PAYLOAD bytes or NULL while the window is full, commit sends
+// the first length bytes of it
+uint8_t __xdata *transport_reserve(void);
+void transport_commit(uint8_t length);
+
+// takes ownership of a decoded frame, it goes back to the pool once handled
+void transport_receive(PoolBlock __xdata *frame);
+
+#endif
@@ -0,0 +1,147 @@
+#include "test.h"
+#include "aes128.h"
+#include "../src/crypto/aes.h"
+#include "../src/crypto/ccm.h"
+#include "../src/hal/dma.h"
+#include <string.h>
+
+// crypto/aes.c and ccm.c against the coprocessor model, which stops the
+// process on a block without its own ST or in the wrong mode. The modes are
+// checked with the NIST SP 800-38A vectors, CCM with a plain software
+// version of RFC 3610 over the model's block cipher.
+
+static const uint8_t key[AES_BLOCK_SIZE] = {0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+                                            0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+
+static const uint8_t plain[4 * AES_BLOCK_SIZE] = {
+    0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+    0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+    0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+    0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10};
+
+static const uint8_t ecb[4 * AES_BLOCK_SIZE] = {
+    0x3a, 0xd7, 0x7b, 0xb4, 0x0d, 0x7a, 0x36, 0x60, 0xa8, 0x9e, 0xca, 0xf3, 0x24, 0x66, 0xef, 0x97,
+    0xf5, 0xd3, 0xd5, 0x85, 0x03, 0xb9, 0x69, 0x9d, 0xe7, 0x85, 0x89, 0x5a, 0x96, 0xfd, 0xba, 0xaf,
+    0x43, 0xb1, 0xcd, 0x7f, 0x59, 0x8e, 0xce, 0x23, 0x88, 0x1b, 0x00, 0xe3, 0xed, 0x03, 0x06, 0x88,
+    0x7b, 0x0c, 0x78, 0x5e, 0x27, 0xe8, 0xad, 0x3f, 0x82, 0x23, 0x20, 0x71, 0x04, 0x72, 0x5d, 0xd4};
+
+static const uint8_t cbc_iv[AES_BLOCK_SIZE] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+                                               0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f};
+
+static const uint8_t cbc[4 * AES_BLOCK_SIZE] = {
+    0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46, 0xce, 0xe9, 0x8e, 0x9b, 0x12, 0xe9, 0x19, 0x7d,
+    0x50, 0x86, 0xcb, 0x9b, 0x50, 0x72, 0x19, 0xee, 0x95, 0xdb, 0x11, 0x3a, 0x91, 0x76, 0x78, 0xb2,
+    0x73, 0xbe, 0xd6, 0xb8, 0xe3, 0xc1, 0x74, 0x3b, 0x71, 0x16, 0xe6, 0x9e, 0x22, 0x22, 0x95, 0x16,
+    0x3f, 0xf1, 0xca, 0xa1, 0x68, 0x1f, 0xac, 0x09, 0x12, 0x0e, 0xca, 0x30, 0x75, 0x86, 0xe1, 0xa7};
+
+static const uint8_t ctr_iv[AES_BLOCK_SIZE] = {0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7,
+                                               0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff};
+
+static const uint8_t ctr[4 * AES_BLOCK_SIZE] = {
+    0x87, 0x4d, 0x61, 0x91, 0xb6, 0x20, 0xe3, 0x26, 0x1b, 0xef, 0x68, 0x64, 0x99, 0x0d, 0xb6, 0xce,
+    0x98, 0x06, 0xf6, 0x6b, 0x79, 0x70, 0xfd, 0xff, 0x86, 0x17, 0x18, 0x7b, 0xb9, 0xff, 0xfd, 0xff,
+    0x5a, 0xe4, 0xdf, 0x3e, 0xdb, 0xd5, 0xd3, 0x5e, 0x5b, 0x4f, 0x09, 0x02, 0x0d, 0xb0, 0x3e, 0xab,
+    0x1e, 0x03, 0x1d, 0xda, 0x2f, 0xbe, 0x03, 0xd1, 0x79, 0x21, 0x70, 0xa0, 0xf3, 0x00, 0x9c, 0xee};
+
+static uint8_t data[4 * AES_BLOCK_SIZE];
+
+static void test_ecb(void) {
+  aes_encrypt(AES_MODE_ECB, plain, data, 4);
+  CHECK(!memcmp(data, ecb, sizeof(ecb)));
+}
+
+static void test_cbc(void) {
+  aes_load_iv(AES_MODE_CBC, cbc_iv);
+  // the chain carries over between calls
+  aes_encrypt(AES_MODE_CBC, plain, data, 1);
+  aes_encrypt(AES_MODE_CBC, plain + AES_BLOCK_SIZE, data + AES_BLOCK_SIZE, 3);
+  CHECK(!memcmp(data, cbc, sizeof(cbc)));
+}
+
+static void test_cbc_mac(void) {
+  // no output until the last block, which is the last CBC one
+  memset(data, 0, sizeof(data));
+  aes_load_iv(AES_MODE_CBC_MAC, cbc_iv);
+  aes_encrypt(AES_MODE_CBC_MAC, plain, NULL, 3);
+  aes_encrypt(AES_MODE_CBC, plain + 3 * AES_BLOCK_SIZE, data, 1);
+  CHECK(!memcmp(data, cbc + 3 * AES_BLOCK_SIZE, AES_BLOCK_SIZE));
+}
+
+static void test_ctr(void) {
+  // in place
+  memcpy(data, plain, sizeof(plain));
+  aes_load_iv(AES_MODE_CTR, ctr_iv);
+  aes_encrypt(AES_MODE_CTR, data, data, 4);
+  CHECK(!memcmp(data, ctr, sizeof(ctr)));
+}
+
+// RFC 3610 with a 4 byte MIC, a 2 byte length and no associated data
+static void reference_seal(const uint8_t *nonce, const uint8_t *in, uint8_t *out, uint8_t length) {
+  uint8_t x[AES_BLOCK_SIZE] = {0x09}, a[AES_BLOCK_SIZE] = {0x01}, s[AES_BLOCK_SIZE];
+  memcpy(x + 1, nonce, CCM_NONCE_SIZE);
+  x[AES_BLOCK_SIZE - 1] = length;
+  aes128_encrypt(x, x);
+  for (uint8_t i = 0; i < length; i++) {
+    x[i % AES_BLOCK_SIZE] ^= in[i];
+    if (i % AES_BLOCK_SIZE == AES_BLOCK_SIZE - 1 || i == length - 1) {
+      aes128_encrypt(x, x);
+    }
+  }
+  memcpy(a + 1, nonce, CCM_NONCE_SIZE);
+  for (uint8_t i = 0; i < length; i++) {
+    if (!(i % AES_BLOCK_SIZE)) {
+      a[AES_BLOCK_SIZE - 1] = i / AES_BLOCK_SIZE + 1;
+      aes128_encrypt(a, s);
+    }
+    out[i] = in[i] ^ s[i % AES_BLOCK_SIZE];
+  }
+  a[AES_BLOCK_SIZE - 1] = 0;
+  aes128_encrypt(a, s);
+  for (uint8_t i = 0; i < CCM_MIC_SIZE; i++) {
+    out[length + i] = x[i] ^ s[i];
+  }
+}
+
+static void test_ccm(void) {
+  static uint8_t nonce[CCM_NONCE_SIZE];
+  static uint8_t frame[8 + 3 * AES_BLOCK_SIZE + CCM_MIC_SIZE];
+  uint8_t message[3 * AES_BLOCK_SIZE];
+  uint8_t expected[sizeof(frame)];
+  static const uint8_t lengths[] = {0, 1, 15, 16, 17, 32, 45};
+
+  for (uint8_t n = 0; n < sizeof(lengths); n++) {
+    uint8_t length = lengths[n];
+    for (uint8_t i = 0; i < CCM_NONCE_SIZE; i++) {
+      nonce[i] = i * 17 + n;
+    }
+    for (uint8_t i = 0; i < length; i++) {
+      message[i] = i * 29 + n;
+    }
+    reference_seal(nonce, message, expected, length);
+
+    memcpy(frame + 8, message, length);
+    ccm_seal(nonce, frame + 8, length);
+    CHECK(!memcmp(frame + 8, expected, length + CCM_MIC_SIZE));
+
+    // opened 8 bytes down, where a header was
+    CHECK(ccm_open(nonce, frame + 8, frame, length));
+    CHECK(!memcmp(frame, message, length));
+
+    memcpy(frame + 8, expected, length + CCM_MIC_SIZE);
+    frame[8 + length] ^= 1;
+    CHECK(!ccm_open(nonce, frame + 8, frame, length));
+  }
+}
+
+int main(void) {
+  test_init();
+  dma_init();
+  aes_load_key(key);
+
+  RUN(test_ecb);
+  RUN(test_cbc);
+  RUN(test_cbc_mac);
+  RUN(test_ctr);
+  RUN(test_ccm);
+  return 0;
+}
@@ -0,0 +1,134 @@
+#include "test.h"
+#include "../src/display/bitmap.h"
+#include <string.h>
+
+// display/bitmap.c against one pixel at a time: spans, blits at every
+// alignment of source and destination, transposes and rotations. Host
+// builds run the C kernels, this pins down the setup they share with the
+// assembly ones (masks, shift, prefetch) and what both have to produce.
+
+#define STRIDE 8 // 64 pixels
+#define ROWS 24
+
+static uint8_t __xdata dst[ROWS * STRIDE];
+static uint8_t __xdata expected[ROWS * STRIDE];
+static uint8_t __xdata src[ROWS * STRIDE + 1]; // blits read a byte ahead
+
+static bool pixel(const uint8_t *bits, uint8_t stride, uint16_t x, uint16_t y) {
+  return bits[y * stride + x / 8] & (0x80 >> (x & 7));
+}
+
+static void set_pixel(uint8_t *bits, uint8_t stride, uint16_t x, uint16_t y, bool ink) {
+  uint8_t mask = 0x80 >> (x & 7);
+  if (ink) {
+    bits[y * stride + x / 8] |= mask;
+  } else {
+    bits[y * stride + x / 8] &= ~mask;
+  }
+}
+
+static void random_fill(uint8_t *bits, uint16_t size) {
+  for (uint16_t i = 0; i < size; i++) {
+    bits[i] = rand();
+  }
+}
+
+static void test_span(void) {
+  for (uint8_t x0 = 0; x0 < 40; x0++) {
+    for (uint8_t x1 = x0; x1 <= 48; x1++) {
+      for (uint8_t ink = 0; ink < 2; ink++) {
+        random_fill(dst, STRIDE);
+        memcpy(expected, dst, STRIDE);
+        for (uint8_t x = x0; x < x1; x++) {
+          set_pixel(expected, STRIDE, x, 0, ink);
+        }
+        bitmap_span(dst, x0, x1, ink);
+        CHECK(!memcmp(dst, expected, STRIDE));
+      }
+    }
+  }
+}
+
+static void test_blit(void) {
+  for (uint8_t x = 0; x < 8; x++) {
+    for (uint8_t src_x = 0; src_x < 16; src_x++) {
+      for (uint8_t width = 1; width <= 40; width++) {
+        for (uint8_t ink = 0; ink < 2; ink++) {
+          // src_stride 0 repeats the first row
+          uint8_t src_stride = width & 1 ? STRIDE : 0;
+          uint8_t rows = 3;
+          random_fill(src, sizeof(src));
+          random_fill(dst, sizeof(dst));
+          memcpy(expected, dst, sizeof(dst));
+          for (uint8_t row = 0; row < rows; row++) {
+            for (uint8_t i = 0; i < width; i++) {
+              if (pixel(src + row * src_stride, STRIDE, src_x + i, 0)) {
+                set_pixel(expected, STRIDE, x + i, row + 1, ink);
+              }
+            }
+          }
+          bitmap_blit(dst + STRIDE, STRIDE, x, src, src_stride, src_x, width, rows, ink);
+          CHECK(!memcmp(dst, expected, sizeof(dst)));
+        }
+      }
+    }
+  }
+}
+
+static void test_transpose(void) {
+  random_fill(src, sizeof(src));
+  memset(dst, 0, sizeof(dst));
+  bitmap_transpose8(src, STRIDE, dst, STRIDE);
+  for (uint8_t i = 0; i < 8; i++) {
+    for (uint8_t j = 0; j < 8; j++) {
+      CHECK(pixel(dst, STRIDE, j, i) == pixel(src, STRIDE, i, j));
+    }
+  }
+  // negative strides mirror, in place
+  memcpy(dst, src, sizeof(dst));
+  bitmap_transpose8(dst + 7 * STRIDE, -STRIDE, dst, STRIDE);
+  for (uint8_t i = 0; i < 8; i++) {
+    for (uint8_t j = 0; j < 8; j++) {
+      CHECK(pixel(dst, STRIDE, j, i) == pixel(src, STRIDE, i, 7 - j));
+    }
+  }
+}
+
+// src is 16 x 24, turned clockwise
+static void test_rotate(void) {
+  const uint16_t width = 16, height = 24;
+  random_fill(src, sizeof(src));
+  for (uint8_t rotation = BITMAP_ROTATE_0; rotation <= BITMAP_ROTATE_270; rotation++) {
+    memset(dst, 0, sizeof(dst));
+    bitmap_rotate(src, STRIDE, width, height, dst, STRIDE, rotation);
+    for (uint16_t y = 0; y < height; y++) {
+      for (uint16_t x = 0; x < width; x++) {
+        bool ink = pixel(src, STRIDE, x, y);
+        switch (rotation) {
+        case BITMAP_ROTATE_90:
+          CHECK(pixel(dst, STRIDE, height - 1 - y, x) == ink);
+          break;
+        case BITMAP_ROTATE_180:
+          CHECK(pixel(dst, STRIDE, width - 1 - x, height - 1 - y) == ink);
+          break;
+        case BITMAP_ROTATE_270:
+          CHECK(pixel(dst, STRIDE, y, width - 1 - x) == ink);
+          break;
+        default:
+          CHECK(pixel(dst, STRIDE, x, y) == ink);
+        }
+      }
+    }
+  }
+}
+
+int main(void) {
+  test_init();
+  srand(1);
+
+  RUN(test_span);
+  RUN(test_blit);
+  RUN(test_transpose);
+  RUN(test_rotate);
+  return 0;
+}
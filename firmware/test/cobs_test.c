@@ -0,0 +1,156 @@
+#define _GNU_SOURCE
+#include "test.h"
+#include "../src/cobs/cobs.h"
+#include "../src/hal/dma.h"
+#include "../src/hal/time.h"
+#include "../src/sched/sched.h"
+#include <fcntl.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+// cobs.c receiving through the USART1 model on a pty: frames are decoded
+// from the RX DMA ring by the task the one-shot RX wakeup posts, frames
+// larger than a pool block go to the stream handlers.
+
+#define TIMEOUT_MS 200
+
+static int host;
+static uint8_t streamed[512];
+static uint16_t streamed_length;
+static uint16_t stream_size;
+static bool stream_valid;
+static uint8_t stream_ends;
+
+// COBS encodes data and writes it with its delimiter, as the gateway does
+static void host_send(const uint8_t *data, uint16_t length) {
+  uint8_t frame[600];
+  uint16_t code_at = 0, size = 1;
+  uint8_t code = 1;
+  for (uint16_t i = 0; i < length; i++) {
+    if (data[i]) {
+      frame[size++] = data[i];
+      code++;
+    }
+    if (!data[i] || code == 0xFF) {
+      frame[code_at] = code;
+      code_at = size++;
+      code = 1;
+    }
+  }
+  frame[code_at] = code;
+  frame[size++] = 0;
+  CHECK(write(host, frame, size) == size);
+}
+
+static void pattern(uint8_t *data, uint16_t length, uint8_t seed) {
+  for (uint16_t i = 0; i < length; i++) {
+    data[i] = i % 37 ? i * seed : 0;
+  }
+}
+
+static void expect_frame(const uint8_t *data, uint8_t length) {
+  RUN_UNTIL(cobs_rx_frame_ready(), TIMEOUT_MS);
+  PoolBlock __xdata *frame = cobs_rx_frame();
+  CHECK(frame->length == length);
+  CHECK(!memcmp(frame->data, data, length));
+  pool_free(frame);
+}
+
+static void on_data(void) {
+  memcpy(streamed + streamed_length, cobs_stream_call.data, cobs_stream_call.length);
+  streamed_length += cobs_stream_call.length;
+}
+
+static void on_end(void) {
+  stream_size = cobs_stream_call.size;
+  stream_valid = cobs_stream_call.valid;
+  stream_ends++;
+}
+
+static void test_frame(void) {
+  uint8_t data[POOL_BLOCK_SIZE];
+  pattern(data, sizeof(data), 3);
+  host_send(data, sizeof(data));
+  expect_frame(data, sizeof(data));
+  CHECK(!cobs_rx_pending());
+  // the wakeup is armed again for the next burst
+  CHECK(URX1IE);
+}
+
+static void test_back_to_back(void) {
+  uint8_t data[3][40];
+  for (uint8_t i = 0; i < 3; i++) {
+    pattern(data[i], sizeof(data[i]), i + 5);
+    host_send(data[i], sizeof(data[i]));
+  }
+  for (uint8_t i = 0; i < 3; i++) {
+    expect_frame(data[i], sizeof(data[i]));
+  }
+  CHECK(cobs_stats.rx_errors == 0);
+}
+
+static void test_truncated(void) {
+  // a block announcing 9 bytes, the delimiter comes after 2
+  static const uint8_t frame[] = {10, 1, 2, 0};
+  CHECK(write(host, frame, sizeof(frame)) == sizeof(frame));
+  RUN_UNTIL(cobs_stats.rx_errors == 1, TIMEOUT_MS);
+  CHECK(!cobs_rx_frame_ready());
+  CHECK(pool_stats.in_use == 0);
+}
+
+static void test_too_long(void) {
+  uint8_t data[POOL_BLOCK_SIZE + 1];
+  pattern(data, sizeof(data), 7);
+  host_send(data, sizeof(data));
+  RUN_UNTIL(cobs_stats.rx_errors == 2, TIMEOUT_MS);
+  CHECK(!cobs_rx_frame_ready());
+  CHECK(pool_stats.in_use == 0);
+}
+
+static void test_stream(void) {
+  uint8_t data[3 * POOL_BLOCK_SIZE + 20];
+  uint8_t small[16];
+  pattern(data, sizeof(data), 11);
+  pattern(small, sizeof(small), 13);
+  cobs_rx_stream(on_data, on_end);
+  host_send(data, sizeof(data));
+  // frames that fit a block are still queued
+  host_send(small, sizeof(small));
+  expect_frame(small, sizeof(small));
+
+  CHECK(stream_ends == 1);
+  CHECK(stream_valid && stream_size == sizeof(data));
+  CHECK(streamed_length == sizeof(data));
+  CHECK(!memcmp(streamed, data, sizeof(data)));
+  CHECK(cobs_stats.rx_errors == 2);
+  CHECK(pool_stats.in_use == 0);
+  cobs_rx_stream(NULL, NULL);
+}
+
+int main(void) {
+  test_init();
+  time_init();
+  sched_init();
+  pool_init();
+  dma_init();
+  uart_init();
+  cobs_rx_init();
+  sched_handle(EVENT_UART_RX, cobs_rx_poll);
+
+  int model = posix_openpt(O_RDWR | O_NOCTTY);
+  CHECK(model >= 0 && !grantpt(model) && !unlockpt(model));
+  host = open(ptsname(model), O_RDWR | O_NOCTTY);
+  struct termios raw;
+  CHECK(host >= 0 && !tcgetattr(host, &raw));
+  cfmakeraw(&raw);
+  CHECK(!tcsetattr(host, TCSANOW, &raw));
+  usart1_model_attach(model);
+
+  RUN(test_frame);
+  RUN(test_back_to_back);
+  RUN(test_truncated);
+  RUN(test_too_long);
+  RUN(test_stream);
+  return 0;
+}
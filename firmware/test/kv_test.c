@@ -0,0 +1,139 @@
+#include "test.h"
+#include "../src/hal/spiflash.h"
+#include "../src/kv/kv.h"
+#include <string.h>
+
+// kv/kv.c against the flash model: values across a reset, deletes,
+// compaction into the other sector, and a compaction cut short by a reset.
+
+#define RECORD_SIZE 16
+#define RECORDS (SPIFLASH_SECTOR_SIZE / RECORD_SIZE)
+#define SECTOR(i) (KV_ADDRESS + (uint32_t)(i)*SPIFLASH_SECTOR_SIZE)
+
+static uint8_t __xdata value[KV_MAX_VALUE];
+
+static void put(uint8_t key, uint8_t length, uint8_t seed) {
+  for (uint8_t i = 0; i < length; i++) {
+    value[i] = seed + i;
+  }
+  kv_put(key, value, length);
+}
+
+static void expect(uint8_t key, uint8_t length, uint8_t seed) {
+  memset(value, 0, sizeof(value));
+  CHECK(kv_get(key, value, sizeof(value)) == length);
+  for (uint8_t i = 0; i < length; i++) {
+    CHECK(value[i] == (uint8_t)(seed + i));
+  }
+}
+
+// slots of sector in with something programmed, the header included
+static uint16_t programmed(uint8_t in) {
+  uint16_t count = 0;
+  for (uint16_t slot = 0; slot < RECORDS; slot++) {
+    spiflash_read_begin(SECTOR(in) + slot * RECORD_SIZE);
+    count += spiflash_read_byte() != 0xFF;
+    spiflash_read_end();
+  }
+  return count;
+}
+
+static void blank(void) {
+  spiflash_erase_sector(SECTOR(0));
+  spiflash_erase_sector(SECTOR(1));
+  kv_init();
+}
+
+static void test_empty(void) {
+  blank();
+  for (uint8_t key = 0; key < KV_KEYS; key++) {
+    CHECK(!kv_get(key, value, sizeof(value)));
+  }
+  CHECK(programmed(0) == 1);
+}
+
+static void test_put_get(void) {
+  blank();
+  put(KV_SCREEN, KV_MAX_VALUE, 1);
+  put(KV_TDMA, 6, 2);
+  expect(KV_SCREEN, KV_MAX_VALUE, 1);
+  expect(KV_TDMA, 6, 2);
+  // the newest record wins, a shorter get is cut
+  put(KV_SCREEN, 3, 7);
+  expect(KV_SCREEN, 3, 7);
+  CHECK(kv_get(KV_SCREEN, value, 2) == 3);
+  // the same value again writes nothing
+  uint16_t used = programmed(0);
+  put(KV_SCREEN, 3, 7);
+  CHECK(programmed(0) == used);
+  // deleted
+  kv_put(KV_TDMA, NULL, 0);
+  CHECK(!kv_get(KV_TDMA, value, sizeof(value)));
+
+  // and all of it after a reset
+  kv_init();
+  expect(KV_SCREEN, 3, 7);
+  CHECK(!kv_get(KV_TDMA, value, sizeof(value)));
+}
+
+// the newest record of each key moves into the other sector, a deleted key
+// stays behind, and the sectors take turns
+static void test_compaction(void) {
+  blank();
+  put(KV_TDMA, 6, 3);
+  put(KV_TRANSPORT, 1, 9);
+  kv_put(KV_TRANSPORT, NULL, 0);
+  uint16_t puts = 2 * RECORDS;
+  for (uint16_t i = 0; i < puts; i++) {
+    put(KV_SCREEN, 4, i);
+    expect(KV_SCREEN, 4, i);
+  }
+  expect(KV_TDMA, 6, 3);
+  CHECK(!kv_get(KV_TRANSPORT, value, sizeof(value)));
+
+  kv_init();
+  expect(KV_SCREEN, 4, puts - 1);
+  expect(KV_TDMA, 6, 3);
+  CHECK(!kv_get(KV_TRANSPORT, value, sizeof(value)));
+  // sector 0 took the first RECORDS - 1 records, sector 1 the two keys and
+  // RECORDS - 3 more, the rest went back into sector 0 behind the two keys
+  CHECK(programmed(1) == RECORDS);
+  CHECK(programmed(0) == 3 + (3 + puts) - (RECORDS - 1) - (RECORDS - 3));
+}
+
+// a reset after the erase of the other sector and part of the copying, but
+// before the header: the full sector stays in charge
+static void test_compaction_cut_short(void) {
+  blank();
+  put(KV_TDMA, 6, 4);
+  uint8_t last = RECORDS - 3;
+  for (uint16_t i = 0; i <= last; i++) {
+    put(KV_SCREEN, 5, i);
+  }
+  CHECK(programmed(0) == RECORDS);
+  uint8_t __xdata copy[RECORD_SIZE];
+  spiflash_read(SECTOR(0) + (RECORDS - 1) * RECORD_SIZE, copy, RECORD_SIZE);
+  spiflash_erase_sector(SECTOR(1));
+  spiflash_program(SECTOR(1) + RECORD_SIZE, copy, RECORD_SIZE);
+
+  kv_init();
+  expect(KV_SCREEN, 5, last);
+  expect(KV_TDMA, 6, 4);
+  // the next put compacts again, from the start
+  put(KV_SCREEN, 5, 0x55);
+  CHECK(programmed(1) == 4);
+  kv_init();
+  expect(KV_SCREEN, 5, 0x55);
+  expect(KV_TDMA, 6, 4);
+}
+
+int main(void) {
+  test_init();
+  spiflash_init();
+
+  RUN(test_empty);
+  RUN(test_put_get);
+  RUN(test_compaction);
+  RUN(test_compaction_cut_short);
+  return 0;
+}
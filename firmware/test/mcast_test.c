@@ -0,0 +1,161 @@
+#include "test.h"
+#include "../src/command/commands.h"
+#include "../src/command/command.h"
+#include "../src/display/label.h"
+#include "../src/hal/crc.h"
+#include "../src/hal/spiflash.h"
+#include "../src/mcast/gf256.h"
+#include "../src/mcast/mcast.h"
+#include "../src/sched/timer.h"
+#include <string.h>
+
+// mcast/mcast.c against the flash model: a template blob sent whole, with
+// source symbols lost and rebuilt from repairs, with a bad CRC and with more
+// losses than the scratch area holds.
+
+#define SYMBOLS (2 * MCAST_GENERATION + 8)
+#define SIZE (SYMBOLS * MCAST_SYMBOL_SIZE - 50)
+#define ADDRESS LABEL_TEMPLATE_ADDRESS(0)
+
+static uint8_t blob[SYMBOLS * MCAST_SYMBOL_SIZE]; // zero padded
+static uint8_t __xdata packet[MCAST_SYMBOL_HEADER + MCAST_SYMBOL_SIZE];
+static uint8_t __xdata readback[SIZE];
+static uint8_t session;
+
+static uint8_t generation_size(uint8_t generation) {
+  uint8_t left = SYMBOLS - generation * MCAST_GENERATION;
+  return left < MCAST_GENERATION ? left : MCAST_GENERATION;
+}
+
+static uint16_t blob_crc(void) {
+  CRC16_INIT(0);
+  for (uint16_t i = 0; i < SIZE; i++) {
+    CRC16_UPDATE(blob[i]);
+  }
+  return CRC16_VALUE();
+}
+
+static void announce(uint16_t crc) {
+  session++;
+  packet[0] = MCAST_ANNOUNCE;
+  packet[1] = session;
+  packet[2] = MCAST_TARGET_TEMPLATE;
+  packet[3] = SIZE & 0xFF;
+  packet[4] = SIZE >> 8;
+  packet[5] = crc & 0xFF;
+  packet[6] = crc >> 8;
+  mcast_receive(packet, MCAST_ANNOUNCE_SIZE);
+}
+
+// source symbol esi < k, repair symbol esi >= MCAST_GENERATION
+static void send(uint8_t generation, uint8_t esi) {
+  uint8_t k = generation_size(generation);
+  const uint8_t *source = blob + generation * MCAST_GENERATION * MCAST_SYMBOL_SIZE;
+  packet[0] = MCAST_SYMBOL;
+  packet[1] = session;
+  packet[2] = generation;
+  packet[3] = esi;
+  uint8_t __xdata *symbol = packet + MCAST_SYMBOL_HEADER;
+  if (esi < k) {
+    memcpy(symbol, source + esi * MCAST_SYMBOL_SIZE, MCAST_SYMBOL_SIZE);
+  } else {
+    memset(symbol, 0, MCAST_SYMBOL_SIZE);
+    for (uint8_t j = 0; j < k; j++) {
+      uint8_t factor = gf_inv(esi ^ j);
+      for (uint8_t i = 0; i < MCAST_SYMBOL_SIZE; i++) {
+        symbol[i] ^= gf_mul(source[j * MCAST_SYMBOL_SIZE + i], factor);
+      }
+    }
+  }
+  mcast_receive(packet, MCAST_SYMBOL_HEADER + MCAST_SYMBOL_SIZE);
+}
+
+static uint8_t state(void) {
+  static uint8_t __xdata request[COMMAND_REQUEST_HEADER] = {COMMAND_MCAST_STATUS};
+  static uint8_t __xdata reply[64];
+  command_execute(request, sizeof(request), reply);
+  CHECK(reply[3] == STATUS_OK);
+  return reply[COMMAND_REPLY_HEADER];
+}
+
+static void expect_blob(void) {
+  CHECK(state() == MCAST_DONE);
+  spiflash_read(ADDRESS, readback, SIZE);
+  CHECK(!memcmp(readback, blob, SIZE));
+}
+
+static void test_source_only(void) {
+  announce(blob_crc());
+  CHECK(state() == MCAST_RECEIVING);
+  for (uint8_t g = 0; g * MCAST_GENERATION < SYMBOLS; g++) {
+    for (uint8_t esi = 0; esi < generation_size(g); esi++) {
+      send(g, esi);
+    }
+  }
+  expect_blob();
+  CHECK(mcast_stats.decoded == 0);
+  CHECK(mcast_stats.repairs == 0);
+}
+
+// the first generation gets every fifth source symbol, the second none and
+// the last all but one, repairs make up for the rest
+static void test_repairs(void) {
+  uint16_t decoded = mcast_stats.decoded;
+  announce(blob_crc());
+  for (uint8_t esi = 1; esi < MCAST_GENERATION; esi += 5) {
+    send(0, esi);
+  }
+  for (uint8_t esi = 0; esi < generation_size(2) - 1; esi++) {
+    send(2, esi);
+  }
+  static const uint8_t needed[] = {MCAST_GENERATION - 3, MCAST_GENERATION, 1};
+  for (uint8_t g = 0; g < sizeof(needed); g++) {
+    for (uint8_t r = 0; r < needed[g]; r++) {
+      CHECK(state() == MCAST_RECEIVING);
+      // any distinct repairs will do, in increasing esi
+      send(g, MCAST_GENERATION + 2 * r + 1);
+    }
+  }
+  expect_blob();
+  CHECK(mcast_stats.decoded == decoded + sizeof(needed));
+}
+
+static void test_bad_crc(void) {
+  announce(blob_crc() ^ 1);
+  for (uint8_t g = 0; g * MCAST_GENERATION < SYMBOLS; g++) {
+    for (uint8_t esi = 0; esi < generation_size(g); esi++) {
+      send(g, esi);
+    }
+  }
+  CHECK(state() == MCAST_FAILED);
+}
+
+static void test_out_of_scratch(void) {
+  announce(blob_crc());
+  uint8_t g = 0;
+  for (uint16_t sent = 0; state() == MCAST_RECEIVING; sent++) {
+    CHECK(sent <= MCAST_SCRATCH_SIZE / 128);
+    send(g, MCAST_GENERATION + sent % generation_size(g));
+    if (sent % generation_size(g) == generation_size(g) - 1) {
+      g++;
+    }
+  }
+  CHECK(state() == MCAST_STALLED);
+}
+
+int main(void) {
+  test_init();
+  timer_init();
+  spiflash_init();
+  mcast_init();
+  srand(1);
+  for (uint16_t i = 0; i < SIZE; i++) {
+    blob[i] = rand();
+  }
+
+  RUN(test_source_only);
+  RUN(test_repairs);
+  RUN(test_bad_crc);
+  RUN(test_out_of_scratch);
+  return 0;
+}
@@ -0,0 +1,128 @@
+#include "test.h"
+#include "nt3h2111.h"
+#include "../src/command/command.h"
+#include "../src/hal/port.h"
+#include "../src/hal/time.h"
+#include "../src/nfc/nfc.h"
+#include "../src/pool/pool.h"
+#include "../src/sched/sched.h"
+#include <string.h>
+
+// nfc.c against the NT3H2111 model: the phone writes requests into the SRAM
+// with nt3h_rf_*, FD on P1_1 and the pass-through hand the SRAM back and
+// forth, the replies come back the same way.
+
+#define TIMEOUT_MS 200
+
+static uint8_t page[NT3H_SRAM_SIZE];
+
+static void rf_write(uint8_t flags, const uint8_t *data, uint8_t length) {
+  memset(page, 0, sizeof(page));
+  page[0] = flags;
+  page[1] = length;
+  memcpy(page + NFC_FRAGMENT_HEADER, data, length);
+  RUN_UNTIL(nt3h_rf_write_sram(page), TIMEOUT_MS);
+}
+
+// the reply fragments, reassembled, returns its length
+static uint8_t rf_read(uint8_t *reply) {
+  uint8_t length = 0;
+  do {
+    RUN_UNTIL(nt3h_rf_read_sram(page), TIMEOUT_MS);
+    CHECK(!!length == !(page[0] & NFC_FLAG_FIRST));
+    CHECK(page[1] <= NFC_FRAGMENT_DATA);
+    memcpy(reply + length, page + NFC_FRAGMENT_HEADER, page[1]);
+    length += page[1];
+  } while (!(page[0] & NFC_FLAG_LAST));
+  return length;
+}
+
+static void test_session(void) {
+  nt3h_rf_field(true);
+  CHECK(!P1_1);
+  RUN_UNTIL(nfc_stats.sessions == 1, TIMEOUT_MS);
+}
+
+static void test_ping(void) {
+  static const uint8_t request[] = {COMMAND_PING, 0x34, 0x12};
+  uint8_t reply[128];
+  rf_write(NFC_FLAG_FIRST | NFC_FLAG_LAST, request, sizeof(request));
+  // the tag took the SRAM, FD is released
+  RUN_UNTIL(P1_1, TIMEOUT_MS);
+
+  CHECK(rf_read(reply) >= COMMAND_REPLY_HEADER);
+  CHECK(reply[0] == COMMAND_PING && reply[1] == 0x34 && reply[2] == 0x12);
+  CHECK(reply[3] == STATUS_OK);
+  CHECK(nfc_stats.frames == 1);
+}
+
+// the longest echo, request and reply over two SRAM pages each
+static void test_echo_fragments(void) {
+  uint8_t request[COMMAND_REQUEST_HEADER + COMMAND_MAX_REPLY];
+  uint8_t reply[128];
+  request[0] = COMMAND_ECHO;
+  request[1] = 0x78;
+  request[2] = 0x56;
+  for (uint8_t i = COMMAND_REQUEST_HEADER; i < sizeof(request); i++) {
+    request[i] = i * 7;
+  }
+
+  uint8_t offset = 0;
+  while (offset < sizeof(request)) {
+    uint8_t length = sizeof(request) - offset;
+    length = length > NFC_FRAGMENT_DATA ? NFC_FRAGMENT_DATA : length;
+    uint8_t flags = (offset ? 0 : NFC_FLAG_FIRST) | (offset + length == sizeof(request) ? NFC_FLAG_LAST : 0);
+    rf_write(flags, request + offset, length);
+    if (offset) {
+      // the previous page was read and FD released, this one pulls it low
+      // again and the edge posts EVENT_NFC_FIELD
+      CHECK(!P1_1);
+    }
+    RUN_UNTIL(P1_1, TIMEOUT_MS);
+    offset += length;
+  }
+
+  CHECK(rf_read(reply) == COMMAND_REPLY_HEADER + COMMAND_MAX_REPLY);
+  CHECK(reply[0] == COMMAND_ECHO && reply[1] == 0x78 && reply[2] == 0x56 && reply[3] == STATUS_OK);
+  CHECK(!memcmp(reply + COMMAND_REPLY_HEADER, request + COMMAND_REQUEST_HEADER, COMMAND_MAX_REPLY));
+  CHECK(nfc_stats.frames == 2);
+}
+
+static void test_lost_start(void) {
+  static const uint8_t tail[] = {1, 2, 3};
+  uint16_t errors = nfc_stats.errors;
+  rf_write(NFC_FLAG_LAST, tail, sizeof(tail));
+  RUN_UNTIL(nfc_stats.errors == errors + 1, TIMEOUT_MS);
+  CHECK(nfc_stats.frames == 2);
+}
+
+static void test_field_gone(void) {
+  nt3h_rf_field(false);
+  CHECK(P1_1);
+  // the poll finds the field gone and ends the session
+  uint64_t until = cc2510_now() + 3 * NFC_POLL_MS * 1000000ULL;
+  RUN_UNTIL(cc2510_now() > until, TIMEOUT_MS);
+  CHECK(nfc_stats.errors == 1);
+  CHECK(pool_stats.in_use == 0);
+
+  // a second tap is a new session
+  nt3h_rf_field(true);
+  RUN_UNTIL(nfc_stats.sessions == 2, TIMEOUT_MS);
+  nt3h_rf_field(false);
+}
+
+int main(void) {
+  test_init();
+  time_init();
+  port_init();
+  sched_init();
+  pool_init();
+  nfc_init();
+
+  RUN(test_session);
+  RUN(test_ping);
+  RUN(test_echo_fragments);
+  RUN(test_lost_start);
+  RUN(test_field_gone);
+  return 0;
+}
@@ -0,0 +1,87 @@
+#include "test.h"
+#include "../src/hal/spiflash.h"
+#include "../src/ota/image.h"
+#include <string.h>
+
+// ota/meta.c against the flash model: state records across both sectors,
+// with writes and erases cut short by a reset.
+
+#define META_RECORDS (SPIFLASH_SECTOR_SIZE / sizeof(OtaMeta))
+
+static OtaMeta __xdata meta;
+
+static void write(uint16_t image_size) {
+  meta.state = OTA_PENDING;
+  meta.image_size = image_size;
+  ota_meta_write(&meta);
+}
+
+static void expect(uint16_t image_size) {
+  CHECK(ota_meta_read(&meta));
+  CHECK(meta.state == OTA_PENDING);
+  CHECK(meta.image_size == image_size);
+}
+
+static void test_empty(void) {
+  meta.state = OTA_TRIAL;
+  CHECK(!ota_meta_read(&meta));
+  CHECK(meta.state == OTA_IDLE);
+}
+
+// around both sectors twice, the newest record always wins
+static void test_alternate(void) {
+  for (uint16_t i = 1; i <= 4 * META_RECORDS + 3; i++) {
+    write(i);
+    expect(i);
+  }
+  CHECK(meta.generation == 4);
+}
+
+static void test_broken_record(void) {
+  write(0x1234);
+  // a reset while programming the next one leaves it half written
+  static const uint8_t __xdata magic = OTA_META_MAGIC;
+  uint32_t address = OTA_META_ADDRESS;
+  for (uint16_t slot = 0; slot < META_RECORDS; slot++, address += sizeof(OtaMeta)) {
+    spiflash_read_begin(address);
+    uint8_t first = spiflash_read_byte();
+    spiflash_read_end();
+    if (first == 0xFF) {
+      break;
+    }
+  }
+  spiflash_program(address, &magic, 1);
+  expect(0x1234);
+
+  // the next write goes after it
+  write(0x5678);
+  expect(0x5678);
+}
+
+static void test_erase_cut_short(void) {
+  // fill the sector in use, the last record of it holds the state
+  CHECK(ota_meta_read(&meta));
+  uint16_t generation = meta.generation;
+  uint16_t i = 0;
+  while (meta.generation == generation) {
+    write(++i);
+  }
+  // the write into the other sector never happened, its erase did. Starting
+  // from blank flash, odd generations are in the second sector.
+  spiflash_erase_sector(meta.generation & 1 ? OTA_META_ADDRESS_2 : OTA_META_ADDRESS);
+  expect(i - 1);
+  write(0xBEEF);
+  expect(0xBEEF);
+  CHECK(meta.generation == generation + 1);
+}
+
+int main(void) {
+  test_init();
+  spiflash_init();
+
+  RUN(test_empty);
+  RUN(test_alternate);
+  RUN(test_broken_record);
+  RUN(test_erase_cut_short);
+  return 0;
+}
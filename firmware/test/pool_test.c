@@ -0,0 +1,74 @@
+#include "test.h"
+#include "../src/pool/pool.h"
+#include <string.h>
+
+// pool/pool.c: blocks handed out once each until the pool runs dry, the
+// stats, and queues keeping their order.
+
+static void test_exhaust(void) {
+  PoolBlock __xdata *blocks[POOL_BLOCKS];
+  for (uint8_t i = 0; i < POOL_BLOCKS; i++) {
+    blocks[i] = pool_alloc();
+    CHECK(blocks[i]);
+    for (uint8_t j = 0; j < i; j++) {
+      CHECK(blocks[j] != blocks[i]);
+    }
+    // the whole block is the owner's
+    memset(blocks[i]->packet, i, sizeof(blocks[i]->packet));
+  }
+  CHECK(pool_stats.in_use == POOL_BLOCKS);
+  CHECK(pool_stats.high_water == POOL_BLOCKS);
+
+  CHECK(!pool_alloc());
+  CHECK(pool_stats.alloc_failures == 1);
+  for (uint8_t i = 0; i < POOL_BLOCKS; i++) {
+    CHECK(blocks[i]->packet[0] == i && blocks[i]->packet[sizeof(blocks[i]->packet) - 1] == i);
+    pool_free(blocks[i]);
+  }
+  CHECK(pool_stats.in_use == 0);
+  CHECK(pool_stats.high_water == POOL_BLOCKS);
+
+  // a freed block comes back
+  PoolBlock __xdata *block = pool_alloc();
+  CHECK(block);
+  pool_free(block);
+}
+
+static void test_queue(void) {
+  PoolQueue __xdata queue;
+  PoolBlock __xdata *blocks[3];
+  pool_queue_init(&queue);
+  CHECK(pool_queue_empty(&queue));
+  CHECK(!pool_queue_pop(&queue));
+
+  for (uint8_t i = 0; i < 3; i++) {
+    blocks[i] = pool_alloc();
+    pool_queue_push(&queue, blocks[i]);
+    CHECK(!pool_queue_empty(&queue));
+  }
+  CHECK(pool_queue_pop(&queue) == blocks[0]);
+  // pushed behind what is left
+  pool_queue_push(&queue, blocks[0]);
+  CHECK(pool_queue_pop(&queue) == blocks[1]);
+  CHECK(pool_queue_pop(&queue) == blocks[2]);
+  CHECK(pool_queue_pop(&queue) == blocks[0]);
+  CHECK(pool_queue_empty(&queue));
+  CHECK(!pool_queue_pop(&queue));
+
+  // emptied, the queue takes blocks again
+  pool_queue_push(&queue, blocks[1]);
+  CHECK(pool_queue_pop(&queue) == blocks[1]);
+  for (uint8_t i = 0; i < 3; i++) {
+    pool_free(blocks[i]);
+  }
+  CHECK(pool_stats.in_use == 0);
+}
+
+int main(void) {
+  test_init();
+  pool_init();
+
+  RUN(test_exhaust);
+  RUN(test_queue);
+  return 0;
+}
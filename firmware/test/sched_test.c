@@ -0,0 +1,103 @@
+#include "test.h"
+#include "../src/sched/sched.h"
+#include <string.h>
+
+// sched/sched.c: events run in the order they were posted, one that is
+// already queued is not queued twice, and a handler may post again.
+
+static uint8_t ran[16];
+static uint8_t ran_count;
+
+static void run_all(void) {
+  ran_count = 0;
+  while (sched_step()) {
+  }
+}
+
+static void expect_ran(const uint8_t *events, uint8_t count) {
+  CHECK(ran_count == count);
+  CHECK(!memcmp(ran, events, count));
+}
+
+static void on_ready(void) {
+  ran[ran_count++] = EVENT_EPD_READY;
+}
+
+static void on_step(void) {
+  ran[ran_count++] = EVENT_EPD_STEP;
+}
+
+// posts itself once more, and the step
+static void on_field(void) {
+  ran[ran_count++] = EVENT_NFC_FIELD;
+  if (ran_count < 3) {
+    sched_post(EVENT_NFC_FIELD);
+    sched_post(EVENT_EPD_STEP);
+  }
+}
+
+static void test_order(void) {
+  sched_post(EVENT_NFC_FIELD);
+  sched_post(EVENT_EPD_READY);
+  sched_post_isr(EVENT_EPD_STEP);
+  sched_handle(EVENT_NFC_FIELD, on_ready);
+  run_all();
+  // the handler is looked up when the event runs
+  static const uint8_t expected[] = {EVENT_EPD_READY, EVENT_EPD_READY, EVENT_EPD_STEP};
+  expect_ran(expected, sizeof(expected));
+  sched_handle(EVENT_NFC_FIELD, on_field);
+}
+
+static void test_coalesce(void) {
+  sched_post(EVENT_EPD_STEP);
+  sched_post(EVENT_EPD_READY);
+  sched_post(EVENT_EPD_STEP);
+  sched_post_isr(EVENT_EPD_READY);
+  run_all();
+  static const uint8_t expected[] = {EVENT_EPD_STEP, EVENT_EPD_READY};
+  expect_ran(expected, sizeof(expected));
+}
+
+static void test_post_from_handler(void) {
+  sched_post(EVENT_NFC_FIELD);
+  sched_post(EVENT_EPD_READY);
+  run_all();
+  // taken off the queue before it runs, an event can post itself again
+  static const uint8_t expected[] = {EVENT_NFC_FIELD, EVENT_EPD_READY, EVENT_NFC_FIELD, EVENT_EPD_STEP};
+  expect_ran(expected, sizeof(expected));
+}
+
+static void test_no_handler(void) {
+  sched_post(EVENT_RADIO_RX);
+  sched_post(EVENT_EPD_STEP);
+  run_all();
+  static const uint8_t expected[] = {EVENT_EPD_STEP};
+  expect_ran(expected, sizeof(expected));
+}
+
+// every event at once fits the queue, many times over
+static void test_full(void) {
+  for (uint8_t round = 0; round < 20; round++) {
+    for (uint8_t event = EVENT_EPD_READY; event <= EVENT_EPD_STEP; event++) {
+      sched_post(event);
+      sched_post(event);
+    }
+    run_all();
+    static const uint8_t expected[] = {EVENT_EPD_READY, EVENT_EPD_STEP};
+    expect_ran(expected, sizeof(expected));
+  }
+}
+
+int main(void) {
+  test_init();
+  sched_init();
+  sched_handle(EVENT_EPD_READY, on_ready);
+  sched_handle(EVENT_EPD_STEP, on_step);
+
+  RUN(test_order);
+  RUN(test_coalesce);
+  RUN(test_post_from_handler);
+  RUN(test_no_handler);
+  RUN(test_full);
+  return 0;
+}
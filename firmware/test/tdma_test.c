@@ -0,0 +1,129 @@
+#include "test.h"
+#include "../src/command/command.h"
+#include "../src/command/commands.h"
+#include "../src/hal/dma.h"
+#include "../src/hal/radio.h"
+#include "../src/hal/spiflash.h"
+#include "../src/hal/time.h"
+#include "../src/kv/kv.h"
+#include "../src/sched/sched.h"
+#include "../src/tdma/tdma.h"
+#include <string.h>
+
+// tdma/tdma.c as a member, against beacons of a coordinator whose sleep
+// timer runs fast: the drift is measured from the first beacon of the own
+// slot, refined by the next, saved, and narrows the listen window. The
+// beacons are handed to tdma_receive with the arrival time the radio would
+// have stamped, so the drift comes out exact.
+
+#define ADDRESS 0x21
+#define OWN_SLOT 0
+#define FRAME 10
+#define SLOT_TICKS TIME_MS_TO_TICKS(TDMA_SLOT_MS)
+#define FRAME_TICKS TIME_MS_TO_TICKS((uint32_t)TDMA_SLOTS * TDMA_SLOT_MS)
+#define TIMEOUT_MS (2 * TDMA_SLOTS * TDMA_SLOT_MS)
+
+// each of the coordinator's frames ends this many of the member's ticks early
+#define ERROR_TICKS (-53)
+#define DRIFT ((int32_t)ERROR_TICKS * 1024 / (int32_t)(FRAME_TICKS >> 10))
+
+static uint32_t last_arrival;
+
+static void command(uint8_t id, uint8_t a, uint8_t b, uint8_t c, uint8_t *reply) {
+  static uint8_t __xdata request[COMMAND_REQUEST_HEADER + 3];
+  static uint8_t __xdata out[64];
+  request[0] = id;
+  request[COMMAND_REQUEST_HEADER] = a;
+  request[COMMAND_REQUEST_HEADER + 1] = b;
+  request[COMMAND_REQUEST_HEADER + 2] = c;
+  command_execute(request, sizeof(request), out);
+  CHECK(out[3] == STATUS_OK);
+  if (reply) {
+    memcpy(reply, out + COMMAND_REPLY_HEADER, sizeof(out) - COMMAND_REPLY_HEADER);
+  }
+}
+
+static uint8_t state(void) {
+  uint8_t reply[60];
+  command(COMMAND_TDMA_STATUS, 0, 0, 0, reply);
+  return reply[0];
+}
+
+// a beacon that ended at the given tick, once that has passed
+static void beacon(uint16_t frame, uint8_t slot, uint32_t at) {
+  RUN_UNTIL((int32_t)(time_ticks() - at) >= 0, TIMEOUT_MS);
+  PoolBlock __xdata *block = pool_alloc();
+  CHECK(block);
+  block->data[0] = TDMA_BEACON;
+  block->data[1] = frame;
+  block->data[2] = frame >> 8;
+  block->data[3] = slot;
+  block->length = TDMA_BEACON_HEADER;
+  radio_rx_info.stamp = at;
+  CHECK(!tdma_receive(block));
+  pool_free(block);
+  last_arrival = at;
+}
+
+static void test_first_drift(void) {
+  command(COMMAND_TDMA_ASSIGN, OWN_SLOT, 0, 0, NULL);
+  CHECK(state() == TDMA_SEARCH);
+  // the last slot of a frame, the own slot comes next
+  beacon(FRAME, TDMA_SLOTS - 1, time_ticks());
+  CHECK(state() == TDMA_SLEEP);
+  uint32_t predicted = last_arrival - (TDMA_SLOTS - 1) * SLOT_TICKS + FRAME_TICKS;
+
+  RUN_UNTIL(state() == TDMA_WINDOW, TIMEOUT_MS);
+  uint16_t window = tdma_stats.window;
+  beacon(FRAME + 1, OWN_SLOT, predicted + ERROR_TICKS);
+  CHECK(state() == TDMA_SLEEP);
+  CHECK(tdma_stats.beacons == 1 && !tdma_stats.misses);
+  CHECK(tdma_stats.drift == DRIFT);
+
+  // saved for after a reset, calibrated
+  uint8_t __xdata saved[6];
+  CHECK(kv_get(KV_TDMA, saved, sizeof(saved)) == sizeof(saved));
+  CHECK(saved[3] == 1);
+  CHECK((int16_t)(saved[4] | saved[5] << 8) == DRIFT);
+
+  // the next window is narrower
+  RUN_UNTIL(state() == TDMA_WINDOW, TIMEOUT_MS);
+  CHECK(tdma_stats.window < window);
+}
+
+// what is left of the error after the correction counts half
+static void test_refined(void) {
+  int32_t correction = (int32_t)(FRAME_TICKS >> 10) * DRIFT / 1024;
+  int32_t left = ERROR_TICKS - correction;
+  beacon(FRAME + 2, OWN_SLOT, last_arrival + FRAME_TICKS + ERROR_TICKS);
+  CHECK(tdma_stats.beacons == 2 && !tdma_stats.misses);
+  CHECK(tdma_stats.drift == DRIFT + left * 1024 / (int32_t)(FRAME_TICKS >> 10) / 2);
+}
+
+// back from a reset the member starts out with what it saved: the first
+// measurement, the refinement was too small to be saved again
+static void test_restored(void) {
+  CHECK(tdma_stats.drift != DRIFT);
+  tdma_init(ADDRESS);
+  CHECK(state() == TDMA_SEARCH);
+  CHECK(tdma_stats.drift == DRIFT);
+  command(COMMAND_TDMA_ASSIGN, 0xFF, 0, 0, NULL);
+  CHECK(state() == TDMA_OFF);
+}
+
+int main(void) {
+  test_init();
+  time_init();
+  sched_init();
+  dma_init();
+  spiflash_init();
+  kv_init();
+  pool_init();
+  radio_init(ADDRESS);
+  tdma_init(ADDRESS);
+
+  RUN(test_first_drift);
+  RUN(test_refined);
+  RUN(test_restored);
+  return 0;
+}
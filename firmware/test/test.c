@@ -0,0 +1,27 @@
+#define _GNU_SOURCE
+#include "test.h"
+#include "nt3h2111.h"
+#include "w25x10.h"
+#include "../src/hal/hal.h"
+#include "../src/sched/sched.h"
+#include <sys/mman.h>
+
+// sim/host.c restarts the process, a test has nothing to restart into
+void cc2510_reset(void) {
+  fprintf(stderr, "watchdog reset\n");
+  exit(1);
+}
+
+void test_init(void) {
+  cc2510_init();
+  w25x10_model_init(memfd_create("w25x10", 0));
+  nt3h_model_init();
+  HAL_ENABLE_INTERRUPTS();
+}
+
+void test_step(void) {
+  while (sched_step()) {
+  }
+  usart1_model_poll(0);
+  cc2510_interrupts();
+}
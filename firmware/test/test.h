@@ -0,0 +1,52 @@
+#ifndef _TEST_TEST_H_
+#define _TEST_TEST_H_
+
+#include "cc2510.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Host tests, see make test. A test is a program that drives the firmware
+// through the register model in sim/ and exits non-zero on the first failed
+// check. test.c starts the model, the test then calls the drivers itself:
+// there is no scheduler loop unless the test runs one.
+
+// the Makefile renames main() in every file, for src/main.c
+#undef main
+
+#define CHECK(condition)                                                                                              \
+  do {                                                                                                                \
+    if (!(condition)) {                                                                                               \
+      fprintf(stderr, "%s:%d: %s failed\n", __FILE__, __LINE__, #condition);                                          \
+      exit(1);                                                                                                        \
+    }                                                                                                                 \
+  } while (0)
+
+// runs a test function and reports it
+#define RUN(test)                                                                                                     \
+  do {                                                                                                                \
+    test();                                                                                                           \
+    printf("ok %s\n", #test);                                                                                         \
+  } while (0)
+
+// registers to their reset values and the models that are not per test
+// (flash in memory, NFC tag) attached, interrupts enabled
+void test_init(void);
+
+// runs the queued events, then delivers what the serial link received and
+// runs the pending interrupts
+void test_step(void);
+
+// steps until condition holds, fails the test after timeout_ms
+#define RUN_UNTIL(condition, timeout_ms)                                                                              \
+  do {                                                                                                                \
+    uint64_t deadline = cc2510_now() + (uint64_t)(timeout_ms) * 1000000;                                              \
+    while (!(condition)) {                                                                                            \
+      if (cc2510_now() > deadline) {                                                                                  \
+        fprintf(stderr, "%s:%d: %s timed out\n", __FILE__, __LINE__, #condition);                                     \
+        exit(1);                                                                                                      \
+      }                                                                                                               \
+      test_step();                                                                                                    \
+    }                                                                                                                 \
+  } while (0)
+
+#endif
@@ -0,0 +1,150 @@
+#include "test.h"
+#include "../src/display/bitmap.h"
+#include "../src/display/text.h"
+#include <string.h>
+
+// display/text.c with the atlases in atlas.c, drawn through bitmap_blit as
+// display/label.c does: a line drawn band by band comes out as drawn whole,
+// at any pixel offset, run length coded glyphs as stored, the measured
+// width where the ink ends, and '?' for a missing character.
+
+#define STRIDE 32 // 256 pixels
+#define ROWS 48
+#define BAND_ROWS 8
+
+static uint8_t __xdata canvas[ROWS * STRIDE];
+static uint8_t __xdata whole[ROWS * STRIDE];
+static char __xdata text[16];
+static uint16_t clip_y0, clip_y1;
+
+static bool pixel(const uint8_t *bits, uint8_t stride, uint16_t x, uint16_t y) {
+  return bits[y * stride + x / 8] & (0x80 >> (x & 7));
+}
+
+// TextBlit, clipped to the rows being drawn
+static void blit(void) {
+  uint16_t y0 = text_blit_call.y > clip_y0 ? text_blit_call.y : clip_y0;
+  uint16_t y1 = text_blit_call.y + text_blit_call.rows;
+  if (y1 > clip_y1) {
+    y1 = clip_y1;
+  }
+  if (y0 < y1) {
+    bitmap_blit(canvas + y0 * STRIDE, STRIDE, text_blit_call.x, text_blit_call.bits, 0, 0, text_blit_call.width,
+                y1 - y0, true);
+  }
+}
+
+static uint16_t draw(uint8_t atlas, uint16_t x, const char *s, uint16_t y0, uint16_t y1) {
+  uint8_t length = strlen(s);
+  memcpy(text, s, length);
+  clip_y0 = y0;
+  clip_y1 = y1;
+  return text_draw(atlas, x, 0, text, length, y0, y1, blit);
+}
+
+static void draw_whole(uint8_t atlas, uint16_t x, const char *s) {
+  memset(canvas, 0, sizeof(canvas));
+  uint16_t pen = draw(atlas, x, s, 0, ROWS);
+  CHECK(pen == x + text_advance(atlas, text, strlen(s)));
+}
+
+static uint16_t ink(void) {
+  uint16_t count = 0;
+  for (uint16_t i = 0; i < sizeof(canvas); i++) {
+    count += __builtin_popcount(canvas[i]);
+  }
+  return count;
+}
+
+static void test_bands(void) {
+  static const char *lines[] = {"Hello, World!", "4.99", "12:30"};
+  for (uint8_t atlas = 0; atlas < text_atlas_count; atlas++) {
+    CHECK(text_height(atlas) <= ROWS);
+    draw_whole(atlas, 3, lines[atlas]);
+    CHECK(ink());
+    memcpy(whole, canvas, sizeof(canvas));
+    memset(canvas, 0, sizeof(canvas));
+    for (uint16_t y = 0; y < ROWS; y += BAND_ROWS) {
+      draw(atlas, 3, lines[atlas], y, y + BAND_ROWS);
+    }
+    CHECK(!memcmp(canvas, whole, sizeof(canvas)));
+  }
+}
+
+static void test_offsets(void) {
+  draw_whole(0, 0, "Wavy");
+  memcpy(whole, canvas, sizeof(canvas));
+  for (uint8_t offset = 1; offset < 8; offset++) {
+    draw_whole(0, offset, "Wavy");
+    for (uint16_t y = 0; y < ROWS; y++) {
+      for (uint16_t x = 0; x + offset < 8 * STRIDE; x++) {
+        CHECK(pixel(canvas, STRIDE, x + offset, y) == pixel(whole, STRIDE, x, y));
+      }
+    }
+  }
+}
+
+// 'F' is stored as runs of equal rows, its stem in one
+static void test_rle(void) {
+  const FontAtlas *atlas = &text_atlases[0];
+  const FontGlyph *glyph = &atlas->glyphs['F' - atlas->first];
+  CHECK(glyph->offset & FONT_GLYPH_RLE);
+  draw_whole(0, 8, "F");
+
+  const uint8_t *bits = atlas->bitmaps + (glyph->offset & ~FONT_GLYPH_RLE);
+  uint8_t row_bytes = (glyph->width + 7) / 8;
+  uint8_t y = glyph->top;
+  while (y < glyph->top + glyph->height) {
+    uint8_t repeat = *bits++;
+    for (; repeat; repeat--, y++) {
+      for (uint8_t x = 0; x < glyph->width; x++) {
+        CHECK(pixel(canvas, STRIDE, 8 + glyph->left + x, y) == pixel(bits, row_bytes, x, 0));
+      }
+    }
+    bits += row_bytes;
+  }
+  CHECK(y == glyph->top + glyph->height);
+  // and nothing outside its box
+  uint16_t inside = 0;
+  for (uint8_t gy = 0; gy < glyph->height; gy++) {
+    for (uint8_t gx = 0; gx < glyph->width; gx++) {
+      inside += pixel(canvas, STRIDE, 8 + glyph->left + gx, glyph->top + gy);
+    }
+  }
+  CHECK(inside == ink());
+}
+
+static void test_width(void) {
+  draw_whole(0, 8, "Hello");
+  uint16_t right = 0;
+  for (uint16_t y = 0; y < ROWS; y++) {
+    for (uint16_t x = 0; x < 8 * STRIDE; x++) {
+      if (pixel(canvas, STRIDE, x, y) && x + 1 > right) {
+        right = x + 1;
+      }
+    }
+  }
+  memcpy(text, "Hello", 5);
+  CHECK(right == 8 + text_width(0, text, 5));
+}
+
+static void test_missing(void) {
+  draw_whole(0, 8, "?");
+  memcpy(whole, canvas, sizeof(canvas));
+  draw_whole(0, 8, "\x01");
+  CHECK(!memcmp(canvas, whole, sizeof(canvas)));
+  // the digit atlases have no '?', the character is left out
+  draw_whole(1, 8, "A");
+  CHECK(!ink());
+}
+
+int main(void) {
+  test_init();
+
+  RUN(test_bands);
+  RUN(test_offsets);
+  RUN(test_rle);
+  RUN(test_width);
+  RUN(test_missing);
+  return 0;
+}
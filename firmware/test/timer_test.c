@@ -0,0 +1,109 @@
+#include "test.h"
+#include "../src/hal/time.h"
+#include "../src/sched/sched.h"
+#include "../src/sched/timer.h"
+
+// sched/timer.c on the sleep timer model: deadlines in order across rounds
+// of the wheel, a later start that comes first, a stopped timer that was
+// the nearest, and a timer restarted from its own callback.
+
+#define TIMEOUT_MS 200
+
+static Timer __xdata timers[3];
+static uint8_t fired[8];
+static uint32_t fired_at[8];
+static uint8_t fired_count;
+static uint32_t started_at;
+
+static void fire(uint8_t index) {
+  fired_at[fired_count] = millis();
+  fired[fired_count++] = index;
+}
+
+static void on_0(void) {
+  fire(0);
+}
+
+static void on_1(void) {
+  fire(1);
+}
+
+static void on_2(void) {
+  fire(2);
+}
+
+static void on_periodic(void) {
+  fire(0);
+  if (fired_count < 4) {
+    timer_start(&timers[0], 5, on_periodic);
+  }
+}
+
+static void reset(void) {
+  fired_count = 0;
+  started_at = millis();
+}
+
+static void expect_fired(uint8_t index, uint8_t nth, uint16_t delay) {
+  CHECK(fired[nth] == index);
+  CHECK(fired_at[nth] - started_at >= delay);
+}
+
+static void test_order(void) {
+  reset();
+  timer_start(&timers[2], 30, on_2);
+  timer_start(&timers[0], 10, on_0);
+  timer_start(&timers[1], 20, on_1);
+  RUN_UNTIL(fired_count == 3, TIMEOUT_MS);
+  expect_fired(0, 0, 10);
+  expect_fired(1, 1, 20);
+  expect_fired(2, 2, 30);
+  CHECK(time_until_alarm() == TIME_NO_ALARM);
+}
+
+static void test_earlier_start(void) {
+  reset();
+  timer_start(&timers[0], 100, on_0);
+  timer_start(&timers[1], 5, on_1);
+  // the alarm moved up to the new nearest deadline
+  CHECK(time_until_alarm() <= TIME_MS_TO_TICKS(5));
+  RUN_UNTIL(fired_count == 1, TIMEOUT_MS);
+  expect_fired(1, 0, 5);
+  CHECK(fired_at[0] - started_at < 100);
+  RUN_UNTIL(fired_count == 2, TIMEOUT_MS);
+  expect_fired(0, 1, 100);
+}
+
+static void test_stop_nearest(void) {
+  reset();
+  timer_start(&timers[0], 5, on_0);
+  timer_start(&timers[1], 40, on_1);
+  timer_stop(&timers[0]);
+  // the alarm for the stopped timer finds nothing due and moves on
+  RUN_UNTIL(fired_count == 1, TIMEOUT_MS);
+  expect_fired(1, 0, 40);
+  CHECK(!timers[0].active);
+}
+
+static void test_periodic(void) {
+  reset();
+  timer_start(&timers[0], 5, on_periodic);
+  RUN_UNTIL(fired_count == 4, TIMEOUT_MS);
+  for (uint8_t i = 0; i < 4; i++) {
+    expect_fired(0, i, 5 * (i + 1));
+  }
+  CHECK(time_until_alarm() == TIME_NO_ALARM);
+}
+
+int main(void) {
+  test_init();
+  time_init();
+  sched_init();
+  timer_init();
+
+  RUN(test_order);
+  RUN(test_earlier_start);
+  RUN(test_stop_nearest);
+  RUN(test_periodic);
+  return 0;
+}
@@ -0,0 +1,328 @@
+#define _GNU_SOURCE
+#include "test.h"
+#include "../src/cobs/cobs.h"
+#include "../src/hal/crc.h"
+#include "../src/hal/dma.h"
+#include "../src/hal/spiflash.h"
+#include "../src/hal/time.h"
+#include "../src/hal/uart.h"
+#include "../src/kv/kv.h"
+#include "../src/sched/sched.h"
+#include "../src/transport/transport.h"
+#include <fcntl.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+// transport/transport.c against a gateway played by the test on the other
+// end of the USART1 model: delivery in order across loss and reordering,
+// duplicates, retransmission and its cap, and a restart of either side.
+
+#define TIMEOUT_MS 200
+#define FAIL_MS ((TRANSPORT_MAX_RETRIES + 2) * TRANSPORT_RTO_MS + TIMEOUT_MS)
+
+typedef struct {
+  uint8_t flags;
+  uint8_t seq;
+  uint8_t ack;
+  uint8_t sack;
+  uint8_t payload[TRANSPORT_MAX_PAYLOAD];
+  uint8_t length;
+} Frame;
+
+static int host;
+static uint8_t host_rx[1024];
+static uint16_t host_rx_length;
+static Frame got; // the last frame from the tag
+static uint8_t host_next; // next seq of the gateway
+static uint8_t host_ack; // what the gateway expects from the tag
+static char delivered[64];
+static uint8_t delivered_length;
+
+static bool on_payload(void) {
+  memcpy(delivered + delivered_length, transport_rx.data, transport_rx.length);
+  delivered_length += transport_rx.length;
+  delivered[delivered_length] = 0;
+  return true;
+}
+
+// what main.c's link task does, run on every step
+static void step(void) {
+  test_step();
+  cobs_rx_poll();
+  while (cobs_rx_frame_ready()) {
+    transport_receive(cobs_rx_frame());
+  }
+  transport_poll();
+}
+
+// header, payload and big endian CRC, COBS encoded with its delimiter
+static void host_send(uint8_t flags, uint8_t seq, const char *payload) {
+  uint8_t data[TRANSPORT_HEADER_SIZE + TRANSPORT_MAX_PAYLOAD + TRANSPORT_CRC_SIZE] = {
+      flags | TRANSPORT_FLAG_ACK, seq, host_ack, 0};
+  uint8_t length = TRANSPORT_HEADER_SIZE;
+  if (payload) {
+    memcpy(data + length, payload, strlen(payload));
+    length += strlen(payload);
+  }
+  CRC16_INIT(0);
+  for (uint8_t i = 0; i < length; i++) {
+    CRC16_UPDATE(data[i]);
+  }
+  uint16_t crc = CRC16_VALUE();
+  data[length++] = crc >> 8;
+  data[length++] = crc;
+
+  uint8_t frame[sizeof(data) + 2];
+  uint16_t code_at = 0, size = 1;
+  uint8_t code = 1;
+  for (uint8_t i = 0; i < length; i++) {
+    if (data[i]) {
+      frame[size++] = data[i];
+      code++;
+    } else {
+      frame[code_at] = code;
+      code_at = size++;
+      code = 1;
+    }
+  }
+  frame[code_at] = code;
+  frame[size++] = 0;
+  CHECK(write(host, frame, size) == size);
+}
+
+static void host_data(uint8_t seq, const char *payload, bool syn) {
+  host_send(TRANSPORT_FLAG_DATA | (syn ? TRANSPORT_FLAG_SYN : 0), seq, payload);
+}
+
+static void host_acknowledge(void) {
+  host_send(0, 0, NULL);
+}
+
+// a frame from the tag into got, false while none is complete
+static bool tag_frame(void) {
+  step();
+  ssize_t count = read(host, host_rx + host_rx_length, sizeof(host_rx) - host_rx_length);
+  if (count > 0) {
+    host_rx_length += count;
+  }
+  uint8_t *end = memchr(host_rx, 0, host_rx_length);
+  if (!end) {
+    return false;
+  }
+
+  uint8_t data[sizeof(host_rx)];
+  uint16_t length = 0;
+  for (uint8_t *p = host_rx; p < end;) {
+    uint8_t code = *p++;
+    for (uint8_t i = 1; i < code; i++) {
+      data[length++] = *p++;
+    }
+    if (code < 0xFF && p < end) {
+      data[length++] = 0;
+    }
+  }
+  uint16_t used = end + 1 - host_rx;
+  memmove(host_rx, end + 1, host_rx_length - used);
+  host_rx_length -= used;
+
+  CRC16_INIT(0);
+  for (uint16_t i = 0; i < length; i++) {
+    CRC16_UPDATE(data[i]);
+  }
+  CHECK(length >= TRANSPORT_HEADER_SIZE + TRANSPORT_CRC_SIZE && CRC16_VALUE() == 0);
+  got.flags = data[0];
+  got.seq = data[1];
+  got.ack = data[2];
+  got.sack = data[3];
+  got.length = length - TRANSPORT_HEADER_SIZE - TRANSPORT_CRC_SIZE;
+  memcpy(got.payload, data + TRANSPORT_HEADER_SIZE, got.length);
+  return true;
+}
+
+// nothing left to send, what the tag sent meanwhile is read and dropped
+static bool idle(void) {
+  while (tag_frame()) {
+  }
+  return transport_idle();
+}
+
+// waits for the tag's ack of what the gateway sent
+static void expect_ack(uint8_t ack, uint8_t sack) {
+  RUN_UNTIL(tag_frame() && !(got.flags & TRANSPORT_FLAG_DATA), TIMEOUT_MS);
+  CHECK(got.ack == ack);
+  CHECK(got.sack == sack);
+}
+
+static void expect_delivered(const char *payload) {
+  CHECK(!strcmp(delivered, payload));
+  delivered_length = 0;
+  delivered[0] = 0;
+}
+
+static void expect_data(const char *payload, bool syn) {
+  RUN_UNTIL(tag_frame() && (got.flags & TRANSPORT_FLAG_DATA), TIMEOUT_MS);
+  CHECK(got.length == strlen(payload) && !memcmp(got.payload, payload, got.length));
+  CHECK(!(got.flags & TRANSPORT_FLAG_SYN) == !syn);
+}
+
+static void test_first_contact(void) {
+  // the first start numbers from 0
+  uint8_t __xdata start;
+  CHECK(kv_get(KV_TRANSPORT, &start, 1) == 1 && start == 0);
+  host_next = 0xF0;
+  host_data(host_next++, "a", true);
+  expect_ack(host_next, 0);
+  expect_delivered("a");
+
+  // the tag's own frames carry SYN until the gateway acknowledges them
+  CHECK(transport_send((const uint8_t *)"x", 1));
+  expect_data("x", true);
+  CHECK(got.seq == 0);
+  host_ack = got.seq + 1;
+  host_acknowledge();
+  RUN_UNTIL(idle(), TIMEOUT_MS);
+  CHECK(transport_send((const uint8_t *)"y", 1));
+  expect_data("y", false);
+  host_ack = got.seq + 1;
+  host_acknowledge();
+  RUN_UNTIL(idle(), TIMEOUT_MS);
+}
+
+static void test_loss_reorder(void) {
+  uint8_t seq = host_next;
+  host_next += 3;
+  // seq is lost, the next two arrive out of order: held back and sacked
+  host_data(seq + 2, "d", false);
+  expect_ack(seq, 0x02);
+  host_data(seq + 1, "c", false);
+  expect_ack(seq, 0x03);
+  CHECK(!delivered_length);
+  host_data(seq, "b", false);
+  expect_ack(host_next, 0);
+  expect_delivered("bcd");
+}
+
+static void test_duplicate(void) {
+  uint16_t dropped = transport_stats.rx_dropped;
+  host_data(host_next - 1, "d", false);
+  expect_ack(host_next, 0);
+  CHECK(!delivered_length);
+  CHECK(transport_stats.rx_dropped == dropped + 1);
+}
+
+static void test_retransmit(void) {
+  uint16_t retransmits = transport_stats.tx_retransmits;
+  CHECK(transport_send((const uint8_t *)"z", 1));
+  expect_data("z", false);
+  uint8_t seq = got.seq;
+  expect_data("z", false);
+  CHECK(got.seq == seq);
+  CHECK(transport_stats.tx_retransmits == retransmits + 1);
+  host_ack = seq + 1;
+  host_acknowledge();
+  RUN_UNTIL(idle(), TIMEOUT_MS);
+}
+
+// the gateway restarts and happens to pick numbers just behind the old ones,
+// which the tag would otherwise drop as late duplicates
+static void test_gateway_restart(void) {
+  CHECK(transport_send((const uint8_t *)"old", 3));
+  expect_data("old", false);
+  host_next -= 2;
+  host_data(host_next++, "e", true);
+  expect_ack(host_next, 0);
+  expect_delivered("e");
+  // "old" was meant for the previous gateway, it is dropped, the tag starts
+  // over with SYN
+  CHECK(idle());
+  CHECK(transport_send((const uint8_t *)"new", 3));
+  expect_data("new", true);
+  host_ack = got.seq + 1;
+  host_acknowledge();
+  RUN_UNTIL(idle(), TIMEOUT_MS);
+  // SYN frames the gateway resends before it hears from the tag are the
+  // same session
+  host_data(host_next - 1, "e", true);
+  expect_ack(host_next, 0);
+  CHECK(!delivered_length);
+  host_data(host_next++, "f", false);
+  expect_ack(host_next, 0);
+  expect_delivered("f");
+}
+
+// the tag restarts, the gateway still expects the old numbering
+static void test_tag_restart(void) {
+  transport_init(on_payload);
+  uint8_t __xdata start;
+  CHECK(kv_get(KV_TRANSPORT, &start, 1) == 1 && start == 0x80);
+  CHECK(transport_send((const uint8_t *)"g", 1));
+  expect_data("g", true);
+  CHECK(got.seq == 0x80);
+  host_ack = got.seq + 1;
+  host_acknowledge();
+  RUN_UNTIL(idle(), TIMEOUT_MS);
+  // and the tag follows the gateway, whose frames do not match its numbering
+  // any more, once they carry SYN
+  host_data(host_next++, "h", false);
+  expect_ack(0, 0);
+  CHECK(!delivered_length);
+  host_next = 0x10;
+  host_data(host_next++, "i", true);
+  expect_ack(host_next, 0);
+  expect_delivered("i");
+}
+
+static void test_link_failure(void) {
+  // following the gateway's SYN above started the tag's numbering over
+  CHECK(transport_send((const uint8_t *)"j", 1));
+  expect_data("j", true);
+  host_ack = got.seq + 1;
+  host_acknowledge();
+  RUN_UNTIL(idle(), TIMEOUT_MS);
+
+  uint16_t failures = transport_stats.link_failures;
+  uint16_t retransmits = transport_stats.tx_retransmits;
+  CHECK(transport_send((const uint8_t *)"k", 1));
+  expect_data("k", false);
+  RUN_UNTIL(idle(), FAIL_MS);
+  CHECK(transport_stats.link_failures == failures + 1);
+  CHECK(transport_stats.tx_retransmits == retransmits + TRANSPORT_MAX_RETRIES);
+  // what comes next starts over with SYN
+  CHECK(transport_send((const uint8_t *)"l", 1));
+  expect_data("l", true);
+  host_ack = got.seq + 1;
+  host_acknowledge();
+  RUN_UNTIL(idle(), TIMEOUT_MS);
+}
+
+int main(void) {
+  test_init();
+  time_init();
+  sched_init();
+  pool_init();
+  dma_init();
+  uart_init();
+  spiflash_init();
+  kv_init();
+  transport_init(on_payload);
+  cobs_rx_init();
+
+  int model = posix_openpt(O_RDWR | O_NOCTTY);
+  CHECK(model >= 0 && !grantpt(model) && !unlockpt(model));
+  host = open(ptsname(model), O_RDWR | O_NOCTTY | O_NONBLOCK);
+  struct termios raw;
+  CHECK(host >= 0 && !tcgetattr(host, &raw));
+  cfmakeraw(&raw);
+  CHECK(!tcsetattr(host, TCSANOW, &raw));
+  usart1_model_attach(model);
+
+  RUN(test_first_contact);
+  RUN(test_loss_reorder);
+  RUN(test_duplicate);
+  RUN(test_retransmit);
+  RUN(test_gateway_restart);
+  RUN(test_tag_restart);
+  RUN(test_link_failure);
+  return 0;
+}
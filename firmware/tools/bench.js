@@ -0,0 +1,125 @@
+#!/usr/bin/env node
+// Runs the kernel benchmarks of firmware/bench under s51 and prints one JSON
+// object per line, for regression tracking: {kernel, cycles} for each
+// benchmark, then {function, module, bytes} for everything in code memory of
+// the firmware image.
+//   node bench.js <bench.ihx> <bench.map> <results address> <firmware.map>
+const { spawnSync } = require("child_process");
+const fs = require("fs");
+
+const [ihx, benchMap, resultsAddress, firmwareMap] = process.argv.slice(2);
+if (!firmwareMap) {
+  console.error(
+    "usage: bench.js <bench.ihx> <bench.map> <results address> <firmware.map>"
+  );
+  process.exit(1);
+}
+
+// must match BenchData and BenchResult in bench/kernels.c
+const NAME_SIZE = 12;
+const RESULT_SIZE = NAME_SIZE + 4;
+const MAX_RESULTS = 16;
+
+// code memory symbols of an aslink map by area, with their size up to the
+// next symbol or the end of the area
+function codeSymbols(file) {
+  const symbols = [];
+  let area;
+  let pending = [];
+  const close = () => {
+    pending.sort((a, b) => a.address - b.address);
+    pending.forEach((symbol, i) => {
+      const next = pending[i + 1]?.address ?? area.address + area.size;
+      symbols.push({ ...symbol, bytes: next - symbol.address });
+    });
+    pending = [];
+  };
+  for (const line of fs.readFileSync(file, "utf8").split("\n")) {
+    const header = line.match(/^(\w+)\s+([0-9A-F]{8})\s+([0-9A-F]{8})\s+=/i);
+    if (header) {
+      if (area) {
+        close();
+      }
+      area = {
+        name: header[1],
+        address: parseInt(header[2], 16),
+        size: parseInt(header[3], 16),
+      };
+      continue;
+    }
+    const symbol = line.match(/^\s*C:\s+([0-9A-F]+)\s+(\S+)\s+(\S+)/i);
+    if (symbol && area) {
+      pending.push({
+        name: symbol[2],
+        module: symbol[3],
+        address: parseInt(symbol[1], 16),
+      });
+    }
+  }
+  if (area) {
+    close();
+  }
+  return symbols;
+}
+
+function address(symbols, name) {
+  const symbol = symbols.find((s) => s.name === name);
+  if (!symbol) {
+    throw new Error(`${name} not in ${benchMap}`);
+  }
+  return symbol.address;
+}
+
+const hex = (value) => `0x${value.toString(16)}`;
+
+// run to bench_done, then dump the results
+const start = parseInt(resultsAddress, 16);
+const end = start + 1 + MAX_RESULTS * RESULT_SIZE;
+const commands = [
+  `break ${hex(address(codeSymbols(benchMap), "_bench_done"))}`,
+  "run",
+  `dump xram ${hex(start)} ${hex(end - 1)} 16`,
+  "kill",
+  "",
+].join("\n");
+const s51 = spawnSync("s51", ["-t", "8051", ihx], {
+  input: commands,
+  encoding: "utf8",
+  timeout: 120000,
+});
+if (s51.error) {
+  throw s51.error;
+}
+
+// dump lines are an address, 16 bytes in hex and the same as text
+const memory = [];
+for (const line of s51.stdout.split("\n")) {
+  const match = line.match(/(0x[0-9a-f]+)\s+((?:[0-9a-f]{2}\s+)+)/i);
+  if (!match || parseInt(match[1], 16) !== start + memory.length) {
+    continue;
+  }
+  const bytes = match[2].trim().split(/\s+/).slice(0, 16);
+  memory.push(...bytes.slice(0, end - start - memory.length).map((b) => parseInt(b, 16)));
+}
+if (memory.length < end - start) {
+  console.error(s51.stdout);
+  throw new Error("no results from s51");
+}
+
+const data = Buffer.from(memory);
+for (let i = 0; i < data[0]; i++) {
+  const result = data.subarray(1 + i * RESULT_SIZE, 1 + (i + 1) * RESULT_SIZE);
+  const name = result.subarray(0, NAME_SIZE).toString("latin1").replace(/\0.*$/, "");
+  const cycles = result.readUInt32LE(NAME_SIZE);
+  console.log(JSON.stringify({ kernel: name, cycles }));
+}
+
+for (const symbol of codeSymbols(firmwareMap)) {
+  console.log(
+    JSON.stringify({
+      function: symbol.name.replace(/^_/, ""),
+      module: symbol.module,
+      bytes: symbol.bytes,
+    })
+  );
+}
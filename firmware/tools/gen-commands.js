@@ -0,0 +1,48 @@
+#!/usr/bin/env node
+// Generates the gateway's command table from firmware/src/command/commands.h
+//   node gen-commands.js [output]
+const fs = require("fs");
+const path = require("path");
+
+const header = path.join(__dirname, "../src/command/commands.h");
+const output =
+  process.argv[2] ?? path.join(__dirname, "../../gateway-test/src/commands.ts");
+
+const source = fs.readFileSync(header, "utf8");
+
+function list(name) {
+  const match = source.match(
+    new RegExp(`#define ${name}\\(X\\)((?:.*\\\\\\n)*.*)`)
+  );
+  if (!match) {
+    throw new Error(`${name} not found in ${header}`);
+  }
+  return [...match[1].matchAll(/X\(([^)]*)\)/g)].map((m) =>
+    m[1].split(",").map((arg) => arg.trim())
+  );
+}
+
+const commands = list("COMMAND_LIST");
+const statuses = list("STATUS_LIST");
+
+const lines = [
+  "// generated by firmware/tools/gen-commands.js from",
+  "// firmware/src/command/commands.h, do not edit",
+  "",
+  "export enum Command {",
+  ...commands.map(([name], opcode) => `  ${name} = ${opcode},`),
+  "}",
+  "",
+  "export enum Status {",
+  ...statuses.map(([name, value]) => `  ${name} = ${value},`),
+  "}",
+  "",
+  "// minimum argument bytes per command",
+  "export const commandMinArgs: Record<Command, number> = {",
+  ...commands.map(([name, , min]) => `  [Command.${name}]: ${min},`),
+  "};",
+  "",
+];
+
+fs.writeFileSync(output, lines.join("\n"));
+console.log(`${path.relative(process.cwd(), output)}: ${commands.length} commands`);
@@ -0,0 +1,524 @@
+#!/usr/bin/env node
+// Pre-rasterizes the glyph atlases listed in fonts.json for the tag's text
+// blitter, see firmware/src/display/text.h
+//   node gen-fonts.js [--fonts <dir>] [fonts.json]
+// Each entry names a TrueType file, looked up in --fonts (default
+// tools/fonts), a size in pixels per em and the characters to keep. Glyphs
+// are rendered with 4x4 supersampling and kept where the coverage reaches
+// threshold (default 0.5, lower keeps the thin strokes of small sizes
+// whole), trimmed to their ink and stored as byte aligned rows, run-length
+// coded when that is smaller. Kerning comes from the font's kern table,
+// rounded to pixels.
+// Writes src/display/atlas.c and the gateway's src/fonts.ts.
+const fs = require("fs");
+const path = require("path");
+
+const SUPERSAMPLE = 4;
+const MAX_WIDTH = 64; // TEXT_MAX_WIDTH
+const GLYPH_RLE = 0x8000;
+
+function option(name, fallback) {
+  const index = process.argv.indexOf(`--${name}`);
+  if (index < 0) {
+    return fallback;
+  }
+  const [value] = process.argv.splice(index, 2).slice(1);
+  return value;
+}
+
+const fontDir = option("fonts", path.join(__dirname, "fonts"));
+const specFile = process.argv[2] ?? path.join(__dirname, "fonts.json");
+const atlasOutput = path.join(__dirname, "../src/display/atlas.c");
+const gatewayOutput = path.join(__dirname, "../../gateway-test/src/fonts.ts");
+
+// ---- TrueType ----
+
+function parseFont(data) {
+  const tables = {};
+  for (let i = 0, count = data.readUInt16BE(4); i < count; i++) {
+    const entry = 12 + 16 * i;
+    tables[data.toString("latin1", entry, entry + 4)] = data.readUInt32BE(entry + 8);
+  }
+  for (const name of ["head", "hhea", "hmtx", "maxp", "cmap", "loca", "glyf"]) {
+    if (tables[name] === undefined) {
+      throw new Error(`no ${name} table`);
+    }
+  }
+  const head = tables.head;
+  const hhea = tables.hhea;
+  const font = {
+    unitsPerEm: data.readUInt16BE(head + 18),
+    longLoca: data.readInt16BE(head + 50) === 1,
+    ascender: data.readInt16BE(hhea + 4),
+    descender: data.readInt16BE(hhea + 6),
+    hMetrics: data.readUInt16BE(hhea + 34),
+    glyphCount: data.readUInt16BE(tables.maxp + 4),
+  };
+
+  font.advance = (glyph) =>
+    data.readUInt16BE(tables.hmtx + 4 * Math.min(glyph, font.hMetrics - 1));
+
+  font.location = (glyph) =>
+    font.longLoca
+      ? data.readUInt32BE(tables.loca + 4 * glyph)
+      : 2 * data.readUInt16BE(tables.loca + 2 * glyph);
+
+  // format 4 of the Windows Unicode subtable
+  const cmap = tables.cmap;
+  let format4;
+  for (let i = 0, count = data.readUInt16BE(cmap + 2); i < count; i++) {
+    const platform = data.readUInt16BE(cmap + 4 + 8 * i);
+    const encoding = data.readUInt16BE(cmap + 6 + 8 * i);
+    const offset = cmap + data.readUInt32BE(cmap + 8 + 8 * i);
+    if ((platform === 3 && encoding === 1) || platform === 0) {
+      if (data.readUInt16BE(offset) === 4) {
+        format4 = offset;
+        break;
+      }
+    }
+  }
+  if (format4 === undefined) {
+    throw new Error("no format 4 cmap");
+  }
+  font.glyphIndex = (code) => {
+    const segments = data.readUInt16BE(format4 + 6) / 2;
+    const ends = format4 + 14;
+    const starts = ends + 2 * segments + 2;
+    const deltas = starts + 2 * segments;
+    const ranges = deltas + 2 * segments;
+    for (let i = 0; i < segments; i++) {
+      if (code > data.readUInt16BE(ends + 2 * i)) {
+        continue;
+      }
+      const start = data.readUInt16BE(starts + 2 * i);
+      if (code < start) {
+        return 0;
+      }
+      const delta = data.readInt16BE(deltas + 2 * i);
+      const range = data.readUInt16BE(ranges + 2 * i);
+      if (!range) {
+        return (code + delta) & 0xffff;
+      }
+      const glyph = data.readUInt16BE(ranges + 2 * i + range + 2 * (code - start));
+      return glyph ? (glyph + delta) & 0xffff : 0;
+    }
+    return 0;
+  };
+
+  // contours of [x, y, onCurve] points
+  font.contours = (glyph) => {
+    const start = tables.glyf + font.location(glyph);
+    if (font.location(glyph + 1) === font.location(glyph)) {
+      return [];
+    }
+    const contourCount = data.readInt16BE(start);
+    if (contourCount < 0) {
+      return compositeContours(start);
+    }
+    const endPoints = [];
+    for (let i = 0; i < contourCount; i++) {
+      endPoints.push(data.readUInt16BE(start + 10 + 2 * i));
+    }
+    const pointCount = contourCount ? endPoints[contourCount - 1] + 1 : 0;
+    let at = start + 10 + 2 * contourCount;
+    at += 2 + data.readUInt16BE(at); // instructions
+
+    const flags = [];
+    while (flags.length < pointCount) {
+      const flag = data[at++];
+      flags.push(flag);
+      if (flag & 0x08) {
+        for (let repeat = data[at++]; repeat; repeat--) {
+          flags.push(flag);
+        }
+      }
+    }
+    const coordinates = (short, same) => {
+      const values = [];
+      let value = 0;
+      for (const flag of flags) {
+        if (flag & short) {
+          const delta = data[at++];
+          value += flag & same ? delta : -delta;
+        } else if (!(flag & same)) {
+          value += data.readInt16BE(at);
+          at += 2;
+        }
+        values.push(value);
+      }
+      return values;
+    };
+    const xs = coordinates(0x02, 0x10);
+    const ys = coordinates(0x04, 0x20);
+
+    const contours = [];
+    let first = 0;
+    for (const last of endPoints) {
+      const points = [];
+      for (let i = first; i <= last; i++) {
+        points.push([xs[i], ys[i], (flags[i] & 0x01) !== 0]);
+      }
+      contours.push(points);
+      first = last + 1;
+    }
+    return contours;
+  };
+
+  function compositeContours(start) {
+    const contours = [];
+    let at = start + 10;
+    for (;;) {
+      const flags = data.readUInt16BE(at);
+      const component = data.readUInt16BE(at + 2);
+      at += 4;
+      let dx;
+      let dy;
+      if (flags & 0x0001) {
+        dx = data.readInt16BE(at);
+        dy = data.readInt16BE(at + 2);
+        at += 4;
+      } else {
+        dx = data.readInt8(at);
+        dy = data.readInt8(at + 1);
+        at += 2;
+      }
+      if (!(flags & 0x0002)) {
+        throw new Error("composite glyphs matching points are not supported");
+      }
+      let [a, b, c, d] = [1, 0, 0, 1];
+      const f2dot14 = (offset) => data.readInt16BE(offset) / 16384;
+      if (flags & 0x0008) {
+        a = d = f2dot14(at);
+        at += 2;
+      } else if (flags & 0x0040) {
+        a = f2dot14(at);
+        d = f2dot14(at + 2);
+        at += 4;
+      } else if (flags & 0x0080) {
+        [a, b, c, d] = [f2dot14(at), f2dot14(at + 2), f2dot14(at + 4), f2dot14(at + 6)];
+        at += 8;
+      }
+      for (const contour of font.contours(component)) {
+        contours.push(
+          contour.map(([x, y, on]) => [a * x + c * y + dx, b * x + d * y + dy, on])
+        );
+      }
+      if (!(flags & 0x0020)) {
+        return contours;
+      }
+    }
+  }
+
+  // kern table format 0 pairs, by "left,right" glyph index
+  font.kerning = new Map();
+  if (tables.kern !== undefined) {
+    let at = tables.kern + 4;
+    for (let i = 0, count = data.readUInt16BE(tables.kern + 2); i < count; i++) {
+      const length = data.readUInt16BE(at + 2);
+      const coverage = data.readUInt16BE(at + 4);
+      // horizontal, kerning values, format 0
+      if ((coverage & 0xff07) === 0x0001) {
+        for (let p = 0, pairs = data.readUInt16BE(at + 6); p < pairs; p++) {
+          const pair = at + 14 + 6 * p;
+          font.kerning.set(
+            `${data.readUInt16BE(pair)},${data.readUInt16BE(pair + 2)}`,
+            data.readInt16BE(pair + 4)
+          );
+        }
+      }
+      at += length;
+    }
+  }
+  return font;
+}
+
+// ---- rasterizer ----
+
+// line segments of the outline, quadratic curves flattened
+function outlineEdges(contours, transform) {
+  const edges = [];
+  for (const contour of contours) {
+    if (!contour.length) {
+      continue;
+    }
+    // start on a curve point, add the implied ones between two off points
+    const points = [];
+    for (let i = 0; i < contour.length; i++) {
+      const p = contour[i];
+      const next = contour[(i + 1) % contour.length];
+      points.push(p);
+      if (!p[2] && !next[2]) {
+        points.push([(p[0] + next[0]) / 2, (p[1] + next[1]) / 2, true]);
+      }
+    }
+    const first = points.findIndex((p) => p[2]);
+    const ordered = points.slice(first).concat(points.slice(0, first));
+    ordered.push(ordered[0]);
+
+    let current = transform(ordered[0]);
+    for (let i = 1; i < ordered.length; i++) {
+      const p = ordered[i];
+      if (p[2]) {
+        const to = transform(p);
+        edges.push([current, to]);
+        current = to;
+        continue;
+      }
+      const control = transform(p);
+      const to = transform(ordered[++i]);
+      const steps = 8;
+      for (let s = 1; s <= steps; s++) {
+        const t = s / steps;
+        const u = 1 - t;
+        const point = [
+          u * u * current[0] + 2 * u * t * control[0] + t * t * to[0],
+          u * u * current[1] + 2 * u * t * control[1] + t * t * to[1],
+        ];
+        edges.push([s === 1 ? current : edges[edges.length - 1][1], point]);
+      }
+      current = to;
+    }
+  }
+  return edges;
+}
+
+// pixels of a width x height grid, nonzero winding, covered at least
+// threshold
+function rasterize(edges, width, height, threshold) {
+  const coverage = new Uint16Array(width * height);
+  for (let sy = 0; sy < height * SUPERSAMPLE; sy++) {
+    const y = (sy + 0.5) / SUPERSAMPLE;
+    const crossings = [];
+    for (const [[x0, y0], [x1, y1]] of edges) {
+      if (y0 === y1 || y < Math.min(y0, y1) || y >= Math.max(y0, y1)) {
+        continue;
+      }
+      crossings.push([x0 + ((y - y0) * (x1 - x0)) / (y1 - y0), y1 > y0 ? 1 : -1]);
+    }
+    crossings.sort((a, b) => a[0] - b[0]);
+    let winding = 0;
+    for (let i = 0; i < crossings.length - 1; i++) {
+      winding += crossings[i][1];
+      if (!winding) {
+        continue;
+      }
+      const from = Math.max(0, Math.ceil(crossings[i][0] * SUPERSAMPLE - 0.5));
+      const to = Math.min(width * SUPERSAMPLE, Math.ceil(crossings[i + 1][0] * SUPERSAMPLE - 0.5));
+      for (let sx = from; sx < to; sx++) {
+        coverage[Math.floor(sy / SUPERSAMPLE) * width + Math.floor(sx / SUPERSAMPLE)]++;
+      }
+    }
+  }
+  return Array.from(coverage, (count) => count >= threshold * SUPERSAMPLE * SUPERSAMPLE);
+}
+
+// ---- atlases ----
+
+function renderGlyph(font, glyph, scale, ascent, lineHeight, threshold) {
+  const advance = Math.round(font.advance(glyph) * scale);
+  const contours = font.contours(glyph);
+  const all = contours.flat();
+  if (!all.length) {
+    return { width: 0, height: 0, left: 0, top: 0, advance, rows: [] };
+  }
+  // pixel grid over the outline, y down from the top of the line
+  const left = Math.floor(Math.min(...all.map((p) => p[0])) * scale);
+  const right = Math.ceil(Math.max(...all.map((p) => p[0])) * scale);
+  const top = Math.floor(ascent - Math.max(...all.map((p) => p[1])) * scale);
+  const bottom = Math.ceil(ascent - Math.min(...all.map((p) => p[1])) * scale);
+  const width = right - left;
+  const height = bottom - top;
+  const pixels = rasterize(
+    outlineEdges(contours, ([x, y]) => [x * scale - left, ascent - y * scale - top]),
+    width,
+    height,
+    threshold
+  );
+
+  // trim to the ink and the line
+  let x0 = width;
+  let x1 = 0;
+  let y0 = Math.max(0, -top);
+  let y1 = Math.min(height, lineHeight - top);
+  const inked = (y) => pixels.slice(y * width, (y + 1) * width).some(Boolean);
+  while (y0 < y1 && !inked(y0)) {
+    y0++;
+  }
+  while (y1 > y0 && !inked(y1 - 1)) {
+    y1--;
+  }
+  for (let y = y0; y < y1; y++) {
+    for (let x = 0; x < width; x++) {
+      if (pixels[y * width + x]) {
+        x0 = Math.min(x0, x);
+        x1 = Math.max(x1, x + 1);
+      }
+    }
+  }
+  if (y0 >= y1) {
+    return { width: 0, height: 0, left: 0, top: 0, advance, rows: [] };
+  }
+  const rows = [];
+  for (let y = y0; y < y1; y++) {
+    const row = Buffer.alloc((x1 - x0 + 7) >> 3);
+    for (let x = x0; x < x1; x++) {
+      if (pixels[y * width + x]) {
+        row[(x - x0) >> 3] |= 0x80 >> ((x - x0) & 7);
+      }
+    }
+    rows.push(row);
+  }
+  return { width: x1 - x0, height: y1 - y0, left: left + x0, top: top + y0, advance, rows };
+}
+
+// plain rows, or repeat | row for each run of equal rows
+function encodeRows(rows) {
+  const plain = Buffer.concat(rows);
+  const runs = [];
+  for (let i = 0; i < rows.length; ) {
+    let repeat = 1;
+    while (i + repeat < rows.length && repeat < 255 && rows[i + repeat].equals(rows[i])) {
+      repeat++;
+    }
+    runs.push(Buffer.from([repeat]), rows[i]);
+    i += repeat;
+  }
+  const coded = Buffer.concat(runs);
+  return coded.length < plain.length ? { data: coded, rle: true } : { data: plain, rle: false };
+}
+
+function buildAtlas(spec) {
+  const file = path.resolve(fontDir, spec.file);
+  const font = parseFont(fs.readFileSync(file));
+  const scale = spec.size / font.unitsPerEm;
+  const ascent = Math.round(font.ascender * scale);
+  const lineHeight = ascent + Math.round(-font.descender * scale);
+  const codes = [...new Set([...spec.chars].map((c) => c.charCodeAt(0)))].sort((a, b) => a - b);
+  if (codes.some((code) => code < 0x20 || code > 0x7e)) {
+    throw new Error(`${spec.name}: printable ASCII only`);
+  }
+  const first = codes[0];
+  const last = codes[codes.length - 1];
+
+  const glyphs = [];
+  const bitmaps = [];
+  let size = 0;
+  for (let code = first; code <= last; code++) {
+    const index = codes.includes(code) ? font.glyphIndex(code) : 0;
+    if (!index) {
+      glyphs.push({ code, offset: 0, width: 0, height: 0, left: 0, top: 0, advance: 0 });
+      continue;
+    }
+    const glyph = renderGlyph(font, index, scale, ascent, lineHeight, spec.threshold ?? 0.5);
+    if (glyph.width > MAX_WIDTH) {
+      throw new Error(`${spec.name}: '${String.fromCharCode(code)}' is wider than ${MAX_WIDTH}`);
+    }
+    const { data, rle } = encodeRows(glyph.rows);
+    glyphs.push({ ...glyph, code, index, offset: size | (rle ? GLYPH_RLE : 0) });
+    bitmaps.push(data);
+    size += data.length;
+  }
+
+  const kerning = [];
+  for (const left of glyphs) {
+    for (const right of glyphs) {
+      const value = left.index && right.index && font.kerning.get(`${left.index},${right.index}`);
+      const adjust = value ? Math.round(value * scale) : 0;
+      if (adjust) {
+        kerning.push([left.code, right.code, Math.max(-128, Math.min(127, adjust))]);
+      }
+    }
+  }
+  return { ...spec, first, last, lineHeight, glyphs, bitmaps: Buffer.concat(bitmaps), kerning };
+}
+
+// ---- output ----
+
+function charLiteral(code) {
+  const c = String.fromCharCode(code);
+  return c === "'" || c === "\\" ? `'\\${c}'` : `'${c}'`;
+}
+
+function hexLines(data) {
+  const lines = [];
+  for (let i = 0; i < data.length; i += 12) {
+    lines.push(
+      "    " + [...data.subarray(i, i + 12)].map((b) => `0x${b.toString(16).toUpperCase().padStart(2, "0")},`).join(" ")
+    );
+  }
+  return lines;
+}
+
+const specs = JSON.parse(fs.readFileSync(specFile, "utf8"));
+const atlases = specs.map(buildAtlas);
+
+const c = [
+  "// generated by firmware/tools/gen-fonts.js from firmware/tools/fonts.json,",
+  "// do not edit",
+  '#include "text.h"',
+  "",
+];
+for (const atlas of atlases) {
+  c.push(
+    `// ${atlas.name}: ${atlas.file} at ${atlas.size}px, ${atlas.lineHeight}px lines`,
+    `static __code const uint8_t ${atlas.name}_bitmaps[${Math.max(1, atlas.bitmaps.length)}] = {`,
+    ...(atlas.bitmaps.length ? hexLines(atlas.bitmaps) : ["    0x00,"]),
+    "};",
+    "",
+    `static __code const FontGlyph ${atlas.name}_glyphs[${atlas.glyphs.length}] = {`,
+    ...atlas.glyphs.map(
+      (g) =>
+        `    {0x${g.offset.toString(16).toUpperCase().padStart(4, "0")}, ${g.width}, ${g.height}, ${g.left}, ${g.top}, ${g.advance}}, // ${charLiteral(g.code)}`
+    ),
+    "};",
+    ""
+  );
+  if (atlas.kerning.length) {
+    c.push(
+      `static __code const FontKern ${atlas.name}_kerning[${atlas.kerning.length}] = {`,
+      ...atlas.kerning.map(([l, r, a]) => `    {${charLiteral(l)}, ${charLiteral(r)}, ${a}},`),
+      "};",
+      ""
+    );
+  }
+}
+c.push(
+  `__code const uint8_t text_atlas_count = ${atlases.length};`,
+  "",
+  `__code const FontAtlas text_atlases[${atlases.length}] = {`,
+  ...atlases.map(
+    (a) =>
+      `    {${charLiteral(a.first)}, ${charLiteral(a.last)}, ${a.lineHeight}, ${a.name}_glyphs, ${a.name}_bitmaps, ` +
+      `${a.kerning.length ? `${a.name}_kerning` : "0"}, ${a.kerning.length}},`
+  ),
+  "};",
+  ""
+);
+fs.writeFileSync(atlasOutput, c.join("\n"));
+
+const ts = [
+  "// generated by firmware/tools/gen-fonts.js from firmware/tools/fonts.json,",
+  "// do not edit",
+  "",
+  "// label field fonts, BUILTIN is the tag's scalable 5x7 font",
+  "export enum Font {",
+  "  BUILTIN = 0,",
+  ...atlases.map((a, i) => `  ${a.name.toUpperCase()} = ${i + 1},`),
+  "}",
+  "",
+  "// line heights in pixels",
+  "export const fontHeight: Record<Font, number> = {",
+  "  [Font.BUILTIN]: 8,",
+  ...atlases.map((a) => `  [Font.${a.name.toUpperCase()}]: ${a.lineHeight},`),
+  "};",
+  "",
+];
+fs.writeFileSync(gatewayOutput, ts.join("\n"));
+
+for (const atlas of atlases) {
+  const metrics = atlas.glyphs.length * 7 + atlas.kerning.length * 3;
+  console.log(
+    `${atlas.name}: ${atlas.glyphs.length} glyphs, ${atlas.bitmaps.length} bytes of bitmaps, ` +
+      `${metrics} of metrics and ${atlas.kerning.length} kerning pairs`
+  );
+}
@@ -0,0 +1,61 @@
+import { readFileSync } from "fs";
+import { CommandClient } from "./command-client";
+import { linkFraming } from "./communication/ccm-stream";
+import { SerialStream } from "./communication/serial-stream";
+import { TransportStream } from "./communication/transport-stream";
+import { McastTarget, broadcast } from "./multicast";
+import { readImage } from "./ota";
+
+// npm run broadcast -- <file> [--firmware | --template n] [--session n]
+//   [--repair rounds]
+// sends the file to every listening tag, through the tag on the serial
+// link. A firmware image (.hex) is staged on the tags, OTA_FINISH and REBOOT
+// install it; anything else is a label template (npm run label -- --save)
+// and goes to template n, 0 by default.
+const fileName = process.argv[2];
+if (!fileName) {
+  console.error(
+    "usage: broadcast <file> [--firmware | --template n] [--session n] [--repair rounds]"
+  );
+  process.exit(1);
+}
+
+function option(name: string, fallback: number): number {
+  const index = process.argv.indexOf(`--${name}`);
+  return index < 0 ? fallback : Number(process.argv[index + 1]);
+}
+
+const firmware = process.argv.includes("--firmware");
+const data = firmware ? readImage(fileName) : readFileSync(fileName);
+// a new session number makes tags start over, the default changes every run
+const session = option("session", 1 + (Math.floor(Date.now() / 1000) % 255));
+const repairRounds = option("repair", 4);
+const template = option("template", 0);
+
+const serial = new SerialStream({
+  port: process.env.PORT ?? "/dev/ttyUSB0",
+  baud: 115200,
+});
+const link = new TransportStream(linkFraming(serial), { window: 4 });
+const client = new CommandClient(link);
+
+console.log(`${fileName}: ${data.length} bytes, session ${session}`);
+broadcast(
+  client,
+  data,
+  {
+    session,
+    target: firmware ? McastTarget.FIRMWARE : McastTarget.TEMPLATE + template,
+    repairRounds,
+  },
+  (sent) => process.stdout.write(`\r${sent} packets`)
+).subscribe({
+  complete: () => {
+    console.log();
+    process.exit(0);
+  },
+  error: (err) => {
+    console.error(`\n${err}`);
+    process.exit(1);
+  },
+});
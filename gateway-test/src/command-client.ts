@@ -0,0 +1,150 @@
+import {
+  Observable,
+  Subscription,
+  TimeoutError,
+  of,
+  retry,
+  throwError,
+  timeout,
+} from "rxjs";
+import { Command, Status, commandMinArgs } from "./commands";
+import { DataStream } from "./communication/types";
+
+// request: opcode | id | args, reply: opcode | id | status | payload, with
+// a 16 bit id
+const REPLY_HEADER = 4;
+const IDS = 0x10000;
+
+export class CommandError extends Error {
+  constructor(
+    readonly command: Command,
+    readonly status: Status,
+    readonly payload: Buffer
+  ) {
+    super(
+      `${Command[command] ?? command} failed: ${Status[status] ?? status}`
+    );
+  }
+}
+
+export interface RequestOptions {
+  timeoutMs?: number;
+  // times to send again after a timeout, for requests that are safe to repeat
+  retries?: number;
+}
+
+interface Pending {
+  command: Command;
+  resolve: (payload: Buffer) => void;
+  reject: (err: Error) => void;
+}
+
+// Every request carries an id that the tag copies into its reply, replies
+// are looked up by it in any order. Ids start at random, so a stale reply to
+// an earlier run of the gateway is unlikely to match. Unsubscribing cancels
+// a request, its reply is dropped when it comes.
+export class CommandClient {
+  private readonly pending = new Map<number, Pending>();
+  private nextId = Math.floor(Math.random() * IDS);
+  private rx?: Subscription;
+
+  constructor(
+    private readonly link: DataStream,
+    private readonly timeoutMs = 1000
+  ) {}
+
+  request(
+    command: Command,
+    args: Buffer = Buffer.alloc(0),
+    { timeoutMs = this.timeoutMs, retries = 0 }: RequestOptions = {}
+  ): Observable<Buffer> {
+    const minArgs = commandMinArgs[command];
+    if (args.length < minArgs) {
+      throw new Error(`${Command[command]} needs ${minArgs} argument bytes`);
+    }
+    const reply$ = new Observable<Buffer>((observer) => {
+      const id = this.allocate();
+      if (id < 0) {
+        observer.error(new Error(`${IDS} requests pending`));
+        return;
+      }
+      this.pending.set(id, {
+        command,
+        resolve: (payload) => {
+          observer.next(payload);
+          observer.complete();
+        },
+        reject: (err) => observer.error(err),
+      });
+      this.listen();
+
+      const header = Buffer.from([command, id & 0xff, id >> 8]);
+      const tx = this.link
+        .tx(Buffer.concat([header, args]))
+        .subscribe({ error: (err) => observer.error(err) });
+      return () => {
+        tx.unsubscribe();
+        this.pending.delete(id);
+      };
+    }).pipe(timeout(timeoutMs));
+    // a new id for every attempt, a late reply to the one before is dropped
+    return retries
+      ? reply$.pipe(
+          retry({
+            count: retries,
+            delay: (err) =>
+              err instanceof TimeoutError ? of(0) : throwError(() => err),
+          })
+        )
+      : reply$;
+  }
+
+  // a free id, -1 without one
+  private allocate(): number {
+    for (let i = 0; i < IDS; i++) {
+      const id = (this.nextId + i) % IDS;
+      if (!this.pending.has(id)) {
+        this.nextId = (id + 1) % IDS;
+        return id;
+      }
+    }
+    return -1;
+  }
+
+  private listen() {
+    if (this.rx) {
+      return;
+    }
+    this.rx = this.link.rx$.subscribe({
+      next: (msg) => this.handleReply(msg),
+      error: (err) => {
+        this.rx = undefined;
+        const pending = [...this.pending.values()];
+        this.pending.clear();
+        for (const entry of pending) {
+          entry.reject(err);
+        }
+      },
+    });
+  }
+
+  private handleReply(msg: Buffer) {
+    if (msg.length < REPLY_HEADER) {
+      return;
+    }
+    const command = msg[0];
+    const id = msg.readUInt16LE(1);
+    const status = msg[3];
+    const entry = this.pending.get(id);
+    if (entry?.command !== command) {
+      return;
+    }
+    this.pending.delete(id);
+    const payload = msg.subarray(REPLY_HEADER);
+    if (status === Status.OK) {
+      entry.resolve(payload);
+    } else {
+      entry.reject(new CommandError(command, status, payload));
+    }
+  }
+}
@@ -0,0 +1,59 @@
+// generated by firmware/tools/gen-commands.js from
+// firmware/src/command/commands.h, do not edit
+
+export enum Command {
+  PING = 0,
+  ECHO = 1,
+  STATS = 2,
+  PROFILE = 3,
+  REBOOT = 4,
+  OTA_BEGIN = 5,
+  OTA_WRITE = 6,
+  OTA_FINISH = 7,
+  OTA_CONFIRM = 8,
+  OTA_STATUS = 9,
+  RADIO_SEND = 10,
+  MCAST_LISTEN = 11,
+  MCAST_STATUS = 12,
+  TDMA_ASSIGN = 13,
+  TDMA_COORDINATE = 14,
+  TDMA_QUEUE = 15,
+  TDMA_RECEIVE = 16,
+  TDMA_STATUS = 17,
+  LABEL_WRITE = 18,
+  LABEL_SHOW = 19,
+}
+
+export enum Status {
+  OK = 0,
+  UNKNOWN_COMMAND = 1,
+  BAD_LENGTH = 2,
+  BAD_ARGUMENT = 3,
+  BUSY = 4,
+  UNSUPPORTED = 5,
+  FAILED = 6,
+}
+
+// minimum argument bytes per command
+export const commandMinArgs: Record<Command, number> = {
+  [Command.PING]: 0,
+  [Command.ECHO]: 0,
+  [Command.STATS]: 0,
+  [Command.PROFILE]: 1,
+  [Command.REBOOT]: 0,
+  [Command.OTA_BEGIN]: 4,
+  [Command.OTA_WRITE]: 2,
+  [Command.OTA_FINISH]: 0,
+  [Command.OTA_CONFIRM]: 0,
+  [Command.OTA_STATUS]: 0,
+  [Command.RADIO_SEND]: 1,
+  [Command.MCAST_LISTEN]: 2,
+  [Command.MCAST_STATUS]: 0,
+  [Command.TDMA_ASSIGN]: 3,
+  [Command.TDMA_COORDINATE]: 1,
+  [Command.TDMA_QUEUE]: 7,
+  [Command.TDMA_RECEIVE]: 0,
+  [Command.TDMA_STATUS]: 0,
+  [Command.LABEL_WRITE]: 3,
+  [Command.LABEL_SHOW]: 1,
+};
@@ -0,0 +1,206 @@
+import { createCipheriv, createDecipheriv } from "crypto";
+import { readFileSync, renameSync, writeFileSync } from "fs";
+import { Observable, defer, filter, map, share } from "rxjs";
+import { CobsStream } from "./cobs-stream";
+import { DataStream } from "./types";
+import { isDefined } from "../util";
+
+// Host side of the encrypted link, see firmware/src/crypto/link.h. Frames
+// are AES-CCM sealed, the MIC takes the place of the CRC:
+//   tag to host:  id | epoch | counter | ciphertext | mic
+//   host to tag:  counter | ciphertext | mic
+const NONCE_SIZE = 13;
+const MIC_SIZE = 4;
+const KEY_SIZE = 16;
+const ID_SIZE = 4;
+const TAG_HEADER = ID_SIZE + 8;
+const ANNOUNCE = 0x80000000;
+// counters handed out ahead of the one in the state file, a restarted host
+// goes on after them
+const COUNTER_RESERVE = 0x100;
+// too short for the tag to open, it answers with an announcement
+const PROBE = Buffer.alloc(1);
+
+export const DIRECTION_TAG = 0;
+export const DIRECTION_HOST = 1;
+
+export function linkNonce(
+  direction: number,
+  epoch: number,
+  counter: number,
+  id: Buffer
+) {
+  const nonce = Buffer.alloc(NONCE_SIZE);
+  nonce[0] = direction;
+  nonce.writeUInt32BE(epoch, 1);
+  nonce.writeUInt32BE(counter, 5);
+  id.copy(nonce, 9);
+  return nonce;
+}
+
+// the last host counter handed out to each tag, by id in hex. The host's
+// nonces only stay unique while this file is kept.
+class CounterFile {
+  constructor(private readonly path: string) {}
+
+  get(id: string): number {
+    return this.read()[id] ?? 0;
+  }
+
+  set(id: string, counter: number) {
+    const counters = { ...this.read(), [id]: counter };
+    // a crash while writing leaves the old file
+    writeFileSync(`${this.path}.tmp`, JSON.stringify(counters));
+    renameSync(`${this.path}.tmp`, this.path);
+  }
+
+  private read(): Record<string, number> {
+    try {
+      return JSON.parse(readFileSync(this.path, "utf8"));
+    } catch {
+      return {};
+    }
+  }
+}
+
+export function ccmSeal(key: Buffer, nonce: Buffer, plaintext: Buffer) {
+  const cipher = createCipheriv("aes-128-ccm", key, nonce, {
+    authTagLength: MIC_SIZE,
+  });
+  cipher.setAAD(Buffer.alloc(0), { plaintextLength: plaintext.length });
+  return Buffer.concat([
+    cipher.update(plaintext),
+    cipher.final(),
+    cipher.getAuthTag(),
+  ]);
+}
+
+// null when the MIC does not match
+export function ccmOpen(
+  key: Buffer,
+  nonce: Buffer,
+  sealed: Buffer
+): Buffer | null {
+  const length = sealed.length - MIC_SIZE;
+  const decipher = createDecipheriv("aes-128-ccm", key, nonce, {
+    authTagLength: MIC_SIZE,
+  });
+  decipher.setAuthTag(sealed.subarray(length));
+  decipher.setAAD(Buffer.alloc(0), { plaintextLength: length });
+  try {
+    const plaintext = decipher.update(sealed.subarray(0, length));
+    decipher.final();
+    return plaintext;
+  } catch {
+    return null;
+  }
+}
+
+// The stream is bound to the tag its first frame comes from, frames with
+// another id are dropped. Until then frames to the tag are dropped too and a
+// probe sent in their place, the transport retransmits them.
+export class CcmStream implements DataStream {
+  readonly rx$: Observable<Buffer>;
+
+  private id?: Buffer; // the tag's
+  private epoch = 0; // the tag's, it goes up on every boot
+  private rxCounter = 0; // last tag counter accepted in that epoch
+  private txCounter = 0;
+  private reserved = 0; // counters up to this one are in the state file
+  private readonly counters: CounterFile;
+
+  constructor(
+    private readonly inner: DataStream,
+    private readonly key: Buffer,
+    statePath: string
+  ) {
+    if (key.length !== KEY_SIZE) {
+      throw new Error(`link key must be ${KEY_SIZE} bytes`);
+    }
+    this.counters = new CounterFile(statePath);
+    this.rx$ = this.inner.rx$.pipe(
+      map((frame) => this.open(frame)),
+      filter(isDefined),
+      share()
+    );
+  }
+
+  // the tag the frames come from
+  get tagId(): Buffer | undefined {
+    return this.id;
+  }
+
+  tx(msg: Buffer): Observable<never> {
+    return defer(() => {
+      if (!this.id) {
+        return this.inner.tx(PROBE);
+      }
+      const counter = ++this.txCounter;
+      if (counter > this.reserved) {
+        this.reserved = counter + COUNTER_RESERVE;
+        this.counters.set(this.id.toString("hex"), this.reserved);
+      }
+      const header = Buffer.alloc(4);
+      header.writeUInt32BE(counter);
+      const sealed = ccmSeal(
+        this.key,
+        linkNonce(DIRECTION_HOST, this.epoch, counter, this.id),
+        msg
+      );
+      return this.inner.tx(Buffer.concat([header, sealed]));
+    });
+  }
+
+  private open(frame: Buffer): Buffer | null {
+    if (frame.length < TAG_HEADER + MIC_SIZE) {
+      return null;
+    }
+    const id = frame.subarray(0, ID_SIZE);
+    const epoch = frame.readUInt32BE(ID_SIZE);
+    const counter = frame.readUInt32BE(ID_SIZE + 4);
+    const sequence = counter & ~ANNOUNCE;
+    // frames from an older boot or seen before are replays
+    const fresh =
+      epoch > this.epoch || (epoch === this.epoch && sequence > this.rxCounter);
+    if ((this.id && !this.id.equals(id)) || !fresh) {
+      return null;
+    }
+    const plaintext = ccmOpen(
+      this.key,
+      linkNonce(DIRECTION_TAG, epoch, counter, id),
+      frame.subarray(TAG_HEADER)
+    );
+    if (!plaintext) {
+      return null;
+    }
+    if (!this.id) {
+      this.id = Buffer.from(id);
+      this.txCounter = this.reserved = this.counters.get(id.toString("hex"));
+    }
+    this.epoch = epoch;
+    this.rxCounter = sequence;
+
+    if (counter & ANNOUNCE) {
+      // the tag refused a frame: it rebooted or we did
+      const next = plaintext.readUInt32BE(0);
+      this.txCounter = Math.max(this.txCounter, next - 1);
+      return null;
+    }
+    return plaintext;
+  }
+}
+
+// the tag's framing: sealed when LINK_KEY (32 hex digits) is set, the same
+// key the firmware was built with, CRC protected otherwise unless LINK_CRC is
+// 0 for a tag built with make CRC=0. The sealed link keeps its counters in
+// LINK_STATE.
+export function linkFraming(
+  inner: DataStream,
+  key = process.env.LINK_KEY,
+  crc = process.env.LINK_CRC !== "0",
+  statePath = process.env.LINK_STATE ?? "link-state.json"
+): DataStream {
+  return key
+    ? new CcmStream(new CobsStream(inner), Buffer.from(key, "hex"), statePath)
+    : new CobsStream(inner, crc);
+}
@@ -0,0 +1,283 @@
+import { Observable, Subject, merge, share } from "rxjs";
+import { DataStream } from "./types";
+
+// Selective repeat ARQ, frame layout matches firmware/src/transport:
+//   flags | seq | ack | sack | payload...
+// The CRC is appended by the inner CobsStream (withCrc) unless the tag was
+// built without it, or a CcmStream seals the frame instead.
+const FLAG_DATA = 0x01;
+const FLAG_ACK = 0x02;
+const FLAG_SYN = 0x04;
+const HEADER_SIZE = 4;
+// TRANSPORT_MAX_PAYLOAD, a longer frame does not fit a pool block on the tag and
+// would be retransmitted until the link fails
+export const MAX_PAYLOAD = 120;
+
+export interface TransportConfig {
+  // frames in flight per direction, must not exceed the tag's TRANSPORT_WINDOW
+  window: number;
+  // retransmission timeout
+  rtoMs: number;
+  // a frame not acknowledged after this many retransmissions fails the link
+  maxRetries: number;
+}
+
+const defaultConfig: TransportConfig = {
+  window: 4,
+  rtoMs: 50,
+  maxRetries: 10,
+};
+
+interface Frame {
+  payload: Buffer;
+  acked: boolean;
+  fastRetransmit: boolean;
+  cancelled: boolean;
+  retries: number;
+  timer?: ReturnType<typeof setTimeout>;
+  done: (err?: Error) => void;
+}
+
+const seqDiff = (a: number, b: number) => (a - b) & 0xff;
+
+export class TransportStream implements DataStream {
+  readonly rx$: Observable<Buffer>;
+
+  private readonly config: TransportConfig;
+  private readonly received$ = new Subject<Buffer>();
+  private readonly link$: Observable<never>;
+
+  private readonly queue: Frame[] = [];
+  private readonly inFlight = new Map<number, Frame>();
+  private txBase = 0;
+  private txNext = 0;
+  private synced = false;
+
+  private readonly reorder = new Map<number, Buffer>();
+  private rxNext = 0;
+  private peerSyn = false; // the tag's frames of this session carry SYN
+  private ackScheduled = false;
+
+  constructor(
+    private readonly inner: DataStream,
+    config?: Partial<TransportConfig>
+  ) {
+    this.config = { ...defaultConfig, ...config };
+    if (this.config.window < 1 || this.config.window > 8) {
+      throw new Error("window must be between 1 and 8");
+    }
+    this.restart();
+
+    this.link$ = new Observable<never>((observer) => {
+      const subscription = this.inner.rx$.subscribe({
+        next: (frame) => this.handleFrame(frame),
+        error: (err) => observer.error(err),
+      });
+      return () => subscription.unsubscribe();
+    }).pipe(share());
+
+    this.rx$ = merge(this.received$, this.link$).pipe(share());
+  }
+
+  tx(msg: Buffer): Observable<never> {
+    return new Observable<never>((observer) => {
+      if (msg.length > MAX_PAYLOAD) {
+        observer.error(
+          new Error(`payload of ${msg.length} bytes, at most ${MAX_PAYLOAD}`)
+        );
+        return;
+      }
+      const link = this.link$.subscribe({
+        error: (err) => observer.error(err),
+      });
+      const frame: Frame = {
+        payload: msg,
+        acked: false,
+        fastRetransmit: false,
+        cancelled: false,
+        retries: 0,
+        done: (err) => (err ? observer.error(err) : observer.complete()),
+      };
+      this.queue.push(frame);
+      this.pump();
+
+      return () => {
+        link.unsubscribe();
+        // once numbered the frame has to go through, the peer waits for it
+        frame.cancelled = true;
+        frame.done = () => {};
+        const index = this.queue.indexOf(frame);
+        if (index >= 0) {
+          this.queue.splice(index, 1);
+        }
+      };
+    });
+  }
+
+  private restart() {
+    this.txBase = this.txNext = Math.floor(Math.random() * 0x100);
+    this.synced = false;
+  }
+
+  private pump() {
+    while (this.queue.length && this.inFlight.size < this.config.window) {
+      const frame = this.queue.shift()!;
+      if (frame.cancelled) {
+        continue;
+      }
+      const seq = this.txNext;
+      this.txNext = (this.txNext + 1) & 0xff;
+      this.inFlight.set(seq, frame);
+      this.sendData(seq, frame);
+    }
+  }
+
+  private sendData(seq: number, frame: Frame) {
+    clearTimeout(frame.timer);
+    frame.timer = setTimeout(() => this.timeout(seq), this.config.rtoMs);
+    this.send(FLAG_DATA, seq, frame.payload);
+  }
+
+  private send(flags: number, seq: number, payload?: Buffer) {
+    const header = Buffer.from([
+      flags | FLAG_ACK | (this.synced ? 0 : FLAG_SYN),
+      seq,
+      this.rxNext,
+      this.sack(),
+    ]);
+    this.ackScheduled = false;
+    this.inner
+      .tx(payload ? Buffer.concat([header, payload]) : header)
+      .subscribe({ error: (err) => this.fail(err) });
+  }
+
+  private sack() {
+    let sack = 0;
+    for (let i = 0; i < Math.min(this.config.window - 1, 8); i++) {
+      if (this.reorder.has((this.rxNext + 1 + i) & 0xff)) {
+        sack |= 1 << i;
+      }
+    }
+    return sack;
+  }
+
+  private timeout(seq: number) {
+    const frame = this.inFlight.get(seq);
+    if (!frame || frame.acked) {
+      return;
+    }
+    if (++frame.retries > this.config.maxRetries) {
+      this.fail(new Error(`frame ${seq} not acknowledged`));
+      return;
+    }
+    this.sendData(seq, frame);
+  }
+
+  private fail(err: Error) {
+    // the peer is gone or restarted, start a new numbering once it is back
+    const frames = [...this.inFlight.values()];
+    this.inFlight.clear();
+    this.restart();
+    for (const frame of frames) {
+      clearTimeout(frame.timer);
+      frame.done(err);
+    }
+    this.pump();
+  }
+
+  private handleFrame(frame: Buffer) {
+    if (frame.length < HEADER_SIZE) {
+      return;
+    }
+    const [flags, seq, ack, sack] = frame;
+    if (flags & FLAG_ACK) {
+      this.acknowledge(ack, sack);
+    }
+    if (flags & FLAG_DATA) {
+      this.receive(seq, frame.subarray(HEADER_SIZE), !!(flags & FLAG_SYN));
+    }
+  }
+
+  private acknowledge(ack: number, sack: number) {
+    const advance = seqDiff(ack, this.txBase);
+    if (advance > this.inFlight.size) {
+      // stale
+      return;
+    }
+    if (advance) {
+      this.synced = true;
+    }
+    for (let i = 0; i < advance; i++) {
+      const frame = this.inFlight.get(this.txBase)!;
+      this.inFlight.delete(this.txBase);
+      clearTimeout(frame.timer);
+      if (!frame.acked) {
+        frame.done();
+      }
+      this.txBase = (this.txBase + 1) & 0xff;
+    }
+
+    for (let i = 0; sack; i++, sack >>= 1) {
+      const frame = this.inFlight.get((ack + 1 + i) & 0xff);
+      if (sack & 1 && frame && !frame.acked) {
+        frame.acked = true;
+        clearTimeout(frame.timer);
+        frame.done();
+      }
+    }
+
+    const first = this.inFlight.get(this.txBase);
+    const second = this.inFlight.get((this.txBase + 1) & 0xff);
+    if (first && !first.acked && !first.fastRetransmit && second?.acked) {
+      first.fastRetransmit = true;
+      this.sendData(this.txBase, first);
+    }
+
+    this.pump();
+  }
+
+  private receive(seq: number, payload: Buffer, syn: boolean) {
+    const window = this.config.window;
+    this.scheduleAck();
+
+    if (!syn) {
+      this.peerSyn = false;
+    } else if (
+      !this.peerSyn ||
+      (seqDiff(seq, this.rxNext) >= window && seqDiff(this.rxNext, seq) > window)
+    ) {
+      // the first frame since we started, SYN after plain frames, or neither
+      // new nor a late duplicate: the tag (re)started its numbering, follow
+      // it. The link keeps the order, a SYN frame of the old session cannot
+      // turn up after a plain one.
+      this.reorder.clear();
+      this.rxNext = seq;
+      this.peerSyn = true;
+    }
+
+    if (seqDiff(seq, this.rxNext) >= window || this.reorder.has(seq)) {
+      return;
+    }
+
+    this.reorder.set(seq, Buffer.from(payload));
+    let next: Buffer | undefined;
+    while ((next = this.reorder.get(this.rxNext))) {
+      this.reorder.delete(this.rxNext);
+      this.rxNext = (this.rxNext + 1) & 0xff;
+      this.received$.next(next);
+    }
+  }
+
+  private scheduleAck() {
+    if (this.ackScheduled) {
+      return;
+    }
+    // one ack for everything that arrived in the same chunk
+    this.ackScheduled = true;
+    setImmediate(() => {
+      if (this.ackScheduled) {
+        this.send(0, 0);
+      }
+    });
+  }
+}
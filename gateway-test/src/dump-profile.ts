@@ -0,0 +1,23 @@
+import { CommandClient } from "./command-client";
+import { linkFraming } from "./communication/ccm-stream";
+import { SerialStream } from "./communication/serial-stream";
+import { TransportStream } from "./communication/transport-stream";
+import { formatProfile, readProfile } from "./profile";
+
+// prints the tag's probe table, `--reset` clears it afterwards
+const serial = new SerialStream({
+  port: process.env.PORT ?? "/dev/ttyUSB0",
+  baud: 115200,
+});
+const link = new TransportStream(linkFraming(serial), { window: 4 });
+
+readProfile(new CommandClient(link), process.argv.includes("--reset")).subscribe({
+  next: (probes) => {
+    console.log(formatProfile(probes));
+    process.exit(0);
+  },
+  error: (err) => {
+    console.error(err);
+    process.exit(1);
+  },
+});
@@ -0,0 +1,18 @@
+// generated by firmware/tools/gen-fonts.js from firmware/tools/fonts.json,
+// do not edit
+
+// label field fonts, BUILTIN is the tag's scalable 5x7 font
+export enum Font {
+  BUILTIN = 0,
+  SANS_16 = 1,
+  DIGITS_18 = 2,
+  DIGITS_36 = 3,
+}
+
+// line heights in pixels
+export const fontHeight: Record<Font, number> = {
+  [Font.BUILTIN]: 8,
+  [Font.SANS_16]: 19,
+  [Font.DIGITS_18]: 23,
+  [Font.DIGITS_36]: 45,
+};
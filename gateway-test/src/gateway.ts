@@ -0,0 +1,196 @@
+import { readFileSync } from "fs";
+import { ServerResponse, createServer } from "http";
+import { CommandClient, CommandError } from "./command-client";
+import { Command } from "./commands";
+import { linkFraming } from "./communication/ccm-stream";
+import { SerialStream } from "./communication/serial-stream";
+import { TransportStream } from "./communication/transport-stream";
+import { Histogram, Metrics } from "./metrics";
+import {
+  DeadlineError,
+  Job,
+  LinkScheduler,
+  QueueFullError,
+  defaultSchedulerConfig,
+} from "./scheduler";
+import { SlotCalendar, TdmaRoute } from "./tdma";
+
+// npm run gateway -- <config.json>
+// Serves any number of serial links, each with its tag and the tags behind it
+// when that one coordinates TDMA, to producers over HTTP:
+//   POST /request {"tag": "front" or 17, "command": "LABEL_SHOW",
+//                  "args": "<hex>", "priority": 0, "deadline": <ms from now>}
+//     answers 200 {"reply": "<hex>"} with the reply payload, 503 with
+//     Retry-After while the link's queue is full, 504 when the deadline
+//     passed, 502 when the tag refused or did not answer
+//   GET /metrics in the Prometheus text format
+// The tag on a link is named after the link, tags behind it by their radio
+// address. The config is
+//   { "listen": 8080,
+//     "links": [{ "name": "front", "port": "/dev/ttyUSB0", "inFlight": 4,
+//                 "maxQueued": 1000, "timeout": 1000,
+//                 "radio": { "period": 4, "tags": [17, 18, 19] } }] }
+// with the radio tags given slots in the order listed, as they were with
+// TDMA_ASSIGN. Every 10s a line per link goes to the console.
+const configName = process.argv[2];
+if (!configName) {
+  console.error("usage: gateway <config.json>");
+  process.exit(1);
+}
+
+interface LinkConfig {
+  name: string;
+  port: string;
+  inFlight?: number;
+  perTag?: number;
+  maxQueued?: number;
+  timeout?: number; // ms for an answer on the serial link
+  radio?: { period: number; tags: number[] };
+}
+
+const config: { listen?: number; links: LinkConfig[] } = JSON.parse(
+  readFileSync(configName, "utf8")
+);
+const STATUS_MS = 10000;
+const RETRY_AFTER_S = 1;
+
+const metrics = new Metrics();
+const route = new Map<string, LinkScheduler>(); // tag to its link
+
+for (const linkConfig of config.links) {
+  const serial = new SerialStream({ port: linkConfig.port, baud: 115200 });
+  const window = Math.min(8, linkConfig.inFlight ?? 4);
+  const link = new TransportStream(linkFraming(serial), { window });
+  const client = new CommandClient(link, linkConfig.timeout);
+
+  let radio: TdmaRoute | undefined;
+  if (linkConfig.radio) {
+    const calendar = new SlotCalendar();
+    for (const address of linkConfig.radio.tags) {
+      calendar.assign(address, linkConfig.radio.period);
+    }
+    radio = new TdmaRoute(client, calendar);
+  }
+
+  const maxQueued = linkConfig.maxQueued ?? defaultSchedulerConfig.maxQueued;
+  const scheduler = new LinkScheduler(
+    linkConfig.name,
+    (job) =>
+      job.tag === linkConfig.name
+        ? client.request(job.command, job.args)
+        : radio!.request(Number(job.tag), job.command, job.args),
+    metrics,
+    {
+      inFlight: linkConfig.inFlight ?? defaultSchedulerConfig.inFlight,
+      perTag: linkConfig.perTag ?? defaultSchedulerConfig.perTag,
+      maxQueued,
+      resume: Math.floor((maxQueued * 3) / 4),
+    }
+  );
+  const tags = [linkConfig.name, ...(linkConfig.radio?.tags ?? []).map(String)];
+  for (const tag of tags) {
+    if (route.has(tag)) {
+      throw new Error(`${tag} is on ${route.get(tag)!.name} already`);
+    }
+    route.set(tag, scheduler);
+  }
+}
+
+function parseJob(body: Record<string, unknown>): Job {
+  const command =
+    typeof body.command === "string"
+      ? Command[body.command as keyof typeof Command]
+      : Number(body.command);
+  if (!(command in Command)) {
+    throw new Error(`unknown command ${body.command}`);
+  }
+  const args = String(body.args ?? "");
+  if (!/^([0-9a-f]{2})*$/i.test(args)) {
+    throw new Error("args must be hex");
+  }
+  return {
+    tag: String(body.tag),
+    command,
+    args: Buffer.from(args, "hex"),
+    priority: Number(body.priority ?? 1),
+    deadline:
+      body.deadline === undefined ? Infinity : Date.now() + Number(body.deadline),
+  };
+}
+
+function reply(
+  res: ServerResponse,
+  status: number,
+  body: object,
+  headers: Record<string, string | number> = {}
+) {
+  res.writeHead(status, { "content-type": "application/json", ...headers });
+  res.end(JSON.stringify(body));
+}
+
+function handleRequest(res: ServerResponse, body: string) {
+  let job: Job;
+  try {
+    job = parseJob(JSON.parse(body));
+  } catch (err) {
+    return reply(res, 400, { error: String(err) });
+  }
+  const scheduler = route.get(job.tag);
+  if (!scheduler) {
+    return reply(res, 404, { error: `no tag ${job.tag}` });
+  }
+  const sub = scheduler.submit(job).subscribe({
+    next: (payload) => reply(res, 200, { reply: payload.toString("hex") }),
+    error: (err) => {
+      if (err instanceof QueueFullError) {
+        reply(res, 503, { error: err.message }, { "retry-after": RETRY_AFTER_S });
+      } else if (err instanceof DeadlineError) {
+        reply(res, 504, { error: err.message });
+      } else if (err instanceof CommandError) {
+        reply(res, 502, { error: err.message, status: err.status });
+      } else {
+        reply(res, 502, { error: String(err) });
+      }
+    },
+  });
+  // a producer that gave up frees its place
+  res.on("close", () => sub.unsubscribe());
+}
+
+const server = createServer((req, res) => {
+  if (req.method === "GET" && req.url === "/metrics") {
+    res.writeHead(200, { "content-type": "text/plain; version=0.0.4" });
+    res.end(metrics.render());
+  } else if (req.method === "POST" && req.url === "/request") {
+    const chunks: Buffer[] = [];
+    req.on("data", (chunk: Buffer) => chunks.push(chunk));
+    req.on("end", () => handleRequest(res, Buffer.concat(chunks).toString()));
+  } else {
+    reply(res, 404, { error: "POST /request or GET /metrics" });
+  }
+});
+const listen = config.listen ?? 8080;
+server.listen(listen, () => console.log(`listening on ${listen}`));
+
+// a bucket bound of the histogram
+function quantile(histogram: Histogram, q: number): string {
+  const ms = histogram.quantile(q);
+  return isNaN(ms) ? "-" : ms === Infinity ? "slow" : `<${ms}ms`;
+}
+
+// per link: waiting, in flight, answers per second and round trip quantiles
+const schedulers = [...new Set(route.values())];
+const answered = new Map<LinkScheduler, number>();
+setInterval(() => {
+  for (const scheduler of schedulers) {
+    const stats = scheduler.stats();
+    const rate = ((stats.ok - (answered.get(scheduler) ?? 0)) * 1000) / STATUS_MS;
+    answered.set(scheduler, stats.ok);
+    console.log(
+      `${scheduler.name}: ${scheduler.depth} queued, ${stats.inFlight} in flight, ` +
+        `${rate.toFixed(1)}/s, round trip p50 ${quantile(stats.roundTrip, 0.5)} ` +
+        `p99 ${quantile(stats.roundTrip, 0.99)}, ${stats.expired} expired, ` +
+        `${stats.failed} failed, ${stats.rejected} refused`
+    );
+  }
+}, STATUS_MS);
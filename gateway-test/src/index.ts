@@ -1,36 +1,30 @@
-import { first, interval, map, merge, mergeMap, tap, timeout } from "rxjs";
-import { CobsStream } from "./communication/cobs-stream";
+import { interval, mergeMap, tap } from "rxjs";
+import { CommandClient } from "./command-client";
+import { Command } from "./commands";
+import { linkFraming } from "./communication/ccm-stream";
 import { SerialStream } from "./communication/serial-stream";
+import { TransportStream } from "./communication/transport-stream";
 
 const serial = new SerialStream({
   port: "/dev/ttyUSB0",
   baud: 115200,
 });
 
-const cobs = new CobsStream(serial);
+const link = new TransportStream(linkFraming(serial), { window: 4 });
+const client = new CommandClient(link);
 
 interval(50)
   .pipe(
-    mergeMap((index) => {
-      const tx$ = cobs.tx(
-        Buffer.from(
-          `how about a longer message that contains an index ${++index}`
+    mergeMap((index) =>
+      client
+        .request(
+          Command.ECHO,
+          Buffer.from(
+            `how about a longer message that contains an index ${index}`
+          )
         )
-      );
-
-      const rx$ = cobs.rx$.pipe(
-        map((rx) => {
-          const msg = rx.toString();
-          const value = +msg.split(" ").slice(-1);
-          return { msg, value };
-        }),
-        first(({ value }) => value === index),
-        timeout(30),
-        tap(({ msg }) => console.log(`rx:${msg}`))
-      );
-
-      return merge(rx$, tx$);
-    })
+        .pipe(tap((rx) => console.log(`rx:${rx.toString()}`)))
+    )
   )
   .subscribe({
     error: (err) => console.error(err),
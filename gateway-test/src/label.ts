@@ -0,0 +1,267 @@
+import { readFileSync } from "fs";
+import { Observable, concatMap, from, ignoreElements } from "rxjs";
+import type { CommandClient } from "./command-client";
+import { Command } from "./commands";
+import { Font } from "./fonts";
+
+// matches firmware/src/display/label.h
+export const HRES = 152;
+export const VRES = 296;
+export const ROW_BYTES = HRES / 8;
+export const PLANE_SIZE = ROW_BYTES * VRES;
+export const TEMPLATES = 3;
+export const MAX_FIELDS = 12;
+export const MAX_VALUES = 96;
+const MAGIC = 0x4c;
+const HEADER_SIZE = 4;
+const FIELD_SIZE = 12;
+const ART_OFFSET = 0x100;
+const STYLE_ALT = 0x20;
+// LABEL_WRITE data per request: the transport payload less the command
+// header, template and offset
+const WRITE_CHUNK = 112;
+
+export enum FieldType {
+  TEXT,
+  PRICE,
+  DATE,
+  BARCODE,
+}
+
+export enum Align {
+  LEFT,
+  CENTER,
+  RIGHT,
+}
+
+// clockwise, the label onto the panel
+export enum Rotation {
+  R0,
+  R90,
+  R180,
+  R270,
+}
+
+export enum Color {
+  NONE,
+  WHITE,
+  BLACK,
+  RED,
+}
+
+export interface Field {
+  name: string;
+  type: FieldType;
+  x: number;
+  y: number;
+  width: number;
+  height: number;
+  scale?: number; // of the 6x8 font cell, or pixels per barcode module
+  font?: Font; // BUILTIN at scale, or an atlas of its own size
+  centsFont?: Font; // alt prices, the font by default
+  align?: Align;
+  alt?: boolean; // small raised cents, ISO dates
+  ink?: Color;
+  background?: Color;
+}
+
+export type FieldValue = string | number | Date;
+
+export interface Template {
+  fields: Field[];
+  rotation?: Rotation;
+  black?: Buffer; // label orientation, rows MSB first, a clear bit is ink
+  red?: Buffer;
+}
+
+export function labelSize(rotation = Rotation.R0): [number, number] {
+  return rotation & 1 ? [VRES, HRES] : [HRES, VRES];
+}
+
+// a blank plane, every bit white
+export function blankPlane(): Buffer {
+  return Buffer.alloc(PLANE_SIZE, 0xff);
+}
+
+// a binary PBM (P4) of the label size
+export function readPbm(fileName: string, rotation = Rotation.R0): Buffer {
+  const [width, height] = labelSize(rotation);
+  const file = readFileSync(fileName);
+  const header = /^P4\s+(?:#.*\s+)*(\d+)\s+(\d+)\s/.exec(
+    file.toString("latin1", 0, 64)
+  );
+  if (!header || +header[1] !== width || +header[2] !== height) {
+    throw new Error(`${fileName}: expected a ${width}x${height} binary PBM`);
+  }
+  const bits = file.subarray(header[0].length, header[0].length + PLANE_SIZE);
+  // PBM marks black with a set bit, the panel with a clear one
+  return Buffer.from(bits.map((b) => ~b & 0xff));
+}
+
+// a plane in label orientation onto the panel, like the tag turns its bands
+export function rotatePlane(plane: Buffer, rotation = Rotation.R0): Buffer {
+  if (rotation === Rotation.R0) {
+    return plane;
+  }
+  const [width, height] = labelSize(rotation);
+  const stride = width / 8;
+  const panel = blankPlane();
+  for (let y = 0; y < VRES; y++) {
+    for (let x = 0; x < HRES; x++) {
+      const [lx, ly] =
+        rotation === Rotation.R90
+          ? [y, height - 1 - x]
+          : rotation === Rotation.R180
+            ? [width - 1 - x, height - 1 - y]
+            : [width - 1 - y, x];
+      if (!(plane[ly * stride + (lx >> 3)] & (0x80 >> (lx & 7)))) {
+        panel[y * ROW_BYTES + (x >> 3)] &= ~(0x80 >> (x & 7));
+      }
+    }
+  }
+  return panel;
+}
+
+export function encodeTemplate(template: Template): Buffer {
+  const { fields } = template;
+  const rotation = template.rotation ?? Rotation.R0;
+  const [width, height] = labelSize(rotation);
+  if (fields.length > MAX_FIELDS) {
+    throw new Error(`at most ${MAX_FIELDS} fields`);
+  }
+  const blob = Buffer.alloc(ART_OFFSET + 2 * PLANE_SIZE, 0xff);
+  blob.fill(0, 0, ART_OFFSET);
+  blob[0] = MAGIC;
+  blob[1] = fields.length;
+  blob[2] = rotation;
+  fields.forEach((field, i) => {
+    const scale = field.scale ?? 1;
+    if (
+      field.x < 0 ||
+      field.y < 0 ||
+      field.x + field.width > width ||
+      field.y + field.height > height ||
+      field.height > 255 ||
+      scale < 1 ||
+      scale > 7 ||
+      !((field.font ?? Font.BUILTIN) in Font) ||
+      !((field.centsFont ?? Font.BUILTIN) in Font)
+    ) {
+      throw new Error(`field ${field.name} does not fit the label`);
+    }
+    const at = HEADER_SIZE + i * FIELD_SIZE;
+    blob[at] = field.type;
+    blob[at + 1] = field.height;
+    blob.writeUInt16LE(field.x, at + 2);
+    blob.writeUInt16LE(field.y, at + 4);
+    blob.writeUInt16LE(field.width, at + 6);
+    blob[at + 8] =
+      scale | ((field.align ?? Align.LEFT) << 3) | (field.alt ? STYLE_ALT : 0);
+    blob[at + 9] =
+      (field.ink ?? Color.BLACK) | ((field.background ?? Color.NONE) << 4);
+    blob[at + 10] =
+      (field.font ?? Font.BUILTIN) | ((field.centsFont ?? Font.BUILTIN) << 4);
+  });
+  // the tag keeps the artwork in panel orientation
+  const art = (plane?: Buffer) =>
+    plane ? rotatePlane(plane, rotation) : blankPlane();
+  art(template.black).copy(blob, ART_OFFSET);
+  art(template.red).copy(blob, ART_OFFSET + PLANE_SIZE);
+  return blob;
+}
+
+function encodeValue(field: Field, value: FieldValue): Buffer {
+  switch (field.type) {
+    case FieldType.TEXT:
+      return Buffer.from(String(value), "latin1");
+    case FieldType.PRICE: {
+      const minor = Math.round(Number(value) * 100);
+      if (!Number.isFinite(minor) || minor < 0 || minor > 0xffffffff) {
+        throw new Error(`${field.name}: bad price ${value}`);
+      }
+      const data = Buffer.alloc(4);
+      data.writeUInt32LE(minor);
+      return data;
+    }
+    case FieldType.DATE: {
+      const date = value instanceof Date ? value : new Date(String(value));
+      if (isNaN(date.getTime())) {
+        throw new Error(`${field.name}: bad date ${value}`);
+      }
+      return Buffer.from([
+        date.getDate(),
+        date.getMonth() + 1,
+        date.getFullYear() - 2000,
+      ]);
+    }
+    case FieldType.BARCODE: {
+      const digits = String(value);
+      if (!/^\d{12,13}$/.test(digits)) {
+        throw new Error(`${field.name}: EAN-13 needs 12 or 13 digits`);
+      }
+      return Buffer.from(digits, "latin1");
+    }
+  }
+}
+
+// LABEL_SHOW values in field order, fields without a value stay empty
+export function encodeValues(
+  template: Template,
+  values: Record<string, FieldValue>
+): Buffer {
+  const parts: Buffer[] = [];
+  let last = -1;
+  template.fields.forEach((field, i) => {
+    if (values[field.name] !== undefined) {
+      last = i;
+    }
+  });
+  for (let i = 0; i <= last; i++) {
+    const field = template.fields[i];
+    const value = values[field.name];
+    const data = value === undefined ? Buffer.alloc(0) : encodeValue(field, value);
+    parts.push(Buffer.from([data.length]), data);
+  }
+  const encoded = Buffer.concat(parts);
+  if (encoded.length > MAX_VALUES) {
+    throw new Error(`values take ${encoded.length} bytes, at most ${MAX_VALUES}`);
+  }
+  return encoded;
+}
+
+// stores the template on the tag, see also McastTarget.TEMPLATE
+export function upload(
+  client: CommandClient,
+  number: number,
+  template: Template,
+  progress?: (sent: number, total: number) => void
+): Observable<never> {
+  const blob = encodeTemplate(template);
+  const offsets: number[] = [];
+  for (let offset = 0; offset < blob.length; offset += WRITE_CHUNK) {
+    offsets.push(offset);
+  }
+  return from(offsets).pipe(
+    concatMap((offset) => {
+      const args = Buffer.alloc(3);
+      args[0] = number;
+      args.writeUInt16LE(offset, 1);
+      const data = blob.subarray(offset, offset + WRITE_CHUNK);
+      progress?.(offset + data.length, blob.length);
+      return client.request(Command.LABEL_WRITE, Buffer.concat([args, data]));
+    }),
+    ignoreElements()
+  );
+}
+
+export function show(
+  client: CommandClient,
+  number: number,
+  template: Template,
+  values: Record<string, FieldValue>
+): Observable<Buffer> {
+  return client.request(
+    Command.LABEL_SHOW,
+    Buffer.concat([Buffer.from([number]), encodeValues(template, values)])
+  );
+}
@@ -0,0 +1,212 @@
+import { ChildProcess, spawn } from "child_process";
+import { rmSync } from "fs";
+import { tmpdir } from "os";
+import { join } from "path";
+import { performance } from "perf_hooks";
+import {
+  Observable,
+  catchError,
+  concatMap,
+  defer,
+  finalize,
+  from,
+  map,
+  mergeMap,
+  of,
+  retry,
+  tap,
+  toArray,
+} from "rxjs";
+import { CommandClient } from "./command-client";
+import { Command } from "./commands";
+import { linkFraming } from "./communication/ccm-stream";
+import { SerialStream } from "./communication/serial-stream";
+import { TransportStream } from "./communication/transport-stream";
+import { DataStream } from "./communication/types";
+import { Histogram } from "./metrics";
+
+// npm run link-bench -- [--sim <firmware.sim>] [--baud 115200,460800]
+//   [--sizes 0,16,64,116] [--concurrency 1,4] [--requests 500] [--window 4]
+//   [--rto 50]
+// Echo throughput and latency of the serial link, one JSON line per baud
+// rate, payload size and concurrency on stdout:
+//   {"baud":115200,"crc":true,"size":64,"concurrency":4,"requests":500,
+//    "errors":0,"seconds":1.9,"framesPerS":..,"payloadBytesPerS":..,
+//    "lineBytesPerS":..,"p50Ms":..,"p99Ms":..,"maxMs":..,
+//    "histogramMs":{"1":..,"2":..,...,"+Inf":..}}
+// frames and line bytes count both directions, acknowledgements and
+// retransmissions included, payload bytes the echoed data both ways.
+//
+// Against the tag on PORT by default, whose firmware fixes the baud rate
+// (UART_BAUD_E), so a sweep there is one run per build. --sim starts the
+// host build of the firmware (make sim) for every rate instead, paced with
+// its --baud. LINK_CRC=0 measures a tag built with make CRC=0, LINK_KEY a
+// sealed link.
+
+function option(name: string, fallback: string): string {
+  const index = process.argv.indexOf(`--${name}`);
+  return index < 0 ? fallback : process.argv[index + 1];
+}
+
+const list = (value: string) => value.split(",").map(Number);
+
+const sim = option("sim", "");
+const bauds = list(option("baud", "115200"));
+const sizes = list(option("sizes", "0,16,64,116"));
+const concurrencies = list(option("concurrency", "1,4"));
+const requests = Number(option("requests", "500"));
+const window = Number(option("window", "4"));
+// a full window of long frames takes longer than 50ms at 115200, raise it
+// there or see the retransmissions in framesPerS
+const rtoMs = Number(option("rto", "50"));
+const crc = !process.env.LINK_KEY && process.env.LINK_CRC !== "0";
+
+// at most COMMAND_MAX_REPLY, a reply must fit a transport frame
+const MAX_ECHO = 116;
+const BUCKETS_MS = [1, 2, 5, 10, 20, 50, 100, 200, 500, 1000];
+
+interface Counts {
+  frames: number;
+  lineBytes: number;
+}
+
+// counts what goes through a DataStream in both directions
+function counted(
+  inner: DataStream,
+  counts: Counts,
+  key: keyof Counts,
+  size: (msg: Buffer) => number
+): DataStream {
+  return {
+    rx$: inner.rx$.pipe(tap((msg) => (counts[key] += size(msg)))),
+    tx: (msg) => {
+      counts[key] += size(msg);
+      return inner.tx(msg);
+    },
+  };
+}
+
+// the stand-in tag, resolves to its pty once it is up, gone when we exit
+function startSim(baud: number): Observable<{ port: string; process: ChildProcess }> {
+  return new Observable((observer) => {
+    const link = join(tmpdir(), `link-bench-${process.pid}-${baud}`);
+    const child = spawn(sim, ["--pty", link, "--baud", String(baud)], {
+      stdio: ["ignore", "pipe", "inherit"],
+    });
+    child.once("error", (err) => observer.error(err));
+    process.once("exit", () => {
+      child.kill();
+      rmSync(link, { force: true });
+    });
+    child.stdout!.once("data", () => {
+      observer.next({ port: link, process: child });
+      observer.complete();
+    });
+  });
+}
+
+function quantile(sorted: number[], q: number): number {
+  return sorted[Math.min(sorted.length - 1, Math.floor(q * sorted.length))];
+}
+
+const round = (value: number) => Math.round(value * 100) / 100;
+
+function measure(
+  client: CommandClient,
+  counts: Counts,
+  baud: number,
+  size: number,
+  concurrency: number
+): Observable<object> {
+  return defer(() => {
+    const before = { ...counts };
+    const start = performance.now();
+    return from(Array.from({ length: requests }, (_, i) => i)).pipe(
+      mergeMap((i) => {
+        const payload = Buffer.alloc(size, i);
+        const sent = performance.now();
+        return client.request(Command.ECHO, payload).pipe(
+          map((reply) => (reply.equals(payload) ? performance.now() - sent : -1)),
+          catchError(() => of(-1))
+        );
+      }, concurrency),
+      toArray(),
+      map((times) => {
+        const seconds = (performance.now() - start) / 1000;
+        const ok = times.filter((t) => t >= 0).sort((a, b) => a - b);
+        const histogram = new Histogram(BUCKETS_MS);
+        ok.forEach((t) => histogram.observe(t));
+        const buckets: Record<string, number> = {};
+        histogram.counts.forEach((count, i) => {
+          buckets[String(BUCKETS_MS[i] ?? "+Inf")] = count;
+        });
+        return {
+          baud,
+          crc,
+          size,
+          concurrency,
+          requests,
+          errors: times.length - ok.length,
+          seconds: round(seconds),
+          framesPerS: round((counts.frames - before.frames) / seconds),
+          payloadBytesPerS: round((2 * size * ok.length) / seconds),
+          lineBytesPerS: round((counts.lineBytes - before.lineBytes) / seconds),
+          p50Ms: round(quantile(ok, 0.5) ?? NaN),
+          p99Ms: round(quantile(ok, 0.99) ?? NaN),
+          maxMs: round(ok[ok.length - 1] ?? NaN),
+          histogramMs: buckets,
+        };
+      })
+    );
+  });
+}
+
+function runBaud(baud: number): Observable<object> {
+  const port$: Observable<{ port: string; process?: ChildProcess }> = sim
+    ? startSim(baud)
+    : of({ port: process.env.PORT ?? "/dev/ttyUSB0" });
+  return port$.pipe(
+    concatMap(({ port, process: child }) => {
+      const counts: Counts = { frames: 0, lineBytes: 0 };
+      const serial = counted(
+        new SerialStream({ port, baud }),
+        counts,
+        "lineBytes",
+        (msg) => msg.length
+      );
+      const link = new TransportStream(
+        counted(linkFraming(serial), counts, "frames", () => 1),
+        { window, rtoMs }
+      );
+      const client = new CommandClient(link, 2000);
+      const points = sizes.flatMap((size) =>
+        concurrencies.map((concurrency) => ({ size, concurrency }))
+      );
+      // a ping first, the transport syncs with the tag
+      return client.request(Command.PING).pipe(
+        retry(5),
+        concatMap(() => from(points)),
+        concatMap(({ size, concurrency }) =>
+          measure(client, counts, baud, size, concurrency)
+        ),
+        finalize(() => child?.kill())
+      );
+    })
+  );
+}
+
+if (sizes.some((size) => size > MAX_ECHO)) {
+  console.error(`echo payloads are at most ${MAX_ECHO} bytes`);
+  process.exit(1);
+}
+
+from(bauds)
+  .pipe(concatMap((baud) => runBaud(baud)))
+  .subscribe({
+    next: (point) => console.log(JSON.stringify(point)),
+    complete: () => process.exit(0),
+    error: (err) => {
+      console.error(String(err));
+      process.exit(1);
+    },
+  });
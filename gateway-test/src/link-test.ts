@@ -0,0 +1,237 @@
+import { ChildProcess, spawn } from "child_process";
+import { mkdtempSync, readFileSync, rmSync } from "fs";
+import { tmpdir } from "os";
+import { join } from "path";
+import {
+  Observable,
+  filter,
+  firstValueFrom,
+  merge,
+  tap,
+  timeout,
+} from "rxjs";
+import { Command, Status } from "./commands";
+import {
+  CcmStream,
+  DIRECTION_HOST,
+  ccmSeal,
+  linkNonce,
+} from "./communication/ccm-stream";
+import { CobsStream } from "./communication/cobs-stream";
+import { SerialStream } from "./communication/serial-stream";
+import { TransportStream } from "./communication/transport-stream";
+import { DataStream } from "./communication/types";
+
+// LINK_KEY=<32 hex digits> npm test -- [--sim <firmware.sim>]
+// The sealed link between CcmStream and the firmware's crypto/link.c, both
+// ways: echo requests through the host build of the firmware made with the
+// same make LINK_KEY, on the AES coprocessor model. Prints "ok <test>" for
+// every test that passes, stops at the first that fails.
+
+function option(name: string, fallback: string): string {
+  const index = process.argv.indexOf(`--${name}`);
+  return index < 0 ? fallback : process.argv[index + 1];
+}
+
+const sim = option("sim", "../firmware/firmware.sim");
+const key = Buffer.from(process.env.LINK_KEY ?? "", "hex");
+const dir = mkdtempSync(join(tmpdir(), "link-test-"));
+const statePath = join(dir, "link-state.json");
+process.once("exit", () => rmSync(dir, { recursive: true, force: true }));
+
+// sim/w25x10.c keeps the flash's unique ID behind its 128KB
+const FLASH_SIZE = 0x20000;
+const UNIQUE_ID_SIZE = 8;
+const ID_SIZE = 4;
+const ANNOUNCE = 0x80000000;
+const REPLY_HEADER = 4;
+const TIMEOUT_MS = 2000;
+
+interface Tag {
+  flash: string;
+  port: string;
+  process: ChildProcess;
+}
+
+interface Host {
+  ccm: CcmStream;
+  link: DataStream;
+  sent: Buffer[]; // sealed frames to the tag
+  received: Buffer[]; // sealed frames from it
+}
+
+function check(condition: boolean, what: string) {
+  if (!condition) {
+    throw new Error(`${what} failed`);
+  }
+}
+
+// a stand-in tag with its own flash, so its own unique ID
+function startTag(name: string): Promise<Tag> {
+  const flash = join(dir, `${name}.flash`);
+  const port = join(dir, name);
+  const child = spawn(sim, ["--pty", port, "--flash", flash], {
+    stdio: ["ignore", "pipe", "inherit"],
+  });
+  process.once("exit", () => child.kill());
+  return new Promise((resolve, reject) => {
+    child.once("error", reject);
+    child.stdout!.once("data", () => resolve({ flash, port, process: child }));
+  });
+}
+
+// the id link.c puts in its frames, the unique ID folded to 32 bits
+function tagId(tag: Tag): Buffer {
+  const unique = readFileSync(tag.flash).subarray(
+    FLASH_SIZE,
+    FLASH_SIZE + UNIQUE_ID_SIZE
+  );
+  return Buffer.from(
+    Array.from({ length: ID_SIZE }, (_, i) => unique[i] ^ unique[i + ID_SIZE])
+  );
+}
+
+function logged(inner: DataStream, sent: Buffer[], received: Buffer[]): DataStream {
+  return {
+    rx$: inner.rx$.pipe(tap((frame) => received.push(frame))),
+    tx: (frame) => {
+      sent.push(frame);
+      return inner.tx(frame);
+    },
+  };
+}
+
+function connect(tag: Tag): Host {
+  const sent: Buffer[] = [];
+  const received: Buffer[] = [];
+  const cobs = new CobsStream(new SerialStream({ port: tag.port, baud: 115200 }));
+  const ccm = new CcmStream(logged(cobs, sent, received), key, statePath);
+  return { ccm, link: new TransportStream(ccm), sent, received };
+}
+
+// an echo through the transport, which drops the link when done with it
+async function echo(host: Host, payload: Buffer): Promise<void> {
+  for (let attempt = 0; ; attempt++) {
+    const id = Math.floor(Math.random() * 0x10000);
+    const request = Buffer.concat([
+      Buffer.from([Command.ECHO, id & 0xff, id >> 8]),
+      payload,
+    ]);
+    const reply$: Observable<Buffer> = merge(
+      host.link.rx$,
+      host.link.tx(request)
+    ).pipe(
+      filter((msg) => msg[0] === Command.ECHO && msg.readUInt16LE(1) === id),
+      timeout(TIMEOUT_MS)
+    );
+    try {
+      const reply = await firstValueFrom(reply$);
+      check(reply[3] === Status.OK, "echo status");
+      check(reply.subarray(REPLY_HEADER).equals(payload), "echoed payload");
+      return;
+    } catch (err) {
+      // the first request syncs the transport, and waits for the tag's id
+      if (attempt === 4) {
+        throw err;
+      }
+    }
+  }
+}
+
+const hostCounters = (host: Host) =>
+  host.sent.filter((frame) => frame.length > 1).map((frame) => frame.readUInt32BE(0));
+
+const idle = () => new Promise((resolve) => setTimeout(resolve, 600));
+
+let tag: Tag;
+let first: Host;
+
+const tests: [string, () => Promise<void>][] = [
+  [
+    "test_echo",
+    async () => {
+      first = connect(tag);
+      // across the 16 byte blocks, up to the longest echo
+      for (const size of [0, 1, 15, 16, 17, 32, 116]) {
+        await echo(first, Buffer.from(Array.from({ length: size }, (_, i) => i * 7 + size)));
+      }
+    },
+  ],
+  [
+    "test_tag_id",
+    async () => {
+      check(first.ccm.tagId?.equals(tagId(tag)) ?? false, "id from the flash");
+      // the first request went out as a probe, the tag announced itself
+      check(first.sent[0].length === 1, "probe");
+      check(
+        first.received.some((frame) => frame.readUInt32BE(ID_SIZE + 4) & ANNOUNCE),
+        "announcement"
+      );
+    },
+  ],
+  [
+    "test_other_id",
+    async () => {
+      // sealed for another tag, with a counter and epoch the tag would take:
+      // it refuses the frame and announces itself
+      await idle();
+      const counter = Math.max(...hostCounters(first)) + 1;
+      const epoch = first.received[first.received.length - 1].readUInt32BE(ID_SIZE);
+      const other = tagId(tag);
+      other[0] ^= 1;
+      const header = Buffer.alloc(4);
+      header.writeUInt32BE(counter);
+      const nonce = linkNonce(DIRECTION_HOST, epoch, counter, other);
+      const frame = Buffer.concat([header, ccmSeal(key, nonce, Buffer.alloc(8))]);
+      const cobs = new CobsStream(new SerialStream({ port: tag.port, baud: 115200 }));
+      await firstValueFrom(
+        merge(cobs.rx$, cobs.tx(frame)).pipe(
+          filter((reply) => !!(reply.readUInt32BE(ID_SIZE + 4) & ANNOUNCE)),
+          timeout(TIMEOUT_MS)
+        )
+      );
+    },
+  ],
+  [
+    "test_host_restart",
+    async () => {
+      // a new host with the same state file goes on above the counters the
+      // first one used, the tag takes its frames right away
+      await idle();
+      const second = connect(tag);
+      await echo(second, Buffer.from("again"));
+      const before = Math.max(...hostCounters(first));
+      check(Math.min(...hostCounters(second)) > before, "counters go on");
+      check(second.sent[0].length === 1, "probe");
+    },
+  ],
+  [
+    "test_two_tags",
+    async () => {
+      const other = await startTag("tag1");
+      const host = connect(other);
+      await echo(host, Buffer.from("other"));
+      check(host.ccm.tagId?.equals(tagId(other)) ?? false, "id from the flash");
+      check(!host.ccm.tagId!.equals(first.ccm.tagId!), "ids differ");
+      other.process.kill();
+    },
+  ],
+];
+
+async function main() {
+  if (key.length !== 16) {
+    throw new Error("LINK_KEY must be the 32 hex digits the sim was built with");
+  }
+  tag = await startTag("tag0");
+  for (const [name, test] of tests) {
+    await test();
+    console.log(`ok ${name}`);
+  }
+}
+
+main()
+  .then(() => process.exit(0))
+  .catch((err) => {
+    console.error(String(err));
+    process.exit(1);
+  });
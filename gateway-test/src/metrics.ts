@@ -0,0 +1,132 @@
+// Counters, gauges and histograms in the Prometheus text format, for the
+// gateway's /metrics. Labels are fixed when a series is made.
+
+export type Labels = Record<string, string>;
+
+export const LATENCY_BUCKETS_MS = [
+  5, 10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 30000, 60000,
+];
+
+export class Counter {
+  value = 0;
+
+  add(n = 1) {
+    this.value += n;
+  }
+}
+
+export class Histogram {
+  readonly counts: number[];
+  sum = 0;
+  count = 0;
+
+  constructor(readonly buckets: number[]) {
+    this.counts = new Array(buckets.length + 1).fill(0);
+  }
+
+  observe(value: number) {
+    let i = 0;
+    while (i < this.buckets.length && value > this.buckets[i]) {
+      i++;
+    }
+    this.counts[i]++;
+    this.sum += value;
+    this.count++;
+  }
+
+  // upper bound of the bucket holding the q quantile, Infinity past the last
+  quantile(q: number): number {
+    if (!this.count) {
+      return NaN;
+    }
+    let seen = 0;
+    for (let i = 0; i < this.counts.length; i++) {
+      seen += this.counts[i];
+      if (seen >= q * this.count) {
+        return this.buckets[i] ?? Infinity;
+      }
+    }
+    return Infinity;
+  }
+}
+
+type Sample = Counter | Histogram | (() => number);
+
+interface Family {
+  type: "counter" | "gauge" | "histogram";
+  help: string;
+  samples: { labels: Labels; sample: Sample }[];
+}
+
+function formatLabels(labels: Labels, extra?: Labels): string {
+  const all = Object.entries({ ...labels, ...extra });
+  return all.length
+    ? `{${all.map(([k, v]) => `${k}=${JSON.stringify(v)}`).join(",")}}`
+    : "";
+}
+
+export class Metrics {
+  private readonly families = new Map<string, Family>();
+
+  counter(name: string, help: string, labels: Labels = {}): Counter {
+    const counter = new Counter();
+    this.add(name, "counter", help, labels, counter);
+    return counter;
+  }
+
+  // read when rendered
+  gauge(name: string, help: string, labels: Labels, read: () => number) {
+    this.add(name, "gauge", help, labels, read);
+  }
+
+  histogram(
+    name: string,
+    help: string,
+    labels: Labels = {},
+    buckets = LATENCY_BUCKETS_MS
+  ): Histogram {
+    const histogram = new Histogram(buckets);
+    this.add(name, "histogram", help, labels, histogram);
+    return histogram;
+  }
+
+  render(): string {
+    const lines: string[] = [];
+    for (const [name, family] of this.families) {
+      lines.push(`# HELP ${name} ${family.help}`, `# TYPE ${name} ${family.type}`);
+      for (const { labels, sample } of family.samples) {
+        if (sample instanceof Histogram) {
+          let cumulative = 0;
+          sample.counts.forEach((count, i) => {
+            cumulative += count;
+            const le = String(sample.buckets[i] ?? "+Inf");
+            lines.push(`${name}_bucket${formatLabels(labels, { le })} ${cumulative}`);
+          });
+          lines.push(`${name}_sum${formatLabels(labels)} ${sample.sum}`);
+          lines.push(`${name}_count${formatLabels(labels)} ${sample.count}`);
+        } else {
+          const value = sample instanceof Counter ? sample.value : sample();
+          lines.push(`${name}${formatLabels(labels)} ${value}`);
+        }
+      }
+    }
+    return lines.join("\n") + "\n";
+  }
+
+  private add(
+    name: string,
+    type: Family["type"],
+    help: string,
+    labels: Labels,
+    sample: Sample
+  ) {
+    let family = this.families.get(name);
+    if (!family) {
+      family = { type, help, samples: [] };
+      this.families.set(name, family);
+    } else if (family.type !== type) {
+      throw new Error(`${name} is a ${family.type}`);
+    }
+    family.samples.push({ labels, sample });
+  }
+}
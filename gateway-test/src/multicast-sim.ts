@@ -0,0 +1,216 @@
+import { randomBytes } from "crypto";
+import {
+  GENERATION,
+  McastDecoder,
+  McastEncoder,
+  McastSymbol,
+  McastTarget,
+  SYMBOL_SIZE,
+} from "./multicast";
+
+// Air time of pushing one blob to many tags with lossy links: multicast
+// with repair rounds against the same blob sent to each tag in turn over a
+// selective repeat link.
+//
+// npm run multicast-sim -- [--tags 200] [--loss 0.1] [--burst 1]
+//   [--size 29696] [--rate 250000] [--seed 1]
+//
+// Each tag gets its own loss rate, uniform in 0 .. 2 * loss, and losses come
+// in bursts of --burst packets on average (Gilbert-Elliott). After the
+// source symbols the gateway polls every tag with MCAST_STATUS and sends as
+// many repair rounds as the worst generation of any tag is short, for the
+// generations someone still needs, until all tags are done. Tags that run
+// out of scratch space get the blob by unicast instead, that is counted as
+// part of the multicast.
+
+function option(name: string, fallback: number): number {
+  const index = process.argv.indexOf(`--${name}`);
+  return index < 0 ? fallback : Number(process.argv[index + 1]);
+}
+
+const TAGS = option("tags", 200);
+const LOSS = option("loss", 0.1);
+const BURST = option("burst", 1);
+const SIZE = option("size", 29696);
+const RATE = option("rate", 250000);
+let seed = option("seed", 1);
+
+// CC2510 packet: preamble, sync word, length, address, payload, CRC16
+const PACKET_OVERHEAD = 4 + 4 + 1 + 1 + 2;
+// a poll: MCAST_STATUS request and its reply over the radio
+const POLL_REQUEST = 1;
+const POLL_REPLY = 2 + 13 + 3;
+// unicast OTA_WRITE: transport header and CRC, command, offset and data,
+// the acknowledgement is a bare transport header and CRC
+const UNICAST_DATA = 4 + 1 + 2 + SYMBOL_SIZE + 2;
+const UNICAST_ACK = 4 + 2;
+
+function random(): number {
+  // mulberry32
+  seed = (seed + 0x6d2b79f5) | 0;
+  let t = Math.imul(seed ^ (seed >>> 15), 1 | seed);
+  t = (t + Math.imul(t ^ (t >>> 7), 61 | t)) ^ t;
+  return ((t ^ (t >>> 14)) >>> 0) / 4294967296;
+}
+
+class Channel {
+  private bad = false;
+  readonly loss: number;
+
+  constructor(mean: number) {
+    this.loss = Math.min(0.9, random() * 2 * mean);
+  }
+
+  // true when the packet gets through
+  deliver(): boolean {
+    if (BURST <= 1) {
+      return random() >= this.loss;
+    }
+    // stays bad for BURST packets on average, bad loss fraction of the time
+    const enterBad = this.loss / (BURST * (1 - this.loss));
+    this.bad = this.bad ? random() >= 1 / BURST : random() < enterBad;
+    return !this.bad;
+  }
+}
+
+function airTime(payload: number): number {
+  return ((PACKET_OVERHEAD + payload) * 8) / RATE;
+}
+
+interface Tag {
+  channel: Channel;
+  decoder: McastDecoder;
+}
+
+const data = randomBytes(SIZE);
+const encoder = new McastEncoder(data, 1, McastTarget.FIRMWARE);
+const tags: Tag[] = Array.from({ length: TAGS }, () => ({
+  channel: new Channel(LOSS),
+  decoder: new McastDecoder(encoder),
+}));
+
+let symbolsSent = 0;
+let multicastTime = 0;
+let pollTime = 0;
+let polls = 0;
+
+function send(symbols: Iterable<McastSymbol>) {
+  for (const symbol of symbols) {
+    const packet = encoder.symbol(symbol);
+    symbolsSent++;
+    multicastTime += airTime(packet.length);
+    for (const tag of tags) {
+      if (tag.channel.deliver()) {
+        tag.decoder.receive(symbol, packet);
+      }
+    }
+  }
+}
+
+// a poll repeats until both directions got through
+function poll(tag: Tag) {
+  do {
+    polls++;
+    pollTime += airTime(POLL_REQUEST) + airTime(POLL_REPLY);
+  } while (!tag.channel.deliver() || !tag.channel.deliver());
+}
+
+send(encoder.sources());
+let round = 0;
+let feedbackRounds = 0;
+for (;;) {
+  let worst = 0;
+  const pending = new Set<number>();
+  for (const tag of tags) {
+    if (tag.decoder.done || tag.decoder.stalled) {
+      continue;
+    }
+    poll(tag);
+    for (let g = 0; g < encoder.generations; g++) {
+      const needed = tag.decoder.neededIn(g);
+      if (needed) {
+        worst = Math.max(worst, needed);
+        pending.add(g);
+      }
+    }
+  }
+  if (!pending.size) {
+    break;
+  }
+  if (round + worst > 256 - GENERATION) {
+    console.error("out of repair symbols");
+    break;
+  }
+  feedbackRounds++;
+  const symbols = [...encoder.repairs(round, worst)].filter((symbol) =>
+    pending.has(symbol.generation)
+  );
+  send(symbols);
+  round += worst;
+}
+
+// the same blob to a tag over selective repeat: every data frame and its
+// ack repeat until both got through
+let unicastFrames = 0;
+function unicast(tag: Tag): number {
+  let time = 0;
+  for (let i = 0; i < encoder.symbols; i++) {
+    let delivered = false;
+    while (!delivered) {
+      unicastFrames++;
+      time += airTime(UNICAST_DATA);
+      if (tag.channel.deliver()) {
+        time += airTime(UNICAST_ACK);
+        delivered = tag.channel.deliver();
+      }
+    }
+  }
+  return time;
+}
+
+const stalled = tags.filter((tag) => tag.decoder.stalled);
+const fallbackTime = stalled.reduce((time, tag) => time + unicast(tag), 0);
+const multicastTotal = multicastTime + pollTime + fallbackTime;
+unicastFrames = 0;
+const unicastTime = tags.reduce((time, tag) => time + unicast(tag), 0);
+
+const failed = tags.filter(
+  (tag) =>
+    !tag.decoder.stalled &&
+    (!tag.decoder.done || !tag.decoder.output.subarray(0, SIZE).equals(data))
+).length;
+const losses = tags.map((tag) => tag.channel.loss);
+const used = tags.map((tag) => tag.decoder.symbolsUsed);
+const seconds = (s: number) => `${s.toFixed(2)}s`;
+
+console.log(
+  `${TAGS} tags, loss ${Math.min(...losses).toFixed(2)} .. ${Math.max(
+    ...losses
+  ).toFixed(2)}, bursts of ${BURST}, ${SIZE} bytes at ${RATE / 1000}kbit/s`
+);
+console.log(
+  `${encoder.symbols} source symbols in ${encoder.generations} generations`
+);
+console.log(
+  `multicast: ${symbolsSent} symbols (${(
+    (symbolsSent / encoder.symbols - 1) *
+    100
+  ).toFixed(1)}% repair) in ${feedbackRounds} feedback rounds, ${seconds(
+    multicastTime
+  )} + ${polls} polls ${seconds(pollTime)} + ${
+    stalled.length
+  } stalled tags by unicast ${seconds(fallbackTime)} = ${seconds(
+    multicastTotal
+  )}`
+);
+console.log(
+  `unicast:   ${unicastFrames} frames, ${seconds(unicastTime)}, ${(
+    unicastTime / multicastTotal
+  ).toFixed(1)}x the multicast air time`
+);
+console.log(
+  `symbols kept per tag: ${Math.min(...used)} .. ${Math.max(
+    ...used
+  )}, ${failed} tags failed`
+);
+process.exit(failed ? 1 : 0);
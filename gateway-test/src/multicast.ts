@@ -0,0 +1,372 @@
+import {
+  Observable,
+  concatMap,
+  from,
+  ignoreElements,
+  map,
+  retry,
+  tap,
+} from "rxjs";
+import { CommandClient } from "./command-client";
+import { Command } from "./commands";
+import { crc16 } from "./communication/crc";
+
+// matches firmware/src/mcast/mcast.h
+export const MCAST_ANNOUNCE = 0xa0;
+export const MCAST_SYMBOL = 0xa1;
+export const SYMBOL_HEADER = 4;
+export const SYMBOL_SIZE = 112;
+export const GENERATION = 16;
+export const MAX_ESI = 255;
+// repair symbols a tag can hold, the size of its scratch area in slots
+export const SCRATCH_SLOTS = 32;
+export const RADIO_BROADCAST = 0x00;
+
+export enum McastTarget {
+  FIRMWARE,
+  TEMPLATE, // label template n is TEMPLATE + n
+}
+
+export enum McastState {
+  IDLE,
+  RECEIVING,
+  DONE,
+  FAILED,
+  STALLED, // out of scratch space, needs a unicast transfer
+}
+
+// GF(2^8) over 0x11D, like firmware/src/mcast/gf256.c
+const EXP = new Uint8Array(510);
+const LOG = new Uint8Array(256);
+for (let i = 0, x = 1; i < 255; i++) {
+  EXP[i] = EXP[i + 255] = x;
+  LOG[x] = i;
+  x = x & 0x80 ? ((x << 1) ^ 0x11d) & 0xff : x << 1;
+}
+
+export function gfMul(a: number, b: number): number {
+  return a && b ? EXP[LOG[a] + LOG[b]] : 0;
+}
+
+export function gfInv(a: number): number {
+  return EXP[255 - LOG[a]];
+}
+
+// coefficient of source symbol j in repair symbol esi
+export function repairCoefficient(esi: number, j: number): number {
+  return gfInv(esi ^ j);
+}
+
+function mulAdd(dst: Uint8Array, src: Uint8Array, factor: number) {
+  if (!factor) {
+    return;
+  }
+  for (let i = 0; i < dst.length; i++) {
+    dst[i] ^= gfMul(factor, src[i]);
+  }
+}
+
+export interface McastSymbol {
+  generation: number;
+  esi: number;
+}
+
+export class McastEncoder {
+  readonly symbols: number;
+  readonly generations: number;
+  private readonly padded: Buffer;
+
+  constructor(
+    readonly data: Buffer,
+    readonly session: number,
+    readonly target: McastTarget
+  ) {
+    if (!data.length || data.length > 0xffff) {
+      throw new Error(`can not multicast ${data.length} bytes`);
+    }
+    if (session < 1 || session > 255) {
+      throw new Error("session must be 1 to 255");
+    }
+    this.symbols = Math.ceil(data.length / SYMBOL_SIZE);
+    this.generations = Math.ceil(this.symbols / GENERATION);
+    this.padded = Buffer.alloc(this.symbols * SYMBOL_SIZE);
+    data.copy(this.padded);
+  }
+
+  generationSize(generation: number): number {
+    return Math.min(GENERATION, this.symbols - generation * GENERATION);
+  }
+
+  announce(): Buffer {
+    const packet = Buffer.alloc(7);
+    packet[0] = MCAST_ANNOUNCE;
+    packet[1] = this.session;
+    packet[2] = this.target;
+    packet.writeUInt16LE(this.data.length, 3);
+    packet.writeUInt16LE(crc16(this.data), 5);
+    return packet;
+  }
+
+  source(index: number): Buffer {
+    return this.padded.subarray(index * SYMBOL_SIZE, (index + 1) * SYMBOL_SIZE);
+  }
+
+  // source symbol esi < generation size, repair symbol esi >= GENERATION
+  symbol({ generation, esi }: McastSymbol): Buffer {
+    const packet = Buffer.alloc(SYMBOL_HEADER + SYMBOL_SIZE);
+    packet[0] = MCAST_SYMBOL;
+    packet[1] = this.session;
+    packet[2] = generation;
+    packet[3] = esi;
+    const body = packet.subarray(SYMBOL_HEADER);
+    const first = generation * GENERATION;
+    if (esi < GENERATION) {
+      this.source(first + esi).copy(body);
+    } else {
+      for (let j = 0; j < this.generationSize(generation); j++) {
+        mulAdd(body, this.source(first + j), repairCoefficient(esi, j));
+      }
+    }
+    return packet;
+  }
+
+  // every generation's source symbols, interleaved so a burst of losses is
+  // spread over many generations
+  *sources(): Generator<McastSymbol> {
+    for (let esi = 0; esi < GENERATION; esi++) {
+      for (let generation = 0; generation < this.generations; generation++) {
+        if (esi < this.generationSize(generation)) {
+          yield { generation, esi };
+        }
+      }
+    }
+  }
+
+  // repair symbols round by round, round r of each generation has esi
+  // GENERATION + r, the tag relies on the increasing order
+  *repairs(firstRound: number, rounds: number): Generator<McastSymbol> {
+    const last = Math.min(firstRound + rounds, MAX_ESI + 1 - GENERATION);
+    for (let round = firstRound; round < last; round++) {
+      for (let generation = 0; generation < this.generations; generation++) {
+        yield { generation, esi: GENERATION + round };
+      }
+    }
+  }
+}
+
+// What a tag does with the symbols it hears, firmware/src/mcast/mcast.c
+// without the flash. Used by the simulator to count and to check the code.
+export class McastDecoder {
+  private readonly held: (Map<number, Uint8Array> | undefined)[];
+  private readonly lastRepair: number[];
+  private left: number;
+  private scratchUsed = 0;
+  readonly output: Buffer;
+  symbolsUsed = 0;
+  dropped = 0;
+  stalled = false;
+
+  constructor(private readonly encoder: McastEncoder) {
+    this.held = Array.from({ length: encoder.generations }, () => new Map());
+    this.lastRepair = new Array(encoder.generations).fill(0);
+    this.left = encoder.generations;
+    this.output = Buffer.alloc(encoder.symbols * SYMBOL_SIZE);
+  }
+
+  get done(): boolean {
+    return !this.left;
+  }
+
+  // symbols still needed, like the tag's MCAST_STATUS
+  get needed(): number {
+    let needed = 0;
+    this.held.forEach((held, generation) => {
+      if (held) {
+        needed += this.encoder.generationSize(generation) - held.size;
+      }
+    });
+    return needed;
+  }
+
+  neededIn(generation: number): number {
+    const held = this.held[generation];
+    return held ? this.encoder.generationSize(generation) - held.size : 0;
+  }
+
+  receive({ generation, esi }: McastSymbol, packet: Buffer) {
+    const held = this.held[generation];
+    const k = this.encoder.generationSize(generation);
+    const isSource = esi < k;
+    if (
+      this.stalled ||
+      !held ||
+      held.has(esi) ||
+      (!isSource &&
+        (esi < GENERATION || esi <= this.lastRepair[generation]))
+    ) {
+      this.dropped++;
+      return;
+    }
+    if (!isSource) {
+      if (this.scratchUsed === SCRATCH_SLOTS) {
+        this.stalled = true;
+        return;
+      }
+      this.scratchUsed++;
+      this.lastRepair[generation] = esi;
+    }
+    held.set(esi, Uint8Array.from(packet.subarray(SYMBOL_HEADER)));
+    this.symbolsUsed++;
+    if (held.size === k) {
+      this.decode(generation, held);
+      this.held[generation] = undefined;
+      this.left--;
+    }
+  }
+
+  private decode(generation: number, held: Map<number, Uint8Array>) {
+    const k = this.encoder.generationSize(generation);
+    const first = generation * GENERATION;
+    const missing: number[] = [];
+    for (let c = 0; c < k; c++) {
+      const symbol = held.get(c);
+      if (symbol) {
+        this.output.set(symbol, (first + c) * SYMBOL_SIZE);
+      } else {
+        missing.push(c);
+      }
+    }
+    const repairs = [...held.keys()].filter((esi) => esi >= GENERATION);
+
+    // invert the Cauchy matrix of repairs by missing symbols
+    const m = missing.length;
+    const a = repairs.map((esi) =>
+      missing.map((c) => repairCoefficient(esi, c))
+    );
+    for (let p = 0; p < m; p++) {
+      const pivot = gfInv(a[p][p]);
+      a[p][p] = 1;
+      a[p] = a[p].map((v) => gfMul(v, pivot));
+      for (let i = 0; i < m; i++) {
+        if (i !== p) {
+          const factor = a[i][p];
+          a[i][p] = 0;
+          a[i] = a[i].map((v, j) => v ^ gfMul(factor, a[p][j]));
+        }
+      }
+    }
+
+    // missing = inverse * (repairs - known sources in them)
+    repairs.forEach((esi, r) => {
+      const rhs = Uint8Array.from(held.get(esi)!);
+      for (let c = 0; c < k; c++) {
+        const symbol = held.get(c);
+        if (symbol) {
+          mulAdd(rhs, symbol, repairCoefficient(esi, c));
+        }
+      }
+      missing.forEach((c, i) => {
+        const out = this.output.subarray(
+          (first + c) * SYMBOL_SIZE,
+          (first + c + 1) * SYMBOL_SIZE
+        );
+        mulAdd(out, rhs, a[i][r]);
+      });
+    });
+  }
+}
+
+export interface BroadcastOptions {
+  session: number;
+  target: McastTarget;
+  // repair rounds sent after the source symbols, each one covers a lost
+  // symbol per generation on every tag
+  repairRounds: number;
+  // the announce is repeated every this many symbols
+  announceEvery?: number;
+}
+
+// the packets of one multicast session, in sending order
+export function* broadcastPackets(
+  encoder: McastEncoder,
+  repairRounds: number,
+  announceEvery = 64
+): Generator<Buffer> {
+  let count = 0;
+  const symbols = function* () {
+    yield* encoder.sources();
+    yield* encoder.repairs(0, repairRounds);
+  };
+  for (const symbol of symbols()) {
+    if (!(count++ % announceEvery)) {
+      yield encoder.announce();
+    }
+    yield encoder.symbol(symbol);
+  }
+  yield encoder.announce();
+}
+
+// sends a session through the tag on the serial link, which acts as the
+// gateway's radio. Tags have to be listening, see COMMAND_MCAST_LISTEN.
+export function broadcast(
+  client: CommandClient,
+  data: Buffer,
+  options: BroadcastOptions,
+  progress?: (sent: number) => void
+): Observable<never> {
+  const encoder = new McastEncoder(data, options.session, options.target);
+  let sent = 0;
+  return from(
+    broadcastPackets(encoder, options.repairRounds, options.announceEvery)
+  ).pipe(
+    concatMap((packet) =>
+      client
+        .request(
+          Command.RADIO_SEND,
+          Buffer.concat([Buffer.from([RADIO_BROADCAST]), packet])
+        )
+        .pipe(
+          // BUSY while the bridge's radio queue is full
+          retry({ count: 20, delay: 10 })
+        )
+    ),
+    tap(() => progress?.(++sent)),
+    ignoreElements()
+  );
+}
+
+export interface McastStatus {
+  state: McastState;
+  session: number;
+  needed: number;
+  worst: number; // most symbols a single generation still needs
+  symbols: number;
+  repairs: number;
+  dropped: number;
+  decoded: number;
+  pending: number[]; // generations not complete
+}
+
+export function readStatus(client: CommandClient): Observable<McastStatus> {
+  return client.request(Command.MCAST_STATUS).pipe(
+    map((reply) => {
+      const pending: number[] = [];
+      for (let g = 0; g < (reply.length - 13) * 8; g++) {
+        if (reply[13 + (g >> 3)] & (1 << (g & 7))) {
+          pending.push(g);
+        }
+      }
+      return {
+        state: reply[0],
+        session: reply[1],
+        needed: reply.readUInt16LE(2),
+        worst: reply[4],
+        symbols: reply.readUInt16LE(5),
+        repairs: reply.readUInt16LE(7),
+        dropped: reply.readUInt16LE(9),
+        decoded: reply.readUInt16LE(11),
+        pending,
+      };
+    })
+  );
+}
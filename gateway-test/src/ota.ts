@@ -0,0 +1,128 @@
+import { readFileSync } from "fs";
+import {
+  Observable,
+  concat,
+  defer,
+  ignoreElements,
+  map,
+  mergeMap,
+  range,
+  retry,
+  tap,
+  timer,
+} from "rxjs";
+import { CommandClient } from "./command-client";
+import { Command } from "./commands";
+import { crc16 } from "./communication/crc";
+
+// matches firmware/src/ota/image.h
+export const APP_START = 0x0800;
+export const APP_SIZE = 0x7400;
+
+// offset (16 bit) + data fits a transport frame with the command header
+const CHUNK_SIZE = 112;
+// chunks in flight, the tag's transport window
+const CONCURRENCY = 4;
+const REBOOT_WAIT_MS = 3000;
+
+export enum OtaState {
+  IDLE,
+  PENDING,
+  INSTALLING,
+  TRIAL,
+  REVERTING,
+}
+
+export interface OtaStatus {
+  state: OtaState;
+  attempts: number;
+  rolledBack: boolean;
+  imageSize: number;
+  imageCrc: number;
+}
+
+// the application image out of an Intel HEX file, from APP_START on
+export function readImage(fileName: string): Buffer {
+  const image = Buffer.alloc(APP_SIZE, 0xff);
+  let size = 0;
+  let base = 0;
+  for (const line of readFileSync(fileName, "utf8").split(/\r?\n/)) {
+    if (!line.startsWith(":")) {
+      continue;
+    }
+    const record = Buffer.from(line.substring(1), "hex");
+    const [length, addressHigh, addressLow, type] = record;
+    const data = record.subarray(4, 4 + length);
+    if (type === 0x04) {
+      base = data.readUInt16BE(0) << 16;
+    } else if (type === 0x00) {
+      const address = base + ((addressHigh << 8) | addressLow) - APP_START;
+      if (address < 0 || address + length > APP_SIZE) {
+        throw new Error(`${fileName}: data outside the application area`);
+      }
+      data.copy(image, address);
+      size = Math.max(size, address + length);
+    }
+  }
+  return image.subarray(0, size);
+}
+
+export function readStatus(client: CommandClient): Observable<OtaStatus> {
+  return client.request(Command.OTA_STATUS).pipe(
+    map((reply) => ({
+      state: reply[0],
+      attempts: reply[1],
+      rolledBack: !!(reply[2] & 0x01),
+      imageSize: reply.readUInt16LE(3),
+      imageCrc: reply.readUInt16LE(5),
+    }))
+  );
+}
+
+// stages the image, reboots into it and confirms it once the tag answers again
+export function update(
+  client: CommandClient,
+  image: Buffer,
+  progress?: (sent: number, total: number) => void
+): Observable<never> {
+  const crc = crc16(image);
+  const begin = Buffer.alloc(4);
+  begin.writeUInt16LE(image.length, 0);
+  begin.writeUInt16LE(crc, 2);
+
+  const chunks = Math.ceil(image.length / CHUNK_SIZE);
+  let sent = 0;
+
+  return concat(
+    client.request(Command.OTA_BEGIN, begin),
+    range(0, chunks).pipe(
+      mergeMap((index) => {
+        const offset = index * CHUNK_SIZE;
+        const header = Buffer.alloc(2);
+        header.writeUInt16LE(offset);
+        const data = image.subarray(offset, offset + CHUNK_SIZE);
+        return client
+          .request(Command.OTA_WRITE, Buffer.concat([header, data]))
+          .pipe(
+            retry(2),
+            tap(() => progress?.((sent += data.length), image.length))
+          );
+      }, CONCURRENCY)
+    ),
+    client.request(Command.OTA_FINISH),
+    client.request(Command.REBOOT),
+    // the bootloader backs up and installs before the tag answers again
+    timer(REBOOT_WAIT_MS).pipe(ignoreElements()),
+    defer(() => readStatus(client)).pipe(
+      retry({ count: 10, delay: 500 }),
+      tap((status) => {
+        if (status.state !== OtaState.TRIAL) {
+          throw new Error(
+            `new image did not start, state ${OtaState[status.state]}`
+          );
+        }
+      })
+    ),
+    client.request(Command.OTA_CONFIRM)
+  ).pipe(ignoreElements());
+}
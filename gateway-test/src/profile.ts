@@ -0,0 +1,93 @@
+import { Observable, concatMap, defer } from "rxjs";
+import { CommandClient } from "./command-client";
+import { Command } from "./commands";
+
+// mirrors the probe enum in firmware/src/profile/profile.h
+export const PROBE_NAMES = [
+  "cobs_rx_poll",
+  "transport_receive",
+  "transport_send",
+  "epd_sendData",
+  "epd_sendBand",
+  "label_render",
+  "bitmap_span",
+  "bitmap_blit",
+  "bitmap_transpose",
+  "bitmap_rotate",
+  "text_draw",
+];
+
+const FLAG_RESET = 0x01;
+const REPLY_HEADER = 2;
+const ENTRY_SIZE = 10;
+
+export interface ProbeStats {
+  name: string;
+  count: number;
+  total: number;
+  max: number;
+}
+
+// reads the whole probe table, one request per page
+export function readProfile(
+  client: CommandClient,
+  reset = false
+): Observable<ProbeStats[]> {
+  const probes: ProbeStats[] = [];
+
+  const page = (from: number): Observable<ProbeStats[]> =>
+    defer(() =>
+      client.request(
+        Command.PROFILE,
+        Buffer.from([from, reset ? FLAG_RESET : 0])
+      )
+    ).pipe(
+      concatMap((msg) => {
+        const count = msg[1];
+        if (msg.length < REPLY_HEADER + ENTRY_SIZE) {
+          throw new Error(`no entries from probe ${from}`);
+        }
+        for (
+          let offset = REPLY_HEADER;
+          offset + ENTRY_SIZE <= msg.length;
+          offset += ENTRY_SIZE
+        ) {
+          probes.push({
+            name: PROBE_NAMES[probes.length] ?? `probe ${probes.length}`,
+            count: msg.readUInt16LE(offset),
+            total: msg.readUInt32LE(offset + 2),
+            max: msg.readUInt32LE(offset + 6),
+          });
+        }
+        return probes.length < count ? page(probes.length) : [probes];
+      })
+    );
+
+  return page(0);
+}
+export function formatProfile(probes: ProbeStats[], clockHz = 26e6): string {
+  const rows = [["probe", "count", "total", "avg", "max", "avg us"]];
+  for (const { name, count, total, max } of probes) {
+    const avg = count ? total / count : 0;
+    rows.push([
+      name,
+      `${count}`,
+      `${total}`,
+      avg.toFixed(1),
+      `${max}`,
+      ((avg / clockHz) * 1e6).toFixed(2),
+    ]);
+  }
+  const widths = rows[0].map((_, i) =>
+    Math.max(...rows.map((row) => row[i].length))
+  );
+  return rows
+    .map((row) =>
+      row
+        .map((cell, i) =>
+          i ? cell.padStart(widths[i]) : cell.padEnd(widths[i])
+        )
+        .join("  ")
+    )
+    .join("\n");
+}
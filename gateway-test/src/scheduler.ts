@@ -0,0 +1,308 @@
+import { Observable, Subject, Subscription, first, of } from "rxjs";
+import { Command } from "./commands";
+import { Counter, Histogram, Metrics } from "./metrics";
+
+export interface Job {
+  tag: string;
+  command: Command;
+  args: Buffer;
+  priority: number; // 0 goes first
+  deadline: number; // Date.now() by which the reply is due, Infinity if never
+}
+
+export interface SchedulerConfig {
+  // requests on the link at once, the transport window is a good start
+  inFlight: number;
+  // of those for the same tag, which answers in order anyway
+  perTag: number;
+  // jobs waiting, submit() refuses more until they are down to resume
+  maxQueued: number;
+  resume: number;
+}
+
+export const defaultSchedulerConfig: SchedulerConfig = {
+  inFlight: 4,
+  perTag: 4,
+  maxQueued: 1000,
+  resume: 750,
+};
+
+export class QueueFullError extends Error {
+  constructor(link: string) {
+    super(`${link}: queue full`);
+  }
+}
+
+export class DeadlineError extends Error {
+  constructor(job: Job, sent: boolean) {
+    super(
+      `${Command[job.command] ?? job.command} for ${job.tag}: deadline passed ${
+        sent ? "in flight" : "before it was sent"
+      }`
+    );
+  }
+}
+
+// what the scheduler hands a job to, the CommandClient of the link for the
+// tag on it, TdmaRoute for tags behind it
+export type Send = (job: Job) => Observable<Buffer>;
+
+interface Entry {
+  job: Job;
+  order: number;
+  queuedAt: number;
+  resolve: (reply: Buffer) => void;
+  reject: (err: Error) => void;
+  state: "queued" | "sent" | "done";
+  expiry?: ReturnType<typeof setTimeout>;
+  tx?: Subscription;
+}
+
+// One link's outbound requests: a queue per tag, kept in priority order and
+// FIFO within a priority, and at most config.inFlight requests on the link.
+// The next request is the most urgent head of all the tag queues, earliest
+// deadline and then oldest first among equals. Jobs still waiting at their
+// deadline are dropped.
+//
+// Producers are held back by refusal: past maxQueued waiting jobs submit()
+// fails with QueueFullError until the queue drained to resume, whenReady()
+// says when that is.
+export class LinkScheduler {
+  private readonly queues = new Map<string, Entry[]>();
+  private readonly busy = new Map<string, number>(); // in flight per tag
+  private readonly ready = new Subject<void>();
+  private queued = 0;
+  private inFlight = 0;
+  private order = 0;
+  private full = false;
+
+  private readonly results: Record<
+    "ok" | "failed" | "expired" | "rejected",
+    Counter
+  >;
+  private readonly bytes: Counter;
+  private readonly queueWait: Histogram;
+  private readonly roundTrip: Histogram;
+
+  constructor(
+    readonly name: string,
+    private readonly send: Send,
+    metrics: Metrics,
+    private readonly config = defaultSchedulerConfig
+  ) {
+    const labels = { link: name };
+    const gauge = (name: string, help: string, read: () => number) =>
+      metrics.gauge(name, help, labels, read);
+    gauge("gateway_queued", "jobs waiting", () => this.queued);
+    gauge("gateway_tags_queued", "tags with jobs waiting", () => this.queues.size);
+    gauge("gateway_in_flight", "requests not answered yet", () => this.inFlight);
+    gauge("gateway_accepting", "1 while jobs are taken", () => +!this.full);
+    const result = (result: string) =>
+      metrics.counter("gateway_requests_total", "jobs by outcome", {
+        ...labels,
+        result,
+      });
+    this.results = {
+      ok: result("ok"),
+      failed: result("failed"),
+      expired: result("expired"),
+      rejected: result("rejected"),
+    };
+    this.bytes = metrics.counter(
+      "gateway_request_bytes_total",
+      "request bytes sent",
+      labels
+    );
+    this.queueWait = metrics.histogram(
+      "gateway_queue_wait_ms",
+      "time from submit to send",
+      labels
+    );
+    this.roundTrip = metrics.histogram(
+      "gateway_round_trip_ms",
+      "time from send to reply",
+      labels
+    );
+  }
+
+  get depth(): number {
+    return this.queued;
+  }
+
+  get accepting(): boolean {
+    return !this.full;
+  }
+
+  stats() {
+    return {
+      inFlight: this.inFlight,
+      ok: this.results.ok.value,
+      failed: this.results.failed.value,
+      expired: this.results.expired.value,
+      rejected: this.results.rejected.value,
+      queueWait: this.queueWait,
+      roundTrip: this.roundTrip,
+    };
+  }
+
+  // completes once submit() takes jobs again
+  whenReady(): Observable<void> {
+    return this.full ? this.ready.pipe(first()) : of(undefined);
+  }
+
+  // the reply payload, or an error, queued when subscribed
+  submit(job: Job): Observable<Buffer> {
+    return new Observable<Buffer>((observer) => {
+      if (this.full) {
+        this.results.rejected.add();
+        observer.error(new QueueFullError(this.name));
+        return;
+      }
+      const entry: Entry = {
+        job,
+        order: this.order++,
+        queuedAt: Date.now(),
+        resolve: (reply) => {
+          observer.next(reply);
+          observer.complete();
+        },
+        reject: (err) => observer.error(err),
+        state: "queued",
+      };
+      if (job.deadline !== Infinity) {
+        entry.expiry = setTimeout(
+          () => this.expire(entry),
+          Math.max(0, job.deadline - entry.queuedAt)
+        );
+      }
+      this.enqueue(entry);
+      this.pump();
+      return () => {
+        clearTimeout(entry.expiry);
+        if (entry.state === "queued") {
+          this.dequeue(entry);
+          entry.state = "done";
+        } else {
+          entry.tx?.unsubscribe();
+          this.finish(entry);
+        }
+      };
+    });
+  }
+
+  private enqueue(entry: Entry) {
+    let queue = this.queues.get(entry.job.tag);
+    if (!queue) {
+      queue = [];
+      this.queues.set(entry.job.tag, queue);
+    }
+    let i = queue.length;
+    while (i > 0 && queue[i - 1].job.priority > entry.job.priority) {
+      i--;
+    }
+    queue.splice(i, 0, entry);
+    this.queued++;
+    if (this.queued >= this.config.maxQueued) {
+      this.full = true;
+    }
+  }
+
+  private dequeue(entry: Entry) {
+    const queue = this.queues.get(entry.job.tag)!;
+    queue.splice(queue.indexOf(entry), 1);
+    if (!queue.length) {
+      this.queues.delete(entry.job.tag);
+    }
+    this.queued--;
+    if (this.full && this.queued <= this.config.resume) {
+      this.full = false;
+      this.ready.next();
+    }
+  }
+
+  private expire(entry: Entry) {
+    const sent = entry.state === "sent";
+    if (sent) {
+      entry.tx?.unsubscribe();
+      this.finish(entry);
+    } else if (entry.state === "queued") {
+      this.dequeue(entry);
+      entry.state = "done";
+    } else {
+      return;
+    }
+    this.results.expired.add();
+    entry.reject(new DeadlineError(entry.job, sent));
+  }
+
+  // the next job to send, of the tags that can take one more
+  private next(): Entry | undefined {
+    let best: Entry | undefined;
+    for (const [tag, queue] of this.queues) {
+      if ((this.busy.get(tag) ?? 0) >= this.config.perTag) {
+        continue;
+      }
+      const head = queue[0];
+      if (
+        !best ||
+        head.job.priority < best.job.priority ||
+        (head.job.priority === best.job.priority &&
+          (head.job.deadline < best.job.deadline ||
+            (head.job.deadline === best.job.deadline && head.order < best.order)))
+      ) {
+        best = head;
+      }
+    }
+    return best;
+  }
+
+  private pump() {
+    let entry: Entry | undefined;
+    while (this.inFlight < this.config.inFlight && (entry = this.next())) {
+      this.dispatch(entry);
+    }
+  }
+
+  private dispatch(entry: Entry) {
+    this.dequeue(entry);
+    const { job } = entry;
+    this.inFlight++;
+    this.busy.set(job.tag, (this.busy.get(job.tag) ?? 0) + 1);
+    const sentAt = Date.now();
+    this.queueWait.observe(sentAt - entry.queuedAt);
+    this.bytes.add(1 + job.args.length);
+    entry.state = "sent";
+    entry.tx = this.send(job).subscribe({
+      next: (reply) => {
+        clearTimeout(entry.expiry);
+        this.roundTrip.observe(Date.now() - sentAt);
+        this.results.ok.add();
+        this.finish(entry);
+        entry.resolve(reply);
+      },
+      error: (err) => {
+        clearTimeout(entry.expiry);
+        this.results.failed.add();
+        this.finish(entry);
+        entry.reject(err);
+      },
+    });
+  }
+
+  // frees the job's place on the link, once
+  private finish(entry: Entry) {
+    if (entry.state !== "sent") {
+      return;
+    }
+    entry.state = "done";
+    const tag = entry.job.tag;
+    this.inFlight--;
+    const busy = this.busy.get(tag)! - 1;
+    if (busy) {
+      this.busy.set(tag, busy);
+    } else {
+      this.busy.delete(tag);
+    }
+    this.pump();
+  }
+}
@@ -0,0 +1,134 @@
+import { readFileSync, writeFileSync } from "fs";
+import { dirname, resolve } from "path";
+import { EMPTY, concat, defer } from "rxjs";
+import { CommandClient } from "./command-client";
+import { linkFraming } from "./communication/ccm-stream";
+import { SerialStream } from "./communication/serial-stream";
+import { TransportStream } from "./communication/transport-stream";
+import { Font } from "./fonts";
+import {
+  Align,
+  Color,
+  Field,
+  FieldType,
+  PLANE_SIZE,
+  Rotation,
+  Template,
+  encodeTemplate,
+  encodeValues,
+  readPbm,
+  show,
+  upload,
+} from "./label";
+
+// npm run label -- <layout.json> [--template n] [--upload] [--save file]
+//   [name=value ...]
+// Shows a label on the tag on the serial link: with --upload the template
+// is stored first, the values alone are sent after that. --save writes the
+// template blob instead, for npm run broadcast. The layout is
+//   { "rotation": 90, "black": "art.pbm", "red": "red.pbm",
+//     "fields": [{ "name": "price", "type": "price", "x": 8, "y": 200,
+//                  "width": 136, "height": 40, "scale": 4,
+//                  "align": "right", "alt": true, "ink": "red",
+//                  "font": "digits_36", "centsFont": "digits_18" }] }
+// with the label turned clockwise onto the panel by rotation, 0 to 270, and
+// PBM artwork of the label size, all optional. Fonts are "builtin" at the
+// scale or an atlas from firmware/tools/fonts.json.
+const layoutName = process.argv[2];
+if (!layoutName) {
+  console.error(
+    "usage: label <layout.json> [--template n] [--upload] [--save file] [name=value ...]"
+  );
+  process.exit(1);
+}
+
+function option(name: string): string | undefined {
+  const index = process.argv.indexOf(`--${name}`);
+  return index < 0 ? undefined : process.argv[index + 1];
+}
+
+function named<T>(names: object, value: unknown, fallback: T): T {
+  if (value === undefined) {
+    return fallback;
+  }
+  const key = String(value).toUpperCase();
+  if (!(key in names)) {
+    throw new Error(`unknown ${value}`);
+  }
+  return (names as Record<string, T>)[key];
+}
+
+const layout = JSON.parse(readFileSync(layoutName, "utf8"));
+const rotation: Rotation = Number(layout.rotation ?? 0) / 90;
+if (!(rotation in Rotation)) {
+  throw new Error(`bad rotation ${layout.rotation}`);
+}
+const art = (file?: string) =>
+  file ? readPbm(resolve(dirname(layoutName), file), rotation) : undefined;
+const template: Template = {
+  rotation,
+  black: art(layout.black),
+  red: art(layout.red),
+  fields: (layout.fields ?? []).map(
+    (field: Record<string, unknown>): Field => ({
+      name: String(field.name),
+      type: named(FieldType, field.type, FieldType.TEXT),
+      x: Number(field.x),
+      y: Number(field.y),
+      width: Number(field.width),
+      height: Number(field.height),
+      scale: field.scale === undefined ? undefined : Number(field.scale),
+      font: named(Font, field.font, Font.BUILTIN),
+      centsFont: named(Font, field.centsFont, Font.BUILTIN),
+      align: named(Align, field.align, Align.LEFT),
+      alt: Boolean(field.alt),
+      ink: named(Color, field.ink, Color.BLACK),
+      background: named(Color, field.background, Color.NONE),
+    })
+  ),
+};
+
+const values: Record<string, string> = {};
+for (const arg of process.argv.slice(3)) {
+  const match = /^([^=]+)=(.*)$/.exec(arg);
+  if (match) {
+    values[match[1]] = match[2];
+  }
+}
+
+const saveName = option("save");
+if (saveName) {
+  writeFileSync(saveName, encodeTemplate(template));
+  process.exit(0);
+}
+
+const number = Number(option("template") ?? 0);
+const encoded = encodeValues(template, values);
+console.log(
+  `values ${encoded.length + 2} bytes, a full frame ${2 * PLANE_SIZE} bytes`
+);
+
+const serial = new SerialStream({
+  port: process.env.PORT ?? "/dev/ttyUSB0",
+  baud: 115200,
+});
+const link = new TransportStream(linkFraming(serial), { window: 4 });
+const client = new CommandClient(link);
+
+concat(
+  process.argv.includes("--upload")
+    ? upload(client, number, template, (sent, total) =>
+        process.stdout.write(`\r${Math.round((sent * 100) / total)}%`)
+      )
+    : EMPTY,
+  defer(() => show(client, number, template, values))
+).subscribe({
+  complete: () => {
+    console.log();
+    process.exit(0);
+  },
+  error: (err) => {
+    console.error(`\n${err}`);
+    process.exit(1);
+  },
+});
@@ -0,0 +1,68 @@
+import { FRAME_MS, SLOTS, SLOT_MS, SlotCalendar, windowMs } from "./tdma";
+
+// What a slot calendar promises for a deployment: how long tags listen and
+// how long an update for every tag waits for its slots.
+//
+// npm run tdma-plan -- [--tags 1000] [--period 4] [--requests 1]
+//
+// All tags wake every 2^period frames. Each gets --requests requests at
+// once, packed into the earliest slots with room.
+
+function option(name: string, fallback: number): number {
+  const index = process.argv.indexOf(`--${name}`);
+  return index < 0 ? fallback : Number(process.argv[index + 1]);
+}
+
+const TAGS = option("tags", 1000);
+const PERIOD = option("period", 4);
+const REQUESTS = option("requests", 1);
+
+const calendar = new SlotCalendar();
+for (let address = 1; address <= TAGS; address++) {
+  calendar.assign(address, PERIOD);
+}
+const cycle = SLOTS << PERIOD;
+const perCell = new Map<number, number>();
+for (const tag of calendar.assignments) {
+  const key = tag.slot * 16 + tag.phase;
+  perCell.set(key, (perCell.get(key) ?? 0) + 1);
+}
+
+// the update arrives at a random point of the cycle
+const now = 12345;
+const requests = [];
+for (let r = 0; r < REQUESTS; r++) {
+  for (let address = 1; address <= TAGS; address++) {
+    requests.push({ address, request: Buffer.from([0]) });
+  }
+}
+const placed = calendar.pack(requests, now);
+const waits = placed.map((p) => ((p.time - now) * SLOT_MS) / 1000).sort(
+  (a, b) => a - b
+);
+const percentile = (p: number) =>
+  waits[Math.min(waits.length - 1, Math.floor(p * waits.length))];
+const wakeMs = windowMs(PERIOD);
+const periodS = (FRAME_MS << PERIOD) / 1000;
+
+console.log(
+  `${TAGS} tags waking every ${periodS}s, at most ${Math.max(
+    ...perCell.values()
+  )} per slot`
+);
+console.log(
+  `listening ${wakeMs.toFixed(1)}ms per wakeup, ${(
+    ((wakeMs / 1000) * 86400) /
+    periodS
+  ).toFixed(1)}s a day (${((wakeMs / (periodS * 1000)) * 100).toFixed(3)}%)`
+);
+console.log(
+  `${placed.length} requests: first after ${waits[0].toFixed(
+    2
+  )}s, median ${percentile(0.5).toFixed(2)}s, 99% ${percentile(
+    0.99
+  ).toFixed(2)}s, all ${waits[waits.length - 1].toFixed(2)}s (cycle ${(
+    (cycle * SLOT_MS) /
+    1000
+  ).toFixed(1)}s)`
+);
@@ -0,0 +1,466 @@
+import {
+  Observable,
+  Subscription,
+  concatMap,
+  exhaustMap,
+  from,
+  interval,
+  map,
+  of,
+  retry,
+  timer,
+  toArray,
+} from "rxjs";
+import { CommandClient, CommandError } from "./command-client";
+import { Command, Status } from "./commands";
+
+// matches firmware/src/tdma/tdma.h
+export const SLOTS = 64;
+export const SLOT_MS = 50;
+export const FRAME_MS = SLOTS * SLOT_MS;
+export const MAX_PERIOD = 4;
+export const MAX_LISTED = 8;
+// requests the coordinator holds at once, tdma.c MAX_QUEUED
+export const MAX_QUEUED = 3;
+const PHASES = 1 << MAX_PERIOD;
+
+export enum TdmaState {
+  OFF,
+  SEARCH,
+  SLEEP,
+  WINDOW,
+  SLOT,
+  COORDINATOR,
+}
+
+export interface Assignment {
+  address: number;
+  slot: number;
+  period: number; // wakes every 2^period frames
+  phase: number; // in frames with frame % 2^period == phase
+}
+
+export interface Request {
+  address: number;
+  request: Buffer; // opcode | id | args
+}
+
+// a request placed in a slot, time counts slots since frame 0
+export interface Placed extends Request {
+  frame: number;
+  slot: number;
+  time: number;
+}
+
+// The gateway's view of who wakes when. Assignments spread tags over slots
+// and phases so every slot of the 2^MAX_PERIOD frame cycle has about the
+// same number of tags, requests go into the earliest wakeup of their tag
+// that still has room.
+export class SlotCalendar {
+  private readonly tags = new Map<number, Assignment>();
+  // tags awake in (slot, frame % PHASES)
+  private readonly load = new Uint16Array(SLOTS * PHASES);
+
+  constructor(
+    // slots kept free for other traffic, a multicast session say
+    private readonly reserved: number[] = []
+  ) {}
+
+  get assignments(): Assignment[] {
+    return [...this.tags.values()];
+  }
+
+  assignment(address: number): Assignment | undefined {
+    return this.tags.get(address);
+  }
+
+  // least loaded slot and phase for the period, the same address keeps its
+  // place when the period did not change
+  assign(address: number, period: number): Assignment {
+    if (period < 0 || period > MAX_PERIOD) {
+      throw new Error(`period must be 0 to ${MAX_PERIOD}`);
+    }
+    const current = this.tags.get(address);
+    if (current?.period === period) {
+      return current;
+    }
+    this.release(address);
+    let best: Assignment | undefined;
+    let bestLoad = Infinity;
+    for (let slot = 0; slot < SLOTS; slot++) {
+      if (this.reserved.includes(slot)) {
+        continue;
+      }
+      for (let phase = 0; phase < 1 << period; phase++) {
+        const load = this.worstLoad(slot, period, phase);
+        if (load < bestLoad) {
+          best = { address, slot, period, phase };
+          bestLoad = load;
+        }
+      }
+    }
+    if (!best) {
+      throw new Error("no slot left");
+    }
+    this.tags.set(address, best);
+    this.mark(best, 1);
+    return best;
+  }
+
+  release(address: number) {
+    const current = this.tags.get(address);
+    if (current) {
+      this.mark(current, -1);
+      this.tags.delete(address);
+    }
+  }
+
+  // first slot time >= after the tag is awake in
+  nextWake(address: number, after: number): number {
+    const tag = this.tags.get(address);
+    if (!tag) {
+      throw new Error(`no slot for ${address}`);
+    }
+    let frame = Math.floor(after / SLOTS);
+    if (frame * SLOTS + tag.slot < after) {
+      frame++;
+    }
+    const mask = (1 << tag.period) - 1;
+    frame += (tag.phase - frame) & mask;
+    return frame * SLOTS + tag.slot;
+  }
+
+  // requests in arrival order into the earliest wakeups at or after now with
+  // room: at most perSlot requests and MAX_LISTED tags per slot. Requests for
+  // the same tag keep their order. used holds what earlier calls placed, by
+  // slot time, and gets the new requests added.
+  pack(
+    requests: Request[],
+    now: number,
+    perSlot = MAX_QUEUED,
+    used = new Map<number, Placed[]>()
+  ): Placed[] {
+    const earliest = new Map<number, number>();
+    const placed = requests.map((request) => {
+      let time = this.nextWake(
+        request.address,
+        earliest.get(request.address) ?? now
+      );
+      for (;;) {
+        const inSlot = used.get(time) ?? [];
+        const tags = new Set(inSlot.map((p) => p.address));
+        tags.add(request.address);
+        if (inSlot.length < perSlot && tags.size <= MAX_LISTED) {
+          break;
+        }
+        time = this.nextWake(request.address, time + 1);
+      }
+      const entry: Placed = {
+        ...request,
+        time,
+        frame: Math.floor(time / SLOTS) & 0xffff,
+        slot: time % SLOTS,
+      };
+      used.set(time, [...(used.get(time) ?? []), entry]);
+      earliest.set(request.address, time);
+      return entry;
+    });
+    return placed.sort((a, b) => a.time - b.time);
+  }
+
+  private worstLoad(slot: number, period: number, phase: number): number {
+    let worst = 0;
+    for (let f = phase; f < PHASES; f += 1 << period) {
+      worst = Math.max(worst, this.load[slot * PHASES + f]);
+    }
+    return worst;
+  }
+
+  private mark(tag: Assignment, delta: number) {
+    for (let f = tag.phase; f < PHASES; f += 1 << tag.period) {
+      this.load[tag.slot * PHASES + f] += delta;
+    }
+  }
+}
+
+// listen time of one wakeup, like tdma.c: a window of twice the guard plus
+// the beacon, the guard 3ms plus 61ppm of the time since the last beacon
+export function windowMs(period: number): number {
+  const guard = 3 + (FRAME_MS << period) / (1 << 14);
+  return 2 * guard + 2;
+}
+
+export interface TdmaStatus {
+  state: TdmaState;
+  slot: number;
+  period: number;
+  phase: number;
+  frame: number;
+  queued: number;
+  replies: number;
+  beacons: number;
+  misses: number;
+  requests: number;
+  expired: number;
+  drift: number; // ppm
+  windowMs: number;
+}
+
+export function readStatus(client: CommandClient): Observable<TdmaStatus> {
+  return client.request(Command.TDMA_STATUS).pipe(
+    map((reply) => ({
+      state: reply[0],
+      slot: reply[1],
+      period: reply[2],
+      phase: reply[3],
+      frame: reply.readUInt16LE(4),
+      queued: reply[6],
+      replies: reply[7],
+      beacons: reply.readUInt16LE(8),
+      misses: reply.readUInt16LE(10),
+      requests: reply.readUInt16LE(12),
+      expired: reply.readUInt16LE(14),
+      drift: (reply.readInt16LE(16) * 1e6) / (1 << 20),
+      windowMs: (reply.readUInt16LE(18) * 3) / 104,
+    }))
+  );
+}
+
+// to the tag itself: on the serial link, by NFC, or in its current slot
+export function assign(
+  client: CommandClient,
+  { slot, period, phase }: Assignment
+): Observable<Buffer> {
+  return client.request(
+    Command.TDMA_ASSIGN,
+    Buffer.from([slot, period, phase])
+  );
+}
+
+export function coordinate(
+  client: CommandClient,
+  enable: boolean
+): Observable<Buffer> {
+  return client.request(Command.TDMA_COORDINATE, Buffer.from([+enable]));
+}
+
+export function queue(
+  client: CommandClient,
+  { address, frame, slot, request }: Placed
+): Observable<Buffer> {
+  const args = Buffer.alloc(4);
+  args[0] = address;
+  args.writeUInt16LE(frame, 1);
+  args[3] = slot;
+  return client
+    .request(Command.TDMA_QUEUE, Buffer.concat([args, request]))
+    .pipe(
+      // BUSY while the coordinator holds MAX_QUEUED requests
+      retry({ count: 100, delay: SLOT_MS })
+    );
+}
+
+export interface TdmaReply {
+  address: number;
+  reply: Buffer; // opcode | id | status | payload
+}
+
+// the answers the coordinator heard since the last call
+export function receive(client: CommandClient): Observable<TdmaReply[]> {
+  const next = (replies: TdmaReply[]): Observable<TdmaReply[]> =>
+    client.request(Command.TDMA_RECEIVE).pipe(
+      concatMap((payload) =>
+        payload.length
+          ? next([
+              ...replies,
+              { address: payload[0], reply: payload.subarray(1) },
+            ])
+          : from([replies])
+      )
+    );
+  return next([]);
+}
+
+// packs the requests against the coordinator's clock and hands them over in
+// slot order, the coordinator only holds a few so each goes shortly before
+// its slot
+export function schedule(
+  client: CommandClient,
+  calendar: SlotCalendar,
+  requests: Request[]
+): Observable<Placed[]> {
+  return readStatus(client).pipe(
+    concatMap((status) => {
+      if (status.state !== TdmaState.COORDINATOR) {
+        throw new Error("the bridge is not coordinating");
+      }
+      // a couple of slots for the serial link
+      const now = status.frame * SLOTS + status.slot + 2;
+      const placed = calendar.pack(requests, now);
+      return from(placed).pipe(
+        concatMap((entry) => queue(client, entry).pipe(map(() => entry))),
+        toArray()
+      );
+    })
+  );
+}
+
+// slots before its slot a request goes to the coordinator, which only holds
+// MAX_QUEUED at once
+const QUEUE_LEAD = 4;
+// slots after its slot a request is given up on
+const REPLY_SLOTS = SLOTS;
+const RECEIVE_POLL_MS = 4 * SLOT_MS;
+const CLOCK_MAX_AGE_MS = 60000;
+
+interface Waiting {
+  resolve: (reply: Buffer) => void;
+  reject: (err: Error) => void;
+}
+
+// Requests to tags behind the coordinator one at a time, as they come,
+// rather than in batches like schedule(): each goes into the earliest wakeup
+// of its tag with room, is handed over shortly before that slot, and its
+// answer is picked up with TDMA_RECEIVE, polled while answers are due.
+// Answers are matched by tag and request id.
+export class TdmaRoute {
+  private clock?: { time: number; at: number }; // slot time at Date.now()
+  private readonly used = new Map<number, Placed[]>();
+  private readonly waiting = new Map<number, Waiting>(); // by address, id
+  private nextId = Math.floor(Math.random() * 0x10000);
+  private poll?: Subscription;
+
+  constructor(
+    private readonly client: CommandClient,
+    readonly calendar: SlotCalendar
+  ) {}
+
+  // the reply payload, like CommandClient.request
+  request(
+    address: number,
+    command: Command,
+    args: Buffer = Buffer.alloc(0)
+  ): Observable<Buffer> {
+    return this.now().pipe(
+      concatMap((now) => {
+        const id = this.nextId;
+        this.nextId = (id + 1) & 0xffff;
+        const request = Buffer.concat([
+          Buffer.from([command, id & 0xff, id >> 8]),
+          args,
+        ]);
+        for (const time of this.used.keys()) {
+          if (time < now) {
+            this.used.delete(time);
+          }
+        }
+        const [placed] = this.calendar.pack(
+          [{ address, request }],
+          now,
+          MAX_QUEUED,
+          this.used
+        );
+        return timer(this.msUntil(placed.time - QUEUE_LEAD)).pipe(
+          concatMap(() => queue(this.client, placed)),
+          concatMap(() => this.reply(placed))
+        );
+      })
+    );
+  }
+
+  // slot time with a couple of slots for the serial link, from the
+  // coordinator's clock read at most CLOCK_MAX_AGE_MS ago
+  private now(): Observable<number> {
+    const clock = this.clock;
+    if (clock && Date.now() - clock.at < CLOCK_MAX_AGE_MS) {
+      return of(Math.ceil(this.slotTime(clock)) + 2);
+    }
+    return readStatus(this.client).pipe(
+      map((status) => {
+        if (status.state !== TdmaState.COORDINATOR) {
+          throw new Error("the bridge is not coordinating");
+        }
+        this.clock = { time: status.frame * SLOTS + status.slot, at: Date.now() };
+        return this.clock.time + 2;
+      })
+    );
+  }
+
+  private slotTime(clock: { time: number; at: number }): number {
+    return clock.time + (Date.now() - clock.at) / SLOT_MS;
+  }
+
+  private msUntil(time: number): number {
+    return Math.max(0, (time - this.slotTime(this.clock!)) * SLOT_MS);
+  }
+
+  private reply(placed: Placed): Observable<Buffer> {
+    return new Observable<Buffer>((observer) => {
+      const key = placed.address * 0x10000 + placed.request.readUInt16LE(1);
+      const entry: Waiting = {
+        resolve: (reply) => {
+          observer.next(reply);
+          observer.complete();
+        },
+        reject: (err) => observer.error(err),
+      };
+      this.waiting.set(key, entry);
+      this.listen();
+      const giveUp = setTimeout(
+        () =>
+          observer.error(
+            new Error(
+              `${Command[placed.request[0]] ?? placed.request[0]} to ${
+                placed.address
+              } was not answered`
+            )
+          ),
+        this.msUntil(placed.time + REPLY_SLOTS)
+      );
+      return () => {
+        clearTimeout(giveUp);
+        this.waiting.delete(key);
+        if (!this.waiting.size) {
+          this.poll?.unsubscribe();
+          this.poll = undefined;
+        }
+      };
+    });
+  }
+
+  private listen() {
+    if (this.poll) {
+      return;
+    }
+    this.poll = interval(RECEIVE_POLL_MS)
+      .pipe(exhaustMap(() => receive(this.client)))
+      .subscribe({
+        next: (replies) => replies.forEach((reply) => this.handleReply(reply)),
+        error: (err) => {
+          this.poll = undefined;
+          for (const entry of [...this.waiting.values()]) {
+            entry.reject(err);
+          }
+        },
+      });
+  }
+
+  private handleReply({ address, reply }: TdmaReply) {
+    if (reply.length < 4) {
+      return;
+    }
+    const command = reply[0];
+    const id = reply.readUInt16LE(1);
+    const status = reply[3];
+    const entry = this.waiting.get(address * 0x10000 + id);
+    if (!entry) {
+      return;
+    }
+    const payload = reply.subarray(4);
+    if (status === Status.OK) {
+      entry.resolve(payload);
+    } else {
+      entry.reject(new CommandError(command, status, payload));
+    }
+  }
+}
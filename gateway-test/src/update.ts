@@ -0,0 +1,42 @@
+import { concat, defer, tap } from "rxjs";
+import { CommandClient } from "./command-client";
+import { linkFraming } from "./communication/ccm-stream";
+import { SerialStream } from "./communication/serial-stream";
+import { TransportStream } from "./communication/transport-stream";
+import { OtaState, readImage, readStatus, update } from "./ota";
+
+// npm run update -- <firmware.hex>
+const fileName = process.argv[2];
+if (!fileName) {
+  console.error("usage: update <firmware.hex>");
+  process.exit(1);
+}
+
+const serial = new SerialStream({
+  port: process.env.PORT ?? "/dev/ttyUSB0",
+  baud: 115200,
+});
+const link = new TransportStream(linkFraming(serial), { window: 4 });
+const client = new CommandClient(link);
+
+const image = readImage(fileName);
+console.log(`${fileName}: ${image.length} bytes`);
+
+concat(
+  update(client, image, (sent, total) =>
+    process.stdout.write(`\r${Math.round((sent * 100) / total)}%`)
+  ),
+  defer(() => readStatus(client)).pipe(
+    tap((status) =>
+      console.log(
+        `\nstate ${OtaState[status.state]}, image ${status.imageSize} bytes`
+      )
+    )
+  )
+).subscribe({
+  complete: () => process.exit(0),
+  error: (err) => {
+    console.error(`\n${err}`);
+    process.exit(1);
+  },
+});